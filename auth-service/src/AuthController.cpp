@@ -3,57 +3,181 @@
 //
 
 #include "../include/AuthController.h"
-#include <curl/curl.h>
+#include "Metrics.h"
+#include <drogon/HttpClient.h>
 #include <json/json.h>
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <stdexcept>
 #include <string>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 using nlohmann::json;
 
 namespace {
-size_t writeCb(char* ptr, size_t size, size_t nmemb, void* userdata) {
-    auto* s = static_cast<std::string*>(userdata);
-    s->append(ptr, size * nmemb);
-    return size * nmemb;
-}
-
 struct HttpResult { long code{0}; std::string body; };
 
-// Send the payload already built (include 'data' if present)  to Supabase
-HttpResult supabaseSignup(const json& payload) {
-    const char* url = std::getenv("SUPABASE_URL");
-    const char* anonKey = std::getenv("SUPABASE_ANON_KEY");
-    if (!url || !anonKey) throw std::runtime_error("Missing SUPABASE_URL/ANON_KEY");
+using OnResult = std::function<void(const HttpResult&)>;
+using OnError  = std::function<void(const std::string&)>;
+
+// Upstream calls give up after SUPABASE_TIMEOUT_MS (default 15 s): a stalled
+// GoTrue / PostgREST must not hold the handler and its callback forever
+double upstreamTimeoutSeconds() {
+    static const double seconds = [] {
+        long ms = 15000;
+        if (const char* v = std::getenv("SUPABASE_TIMEOUT_MS")) {
+            try {
+                ms = std::max(std::stol(v), 1L);
+            } catch (const std::exception&) {
+                LOG_WARN << "Ignoring invalid SUPABASE_TIMEOUT_MS " << v;
+            }
+        }
+        return static_cast<double>(ms) / 1000.0;
+    }();
+    return seconds;
+}
 
-    std::string endpoint = std::string(url) + "/auth/v1/signup";
+// Keep-alive clients of the current IO loop, per base URL. A Drogon client
+// serialises its requests on one connection: a call takes an idle client and
+// opens a new one when they are all busy, so the pool grows to the peak
+// concurrency of the loop instead of queueing behind a fixed few.
+struct PooledClient {
+    drogon::HttpClientPtr client;
+    size_t inFlight{0};     // only touched on its loop
+};
+
+// cb runs on the calling IO loop
+void sendUpstream(const std::string& base, const drogon::HttpRequestPtr& req, drogon::HttpReqCallback&& cb) {
+    thread_local std::unordered_map<std::string, std::vector<std::shared_ptr<PooledClient>>> pools;
+
+    auto& pool = pools[base];
+    auto it = std::find_if(pool.begin(), pool.end(), [](const auto& c) { return c->inFlight == 0; });
+    if (it == pool.end()) {
+        auto* loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+        pool.push_back(std::make_shared<PooledClient>(PooledClient{drogon::HttpClient::newHttpClient(base, loop)}));
+        it = std::prev(pool.end());
+    }
 
-    CURL* curl = curl_easy_init();
-    if (!curl) throw std::runtime_error("curl init failed");
+    auto pooled = *it;
+    ++pooled->inFlight;
+    pooled->client->sendRequest(
+        req,
+        [pooled, cb = std::move(cb)](drogon::ReqResult result, const drogon::HttpResponsePtr& resp) {
+            --pooled->inFlight;
+            cb(result, resp);
+        },
+        upstreamTimeoutSeconds());
+}
 
-    std::string response;
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, ("apikey: " + std::string(anonKey)).c_str());
-    headers = curl_slist_append(headers, ("Authorization: Bearer " + std::string(anonKey)).c_str());
-    headers = curl_slist_append(headers, "Content-Type: application/json");
+// Latency histogram + transport error counter of one upstream call site.
+// op is a string literal, so its address is a stable key.
+struct UpstreamMetrics {
+    Metrics::Id latency;
+    Metrics::Id transportErrors;
+};
+
+const UpstreamMetrics& upstreamMetrics(const char* op) {
+    thread_local std::unordered_map<const char*, UpstreamMetrics> byOp;
+    auto it = byOp.find(op);
+    if (it != byOp.end()) return it->second;
+
+    auto& metrics = Metrics::instance();
+    const auto labels = Metrics::label("op", op);
+    UpstreamMetrics m{
+        metrics.histogram("supabase_request_duration_seconds", labels, "Supabase round trip, by call site"),
+        metrics.counter("supabase_transport_errors_total", labels, "Supabase calls that got no HTTP answer, by call site"),
+    };
+    return byOp.emplace(op, m).first->second;
+}
 
-    const auto body = payload.dump();
+Metrics::Id upstreamInFlight() {
+    static const auto id = Metrics::instance().gauge(
+        "supabase_requests_in_flight", "", "Supabase calls waiting for their answer");
+    return id;
+}
 
-    curl_easy_setopt(curl, CURLOPT_URL, endpoint.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+// Non-blocking call to Supabase; onResult / onError run on the calling IO loop.
+// An empty bearer sends no Authorization header. op names the call site in /metrics.
+void supabaseRequest(const char* op,
+                     drogon::HttpMethod method,
+                     const std::string& base,
+                     const std::string& pathAndQuery,
+                     const std::string& apiKey,
+                     const std::string& bearer,
+                     const std::string& body,
+                     bool returnRepresentation,
+                     OnResult onResult,
+                     OnError onError) {
+    auto req = drogon::HttpRequest::newHttpRequest();
+    req->setMethod(method);
+    req->setPath(pathAndQuery);
+    req->setPathEncode(false);          // the query string is already encoded
+    req->addHeader("apikey", apiKey);
+    if (!bearer.empty()) req->addHeader("Authorization", "Bearer " + bearer);
+    if (returnRepresentation) req->addHeader("Prefer", "return=representation");
+    req->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+    if (!body.empty()) req->setBody(body);
+
+    const auto& metrics = upstreamMetrics(op);
+    const auto inFlight = upstreamInFlight();
+    const auto started = std::chrono::steady_clock::now();
+    Metrics::instance().add(inFlight, 1);
+
+    sendUpstream(
+        base,
+        req,
+        [onResult = std::move(onResult), onError = std::move(onError), metrics, inFlight, started](
+            drogon::ReqResult result, const drogon::HttpResponsePtr& resp) {
+            auto& m = Metrics::instance();
+            m.add(inFlight, -1);
+            m.observe(metrics.latency, static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - started).count()));
+
+            if (result != drogon::ReqResult::Ok || !resp) {
+                m.add(metrics.transportErrors);
+                return onError("upstream request failed: " + drogon::to_string(result));
+            }
+            onResult({static_cast<long>(resp->statusCode()), std::string(resp->body())});
+        });
+}
 
-    auto res = curl_easy_perform(curl);
-    long code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
+// Tell the messaging service to forget the cached profile id of a deleted account.
+// Fire and forget: its cache TTL bounds the staleness if this call is lost.
+void notifyAccountDeleted(const std::string& userId) {
+    const char* messaging = std::getenv("MESSAGING_SERVICE_URL");
+    const char* token = std::getenv("INTERNAL_API_TOKEN");
+    if (!messaging || !token) return;
+
+    auto req = drogon::HttpRequest::newHttpRequest();
+    req->setMethod(drogon::Post);
+    req->setPath("/internal/cache/profiles/invalidate");
+    req->addHeader("X-Internal-Token", token);
+    req->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+    req->setBody(json{{"auth_id", userId}}.dump());
+
+    sendUpstream(
+        messaging,
+        req,
+        [userId](drogon::ReqResult result, const drogon::HttpResponsePtr& resp) {
+            if (result != drogon::ReqResult::Ok || !resp || resp->statusCode() != drogon::k204NoContent) {
+                LOG_WARN << "Profile cache invalidation failed for " << userId;
+            }
+        });
+}
+
+// Send the payload already built (include 'data' if present)  to Supabase
+void supabaseSignup(const json& payload, OnResult onResult, OnError onError) {
+    const char* url = std::getenv("SUPABASE_URL");
+    const char* anonKey = std::getenv("SUPABASE_ANON_KEY");
+    if (!url || !anonKey) throw std::runtime_error("Missing SUPABASE_URL/ANON_KEY");
 
-    if (res != CURLE_OK) throw std::runtime_error("curl perform failed");
-    return {code, response};
+    supabaseRequest("supabaseSignup", drogon::Post, url, "/auth/v1/signup", anonKey, anonKey,
+                    payload.dump(), false, std::move(onResult), std::move(onError));
 }
 } // namespace
 
@@ -74,6 +198,22 @@ static drogon::HttpResponsePtr makeJson(int code, const nlohmann::json& j) {
     return r;
 }
 
+// Forward the Supabase status and body as is
+static drogon::HttpResponsePtr passThrough(long code, const std::string& body) {
+    auto r = drogon::HttpResponse::newHttpResponse();
+    r->setStatusCode(static_cast<drogon::HttpStatusCode>(code));
+    r->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+    r->setBody(body.empty() ? "{}" : body);
+    return r;
+}
+
+static drogon::HttpResponsePtr serverError(const std::string& msg) {
+    Json::Value err; err["error"] = msg;
+    auto r = drogon::HttpResponse::newHttpJsonResponse(err);
+    r->setStatusCode(drogon::k500InternalServerError);
+    return r;
+}
+
 // --- Handler /auth/register ---
 void AuthController::registerUser(const drogon::HttpRequestPtr& req,
                                   std::function<void (const drogon::HttpResponsePtr &)> &&cb) {
@@ -106,26 +246,24 @@ void AuthController::registerUser(const drogon::HttpRequestPtr& req,
             signupPayload["data"] = meta;  // => ira dans auth.users.raw_user_meta_data
         }
 
-        // Supabase signup
-        const auto sup = supabaseSignup(signupPayload);
-
-        // Supabase response to client
-        auto r = drogon::HttpResponse::newHttpResponse();
-        r->setStatusCode(
-            (sup.code >= 200 && sup.code < 300)
-                ? drogon::k201Created
-                : drogon::HttpStatusCode(sup.code)
-        );
-        r->setContentTypeCode(drogon::CT_APPLICATION_JSON);
-        r->setBody(sup.body.empty() ? "{}" : sup.body);
-        return cb(r);
+        // Supabase signup, response to client from the IO loop
+        supabaseSignup(
+            signupPayload,
+            [cb](const HttpResult& sup) {
+                auto r = drogon::HttpResponse::newHttpResponse();
+                r->setStatusCode(
+                    (sup.code >= 200 && sup.code < 300)
+                        ? drogon::k201Created
+                        : drogon::HttpStatusCode(sup.code)
+                );
+                r->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+                r->setBody(sup.body.empty() ? "{}" : sup.body);
+                cb(r);
+            },
+            [cb](const std::string& err) { cb(serverError(err)); });
 
     } catch (const std::exception& e) {
-        Json::Value err;
-        err["error"] = e.what();
-        auto r = drogon::HttpResponse::newHttpJsonResponse(err);
-        r->setStatusCode(drogon::k500InternalServerError);
-        return cb(r);
+        return cb(serverError(e.what()));
     }
 }
 
@@ -145,36 +283,11 @@ void AuthController::getUser(const drogon::HttpRequestPtr& req,
         const char* anon = std::getenv("SUPABASE_ANON_KEY");
         if (!base || !anon) throw std::runtime_error("Missing SUPABASE_URL/ANON_KEY");
 
-        std::string url = std::string(base) + "/auth/v1/user";
-
-        CURL* curl = curl_easy_init();
-        if (!curl) throw std::runtime_error("curl init failed");
-
-        std::string response;
-        struct curl_slist* headers = nullptr;
-        headers = curl_slist_append(headers, ("apikey: " + std::string(anon)).c_str());
-        headers = curl_slist_append(headers, ("Authorization: Bearer " + token).c_str());
-        headers = curl_slist_append(headers, "Content-Type: application/json");
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCb);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-
-        auto res = curl_easy_perform(curl);
-        long code = 0; curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
-        curl_slist_free_all(headers); curl_easy_cleanup(curl);
-        if (res != CURLE_OK) throw std::runtime_error("curl perform failed");
-
-        auto r = drogon::HttpResponse::newHttpResponse();
-        r->setStatusCode(static_cast<drogon::HttpStatusCode>(code));
-        r->setContentTypeCode(drogon::CT_APPLICATION_JSON);
-        r->setBody(response.empty() ? "{}" : response);
-        return cb(r);
+        supabaseRequest("getUser", drogon::Get, base, "/auth/v1/user", anon, token, "", false,
+            [cb](const HttpResult& res) { cb(passThrough(res.code, res.body)); },
+            [cb](const std::string& err) { cb(serverError(err)); });
     } catch (const std::exception& e) {
-        Json::Value err; err["error"] = e.what();
-        auto r = drogon::HttpResponse::newHttpJsonResponse(err);
-        r->setStatusCode(drogon::k500InternalServerError);
-        return cb(r);
+        return cb(serverError(e.what()));
     }
 }
 
@@ -201,73 +314,38 @@ void AuthController::updateUser(const drogon::HttpRequestPtr& req,
         const char* anon = std::getenv("SUPABASE_ANON_KEY");
         if (!base || !anon) throw std::runtime_error("Missing SUPABASE_URL/ANON_KEY");
 
+        nlohmann::json upd;
+        if (body->isMember("first_name")) upd["first_name"] = (*body)["first_name"].asString();
+        if (body->isMember("last_name"))  upd["last_name"]  = (*body)["last_name"].asString();
+        if (body->isMember("state"))      upd["state"]      = (*body)["state"].asString();
+
+        const std::string baseUrl(base);
+        const std::string anonKey(anon);
+        auto onError = [cb](const std::string& err) { cb(serverError(err)); };
+
         // 1) Get current user to know its id
-        {
-            std::string url = std::string(base) + "/auth/v1/user";
-            CURL* curl = curl_easy_init(); if (!curl) throw std::runtime_error("curl init failed");
-            std::string resp; long code = 0;
-            struct curl_slist* hdr = nullptr;
-            hdr = curl_slist_append(hdr, ("apikey: " + std::string(anon)).c_str());
-            hdr = curl_slist_append(hdr, ("Authorization: Bearer " + token).c_str());
-            hdr = curl_slist_append(hdr, "Content-Type: application/json");
-            curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, hdr);
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCb);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &resp);
-            auto res = curl_easy_perform(curl);
-            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
-            curl_slist_free_all(hdr); curl_easy_cleanup(curl);
-            if (res != CURLE_OK) throw std::runtime_error("curl perform failed");
-            if (code != 200) {
-                auto r = drogon::HttpResponse::newHttpResponse();
-                r->setStatusCode(static_cast<drogon::HttpStatusCode>(code));
-                r->setContentTypeCode(drogon::CT_APPLICATION_JSON);
-                r->setBody(resp.empty() ? "{}" : resp);
-                return cb(r);
-            }
-            auto j = nlohmann::json::parse(resp);
-            if (!j.contains("id")) throw std::runtime_error("Cannot extract user id");
-            const std::string userId = j["id"].get<std::string>();
-
-            // 2) PATCH profiles
-            std::string url2 = std::string(base) + "/rest/v1/profiles?auth_id=eq." + userId;
-            nlohmann::json upd;
-
-            if (body->isMember("first_name")) upd["first_name"] = (*body)["first_name"].asString();
-            if (body->isMember("last_name"))  upd["last_name"]  = (*body)["last_name"].asString();
-            if (body->isMember("state"))      upd["state"]      = (*body)["state"].asString();
-
-            CURL* c2 = curl_easy_init(); if (!c2) throw std::runtime_error("curl init failed");
-            std::string resp2; long code2 = 0;
-            struct curl_slist* h2 = nullptr;
-            h2 = curl_slist_append(h2, ("apikey: " + std::string(anon)).c_str());
-            h2 = curl_slist_append(h2, ("Authorization: Bearer " + token).c_str());
-            h2 = curl_slist_append(h2, "Content-Type: application/json");
-            h2 = curl_slist_append(h2, "Prefer: return=representation");
-
-            auto bodyJson = upd.dump();
-            curl_easy_setopt(c2, CURLOPT_URL, url2.c_str());
-            curl_easy_setopt(c2, CURLOPT_HTTPHEADER, h2);
-            curl_easy_setopt(c2, CURLOPT_CUSTOMREQUEST, "PATCH"); // PUT externe, PATCH REST
-            curl_easy_setopt(c2, CURLOPT_POSTFIELDS, bodyJson.c_str());
-            curl_easy_setopt(c2, CURLOPT_WRITEFUNCTION, writeCb);
-            curl_easy_setopt(c2, CURLOPT_WRITEDATA, &resp2);
-            auto res2 = curl_easy_perform(c2);
-            curl_easy_getinfo(c2, CURLINFO_RESPONSE_CODE, &code2);
-            curl_slist_free_all(h2); curl_easy_cleanup(c2);
-            if (res2 != CURLE_OK) throw std::runtime_error("curl perform failed");
-
-            auto r = drogon::HttpResponse::newHttpResponse();
-            r->setStatusCode(static_cast<drogon::HttpStatusCode>(code2));
-            r->setContentTypeCode(drogon::CT_APPLICATION_JSON);
-            r->setBody(resp2.empty() ? "{}" : resp2);
-            return cb(r);
-        }
+        supabaseRequest("updateUser.getUser", drogon::Get, baseUrl, "/auth/v1/user", anonKey, token, "", false,
+            [cb, onError, baseUrl, anonKey, token, bodyJson = upd.dump()](const HttpResult& me) {
+                if (me.code != 200) return cb(passThrough(me.code, me.body));
+
+                std::string userId;
+                try {
+                    auto j = nlohmann::json::parse(me.body);
+                    if (!j.contains("id")) throw std::runtime_error("Cannot extract user id");
+                    userId = j["id"].get<std::string>();
+                } catch (const std::exception& e) {
+                    return cb(serverError(e.what()));
+                }
+
+                // 2) PATCH profiles (PUT externe, PATCH REST)
+                supabaseRequest("updateUser.patchProfile", drogon::Patch, baseUrl, "/rest/v1/profiles?auth_id=eq." + userId,
+                                anonKey, token, bodyJson, true,
+                    [cb](const HttpResult& res) { cb(passThrough(res.code, res.body)); },
+                    onError);
+            },
+            onError);
     } catch (const std::exception& e) {
-        Json::Value err; err["error"] = e.what();
-        auto r = drogon::HttpResponse::newHttpJsonResponse(err);
-        r->setStatusCode(drogon::k500InternalServerError);
-        return cb(r);
+        return cb(serverError(e.what()));
     }
 }
 
@@ -279,70 +357,53 @@ void AuthController::deleteUser(const drogon::HttpRequestPtr& req,
         const char* svc  = std::getenv("SUPABASE_SERVICE_ROLE");
         if (!base || !svc) throw std::runtime_error("Missing SUPABASE_URL/SERVICE_ROLE");
 
+        const std::string baseUrl(base);
+        const std::string svcKey(svc);
+        auto onError = [cb](const std::string& err) { cb(serverError(err)); };
+
+        // 2) DELETE admin (204 No Content on success)
+        auto deleteById = [cb, onError, baseUrl, svcKey](const std::string& userId) {
+            supabaseRequest("deleteUser.adminDelete", drogon::Delete, baseUrl, "/auth/v1/admin/users/" + userId,
+                            svcKey, svcKey, "", false,
+                [cb, userId](const HttpResult& res) {
+                    if (res.code >= 200 && res.code < 300) notifyAccountDeleted(userId);
+                    cb(passThrough(res.code, res.body));
+                },
+                onError);
+        };
+
         // 1) Recover user id (either way)
-        std::string userId;
         const auto body = req->getJsonObject();
         if (body && body->isMember("id")) {
-            userId = (*body)["id"].asString();
-        } else {
-            // si pas d'id fourni, essayer via access token
-            const auto token = getBearerToken(req);
-            if (token.empty()) {
-                Json::Value err; err["error"] = "Provide user id in body or Bearer token";
-                auto r = drogon::HttpResponse::newHttpJsonResponse(err);
-                r->setStatusCode(drogon::k400BadRequest);
-                return cb(r);
-            }
-            // /auth/v1/user to get user id
-            std::string meUrl = std::string(base) + "/auth/v1/user";
-            CURL* c1 = curl_easy_init(); if (!c1) throw std::runtime_error("curl init failed");
-            std::string me; long c = 0;
-            struct curl_slist* h1 = nullptr;
-            h1 = curl_slist_append(h1, ("apikey: " + std::string(svc)).c_str()); // ok avec service role
-            h1 = curl_slist_append(h1, ("Authorization: Bearer " + token).c_str());
-            h1 = curl_slist_append(h1, "Content-Type: application/json");
-            curl_easy_setopt(c1, CURLOPT_URL, meUrl.c_str());
-            curl_easy_setopt(c1, CURLOPT_HTTPHEADER, h1);
-            curl_easy_setopt(c1, CURLOPT_WRITEFUNCTION, writeCb);
-            curl_easy_setopt(c1, CURLOPT_WRITEDATA, &me);
-            auto res1 = curl_easy_perform(c1);
-            curl_easy_getinfo(c1, CURLINFO_RESPONSE_CODE, &c);
-            curl_slist_free_all(h1); curl_easy_cleanup(c1);
-            if (res1 != CURLE_OK || c != 200) throw std::runtime_error("Cannot resolve user id");
-            auto j = nlohmann::json::parse(me);
-            userId = j.value<std::string>("id", "");
-            if (userId.empty()) throw std::runtime_error("Empty user id");
+            return deleteById((*body)["id"].asString());
+        }
+
+        // si pas d'id fourni, essayer via access token
+        const auto token = getBearerToken(req);
+        if (token.empty()) {
+            Json::Value err; err["error"] = "Provide user id in body or Bearer token";
+            auto r = drogon::HttpResponse::newHttpJsonResponse(err);
+            r->setStatusCode(drogon::k400BadRequest);
+            return cb(r);
         }
 
-        // 2) DELETE admin
-        std::string delUrl = std::string(base) + "/auth/v1/admin/users/" + userId;
-        CURL* curl = curl_easy_init(); if (!curl) throw std::runtime_error("curl init failed");
-        std::string response; long code = 0;
-        struct curl_slist* headers = nullptr;
-        headers = curl_slist_append(headers, ("apikey: " + std::string(svc)).c_str());
-        headers = curl_slist_append(headers, ("Authorization: Bearer " + std::string(svc)).c_str());
-        headers = curl_slist_append(headers, "Content-Type: application/json");
-        curl_easy_setopt(curl, CURLOPT_URL, delUrl.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCb);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        auto res = curl_easy_perform(curl);
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
-        curl_slist_free_all(headers); curl_easy_cleanup(curl);
-        if (res != CURLE_OK) throw std::runtime_error("curl perform failed");
-
-        // 204 No Content on success
-        auto r = drogon::HttpResponse::newHttpResponse();
-        r->setStatusCode(static_cast<drogon::HttpStatusCode>(code));
-        r->setContentTypeCode(drogon::CT_APPLICATION_JSON);
-        r->setBody(response.empty() ? "{}" : response);
-        return cb(r);
+        // /auth/v1/user to get user id (ok avec service role)
+        supabaseRequest("deleteUser.getUser", drogon::Get, baseUrl, "/auth/v1/user", svcKey, token, "", false,
+            [cb, deleteById](const HttpResult& me) {
+                std::string userId;
+                try {
+                    if (me.code != 200) throw std::runtime_error("Cannot resolve user id");
+                    auto j = nlohmann::json::parse(me.body);
+                    userId = j.value<std::string>("id", "");
+                    if (userId.empty()) throw std::runtime_error("Empty user id");
+                } catch (const std::exception& e) {
+                    return cb(serverError(e.what()));
+                }
+                deleteById(userId);
+            },
+            [cb](const std::string&) { cb(serverError("Cannot resolve user id")); });
     } catch (const std::exception& e) {
-        Json::Value err; err["error"] = e.what();
-        auto r = drogon::HttpResponse::newHttpJsonResponse(err);
-        r->setStatusCode(drogon::k500InternalServerError);
-        return cb(r);
+        return cb(serverError(e.what()));
     }
 }
 
@@ -366,44 +427,15 @@ void AuthController::loginUser(const drogon::HttpRequestPtr& req,
         const char* anonKey = std::getenv("SUPABASE_ANON_KEY");
         if (!url || !anonKey) throw std::runtime_error("Missing SUPABASE_URL/ANON_KEY");
 
-        std::string endpoint = std::string(url) + "/auth/v1/token?grant_type=password";
         nlohmann::json payload = {{"email", email}, {"password", password}};
 
-        CURL* curl = curl_easy_init();
-        if (!curl) throw std::runtime_error("curl init failed");
-
-        std::string response;
-        struct curl_slist* headers = nullptr;
-        headers = curl_slist_append(headers, ("apikey: " + std::string(anonKey)).c_str());
-        headers = curl_slist_append(headers, "Content-Type: application/json");
-
-        const auto bodyJson = payload.dump();
-        curl_easy_setopt(curl, CURLOPT_URL, endpoint.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_POST, 1L);
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, bodyJson.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCb);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-
-        auto res = curl_easy_perform(curl);
-        long code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
-
-        if (res != CURLE_OK) throw std::runtime_error("curl perform failed");
-
-        auto r = drogon::HttpResponse::newHttpResponse();
-        r->setStatusCode(drogon::HttpStatusCode(code));
-        r->setContentTypeCode(drogon::CT_APPLICATION_JSON);
-        r->setBody(response.empty() ? "{}" : response);
-        return cb(r);
+        // No Authorization header on the password grant
+        supabaseRequest("loginUser.passwordGrant", drogon::Post, url, "/auth/v1/token?grant_type=password", anonKey, "",
+                        payload.dump(), false,
+            [cb](const HttpResult& res) { cb(passThrough(res.code, res.body)); },
+            [cb](const std::string& err) { cb(serverError(err)); });
 
     } catch (const std::exception& e) {
-        Json::Value err;
-        err["error"] = e.what();
-        auto r = drogon::HttpResponse::newHttpJsonResponse(err);
-        r->setStatusCode(drogon::k500InternalServerError);
-        return cb(r);
+        return cb(serverError(e.what()));
     }
-}
\ No newline at end of file
+}
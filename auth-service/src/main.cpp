@@ -1,4 +1,6 @@
 #include "../include/AuthController.h"
+#include "Metrics.h"
+#include "ServerConfig.h"
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -42,6 +44,11 @@ int main() {
     // Vérification rapide
     std::cout << "SUPABASE_URL=" << (std::getenv("SUPABASE_URL") ? std::getenv("SUPABASE_URL") : "non défini") << std::endl;
 
+    // IO threads / listeners / limits (SERVER_* env or SERVER_CONFIG_FILE)
+    ServerConfig::load(8080).apply(drogon::app());
+    // GET /metrics + per-route latency histograms
+    Metrics::instrument(drogon::app());
+
     drogon::app()
         .registerHandler(
             "/health",
@@ -54,7 +61,6 @@ int main() {
             },
             {drogon::Get}
         )
-        .addListener("0.0.0.0", std::getenv("PORT") ? std::stoi(std::getenv("PORT")) : 8080)
         .setLogLevel(trantor::Logger::kInfo)
         .run();
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_METRICS_H
+#define SECURE_CLOUD_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon { class HttpAppFramework; }
+
+// Process metrics, exported at GET /metrics (Prometheus text format).
+//
+// Every thread records into its own slab of cells: only the owning thread
+// writes them (relaxed load + store, no lock, no shared cache line) and a
+// scrape sums the slabs of all threads. Latencies go into log2 buckets,
+// bucket i counting the values below 2^i microseconds (1 us .. ~67 s): an
+// HDR histogram with one significant bit, so recording is a bit scan and
+// two additions.
+//
+// Series are registered once (name + labels -> id, under a mutex); hot
+// paths keep the id and only call observe() / add().
+class Metrics {
+public:
+    using Id = std::uint32_t;
+    // Appends extra exposition lines at scrape time (stats owned by other components)
+    using Collector = std::function<void(std::string& out)>;
+
+    static constexpr std::size_t kBuckets = 28;          // 27 finite bounds + Inf
+    static constexpr std::size_t kMaxHistograms = 128;
+    static constexpr std::size_t kMaxCells = 256;        // counters + gauges
+
+    static Metrics& instance();
+
+    // Same name + labels -> same id. labels is the inside of {...}, built with label()
+    Id histogram(const std::string& name, const std::string& labels, const std::string& help);
+    Id counter(const std::string& name, const std::string& labels, const std::string& help);
+    Id gauge(const std::string& name, const std::string& labels, const std::string& help);
+
+    static std::string label(const std::string& key, const std::string& value);
+
+    void observe(Id histogram, std::uint64_t micros);
+    void add(Id cell, std::int64_t n = 1);   // counter, or gauge up/down
+
+    void addCollector(Collector collector);
+    std::string render() const;
+
+    // GET /metrics, plus per-route latency and in-flight requests through the
+    // pre/post-handling advices
+    static void instrument(drogon::HttpAppFramework& app);
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+private:
+    Metrics() = default;
+
+    enum class Kind { Histogram, Counter, Gauge };
+
+    struct Series {
+        Kind kind;
+        std::string name;
+        std::string labels;
+        Id slot;
+    };
+
+    struct Slab {
+        std::atomic<std::uint64_t> buckets[kMaxHistograms][kBuckets] = {};
+        std::atomic<std::uint64_t> sums[kMaxHistograms] = {};     // microseconds
+        std::atomic<std::int64_t> cells[kMaxCells] = {};
+    };
+
+    Id registerSeries(Kind kind, const std::string& name, const std::string& labels, const std::string& help);
+    Slab& localSlab();
+
+    mutable std::mutex mutex_;                         // registration, slab list, scrape
+    std::vector<Series> series_;
+    std::unordered_map<std::string, std::size_t> byKey_;
+    std::unordered_map<std::string, std::string> help_;
+    std::vector<Slab*> slabs_;
+    std::vector<Collector> collectors_;
+    Id histograms_ = 0;
+    Id cells_ = 0;
+};
+
+#endif //SECURE_CLOUD_METRICS_H
@@ -0,0 +1,43 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_SERVERCONFIG_H
+#define SECURE_CLOUD_SERVERCONFIG_H
+
+#pragma once
+#include <drogon/HttpAppFramework.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Startup settings of the HTTP server (IO threads, listeners, limits).
+//
+// Read in this order, each step overriding the previous one:
+//   1. built-in defaults (one IO loop per core, SO_REUSEPORT on);
+//   2. the JSON file named by SERVER_CONFIG_FILE, if any, e.g.
+//        {"threads": 16, "reuse_port": true, "pin_threads": true,
+//         "max_connections": 200000, "idle_timeout": 60}
+//   3. environment: PORT, SERVER_HOST, SERVER_THREADS, SERVER_REUSE_PORT,
+//      SERVER_PIN_THREADS, SERVER_MAX_CONNECTIONS, SERVER_MAX_CONNECTIONS_PER_IP,
+//      SERVER_IDLE_TIMEOUT, SERVER_KEEPALIVE_REQUESTS, SERVER_PIPELINING_REQUESTS.
+struct ServerConfig {
+    std::string host = "0.0.0.0";
+    std::uint16_t port = 0;
+    std::size_t threads = 0;                // IO loops, 0 = one per core
+    bool reusePort = true;                  // one listening socket per loop, the kernel spreads accepts
+    bool pinThreads = false;                // pin IO loop i to CPU i (Linux only)
+    std::size_t maxConnections = 100000;
+    std::size_t maxConnectionsPerIp = 0;    // 0 = unlimited
+    std::size_t idleTimeoutSeconds = 60;    // 0 = never close idle connections
+    std::size_t keepaliveRequests = 0;      // requests per keep-alive connection, 0 = unlimited
+    std::size_t pipeliningRequests = 0;     // pipelined requests in flight, 0 = unlimited
+
+    static ServerConfig load(std::uint16_t defaultPort);
+
+    // Listener + thread/connection settings, and CPU pinning once the loops run
+    void apply(drogon::HttpAppFramework& app) const;
+};
+
+#endif //SECURE_CLOUD_SERVERCONFIG_H
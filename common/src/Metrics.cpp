@@ -0,0 +1,246 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/Metrics.h"
+
+#include <drogon/HttpAppFramework.h>
+#include <trantor/utils/Date.h>
+#include <trantor/utils/Logger.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <unordered_set>
+
+namespace {
+
+// ---------- Helper 1 : owner-only update of a per-thread cell ----------
+template <typename T>
+void bump(std::atomic<T>& cell, T n) {
+    cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// ---------- Helper 2 : exposition format ----------
+void appendSample(std::string& out, const std::string& name, const std::string& labels,
+                  const std::string& extraLabel, const std::string& value) {
+    out += name;
+    if (!labels.empty() || !extraLabel.empty()) {
+        out += '{';
+        out += labels;
+        if (!labels.empty() && !extraLabel.empty()) out += ',';
+        out += extraLabel;
+        out += '}';
+    }
+    out += ' ';
+    out += value;
+    out += '\n';
+}
+
+std::string seconds(double micros) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", micros / 1e6);
+    return buf;
+}
+
+// ---------- Helper 3 : latency histogram of the route that handled req ----------
+Metrics::Id routeHistogram(const drogon::HttpRequestPtr& req) {
+    // The matched pattern is owned by the router: its address identifies the route
+    thread_local std::unordered_map<std::uintptr_t, Metrics::Id> ids;
+    const auto key = reinterpret_cast<std::uintptr_t>(req->matchedPathPatternData()) * 16 +
+                     static_cast<std::uintptr_t>(req->method());
+
+    auto it = ids.find(key);
+    if (it != ids.end()) return it->second;
+
+    const std::string route = req->matchedPathPatternLength() == 0
+        ? "unmatched"
+        : std::string(req->matchedPathPatternData(), req->matchedPathPatternLength());
+    const auto id = Metrics::instance().histogram(
+        "http_request_duration_seconds",
+        Metrics::label("route", route) + "," + Metrics::label("method", req->methodString()),
+        "Time from request parsed to response ready, by route");
+    ids.emplace(key, id);
+    return id;
+}
+
+} // namespace
+
+Metrics& Metrics::instance() {
+    // Never destroyed: IO threads may record while main() returns
+    static Metrics* metrics = new Metrics();
+    return *metrics;
+}
+
+std::string Metrics::label(const std::string& key, const std::string& value) {
+    std::string out = key + "=\"";
+    for (char c : value) {
+        if (c == '\\' || c == '"') out += '\\';
+        if (c == '\n') { out += "\\n"; continue; }
+        out += c;
+    }
+    out += '"';
+    return out;
+}
+
+Metrics::Id Metrics::registerSeries(Kind kind,
+                                    const std::string& name,
+                                    const std::string& labels,
+                                    const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const std::string key = name + '{' + labels + '}';
+    auto it = byKey_.find(key);
+    if (it != byKey_.end()) return series_[it->second].slot;
+
+    const bool isHistogram = (kind == Kind::Histogram);
+    Id& next = isHistogram ? histograms_ : cells_;
+    const std::size_t limit = isHistogram ? kMaxHistograms : kMaxCells;
+    if (next >= limit) {
+        // Recording into an out-of-range id is a no-op
+        LOG_ERROR << "Metrics: too many series, dropping " << key;
+        return static_cast<Id>(limit);
+    }
+
+    series_.push_back({kind, name, labels, next++});
+    byKey_.emplace(key, series_.size() - 1);
+    help_.emplace(name, help);
+    return series_.back().slot;
+}
+
+Metrics::Id Metrics::histogram(const std::string& name, const std::string& labels, const std::string& help) {
+    return registerSeries(Kind::Histogram, name, labels, help);
+}
+
+Metrics::Id Metrics::counter(const std::string& name, const std::string& labels, const std::string& help) {
+    return registerSeries(Kind::Counter, name, labels, help);
+}
+
+Metrics::Id Metrics::gauge(const std::string& name, const std::string& labels, const std::string& help) {
+    return registerSeries(Kind::Gauge, name, labels, help);
+}
+
+Metrics::Slab& Metrics::localSlab() {
+    thread_local Slab* slab = nullptr;
+    if (!slab) {
+        slab = new Slab();   // kept after the thread exits so its counts are not lost
+        std::lock_guard<std::mutex> lock(mutex_);
+        slabs_.push_back(slab);
+    }
+    return *slab;
+}
+
+void Metrics::observe(Id histogram, std::uint64_t micros) {
+    if (histogram >= kMaxHistograms) return;
+    auto& slab = localSlab();
+
+    // bucket i counts the values < 2^i us
+    const std::size_t bucket = micros == 0
+        ? 0
+        : std::min<std::size_t>(64 - __builtin_clzll(micros), kBuckets - 1);
+    bump<std::uint64_t>(slab.buckets[histogram][bucket], 1);
+    bump<std::uint64_t>(slab.sums[histogram], micros);
+}
+
+void Metrics::add(Id cell, std::int64_t n) {
+    if (cell >= kMaxCells) return;
+    bump<std::int64_t>(localSlab().cells[cell], n);
+}
+
+void Metrics::addCollector(Collector collector) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    collectors_.push_back(std::move(collector));
+}
+
+std::string Metrics::render() const {
+    std::string out;
+    out.reserve(16 * 1024);
+    std::vector<Collector> collectors;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        collectors = collectors_;
+
+        // One HELP/TYPE header per family, families in registration order
+        std::vector<std::string> families;
+        std::unordered_set<std::string> seen;
+        for (const auto& s : series_) {
+            if (seen.insert(s.name).second) families.push_back(s.name);
+        }
+
+        for (const auto& family : families) {
+            bool header = false;
+            for (const auto& s : series_) {
+                if (s.name != family) continue;
+
+                if (!header) {
+                    const char* type = s.kind == Kind::Histogram ? "histogram"
+                                     : s.kind == Kind::Counter ? "counter" : "gauge";
+                    out += "# HELP " + family + " " + help_.at(family) + "\n";
+                    out += "# TYPE " + family + " " + type + "\n";
+                    header = true;
+                }
+
+                if (s.kind != Kind::Histogram) {
+                    std::int64_t total = 0;
+                    for (const auto* slab : slabs_) total += slab->cells[s.slot].load(std::memory_order_relaxed);
+                    appendSample(out, family, s.labels, "", std::to_string(total));
+                    continue;
+                }
+
+                std::uint64_t counts[kBuckets] = {};
+                std::uint64_t sum = 0;
+                for (const auto* slab : slabs_) {
+                    for (std::size_t b = 0; b < kBuckets; ++b) {
+                        counts[b] += slab->buckets[s.slot][b].load(std::memory_order_relaxed);
+                    }
+                    sum += slab->sums[s.slot].load(std::memory_order_relaxed);
+                }
+
+                std::uint64_t cumulative = 0;
+                for (std::size_t b = 0; b + 1 < kBuckets; ++b) {
+                    cumulative += counts[b];
+                    appendSample(out, family + "_bucket", s.labels,
+                                 "le=\"" + seconds(static_cast<double>(1ull << b)) + "\"",
+                                 std::to_string(cumulative));
+                }
+                cumulative += counts[kBuckets - 1];
+                appendSample(out, family + "_bucket", s.labels, "le=\"+Inf\"", std::to_string(cumulative));
+                appendSample(out, family + "_sum", s.labels, "", seconds(static_cast<double>(sum)));
+                appendSample(out, family + "_count", s.labels, "", std::to_string(cumulative));
+            }
+        }
+    }
+
+    // Outside the lock: a collector may register series of its own
+    for (const auto& collect : collectors) {
+        collect(out);
+    }
+    return out;
+}
+
+void Metrics::instrument(drogon::HttpAppFramework& app) {
+    const Id inFlight = instance().gauge("http_requests_in_flight", "", "HTTP requests being handled");
+
+    app.registerPreHandlingAdvice([inFlight](const drogon::HttpRequestPtr&) {
+        instance().add(inFlight, 1);
+    });
+
+    app.registerPostHandlingAdvice([inFlight](const drogon::HttpRequestPtr& req, const drogon::HttpResponsePtr&) {
+        auto& metrics = instance();
+        metrics.add(inFlight, -1);
+        const auto elapsed = trantor::Date::now().microSecondsSinceEpoch() -
+                             req->creationDate().microSecondsSinceEpoch();
+        metrics.observe(routeHistogram(req), elapsed > 0 ? static_cast<std::uint64_t>(elapsed) : 0);
+    });
+
+    app.registerHandler(
+        "/metrics",
+        [](const drogon::HttpRequestPtr&,
+           std::function<void (const drogon::HttpResponsePtr &)> &&cb) {
+            auto resp = drogon::HttpResponse::newHttpResponse();
+            resp->setContentTypeString("text/plain; version=0.0.4");
+            resp->setBody(instance().render());
+            cb(resp);
+        },
+        {drogon::Get});
+}
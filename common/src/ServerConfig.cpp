@@ -0,0 +1,159 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/ServerConfig.h"
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// ---------- Helper 1 : parse one setting ----------
+std::size_t parseCount(const std::string& raw) {
+    std::size_t used = 0;
+    const auto v = std::stoull(raw, &used);
+    if (used != raw.size()) throw std::invalid_argument("not a number");
+    return static_cast<std::size_t>(v);
+}
+
+bool parseFlag(const std::string& raw) {
+    if (raw == "1" || raw == "true" || raw == "yes" || raw == "on") return true;
+    if (raw == "0" || raw == "false" || raw == "no" || raw == "off") return false;
+    throw std::invalid_argument("not a boolean");
+}
+
+// ---------- Helper 2 : JSON file (SERVER_CONFIG_FILE) ----------
+void readJsonFile(const std::string& path, ServerConfig& cfg) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "[WARN] Cannot open SERVER_CONFIG_FILE " << path << std::endl;
+        return;
+    }
+
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    if (!Json::parseFromStream(builder, file, &root, &errors) || !root.isObject()) {
+        std::cerr << "[WARN] Invalid SERVER_CONFIG_FILE " << path << ": " << errors << std::endl;
+        return;
+    }
+
+    auto count = [&root](const char* key, std::size_t& out) {
+        if (root.isMember(key) && root[key].isUInt64()) out = static_cast<std::size_t>(root[key].asUInt64());
+    };
+    auto flag = [&root](const char* key, bool& out) {
+        if (root.isMember(key) && root[key].isBool()) out = root[key].asBool();
+    };
+
+    if (root.isMember("host") && root["host"].isString()) cfg.host = root["host"].asString();
+    if (root.isMember("port") && root["port"].isUInt() && root["port"].asUInt() <= 65535) {
+        cfg.port = static_cast<std::uint16_t>(root["port"].asUInt());
+    }
+    count("threads", cfg.threads);
+    flag("reuse_port", cfg.reusePort);
+    flag("pin_threads", cfg.pinThreads);
+    count("max_connections", cfg.maxConnections);
+    count("max_connections_per_ip", cfg.maxConnectionsPerIp);
+    count("idle_timeout", cfg.idleTimeoutSeconds);
+    count("keepalive_requests", cfg.keepaliveRequests);
+    count("pipelining_requests", cfg.pipeliningRequests);
+}
+
+// ---------- Helper 3 : environment overrides ----------
+template <typename T, typename Parse>
+void readEnv(const char* name, T& out, Parse parse) {
+    const char* raw = std::getenv(name);
+    if (!raw || !*raw) return;
+    try {
+        out = static_cast<T>(parse(raw));
+    } catch (const std::exception&) {
+        std::cerr << "[WARN] Ignoring invalid " << name << " " << raw << std::endl;
+    }
+}
+
+void pinCurrentThread(std::size_t cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        std::cerr << "[WARN] Cannot pin IO loop to CPU " << cpu << std::endl;
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+} // namespace
+
+ServerConfig ServerConfig::load(std::uint16_t defaultPort) {
+    ServerConfig cfg;
+    cfg.port = defaultPort;
+
+    if (const char* path = std::getenv("SERVER_CONFIG_FILE"); path && *path) {
+        readJsonFile(path, cfg);
+    }
+
+    readEnv("SERVER_HOST", cfg.host, [](const std::string& v) { return v; });
+    readEnv("PORT", cfg.port, [](const std::string& v) {
+        const auto port = parseCount(v);
+        if (port == 0 || port > 65535) throw std::out_of_range("port");
+        return port;
+    });
+    readEnv("SERVER_THREADS", cfg.threads, parseCount);
+    readEnv("SERVER_REUSE_PORT", cfg.reusePort, parseFlag);
+    readEnv("SERVER_PIN_THREADS", cfg.pinThreads, parseFlag);
+    readEnv("SERVER_MAX_CONNECTIONS", cfg.maxConnections, parseCount);
+    readEnv("SERVER_MAX_CONNECTIONS_PER_IP", cfg.maxConnectionsPerIp, parseCount);
+    readEnv("SERVER_IDLE_TIMEOUT", cfg.idleTimeoutSeconds, parseCount);
+    readEnv("SERVER_KEEPALIVE_REQUESTS", cfg.keepaliveRequests, parseCount);
+    readEnv("SERVER_PIPELINING_REQUESTS", cfg.pipeliningRequests, parseCount);
+
+    return cfg;
+}
+
+void ServerConfig::apply(drogon::HttpAppFramework& app) const {
+    const std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t loops = threads == 0 ? cores : threads;
+
+    app.addListener(host, port)
+        .setThreadNum(loops)
+        .enableReusePort(reusePort)
+        .setMaxConnectionNum(maxConnections)
+        .setMaxConnectionNumPerIP(maxConnectionsPerIp)
+        .setIdleConnectionTimeout(idleTimeoutSeconds)
+        .setKeepaliveRequestsNumber(keepaliveRequests)
+        .setPipeliningRequestsNumber(pipeliningRequests);
+
+    if (pinThreads) {
+        // The IO loops only exist once run() started them
+        app.registerBeginningAdvice([loops, cores]() {
+            for (std::size_t i = 0; i < loops; ++i) {
+                if (auto* loop = drogon::app().getIOLoop(i)) {
+                    const std::size_t cpu = i % cores;
+                    loop->queueInLoop([cpu]() { pinCurrentThread(cpu); });
+                }
+            }
+        });
+    }
+
+    std::cout << "[INFO] Listening on " << host << ":" << port
+              << " (" << loops << " IO loops"
+              << (reusePort ? ", SO_REUSEPORT" : "")
+              << (pinThreads ? ", pinned" : "")
+              << ", max " << maxConnections << " connections"
+              << ", idle timeout " << idleTimeoutSeconds << "s)" << std::endl;
+}
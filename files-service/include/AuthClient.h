@@ -0,0 +1,67 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_AUTHCLIENT_H
+#define SECURE_CLOUD_AUTHCLIENT_H
+
+#include <drogon/HttpClient.h>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Checks the Supabase access token of a request with auth-service
+// (GET AUTH_SERVICE_URL/auth/user, which asks GoTrue), before any byte of
+// a file goes in or out. The user id it returns owns what the request
+// creates.
+//
+// Accepted tokens are remembered for FILES_AUTH_CACHE_SECONDS (keyed by
+// their SHA-256, FILES_AUTH_CACHE_SIZE at most), so a client resuming an
+// upload chunk after chunk does not cost a round trip each time.
+//
+// One Drogon HttpClient per IO loop: the callback runs on the loop of the
+// request.
+class AuthClient {
+public:
+    // status 200 with the auth user id, else 401 (bad token) or 502 (auth-service)
+    using Callback = std::function<void(int status, const std::string& userId)>;
+
+    static AuthClient& instance();
+
+    // "Authorization: Bearer <token>", empty when absent
+    static std::string bearerToken(const drogon::HttpRequestPtr& req);
+
+    void verify(const std::string& token, Callback cb);
+
+    AuthClient(const AuthClient&) = delete;
+    AuthClient& operator=(const AuthClient&) = delete;
+
+private:
+    AuthClient();
+
+    drogon::HttpClientPtr client();
+
+    bool lookup(const std::string& key, std::string& userId);
+    void store(const std::string& key, const std::string& userId);
+
+    std::string endpoint_;
+    std::chrono::seconds ttl_{60};
+
+    // LRU: front = most recently used
+    struct Entry {
+        std::string key;
+        std::string userId;
+        std::chrono::steady_clock::time_point expiresAt;
+    };
+    std::size_t capacity_ = 10000;
+    std::list<Entry> lru_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    std::mutex mutex_;
+};
+
+#endif //SECURE_CLOUD_AUTHCLIENT_H
@@ -0,0 +1,77 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_CHUNKCIPHER_H
+#define SECURE_CLOUD_CHUNKCIPHER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
+
+// AES-256-GCM through the OpenSSL EVP API (which runs on AES-NI /
+// PCLMULQDQ when the CPU has them).
+//
+// A stream of chunks under one key: a sealed chunk is
+// ciphertext || 16-byte tag, with:
+//  - nonce = 4 zero bytes || chunk index (64-bit big endian): unique per key;
+//  - AAD   = stream id || chunk index || final flag, so chunks cannot be
+//            reordered, moved to another stream, or the stream truncated.
+//
+// Stored chunks are deduplicated within a tenant (the auth user owning the
+// file), so their encryption is convergent per tenant, keyed by the master
+// key: chunk key = HMAC(master, tenant || "key" || SHA-256(chunk)), stream
+// id = the SHA-256, one chunk (index 0, final). The chunk id (object name,
+// index entry) is HMAC(master, tenant || "name" || SHA-256(chunk)). A given
+// chunk always seals to the same object for one tenant and to unrelated
+// ones for the others: an upload can only tell whether its own tenant
+// already stored a chunk, and without the master key neither its content
+// nor its hash can be tested against the store. Tenants are UUIDs (fixed
+// length), so the concatenations are unambiguous.
+//
+// File manifests are sealed as blobs under the master key, random nonce.
+class ChunkCipher {
+public:
+    static constexpr std::size_t kKeySize = 32;
+    static constexpr std::size_t kNonceSize = 12;
+    static constexpr std::size_t kTagSize = 16;
+    using Key = std::array<std::uint8_t, kKeySize>;
+    using ChunkId = std::array<std::uint8_t, 32>;
+
+    ChunkCipher(const Key& key, std::string streamId);
+    ~ChunkCipher();
+
+    ChunkCipher(const ChunkCipher&) = delete;
+    ChunkCipher& operator=(const ChunkCipher&) = delete;
+
+    // Appends the sealed chunk (size + kTagSize bytes) to out
+    bool seal(std::uint64_t index, bool final, const char* data, std::size_t size, std::string& out);
+    // Appends the plaintext to out; false when the tag does not match
+    bool open(std::uint64_t index, bool final, const char* data, std::size_t size, std::string& out);
+
+    // Convergent key, id and object name (the id in hex) of a chunk of this
+    // tenant, from its SHA-256 (32 bytes)
+    static Key chunkKey(const Key& masterKey, const std::string& tenant, const std::uint8_t* digest);
+    static ChunkId chunkId(const Key& masterKey, const std::string& tenant, const std::uint8_t* digest);
+    static std::string chunkName(const Key& masterKey, const std::string& tenant, const std::uint8_t* digest);
+
+    // random nonce || ciphertext || tag
+    static bool sealBlob(const Key& key, const std::string& aad, const std::string& plain, std::string& out);
+    static bool openBlob(const Key& key, const std::string& aad, const std::string& sealed, std::string& out);
+
+    // The CPU has AES-NI (x86-64 only, false elsewhere)
+    static bool hardwareAccelerated();
+
+private:
+    std::string aad(std::uint64_t index, bool final) const;
+
+    Key key_;
+    std::string streamId_;
+    EVP_CIPHER_CTX* encrypt_ = nullptr;
+    EVP_CIPHER_CTX* decrypt_ = nullptr;
+};
+
+#endif //SECURE_CLOUD_CHUNKCIPHER_H
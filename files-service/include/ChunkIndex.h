@@ -0,0 +1,92 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_CHUNKINDEX_H
+#define SECURE_CLOUD_CHUNKINDEX_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+// Chunks already in the store, by chunk id (ChunkCipher::chunkId: keyed by
+// tenant, so one tenant never finds another's chunks): on disk, mmapped,
+// with a Bloom filter in memory in front of it.
+//
+// File FILES_DATA_DIR/chunks.idx: a 4 KiB header, then an open addressing
+// table (linear probing) of 40-byte slots: chunk id, chunk size, references.
+// Size 0 marks a free slot. Over 70% load the table is rebuilt at twice
+// the size in a new file, renamed over the old one.
+//
+// The Bloom filter (at least 14 bits per entry, 7 probes from the digest
+// words) is rebuilt from the table at startup: a chunk never seen before
+// is answered without touching the table, so without a page fault.
+//
+// The index only says what the store has: an entry is added once the
+// chunk is stored, and a missing or damaged file is started over empty
+// (the next uploads send their chunks again). Shared by the IO loops.
+class ChunkIndex {
+public:
+    using Digest = std::array<std::uint8_t, 32>;
+
+    struct Stats {
+        std::uint64_t lookups;
+        std::uint64_t bloomNegatives;   // answered by the filter alone
+        std::uint64_t hits;
+        std::size_t entries;
+        std::size_t capacity;
+    };
+
+    static ChunkIndex& instance();
+
+    bool contains(const Digest& digest);
+    // New entry, or one more reference to an existing one
+    void add(const Digest& digest, std::uint32_t size);
+
+    Stats stats() const;
+
+    ~ChunkIndex();
+    ChunkIndex(const ChunkIndex&) = delete;
+    ChunkIndex& operator=(const ChunkIndex&) = delete;
+
+private:
+    ChunkIndex();
+
+    struct Header;
+    struct Slot {
+        Digest digest;
+        std::uint32_t size;             // 0 = free
+        std::uint32_t refs;
+    };
+
+    bool open(const std::string& path, std::size_t capacity);
+    bool map(int fd, std::size_t capacity, bool create);
+    void unmap();
+    bool grow();
+
+    Slot* find(const Digest& digest) const;
+    void bloomAdd(const Digest& digest);
+    bool bloomMayContain(const Digest& digest) const;
+    void rebuildBloom();
+
+    std::string path_;
+    int fd_ = -1;
+    Header* header_ = nullptr;
+    Slot* slots_ = nullptr;
+    std::size_t capacity_ = 0;          // slots, power of two
+    std::size_t mappedBytes_ = 0;
+
+    std::vector<std::uint64_t> bloom_;
+    std::uint64_t bloomBits_ = 0;
+
+    mutable std::shared_mutex mutex_;
+    mutable std::atomic<std::uint64_t> lookups_{0};
+    mutable std::atomic<std::uint64_t> bloomNegatives_{0};
+    mutable std::atomic<std::uint64_t> hits_{0};
+};
+
+#endif //SECURE_CLOUD_CHUNKINDEX_H
@@ -0,0 +1,54 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_CONTENTCHUNKER_H
+#define SECURE_CLOUD_CONTENTCHUNKER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Content-defined chunking (FastCDC): cut points come from a Gear rolling
+// hash over the data, not from offsets, so an insertion early in a file
+// only changes the chunks around it and the rest still deduplicates.
+//
+// Per chunk: no cut before minSize, a strict mask (more bits) up to
+// avgSize and a loose one after ("normalized chunking", which keeps sizes
+// close to avgSize), a forced cut at maxSize. The hash restarts at each
+// chunk. The Gear table and the masks are part of the storage format:
+// changing them moves every cut point, and with them the deduplication.
+//
+// Streaming: feed() buffers at most maxSize bytes and emits every chunk
+// whose end is known; finish() emits the rest.
+class ContentChunker {
+public:
+    struct Params {
+        std::size_t minSize;
+        std::size_t avgSize;
+        std::size_t maxSize;
+    };
+
+    // A chunk, valid during the call only
+    using Emit = std::function<void(const char* data, std::size_t size)>;
+
+    explicit ContentChunker(const Params& params);
+
+    void feed(const char* data, std::size_t size, const Emit& emit);
+    void finish(const Emit& emit);
+
+    // Length of the first chunk of data (size when no cut point before it)
+    std::size_t cut(const std::uint8_t* data, std::size_t size) const;
+
+private:
+    Params params_;
+    std::uint64_t maskStrict_;
+    std::uint64_t maskLoose_;
+    std::string buffer_;            // the chunk being cut
+    std::size_t pos_ = 0;           // scanned up to here
+    std::uint64_t fp_ = 0;          // hash at pos_
+};
+
+#endif //SECURE_CLOUD_CONTENTCHUNKER_H
@@ -0,0 +1,29 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_CRC32C_H
+#define SECURE_CLOUD_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// CRC-32C (Castagnoli), the checksum S3 stores with an object when asked
+// to (x-amz-checksum-crc32c).
+//
+// Computed with the SSE4.2 crc32 instruction, three independent streams
+// interleaved to hide its latency, when the CPU has it (checked once at
+// runtime); table driven otherwise.
+class Crc32c {
+public:
+    // crc: the value for the bytes before, to continue a computation
+    static std::uint32_t compute(const char* data, std::size_t size, std::uint32_t crc = 0);
+
+    // Big endian, base64: the form of the x-amz-checksum-crc32c header
+    static std::string toBase64(std::uint32_t crc);
+
+    static bool hardwareAccelerated();
+};
+
+#endif //SECURE_CLOUD_CRC32C_H
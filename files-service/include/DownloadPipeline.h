@@ -0,0 +1,72 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_DOWNLOADPIPELINE_H
+#define SECURE_CLOUD_DOWNLOADPIPELINE_H
+
+#include "FileManifest.h"
+#include "FilesConfig.h"
+#include "S3Client.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+// One download from the store: the chunks of a file that overlap the
+// requested byte range are fetched, checked (CRC-32C, S3Client), opened
+// (convergent key, ChunkCipher) and sliced.
+//
+// Up to FILES_DOWNLOAD_CONCURRENCY chunks are fetched at once, each on the
+// next connection of the pool, so a large file is not held to the window
+// of one TCP stream. They complete in any order and go to the sink in file
+// order: memory is at most that many chunks per download, whatever the
+// range.
+//
+// Runs on the IO loop of the request, like UploadPipeline.
+class DownloadPipeline : public std::enable_shared_from_this<DownloadPipeline> {
+public:
+    using Manifest = std::shared_ptr<const FileManifest>;
+    // status 200 with the manifest, else 404 (no such file), 502 (store) or 500
+    using ManifestCallback = std::function<void(int status, Manifest manifest)>;
+    // Receives the plaintext in order; false when the client is gone
+    using Sink = std::function<bool(std::string&& data)>;
+    // complete: the whole range went to the sink
+    using Done = std::function<void(bool complete)>;
+
+    static void loadManifest(const std::string& id, ManifestCallback cb);
+
+    // Bytes [offset, offset + length) of the file; done runs exactly once
+    static void start(Manifest manifest, std::uint64_t offset, std::uint64_t length, Sink sink, Done done);
+
+    DownloadPipeline(const DownloadPipeline&) = delete;
+    DownloadPipeline& operator=(const DownloadPipeline&) = delete;
+
+private:
+    DownloadPipeline(Manifest manifest, std::uint64_t offset, std::uint64_t length, Sink sink, Done done);
+
+    void pump();
+    void onChunk(std::size_t index, std::uint64_t start, const S3Client::Response& r);
+    void finish(bool complete);
+
+    const FilesConfig& config_;
+    S3Client& s3_;
+
+    Manifest manifest_;
+    std::uint64_t begin_;               // range, in the file
+    std::uint64_t end_;
+
+    std::size_t nextFetch_ = 0;         // next chunk to fetch
+    std::uint64_t fetchStart_ = 0;      // its offset in the file
+    std::size_t nextDeliver_ = 0;       // next chunk for the sink
+    std::size_t inFlight_ = 0;
+    std::map<std::size_t, std::string> ready_;  // sliced, waiting for the ones before
+
+    Sink sink_;
+    Done done_;
+};
+
+#endif //SECURE_CLOUD_DOWNLOADPIPELINE_H
@@ -0,0 +1,123 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_FILECACHE_H
+#define SECURE_CLOUD_FILECACHE_H
+
+#include "FileManifest.h"
+#include "FrequencySketch.h"
+
+#include <trantor/net/EventLoop.h>
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Plaintext copies of stored files on local disk, FILES_CACHE_DIR/<id>:
+// a bounded read-through cache in front of the store.
+//
+// A file with a local copy is served from it by Drogon's file response
+// (sendfile), ranges included, instead of being fetched, decrypted and
+// copied through userspace again. On a miss the whole file is fetched
+// once into a temp file of the directory and renamed in when complete,
+// however many requests missed it meanwhile (they all wait for that one
+// fill). Copies only ever appear complete, and files never change once
+// stored, so a copy never goes stale.
+//
+// Size-bounded (FILES_CACHE_MAX_BYTES), least recently used copies go
+// first. A miss is only filled if the file was asked for more often lately
+// than the copy it would evict (TinyLFU admission, FrequencySketch): a
+// burst of one-off downloads does not flush the popular attachments. The
+// index lives in memory, rebuilt from the directory at startup, shared by
+// the IO loops.
+//
+// A copy being served is pinned (Lease): evicting it only drops it from
+// the index, the file goes with the last lease, so a response that has
+// not opened it yet still finds it. The controller keeps the lease in the
+// attributes of the request, which Drogon holds until the response is
+// written (the file open), however long it waits behind pipelined ones.
+//
+// The directory should sit on an encrypted volume: unlike the store, it
+// holds plaintext.
+class FileCache {
+public:
+    struct Stats {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t fills;            // fetched from the store
+        std::uint64_t coalesced;        // misses that waited for another's fill
+        std::uint64_t rejected;         // not admitted, or too large
+        std::uint64_t evictions;
+        std::size_t entries;
+        std::uint64_t bytes;
+    };
+    using Manifest = std::shared_ptr<const FileManifest>;
+    // Path of a copy, pinned until the last reference is gone
+    using Lease = std::shared_ptr<const std::string>;
+    // The copy, null when the file is to be served from the store
+    using FillCallback = std::function<void(Lease copy)>;
+
+    static FileCache& instance();
+
+    bool enabled() const { return !dir_.empty(); }
+
+    // The copy of a file, null when there is none of that size
+    Lease lookup(const std::string& fileId, std::uint64_t size);
+    // After a miss: copies the file from the store if admitted. cb runs on
+    // the loop of the caller, once the copy is there or not to be
+    void fill(Manifest manifest, FillCallback cb);
+    // Moves a complete plaintext file in as the copy of fileId
+    bool adopt(const std::string& fileId, const std::string& path, std::uint64_t size);
+
+    Stats stats() const;
+
+    FileCache(const FileCache&) = delete;
+    FileCache& operator=(const FileCache&) = delete;
+
+private:
+    FileCache();
+
+    struct Entry {
+        std::uint64_t size;
+        std::list<std::string>::iterator lru;
+    };
+    struct Waiter {
+        trantor::EventLoop* loop;
+        FillCallback cb;
+    };
+
+    void load();
+    void startFill(const Manifest& manifest);
+    void endFill(const std::string& fileId, std::uint64_t size, const std::string& tmpPath, bool complete);
+    std::string pathOf(const std::string& fileId) const;
+    void unpin(const std::string& fileId);
+
+    // With mutex_ held
+    bool admit(const std::string& fileId, std::uint64_t size) const;
+    void insert(const std::string& fileId, std::uint64_t size, std::vector<std::string>& evicted);
+    Lease pin(const std::string& fileId);
+
+    std::string dir_;
+    std::uint64_t maxBytes_ = 0;
+    std::uint64_t maxObjectBytes_ = 0;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::list<std::string> lru_;                            // most recent first
+    std::unordered_map<std::string, std::vector<Waiter>> fills_;
+    std::unordered_map<std::string, unsigned> pins_;        // leases per file
+    std::unordered_set<std::string> doomed_;                // evicted while pinned
+    FrequencySketch sketch_;
+    std::uint64_t bytes_ = 0;
+    std::uint64_t reserved_ = 0;                            // fills under way
+    Stats stats_{};
+};
+
+#endif //SECURE_CLOUD_FILECACHE_H
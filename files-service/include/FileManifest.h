@@ -0,0 +1,44 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_FILEMANIFEST_H
+#define SECURE_CLOUD_FILEMANIFEST_H
+
+#include "ChunkIndex.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What a stored file is made of: its metadata and its chunks, in order.
+//
+// Kept in the store as "files/<id>", sealed under the master key (AAD: the
+// id). The chunks themselves are shared: "chunks/<ChunkCipher::chunkName>".
+//
+// Binary layout, little endian: "FMF2", name, content type and owner (u32
+// length + bytes each), size (u64), creation time (i64, unix seconds),
+// chunk count (u32), then per chunk its SHA-256 (32 bytes) and size (u32).
+// The owner (auth user id) is also the tenant its chunks are keyed for.
+struct FileManifest {
+    struct ChunkRef {
+        ChunkIndex::Digest digest;
+        std::uint32_t size;
+    };
+
+    std::string id;
+    std::string name;
+    std::string contentType;
+    std::string owner;
+    std::uint64_t size = 0;
+    std::int64_t createdAt = 0;
+    std::vector<ChunkRef> chunks;
+
+    std::string serialize() const;
+    static bool parse(const std::string& data, FileManifest& out);
+
+    static std::string objectKey(const std::string& id);
+    static std::string chunkObjectKey(const std::string& chunkName);
+};
+
+#endif //SECURE_CLOUD_FILEMANIFEST_H
@@ -0,0 +1,77 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_FILESCONFIG_H
+#define SECURE_CLOUD_FILESCONFIG_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Settings of files-service, read once from the environment.
+//
+//  - PORT                     : default 8082
+//  - MINIO_ENDPOINT           : host:port or URL of the S3 API (default minio:9000)
+//  - MINIO_ACCESS_KEY, MINIO_SECRET_KEY
+//  - MINIO_BUCKET             : default "files", created at startup if missing
+//  - MINIO_REGION             : SigV4 region (default us-east-1)
+//  - FILES_MASTER_KEY         : 64 hex chars, keys the chunk and manifest
+//                               encryption; uploads are refused while it is missing
+//  - FILES_CDC_MIN_SIZE       : content-defined chunks, smallest (default 256 KiB)
+//  - FILES_CDC_AVG_SIZE       : target size, rounded to a power of two (default 1 MiB)
+//  - FILES_CDC_MAX_SIZE       : largest (default 4 MiB, at most 64 MiB)
+//  - FILES_MAX_INFLIGHT_CHUNKS: new chunks being sent per upload (default 2)
+//  - FILES_MAX_QUEUED_CHUNKS  : sealed chunks waiting in memory per upload
+//                               (default 2; the next ones go to the spool file)
+//  - FILES_DOWNLOAD_CONCURRENCY: chunks fetched at once per download (default 4)
+//  - FILES_DATA_DIR           : chunk index and upload sessions (default /var/lib/files)
+//  - FILES_CACHE_DIR          : plaintext copies served with sendfile
+//                               (default FILES_DATA_DIR/cache, "off" disables)
+//  - FILES_CACHE_MAX_BYTES    : size of the local copies, evicted beyond (default 10 GiB)
+//  - FILES_CACHE_MAX_OBJECT_BYTES: larger files are never copied (default 256 MiB)
+//  - FILES_UPLOAD_EXPIRY_HOURS: resumable upload sessions lifetime (default 24)
+//  - FILES_INDEX_CAPACITY     : initial slots of the chunk index (default 1M)
+//  - FILES_SPOOL_DIR          : default /tmp
+//  - FILES_MAX_UPLOAD_BYTES   : default 10 GiB
+//  - FILES_S3_CONNECTIONS     : connections to the store per IO loop (default 4)
+//  - AUTH_SERVICE_URL         : checks the bearer tokens (default http://auth-service:8080)
+//  - FILES_AUTH_CACHE_SECONDS : accepted tokens remembered (default 60, 0 disables)
+//  - FILES_AUTH_CACHE_SIZE    : at most that many of them (default 10000)
+struct FilesConfig {
+    std::uint16_t port = 8082;
+
+    std::string s3Endpoint = "http://minio:9000";
+    std::string s3AccessKey;
+    std::string s3SecretKey;
+    std::string s3Bucket = "files";
+    std::string s3Region = "us-east-1";
+    std::size_t s3Connections = 4;
+
+    std::string authServiceUrl = "http://auth-service:8080";
+    std::uint32_t authCacheSeconds = 60;
+    std::size_t authCacheSize = 10000;
+
+    bool hasMasterKey = false;
+    std::array<std::uint8_t, 32> masterKey{};
+
+    std::size_t cdcMinSize = 256u << 10;
+    std::size_t cdcAvgSize = 1u << 20;
+    std::size_t cdcMaxSize = 4u << 20;
+    std::size_t maxInFlightChunks = 2;
+    std::size_t maxQueuedChunks = 2;
+    std::size_t downloadConcurrency = 4;
+    std::string dataDir = "/var/lib/files";
+    std::string cacheDir;               // empty: no local copies
+    std::uint64_t cacheMaxBytes = 10ull << 30;
+    std::uint64_t cacheMaxObjectBytes = 256ull << 20;
+    std::uint32_t uploadExpiryHours = 24;
+    std::size_t indexCapacity = 1u << 20;
+    std::string spoolDir = "/tmp";
+    std::uint64_t maxUploadBytes = 10ull << 30;
+
+    static const FilesConfig& instance();
+};
+
+#endif //SECURE_CLOUD_FILESCONFIG_H
@@ -0,0 +1,64 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_FILESCONTROLLER_H
+#define SECURE_CLOUD_FILESCONTROLLER_H
+
+#pragma once
+#include <drogon/HttpController.h>
+#include <drogon/RequestStream.h>
+#include <drogon/drogon.h>
+
+class FilesController final
+    : public drogon::HttpController<FilesController> {
+public:
+    METHOD_LIST_BEGIN
+    // Every route but OPTIONS takes "Authorization: Bearer <Supabase access token>" (AuthClient)
+
+    // POST /files?name= (raw body, streamed) → chunked, deduplicated per user, encrypted into MinIO, 201 {"id", ...}
+    ADD_METHOD_TO(FilesController::upload, "/files", drogon::Post);
+    // GET /files/{id} (Range, If-Range, If-None-Match) → the file of its owner, from the local copy when there is one
+    ADD_METHOD_TO(FilesController::download, "/files/{1}", drogon::Get);
+
+    // Resumable uploads, tus 1.0 (creation, termination, expiration); a session is
+    // only visible to the user who created it
+    ADD_METHOD_TO(FilesController::uploadOptions, "/uploads", drogon::Options);
+    // POST /uploads (Upload-Length, Upload-Metadata: filename, filetype) → 201, Location /uploads/{id}
+    ADD_METHOD_TO(FilesController::createUpload, "/uploads", drogon::Post);
+    // HEAD /uploads/{id} → Upload-Offset (and X-File-Id once stored)
+    ADD_METHOD_TO(FilesController::uploadStatus, "/uploads/{1}", drogon::Head);
+    // PATCH /uploads/{id} (Upload-Offset, streamed) → 204; the last one stores the file
+    ADD_METHOD_TO(FilesController::appendUpload, "/uploads/{1}", drogon::Patch);
+    ADD_METHOD_TO(FilesController::deleteUpload, "/uploads/{1}", drogon::Delete);
+    METHOD_LIST_END
+
+    void upload(const drogon::HttpRequestPtr& req,
+                drogon::RequestStreamPtr&& stream,
+                std::function<void (const drogon::HttpResponsePtr &)> &&cb) const;
+
+    void download(const drogon::HttpRequestPtr& req,
+                  std::function<void (const drogon::HttpResponsePtr &)> &&cb,
+                  std::string id) const;
+
+    void uploadOptions(const drogon::HttpRequestPtr& req,
+                       std::function<void (const drogon::HttpResponsePtr &)> &&cb) const;
+
+    void createUpload(const drogon::HttpRequestPtr& req,
+                      std::function<void (const drogon::HttpResponsePtr &)> &&cb) const;
+
+    void uploadStatus(const drogon::HttpRequestPtr& req,
+                      std::function<void (const drogon::HttpResponsePtr &)> &&cb,
+                      std::string id) const;
+
+    void appendUpload(const drogon::HttpRequestPtr& req,
+                      drogon::RequestStreamPtr&& stream,
+                      std::function<void (const drogon::HttpResponsePtr &)> &&cb,
+                      std::string id) const;
+
+    void deleteUpload(const drogon::HttpRequestPtr& req,
+                      std::function<void (const drogon::HttpResponsePtr &)> &&cb,
+                      std::string id) const;
+};
+
+#endif //SECURE_CLOUD_FILESCONTROLLER_H
@@ -0,0 +1,39 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_FREQUENCYSKETCH_H
+#define SECURE_CLOUD_FREQUENCYSKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// How often a key was seen lately, approximately (TinyLFU): a count-min
+// sketch of 4 rows of counters saturating at 15, the estimate being the
+// smallest of the 4. Every 10 x width increments all the counters are
+// halved, so old popularity fades.
+//
+// 4 bytes per counted key, whatever the keys; not thread-safe (the owner locks).
+class FrequencySketch {
+public:
+    // keys: about how many distinct keys matter at a time
+    explicit FrequencySketch(std::size_t keys);
+
+    void increment(std::uint64_t hash);
+    std::uint32_t estimate(std::uint64_t hash) const;
+
+private:
+    std::size_t slot(std::uint64_t hash, unsigned row) const;
+    void halve();
+
+    static constexpr unsigned kRows = 4;
+    static constexpr std::uint8_t kMaxCount = 15;
+
+    std::vector<std::uint8_t> counters_;    // kRows rows of width_
+    std::size_t width_ = 0;                 // power of two
+    std::size_t additions_ = 0;
+    std::size_t sampleSize_ = 0;
+};
+
+#endif //SECURE_CLOUD_FREQUENCYSKETCH_H
@@ -0,0 +1,93 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_S3CLIENT_H
+#define SECURE_CLOUD_S3CLIENT_H
+
+#include <drogon/HttpClient.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Asynchronous client of the S3 API of MinIO (any S3-compatible store),
+// limited to what files-service needs: bucket creation, object puts and
+// gets, multipart uploads. Path-style URLs, AWS Signature V4.
+//
+// Requests go through a small pool of Drogon HttpClients per IO loop
+// (FILES_S3_CONNECTIONS), so the parts of one upload travel in parallel and
+// callbacks run back on the loop that sent the request.
+//
+// Object and part bodies are sent as UNSIGNED-PAYLOAD: hashing them again
+// would cost a pass over the data, and each one already carries its GCM tag.
+// Objects are put with their CRC-32C (Crc32c, SSE4.2), which the store
+// checks on receipt and returns with the object: a get whose body does not
+// match fails with "ChecksumMismatch", before anything is decrypted.
+class S3Client {
+public:
+    struct Response {
+        bool ok = false;        // 2xx (and no <Error> document for CompleteMultipartUpload)
+        int status = 0;         // 0: network failure or timeout
+        std::string body;
+        std::string etag;
+        std::string checksum;   // x-amz-checksum-crc32c, when the store has one
+        std::string error;      // short reason when !ok
+    };
+    using Callback = std::function<void(const Response&)>;
+    // x-amz-meta-<name>: value (ASCII values only)
+    using Metadata = std::vector<std::pair<std::string, std::string>>;
+
+    struct Credentials {
+        std::string accessKey;
+        std::string secretKey;
+        std::string region;
+    };
+
+    static S3Client& instance();
+
+    void createBucket(Callback cb);
+    void putObject(const std::string& key, std::string&& body, Callback cb);
+    // Object in the body, its checksum verified; status 404 (error "NoSuchKey") when missing
+    void getObject(const std::string& key, Callback cb);
+    // The upload id is xmlValue(body, "UploadId")
+    void createMultipartUpload(const std::string& key, const Metadata& metadata, Callback cb);
+    void uploadPart(const std::string& key, const std::string& uploadId, int partNumber,
+                    std::string&& body, Callback cb);
+    // etags[i] is the ETag of part i + 1
+    void completeMultipartUpload(const std::string& key, const std::string& uploadId,
+                                 const std::vector<std::string>& etags, Callback cb);
+    void abortMultipartUpload(const std::string& key, const std::string& uploadId, Callback cb);
+
+    // Text of the first <tag> element of a response document, empty if none
+    static std::string xmlValue(const std::string& xml, const std::string& tag);
+
+    // SigV4 Authorization header. headers: lower-case names, every one of them signed
+    static std::string authorization(const Credentials& credentials, const std::string& method,
+                                     const std::string& canonicalUri, const std::string& canonicalQuery,
+                                     const std::map<std::string, std::string>& headers,
+                                     const std::string& payloadHash, const std::string& amzDate);
+
+    S3Client(const S3Client&) = delete;
+    S3Client& operator=(const S3Client&) = delete;
+
+private:
+    S3Client();
+
+    // query: canonical form (sorted, encoded), also sent as is.
+    // extraHeaders: lower-case names, signed with the others
+    void send(drogon::HttpMethod method, const std::string& key, const std::string& query,
+              const Metadata& extraHeaders, std::string&& body, bool signBody, Callback cb);
+
+    drogon::HttpClientPtr client();
+
+    std::string endpoint_;
+    std::string host_;          // Host header, as signed
+    std::string bucket_;
+    Credentials credentials_;
+    std::size_t connections_ = 4;
+};
+
+#endif //SECURE_CLOUD_S3CLIENT_H
@@ -0,0 +1,139 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_UPLOADPIPELINE_H
+#define SECURE_CLOUD_UPLOADPIPELINE_H
+
+#include "ChunkIndex.h"
+#include "ContentChunker.h"
+#include "FileManifest.h"
+#include "FilesConfig.h"
+#include "S3Client.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_set>
+
+// One streamed upload: request body -> content-defined chunks -> the new
+// ones sealed and stored -> the file manifest, as the bytes arrive.
+//
+// Each chunk (ContentChunker) is hashed (SHA-256) and its id for the owner
+// of the file (ChunkCipher::chunkId) looked up in the ChunkIndex: a chunk
+// the store already has for that tenant, or one this upload already sends,
+// is only referenced by the manifest. The others are sealed with their
+// convergent key (ChunkCipher) and put as "chunks/<name>". Once they
+// are all stored the manifest is sealed and put as "files/<id>", and its
+// chunks are added to the index (one more reference each).
+//
+// Memory: the chunk being cut, FILES_MAX_QUEUED_CHUNKS sealed chunks and
+// FILES_MAX_INFLIGHT_CHUNKS chunks being sent, whatever the file size.
+// Drogon cannot pause a request stream, so when the store is slower than
+// the client the next sealed chunks go to an unlinked spool file
+// (FILES_SPOOL_DIR) and are sent from there.
+//
+// A finished resumable upload is stored the same way from its data file
+// (startFromFile): read as the store takes the chunks, so without spooling.
+//
+// Everything runs on the IO loop of the request (body callbacks and store
+// callbacks alike): no locking. On failure the chunks already stored stay
+// (unreferenced, the next upload of the same content finds them again).
+//
+// How much deduplication saves is only counted process-wide (stats(), on
+// /health), never reported to the client: whether a chunk was new would
+// tell it what its tenant already stored.
+class UploadPipeline : public std::enable_shared_from_this<UploadPipeline> {
+public:
+    struct Outcome {
+        int status = 0;                 // HTTP status for the client
+        std::string error;              // when status is not 201
+        std::string id;
+        std::string name;
+        std::uint64_t size = 0;         // plaintext bytes
+        std::size_t chunks = 0;
+    };
+    using Done = std::function<void(const Outcome&)>;
+
+    // Stored uploads since startup
+    struct Stats {
+        std::uint64_t uploads;
+        std::uint64_t chunks;
+        std::uint64_t newChunks;        // sent to the store
+        std::uint64_t bytes;
+        std::uint64_t deduplicatedBytes;
+    };
+
+    // done runs exactly once; owner: auth user id, the tenant of the chunks
+    static std::shared_ptr<UploadPipeline> start(std::string name, std::string contentType,
+                                                 std::string owner, Done done);
+    // Same, from a complete file on local disk instead of a request body
+    static std::shared_ptr<UploadPipeline> startFromFile(const std::string& path, std::string name,
+                                                         std::string contentType, std::string owner, Done done);
+
+    static Stats stats();
+
+    ~UploadPipeline();
+
+    void onData(const char* data, std::size_t size);
+    // complete: the whole body was received (false: client gone, stream error)
+    void onFinish(bool complete);
+
+    UploadPipeline(const UploadPipeline&) = delete;
+    UploadPipeline& operator=(const UploadPipeline&) = delete;
+
+private:
+    UploadPipeline(std::string name, std::string contentType, std::string owner, Done done);
+
+    struct Chunk {
+        std::string object;             // store key
+        std::string data;               // sealed
+    };
+
+    struct SpilledChunk {
+        std::string object;
+        std::uint64_t offset;
+        std::size_t size;
+    };
+
+    void begin();
+    void onChunk(const char* data, std::size_t size);
+    bool spill(Chunk&& chunk);
+    bool unspill(Chunk& chunk);
+    void pump();
+    void pull();
+    void maybeComplete();
+    void fail(int status, const std::string& error);
+    void finish(const Outcome& outcome);
+
+    const FilesConfig& config_;
+    S3Client& s3_;
+    ChunkIndex& index_;
+
+    ContentChunker chunker_;
+    FileManifest manifest_;
+    std::uint64_t received_ = 0;
+
+    std::unordered_set<std::string> sent_;  // chunk objects of this upload
+    std::size_t newChunks_ = 0;
+    std::uint64_t deduplicatedBytes_ = 0;
+
+    std::deque<Chunk> queued_;
+    std::deque<SpilledChunk> spilled_;
+    int spoolFd_ = -1;
+    std::uint64_t spoolEnd_ = 0;
+    std::size_t inFlight_ = 0;
+
+    int sourceFd_ = -1;                 // startFromFile: file being read
+    bool pullScheduled_ = false;
+
+    bool finished_ = false;             // body received, last chunk cut
+    bool completing_ = false;
+    bool failed_ = false;
+    Done done_;
+};
+
+#endif //SECURE_CLOUD_UPLOADPIPELINE_H
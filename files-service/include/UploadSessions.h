@@ -0,0 +1,73 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_UPLOADSESSIONS_H
+#define SECURE_CLOUD_UPLOADSESSIONS_H
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_set>
+
+// Resumable upload sessions (tus 1.0: creation, termination, expiration),
+// persisted under FILES_DATA_DIR/uploads/<id>/:
+//  - info: length, creation time, name, content type, owner and, once
+//          stored, the id of the file (written to a temp file, synced, renamed);
+//  - data: the bytes received so far. Its size is the upload offset, so
+//          a restart, a dropped connection or a crash loses at most what
+//          was not yet on disk, and the client resumes from HEAD.
+//
+// A session id is 128 random bits and belongs to the auth user who created
+// it: the controller only lets that user see, write or delete it. One PATCH
+// at a time per session (lock / unlock). Sessions older
+// than FILES_UPLOAD_EXPIRY_HOURS are removed by expire().
+class UploadSessions {
+public:
+    struct Info {
+        std::string id;
+        std::uint64_t length = 0;
+        std::int64_t createdAt = 0;     // unix seconds
+        std::string name;
+        std::string contentType;
+        std::string owner;              // auth user id of the creator
+        std::string fileId;             // set once the file is stored
+    };
+
+    static UploadSessions& instance();
+
+    std::optional<Info> create(std::uint64_t length, const std::string& name, const std::string& contentType,
+                               const std::string& owner);
+    std::optional<Info> find(const std::string& id) const;
+    bool setFileId(const std::string& id, const std::string& fileId);
+    void remove(const std::string& id);
+
+    std::string dataPath(const std::string& id) const;
+    // Bytes received; the whole length once stored (the data file is gone then)
+    std::uint64_t offset(const Info& info) const;
+    std::int64_t expiresAt(const Info& info) const;
+
+    // False when another request holds the session
+    bool lock(const std::string& id);
+    void unlock(const std::string& id);
+
+    void expire();
+
+    UploadSessions(const UploadSessions&) = delete;
+    UploadSessions& operator=(const UploadSessions&) = delete;
+
+private:
+    UploadSessions();
+
+    std::string dirOf(const std::string& id) const;
+    bool writeInfo(const Info& info) const;
+
+    std::string root_;
+    std::int64_t expirySeconds_ = 0;
+
+    std::mutex lockedMutex_;
+    std::unordered_set<std::string> locked_;
+};
+
+#endif //SECURE_CLOUD_UPLOADSESSIONS_H
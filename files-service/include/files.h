@@ -6,6 +6,10 @@
 #define MESSAGING_SERVICE_FILES_H
 
 
+// HTTP server of files-service (FilesConfig): POST /files, GET /files/{id},
+// resumable uploads under /uploads (tus 1.0), GET /health.
+// Creates the bucket at startup, expires stale upload sessions every hour,
+// then runs Drogon until shutdown.
 class FilesService {
     public:
     static void run();
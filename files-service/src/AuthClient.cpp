@@ -0,0 +1,118 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/AuthClient.h"
+#include "../include/FilesConfig.h"
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/Logger.h>
+
+#include <openssl/sha.h>
+
+using namespace drogon;
+
+namespace {
+
+constexpr double kRequestTimeoutSeconds = 10.0;
+
+std::string tokenKey(const std::string& token) {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(token.data()), token.size(), digest);
+    return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+} // namespace
+
+AuthClient& AuthClient::instance() {
+    static AuthClient client;
+    return client;
+}
+
+AuthClient::AuthClient() {
+    const auto& config = FilesConfig::instance();
+    endpoint_ = config.authServiceUrl;
+    ttl_ = std::chrono::seconds(config.authCacheSeconds);
+    capacity_ = config.authCacheSize;
+}
+
+std::string AuthClient::bearerToken(const HttpRequestPtr& req) {
+    const auto& h = req->getHeader("authorization");
+    if (h.rfind("Bearer ", 0) == 0) return h.substr(7);
+    return {};
+}
+
+HttpClientPtr AuthClient::client() {
+    // A client belongs to the loop it was created on
+    thread_local HttpClientPtr client;
+    if (!client) client = HttpClient::newHttpClient(endpoint_, trantor::EventLoop::getEventLoopOfCurrentThread());
+    return client;
+}
+
+void AuthClient::verify(const std::string& token, Callback cb) {
+    if (token.empty()) return cb(401, {});
+
+    auto key = tokenKey(token);
+    std::string userId;
+    if (lookup(key, userId)) return cb(200, userId);
+
+    auto req = HttpRequest::newHttpRequest();
+    req->setMethod(Get);
+    req->setPath("/auth/user");
+    req->addHeader("Authorization", "Bearer " + token);
+
+    client()->sendRequest(req, [this, key = std::move(key), cb = std::move(cb)](ReqResult result, const HttpResponsePtr& resp) {
+        if (result != ReqResult::Ok || !resp) {
+            LOG_ERROR << "auth-service unreachable: " << (result == ReqResult::Timeout ? "timeout" : "network failure");
+            return cb(502, {});
+        }
+        const int status = static_cast<int>(resp->statusCode());
+        if (status == 401 || status == 403) return cb(401, {});
+        if (status != 200) {
+            LOG_ERROR << "auth-service answered " << status << " to /auth/user";
+            return cb(502, {});
+        }
+
+        const auto json = resp->getJsonObject();
+        if (!json || !json->isMember("id") || !(*json)["id"].isString() || (*json)["id"].asString().empty()) {
+            LOG_ERROR << "Cannot extract user id from the auth-service response";
+            return cb(502, {});
+        }
+        const auto userId = (*json)["id"].asString();
+        store(key, userId);
+        cb(200, userId);
+    }, kRequestTimeoutSeconds);
+}
+
+bool AuthClient::lookup(const std::string& key, std::string& userId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = index_.find(key);
+    if (it == index_.end()) return false;
+    if (std::chrono::steady_clock::now() >= it->second->expiresAt) {
+        lru_.erase(it->second);
+        index_.erase(it);
+        return false;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    userId = it->second->userId;
+    return true;
+}
+
+void AuthClient::store(const std::string& key, const std::string& userId) {
+    if (ttl_.count() <= 0 || capacity_ == 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto expiresAt = std::chrono::steady_clock::now() + ttl_;
+    if (const auto it = index_.find(key); it != index_.end()) {
+        it->second->userId = userId;
+        it->second->expiresAt = expiresAt;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return;
+    }
+    lru_.push_front(Entry{key, userId, expiresAt});
+    index_[key] = lru_.begin();
+    while (lru_.size() > capacity_) {
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+    }
+}
@@ -0,0 +1,190 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/ChunkCipher.h"
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#include <climits>
+#include <cstring>
+
+namespace {
+
+void putBigEndian(std::uint64_t v, unsigned char* out) {
+    for (int i = 7; i >= 0; --i) {
+        out[i] = static_cast<unsigned char>(v & 0xff);
+        v >>= 8;
+    }
+}
+
+std::string toHex(const unsigned char* data, std::size_t size) {
+    static const char* digits = "0123456789abcdef";
+    std::string out(size * 2, '0');
+    for (std::size_t i = 0; i < size; ++i) {
+        out[2 * i] = digits[data[i] >> 4];
+        out[2 * i + 1] = digits[data[i] & 0x0f];
+    }
+    return out;
+}
+
+// HMAC-SHA256(master, tenant || label || digest)
+void keyed(const ChunkCipher::Key& masterKey, const std::string& tenant, const char* label,
+           const std::uint8_t* digest, unsigned char out[32]) {
+    std::string input = tenant;
+    input += label;
+    input.append(reinterpret_cast<const char*>(digest), 32);
+    unsigned int size = 0;
+    HMAC(EVP_sha256(), masterKey.data(), static_cast<int>(masterKey.size()),
+         reinterpret_cast<const unsigned char*>(input.data()), input.size(), out, &size);
+}
+
+// ---------- Helper 1 : one GCM pass on a context already keyed ----------
+// Appends ciphertext || tag (encrypt) or the plaintext (decrypt, size includes the tag)
+bool gcm(EVP_CIPHER_CTX* ctx, bool encrypt, const unsigned char* nonce,
+         const std::string& aad, const char* data, std::size_t size, std::string& out) {
+    if (!encrypt && size < ChunkCipher::kTagSize) return false;
+    const std::size_t body = encrypt ? size : size - ChunkCipher::kTagSize;
+    if (body > static_cast<std::size_t>(INT_MAX)) return false;
+
+    if (EVP_CipherInit_ex(ctx, nullptr, nullptr, nullptr, nonce, encrypt ? 1 : 0) != 1) return false;
+
+    int len = 0;
+    if (!aad.empty() &&
+        EVP_CipherUpdate(ctx, nullptr, &len, reinterpret_cast<const unsigned char*>(aad.data()),
+                         static_cast<int>(aad.size())) != 1) {
+        return false;
+    }
+
+    const std::size_t start = out.size();
+    out.resize(start + body + (encrypt ? ChunkCipher::kTagSize : 0));
+    auto* dst = reinterpret_cast<unsigned char*>(&out[start]);
+    const auto* src = reinterpret_cast<const unsigned char*>(data);
+
+    int written = 0;
+    if (body > 0 && EVP_CipherUpdate(ctx, dst, &written, src, static_cast<int>(body)) != 1) {
+        out.resize(start);
+        return false;
+    }
+
+    if (!encrypt) {
+        // The tag goes in before Final, which checks it
+        void* tag = const_cast<unsigned char*>(src + body);
+        if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, ChunkCipher::kTagSize, tag) != 1) {
+            out.resize(start);
+            return false;
+        }
+    }
+
+    int tail = 0;
+    if (EVP_CipherFinal_ex(ctx, dst + written, &tail) != 1) {
+        out.resize(start);
+        return false;
+    }
+
+    if (encrypt &&
+        EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, ChunkCipher::kTagSize, dst + body) != 1) {
+        out.resize(start);
+        return false;
+    }
+    return true;
+}
+
+EVP_CIPHER_CTX* keyedContext(const ChunkCipher::Key& key, bool encrypt) {
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    if (ctx && EVP_CipherInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key.data(), nullptr, encrypt ? 1 : 0) != 1) {
+        EVP_CIPHER_CTX_free(ctx);
+        return nullptr;
+    }
+    return ctx;
+}
+
+} // namespace
+
+ChunkCipher::ChunkCipher(const Key& key, std::string streamId)
+    : key_(key), streamId_(std::move(streamId)) {}
+
+ChunkCipher::~ChunkCipher() {
+    if (encrypt_) EVP_CIPHER_CTX_free(encrypt_);
+    if (decrypt_) EVP_CIPHER_CTX_free(decrypt_);
+    OPENSSL_cleanse(key_.data(), key_.size());
+}
+
+std::string ChunkCipher::aad(std::uint64_t index, bool final) const {
+    std::string out = streamId_;
+    unsigned char be[8];
+    putBigEndian(index, be);
+    out.append(reinterpret_cast<const char*>(be), sizeof(be));
+    out.push_back(final ? '\x01' : '\x00');
+    return out;
+}
+
+bool ChunkCipher::seal(std::uint64_t index, bool final, const char* data, std::size_t size, std::string& out) {
+    // Keyed once: each chunk only resets the nonce
+    if (!encrypt_ && !(encrypt_ = keyedContext(key_, true))) return false;
+
+    unsigned char nonce[kNonceSize] = {};
+    putBigEndian(index, nonce + 4);
+    return gcm(encrypt_, true, nonce, aad(index, final), data, size, out);
+}
+
+bool ChunkCipher::open(std::uint64_t index, bool final, const char* data, std::size_t size, std::string& out) {
+    if (!decrypt_ && !(decrypt_ = keyedContext(key_, false))) return false;
+
+    unsigned char nonce[kNonceSize] = {};
+    putBigEndian(index, nonce + 4);
+    return gcm(decrypt_, false, nonce, aad(index, final), data, size, out);
+}
+
+ChunkCipher::Key ChunkCipher::chunkKey(const Key& masterKey, const std::string& tenant, const std::uint8_t* digest) {
+    Key key{};
+    keyed(masterKey, tenant, "key", digest, key.data());
+    return key;
+}
+
+ChunkCipher::ChunkId ChunkCipher::chunkId(const Key& masterKey, const std::string& tenant, const std::uint8_t* digest) {
+    ChunkId id{};
+    keyed(masterKey, tenant, "name", digest, id.data());
+    return id;
+}
+
+std::string ChunkCipher::chunkName(const Key& masterKey, const std::string& tenant, const std::uint8_t* digest) {
+    const auto id = chunkId(masterKey, tenant, digest);
+    return toHex(id.data(), id.size());
+}
+
+bool ChunkCipher::sealBlob(const Key& key, const std::string& aad, const std::string& plain, std::string& out) {
+    unsigned char nonce[kNonceSize];
+    if (RAND_bytes(nonce, sizeof(nonce)) != 1) return false;
+
+    EVP_CIPHER_CTX* ctx = keyedContext(key, true);
+    if (!ctx) return false;
+
+    out.assign(reinterpret_cast<const char*>(nonce), sizeof(nonce));
+    const bool ok = gcm(ctx, true, nonce, aad, plain.data(), plain.size(), out);
+    EVP_CIPHER_CTX_free(ctx);
+    return ok;
+}
+
+bool ChunkCipher::openBlob(const Key& key, const std::string& aad, const std::string& sealed, std::string& out) {
+    if (sealed.size() < kNonceSize + kTagSize) return false;
+
+    EVP_CIPHER_CTX* ctx = keyedContext(key, false);
+    if (!ctx) return false;
+
+    out.clear();
+    const bool ok = gcm(ctx, false, reinterpret_cast<const unsigned char*>(sealed.data()), aad,
+                        sealed.data() + kNonceSize, sealed.size() - kNonceSize, out);
+    EVP_CIPHER_CTX_free(ctx);
+    return ok;
+}
+
+bool ChunkCipher::hardwareAccelerated() {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    return __builtin_cpu_supports("aes");
+#else
+    return false;
+#endif
+}
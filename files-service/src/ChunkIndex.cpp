@@ -0,0 +1,271 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/ChunkIndex.h"
+#include "../include/FilesConfig.h"
+
+#include <trantor/utils/Logger.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+constexpr char kMagic[8] = {'F', 'C', 'H', 'U', 'N', 'K', 'S', '1'};
+constexpr std::uint32_t kVersion = 2;        // 2: chunk ids per tenant (1: plain SHA-256)
+constexpr std::size_t kHeaderBytes = 4096;
+constexpr unsigned kBloomProbes = 7;
+
+std::uint64_t word(const ChunkIndex::Digest& d, std::size_t i) {
+    std::uint64_t w;
+    std::memcpy(&w, d.data() + 8 * i, sizeof(w));
+    return w;
+}
+
+std::size_t powerOfTwoAtLeast(std::size_t v) {
+    std::size_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+} // namespace
+
+struct ChunkIndex::Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t slotSize;
+    std::uint64_t capacity;
+    std::uint64_t count;
+};
+
+static_assert(sizeof(ChunkIndex::Digest) + 2 * sizeof(std::uint32_t) == 40, "40-byte slots");
+
+ChunkIndex& ChunkIndex::instance() {
+    static ChunkIndex index;
+    return index;
+}
+
+ChunkIndex::ChunkIndex() {
+    const auto& config = FilesConfig::instance();
+    const std::size_t capacity = powerOfTwoAtLeast(std::max<std::size_t>(config.indexCapacity, 1024));
+
+    if (!open(config.dataDir + "/chunks.idx", capacity)) {
+        LOG_WARN << "Chunk index unavailable in " << config.dataDir << ", every chunk will be sent";
+        return;
+    }
+    rebuildBloom();
+    LOG_INFO << "Chunk index: " << header_->count << " chunks, " << capacity_ << " slots";
+}
+
+ChunkIndex::~ChunkIndex() {
+    unmap();
+}
+
+bool ChunkIndex::open(const std::string& path, std::size_t capacity) {
+    path_ = path;
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd_ < 0) return false;
+
+    struct stat st{};
+    if (::fstat(fd_, &st) != 0) return false;
+    if (st.st_size == 0) return map(fd_, capacity, true);
+
+    // Existing file: its header gives the capacity
+    Header header{};
+    const bool readable = ::pread(fd_, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    const bool valid = readable &&
+                       std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+                       header.version == kVersion && header.slotSize == sizeof(Slot) &&
+                       header.capacity > 0 && (header.capacity & (header.capacity - 1)) == 0 &&
+                       static_cast<std::uint64_t>(st.st_size) == kHeaderBytes + header.capacity * sizeof(Slot);
+    if (valid) return map(fd_, header.capacity, false);
+
+    LOG_WARN << "Chunk index " << path << " is damaged, starting over";
+    if (::ftruncate(fd_, 0) != 0) return false;
+    return map(fd_, capacity, true);
+}
+
+bool ChunkIndex::map(int fd, std::size_t capacity, bool create) {
+    const std::size_t bytes = kHeaderBytes + capacity * sizeof(Slot);
+    // Sparse file: free slots are holes until written
+    if (create && ::ftruncate(fd, static_cast<off_t>(bytes)) != 0) return false;
+
+    void* base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) return false;
+
+    header_ = static_cast<Header*>(base);
+    slots_ = reinterpret_cast<Slot*>(static_cast<char*>(base) + kHeaderBytes);
+    capacity_ = capacity;
+    mappedBytes_ = bytes;
+
+    if (create) {
+        std::memcpy(header_->magic, kMagic, sizeof(kMagic));
+        header_->version = kVersion;
+        header_->slotSize = sizeof(Slot);
+        header_->capacity = capacity;
+        header_->count = 0;
+    }
+    return true;
+}
+
+void ChunkIndex::unmap() {
+    if (header_) ::munmap(header_, mappedBytes_);
+    if (fd_ >= 0) ::close(fd_);
+    header_ = nullptr;
+    slots_ = nullptr;
+    fd_ = -1;
+}
+
+ChunkIndex::Slot* ChunkIndex::find(const Digest& digest) const {
+    const std::size_t mask = capacity_ - 1;
+    for (std::size_t i = word(digest, 0) & mask;; i = (i + 1) & mask) {
+        Slot* slot = &slots_[i];
+        if (slot->size == 0) return nullptr;
+        if (slot->digest == digest) return slot;
+    }
+}
+
+bool ChunkIndex::contains(const Digest& digest) {
+    lookups_.fetch_add(1, std::memory_order_relaxed);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (!slots_) return false;
+    if (!bloomMayContain(digest)) {
+        bloomNegatives_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (!find(digest)) return false;
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void ChunkIndex::add(const Digest& digest, std::uint32_t size) {
+    if (size == 0) return;
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (!slots_) return;
+
+    if (Slot* slot = find(digest)) {
+        ++slot->refs;
+        return;
+    }
+
+    // Keep probes short (and a free slot always there): at most 70% full
+    if ((header_->count + 1) * 10 > capacity_ * 7 && !grow()) {
+        LOG_WARN << "Chunk index cannot grow past " << capacity_ << " slots";
+        if ((header_->count + 1) * 10 > capacity_ * 9) return;
+    }
+
+    const std::size_t mask = capacity_ - 1;
+    std::size_t i = word(digest, 0) & mask;
+    while (slots_[i].size != 0) i = (i + 1) & mask;
+
+    slots_[i].digest = digest;
+    slots_[i].refs = 1;
+    slots_[i].size = size;      // last: marks the slot used
+    ++header_->count;
+    bloomAdd(digest);
+}
+
+// Rehash into a file twice the size, renamed over the current one
+bool ChunkIndex::grow() {
+    const std::string tmpPath = path_ + ".tmp";
+    const int fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) return false;
+
+    Header* oldHeader = header_;
+    Slot* oldSlots = slots_;
+    const std::size_t oldCapacity = capacity_;
+    const std::size_t oldBytes = mappedBytes_;
+    const int oldFd = fd_;
+
+    if (!map(fd, oldCapacity * 2, true)) {
+        ::close(fd);
+        ::unlink(tmpPath.c_str());
+        header_ = oldHeader;
+        slots_ = oldSlots;
+        capacity_ = oldCapacity;
+        mappedBytes_ = oldBytes;
+        return false;
+    }
+
+    const std::size_t mask = capacity_ - 1;
+    for (std::size_t j = 0; j < oldCapacity; ++j) {
+        const Slot& slot = oldSlots[j];
+        if (slot.size == 0) continue;
+        std::size_t i = word(slot.digest, 0) & mask;
+        while (slots_[i].size != 0) i = (i + 1) & mask;
+        slots_[i] = slot;
+        ++header_->count;
+    }
+
+    // On disk before it replaces the old table
+    ::msync(header_, mappedBytes_, MS_SYNC);
+    if (std::rename(tmpPath.c_str(), path_.c_str()) != 0) {
+        ::munmap(header_, mappedBytes_);
+        ::close(fd);
+        ::unlink(tmpPath.c_str());
+        header_ = oldHeader;
+        slots_ = oldSlots;
+        capacity_ = oldCapacity;
+        mappedBytes_ = oldBytes;
+        return false;
+    }
+
+    ::munmap(oldHeader, oldBytes);
+    ::close(oldFd);
+    fd_ = fd;
+
+    rebuildBloom();
+    LOG_INFO << "Chunk index grown to " << capacity_ << " slots";
+    return true;
+}
+
+void ChunkIndex::rebuildBloom() {
+    // >= 14 bits per entry at the 70% load limit
+    bloomBits_ = powerOfTwoAtLeast(capacity_ * 10);
+    bloom_.assign(bloomBits_ / 64, 0);
+    for (std::size_t i = 0; i < capacity_; ++i) {
+        if (slots_[i].size != 0) bloomAdd(slots_[i].digest);
+    }
+}
+
+void ChunkIndex::bloomAdd(const Digest& digest) {
+    // Double hashing over two other words of the digest
+    const std::uint64_t h1 = word(digest, 1);
+    const std::uint64_t h2 = word(digest, 2) | 1;
+    for (unsigned k = 0; k < kBloomProbes; ++k) {
+        const std::uint64_t bit = (h1 + k * h2) & (bloomBits_ - 1);
+        bloom_[bit >> 6] |= 1ULL << (bit & 63);
+    }
+}
+
+bool ChunkIndex::bloomMayContain(const Digest& digest) const {
+    const std::uint64_t h1 = word(digest, 1);
+    const std::uint64_t h2 = word(digest, 2) | 1;
+    for (unsigned k = 0; k < kBloomProbes; ++k) {
+        const std::uint64_t bit = (h1 + k * h2) & (bloomBits_ - 1);
+        if (!(bloom_[bit >> 6] & (1ULL << (bit & 63)))) return false;
+    }
+    return true;
+}
+
+ChunkIndex::Stats ChunkIndex::stats() const {
+    Stats s{};
+    s.lookups = lookups_.load(std::memory_order_relaxed);
+    s.bloomNegatives = bloomNegatives_.load(std::memory_order_relaxed);
+    s.hits = hits_.load(std::memory_order_relaxed);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    s.entries = header_ ? header_->count : 0;
+    s.capacity = capacity_;
+    return s;
+}
@@ -0,0 +1,113 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/ContentChunker.h"
+
+#include <algorithm>
+
+namespace {
+
+// Gear table: 256 fixed pseudo-random words (splitmix64 from a fixed seed)
+const std::array<std::uint64_t, 256>& gearTable() {
+    static const std::array<std::uint64_t, 256> table = [] {
+        std::array<std::uint64_t, 256> t{};
+        std::uint64_t state = 0x46617374434443ULL;   // "FastCDC"
+        for (auto& word : t) {
+            std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            word = z ^ (z >> 31);
+        }
+        return t;
+    }();
+    return table;
+}
+
+// The high bits of the Gear hash depend on the last 64 bytes, the low ones
+// on the last few only: masks take the top bits
+std::uint64_t topBits(unsigned bits) {
+    return bits == 0 ? 0 : ~0ULL << (64 - bits);
+}
+
+unsigned log2Floor(std::size_t v) {
+    unsigned bits = 0;
+    while (v >>= 1) ++bits;
+    return bits;
+}
+
+// ---------- Helper 1 : resumable scan for the cut point ----------
+// Scans data[pos, size) with the hash state fp; returns the chunk length
+// when a cut point is found (or maxSize is reached), 0 otherwise, with
+// pos / fp left where the scan stopped.
+std::size_t scan(const std::uint8_t* data, std::size_t size, const ContentChunker::Params& p,
+                 std::uint64_t maskStrict, std::uint64_t maskLoose,
+                 std::size_t& pos, std::uint64_t& fp) {
+    const auto& gear = gearTable();
+    if (pos < p.minSize) pos = std::min(p.minSize, size);
+
+    const std::size_t limit = std::min(size, p.maxSize);
+    const std::size_t normal = std::min(p.avgSize, limit);
+
+    while (pos < normal) {
+        fp = (fp << 1) + gear[data[pos++]];
+        if (!(fp & maskStrict)) return pos;
+    }
+    while (pos < limit) {
+        fp = (fp << 1) + gear[data[pos++]];
+        if (!(fp & maskLoose)) return pos;
+    }
+    return pos == p.maxSize ? pos : 0;
+}
+
+} // namespace
+
+ContentChunker::ContentChunker(const Params& params) : params_(params) {
+    // Normalization level 2: two more bits before avgSize, two less after
+    const unsigned bits = log2Floor(params_.avgSize);
+    maskStrict_ = topBits(bits + 2);
+    maskLoose_ = topBits(bits > 2 ? bits - 2 : 0);
+    buffer_.reserve(params_.maxSize);
+}
+
+std::size_t ContentChunker::cut(const std::uint8_t* data, std::size_t size) const {
+    if (size <= params_.minSize) return size;
+    std::size_t pos = 0;
+    std::uint64_t fp = 0;
+    const std::size_t found = scan(data, size, params_, maskStrict_, maskLoose_, pos, fp);
+    return found ? found : std::min(size, params_.maxSize);
+}
+
+void ContentChunker::feed(const char* data, std::size_t size, const Emit& emit) {
+    while (size > 0) {
+        // Never more than maxSize buffered: there is a cut point within it
+        const std::size_t take = std::min(size, params_.maxSize - buffer_.size());
+        buffer_.append(data, take);
+        data += take;
+        size -= take;
+
+        for (;;) {
+            const auto* bytes = reinterpret_cast<const std::uint8_t*>(buffer_.data());
+            const std::size_t found = scan(bytes, buffer_.size(), params_, maskStrict_, maskLoose_, pos_, fp_);
+            if (!found) break;
+
+            emit(buffer_.data(), found);
+            buffer_.erase(0, found);
+            pos_ = 0;
+            fp_ = 0;
+        }
+    }
+}
+
+void ContentChunker::finish(const Emit& emit) {
+    std::size_t offset = 0;
+    while (offset < buffer_.size()) {
+        const auto* bytes = reinterpret_cast<const std::uint8_t*>(buffer_.data()) + offset;
+        const std::size_t length = cut(bytes, buffer_.size() - offset);
+        emit(buffer_.data() + offset, length);
+        offset += length;
+    }
+    buffer_.clear();
+    pos_ = 0;
+    fp_ = 0;
+}
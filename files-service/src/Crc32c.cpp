@@ -0,0 +1,157 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/Crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define FILES_CRC32C_SSE42 1
+#endif
+
+namespace {
+
+// Castagnoli polynomial, reflected
+constexpr std::uint32_t kPoly = 0x82f63b78u;
+
+// Bytes per stream of the interleaved loop
+constexpr std::size_t kBlock = 4096;
+
+std::array<std::uint32_t, 256> makeTable() {
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        std::uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) crc = crc & 1 ? (crc >> 1) ^ kPoly : crc >> 1;
+        table[i] = crc;
+    }
+    return table;
+}
+
+const std::array<std::uint32_t, 256> kTable = makeTable();
+
+std::uint32_t softwareCrc(std::uint32_t crc, const unsigned char* p, std::size_t size) {
+    while (size--) crc = kTable[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+// ---------- Helper 1 : combining the interleaved streams ----------
+//
+// The register after bytes B, started from r, is shift(r, |B|) ^ (the
+// register after B started from 0), and shift(r, n) is r times x^(8n)
+// modulo the polynomial (as in zlib's crc32_combine).
+
+// a * b mod P, reflected
+std::uint32_t multModP(std::uint32_t a, std::uint32_t b) {
+    std::uint32_t m = 1u << 31;
+    std::uint32_t p = 0;
+    for (;;) {
+        if (a & m) {
+            p ^= b;
+            if ((a & (m - 1)) == 0) break;
+        }
+        m >>= 1;
+        b = b & 1 ? (b >> 1) ^ kPoly : b >> 1;
+    }
+    return p;
+}
+
+// x^(8n) mod P
+std::uint32_t shiftOperator(std::size_t n) {
+    std::uint32_t power = 1u << 30;     // x^1, then x^2, x^4, ...
+    std::uint32_t result = 1u << 31;    // x^0
+    for (std::uint64_t bits = static_cast<std::uint64_t>(n) * 8; bits; bits >>= 1) {
+        if (bits & 1) result = multModP(power, result);
+        power = multModP(power, power);
+    }
+    return result;
+}
+
+const std::uint32_t kShiftBlock = shiftOperator(kBlock);
+
+#ifdef FILES_CRC32C_SSE42
+
+__attribute__((target("sse4.2")))
+std::uint32_t hardwareCrc(std::uint32_t crc, const unsigned char* p, std::size_t size) {
+    std::uint64_t c0 = crc;
+
+    // Head: to 8-byte alignment
+    while (size > 0 && (reinterpret_cast<std::uintptr_t>(p) & 7) != 0) {
+        c0 = _mm_crc32_u8(static_cast<std::uint32_t>(c0), *p++);
+        --size;
+    }
+
+    // crc32 has a latency of 3 and a throughput of 1: three streams at once
+    while (size >= 3 * kBlock) {
+        std::uint64_t c1 = 0;
+        std::uint64_t c2 = 0;
+        for (std::size_t i = 0; i < kBlock; i += 8) {
+            std::uint64_t w0, w1, w2;
+            std::memcpy(&w0, p + i, 8);
+            std::memcpy(&w1, p + kBlock + i, 8);
+            std::memcpy(&w2, p + 2 * kBlock + i, 8);
+            c0 = _mm_crc32_u64(c0, w0);
+            c1 = _mm_crc32_u64(c1, w1);
+            c2 = _mm_crc32_u64(c2, w2);
+        }
+        c0 = multModP(kShiftBlock, static_cast<std::uint32_t>(c0)) ^ static_cast<std::uint32_t>(c1);
+        c0 = multModP(kShiftBlock, static_cast<std::uint32_t>(c0)) ^ static_cast<std::uint32_t>(c2);
+        p += 3 * kBlock;
+        size -= 3 * kBlock;
+    }
+
+    while (size >= 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p, 8);
+        c0 = _mm_crc32_u64(c0, w);
+        p += 8;
+        size -= 8;
+    }
+    while (size > 0) {
+        c0 = _mm_crc32_u8(static_cast<std::uint32_t>(c0), *p++);
+        --size;
+    }
+    return static_cast<std::uint32_t>(c0);
+}
+
+const bool kHasSse42 = __builtin_cpu_supports("sse4.2");
+
+#endif
+
+} // namespace
+
+std::uint32_t Crc32c::compute(const char* data, std::size_t size, std::uint32_t crc) {
+    const auto* p = reinterpret_cast<const unsigned char*>(data);
+    crc = ~crc;
+#ifdef FILES_CRC32C_SSE42
+    if (kHasSse42) return ~hardwareCrc(crc, p, size);
+#endif
+    return ~softwareCrc(crc, p, size);
+}
+
+std::string Crc32c::toBase64(std::uint32_t crc) {
+    static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const unsigned char b[4] = {
+        static_cast<unsigned char>(crc >> 24), static_cast<unsigned char>(crc >> 16),
+        static_cast<unsigned char>(crc >> 8), static_cast<unsigned char>(crc),
+    };
+    std::string out;
+    out += alphabet[b[0] >> 2];
+    out += alphabet[(b[0] & 0x03) << 4 | b[1] >> 4];
+    out += alphabet[(b[1] & 0x0f) << 2 | b[2] >> 6];
+    out += alphabet[b[2] & 0x3f];
+    out += alphabet[b[3] >> 2];
+    out += alphabet[(b[3] & 0x03) << 4];
+    out += "==";
+    return out;
+}
+
+bool Crc32c::hardwareAccelerated() {
+#ifdef FILES_CRC32C_SSE42
+    return kHasSse42;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,122 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/DownloadPipeline.h"
+#include "../include/ChunkCipher.h"
+
+#include <trantor/utils/Logger.h>
+
+#include <algorithm>
+
+void DownloadPipeline::loadManifest(const std::string& id, ManifestCallback cb) {
+    S3Client::instance().getObject(FileManifest::objectKey(id), [id, cb = std::move(cb)](const S3Client::Response& r) {
+        if (!r.ok) {
+            if (r.status == 404) return cb(404, nullptr);
+            LOG_ERROR << "GetObject " << FileManifest::objectKey(id) << " failed: " << r.error;
+            return cb(502, nullptr);
+        }
+
+        std::string plain;
+        auto manifest = std::make_shared<FileManifest>();
+        if (!ChunkCipher::openBlob(FilesConfig::instance().masterKey, id, r.body, plain) ||
+            !FileManifest::parse(plain, *manifest)) {
+            LOG_ERROR << "Manifest of " << id << " cannot be opened";
+            return cb(500, nullptr);
+        }
+        manifest->id = id;
+        cb(200, std::move(manifest));
+    });
+}
+
+void DownloadPipeline::start(Manifest manifest, std::uint64_t offset, std::uint64_t length, Sink sink, Done done) {
+    std::shared_ptr<DownloadPipeline> pipeline(
+        new DownloadPipeline(std::move(manifest), offset, length, std::move(sink), std::move(done)));
+    pipeline->pump();
+}
+
+DownloadPipeline::DownloadPipeline(Manifest manifest, std::uint64_t offset, std::uint64_t length,
+                                   Sink sink, Done done)
+    : config_(FilesConfig::instance()),
+      s3_(S3Client::instance()),
+      manifest_(std::move(manifest)),
+      begin_(offset),
+      end_(std::min(offset + length, manifest_->size)),
+      sink_(std::move(sink)),
+      done_(std::move(done)) {
+    // Skip the chunks before the range
+    while (nextFetch_ < manifest_->chunks.size() && fetchStart_ + manifest_->chunks[nextFetch_].size <= begin_) {
+        fetchStart_ += manifest_->chunks[nextFetch_].size;
+        ++nextFetch_;
+    }
+    nextDeliver_ = nextFetch_;
+}
+
+void DownloadPipeline::pump() {
+    // Chunks fetched or waiting for their turn count alike: memory stays bounded
+    while (done_ && begin_ < end_ && fetchStart_ < end_ &&
+           inFlight_ + ready_.size() < config_.downloadConcurrency) {
+        if (nextFetch_ >= manifest_->chunks.size()) {
+            LOG_ERROR << "Manifest of " << manifest_->id << " is shorter than its size";
+            return finish(false);
+        }
+
+        const std::size_t index = nextFetch_;
+        const std::uint64_t start = fetchStart_;
+        const auto& ref = manifest_->chunks[index];
+        fetchStart_ += ref.size;
+        ++nextFetch_;
+        ++inFlight_;
+
+        const auto object = FileManifest::chunkObjectKey(
+            ChunkCipher::chunkName(config_.masterKey, manifest_->owner, ref.digest.data()));
+        auto self = shared_from_this();
+        s3_.getObject(object, [self, index, start](const S3Client::Response& r) { self->onChunk(index, start, r); });
+    }
+
+    if (inFlight_ == 0 && ready_.empty() && (begin_ >= end_ || fetchStart_ >= end_)) finish(true);
+}
+
+void DownloadPipeline::onChunk(std::size_t index, std::uint64_t start, const S3Client::Response& r) {
+    --inFlight_;
+    if (!done_) return;
+
+    const auto& ref = manifest_->chunks[index];
+    if (!r.ok) {
+        LOG_ERROR << "GetObject of a chunk of " << manifest_->id << " failed: " << r.error;
+        return finish(false);
+    }
+
+    std::string plain;
+    plain.reserve(ref.size);
+    ChunkCipher cipher(ChunkCipher::chunkKey(config_.masterKey, manifest_->owner, ref.digest.data()),
+                       std::string(reinterpret_cast<const char*>(ref.digest.data()), ref.digest.size()));
+    if (!cipher.open(0, true, r.body.data(), r.body.size(), plain) || plain.size() != ref.size) {
+        LOG_ERROR << "A chunk of " << manifest_->id << " cannot be opened";
+        return finish(false);
+    }
+
+    // Slice of the chunk inside the range
+    const auto from = static_cast<std::size_t>(std::max(begin_, start) - start);
+    const auto to = static_cast<std::size_t>(std::min<std::uint64_t>(end_ - start, ref.size));
+    if (from > 0 || to < plain.size()) plain = plain.substr(from, to - from);
+    ready_.emplace(index, std::move(plain));
+
+    // In file order, whatever order the store answered in
+    for (auto it = ready_.find(nextDeliver_); it != ready_.end(); it = ready_.find(nextDeliver_)) {
+        std::string data = std::move(it->second);
+        ready_.erase(it);
+        ++nextDeliver_;
+        if (!sink_(std::move(data))) return finish(false);
+    }
+    pump();
+}
+
+void DownloadPipeline::finish(bool complete) {
+    if (!done_) return;
+    auto done = std::move(done_);
+    done_ = nullptr;
+    sink_ = nullptr;
+    ready_.clear();
+    done(complete);
+}
@@ -0,0 +1,285 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/FileCache.h"
+#include "../include/DownloadPipeline.h"
+#include "../include/FilesConfig.h"
+
+#include <trantor/utils/Logger.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Temp files of fills under way, in the cache directory (same filesystem)
+constexpr const char* kFillPrefix = ".fill-";
+
+// Expected size of a copy, to size the frequency sketch
+constexpr std::uint64_t kTypicalFileBytes = 1u << 20;
+
+std::uint64_t keyOf(const std::string& fileId) {
+    return std::hash<std::string>{}(fileId);
+}
+
+void runOn(trantor::EventLoop* loop, std::function<void()> f) {
+    if (!loop || loop == trantor::EventLoop::getEventLoopOfCurrentThread()) return f();
+    loop->queueInLoop(std::move(f));
+}
+
+} // namespace
+
+FileCache& FileCache::instance() {
+    static FileCache cache;
+    return cache;
+}
+
+FileCache::FileCache()
+    : maxBytes_(FilesConfig::instance().cacheMaxBytes),
+      maxObjectBytes_(FilesConfig::instance().cacheMaxObjectBytes),
+      sketch_(static_cast<std::size_t>(std::min<std::uint64_t>(maxBytes_ / kTypicalFileBytes, 1u << 22))) {
+    const auto& dir = FilesConfig::instance().cacheDir;
+    if (dir.empty()) return;
+
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec) {
+        LOG_WARN << "Cannot create FILES_CACHE_DIR " << dir << " (" << ec.message() << "), no local copies";
+        return;
+    }
+    dir_ = dir;
+    load();
+}
+
+std::string FileCache::pathOf(const std::string& fileId) const {
+    return dir_ + "/" + fileId;
+}
+
+void FileCache::load() {
+    struct Found {
+        std::string id;
+        std::uint64_t size;
+        std::int64_t mtime;
+    };
+    std::vector<Found> found;
+
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir_, ec)) {
+        const std::string name = entry.path().filename().string();
+        struct stat st{};
+        if (::stat(entry.path().c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        // Fill interrupted by the previous run
+        if (name.compare(0, std::char_traits<char>::length(kFillPrefix), kFillPrefix) == 0) {
+            ::unlink(entry.path().c_str());
+            continue;
+        }
+        found.push_back({name, static_cast<std::uint64_t>(st.st_size), static_cast<std::int64_t>(st.st_mtime)});
+    }
+
+    // Oldest first, so the newest end up most recent
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) { return a.mtime < b.mtime; });
+    std::vector<std::string> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& f : found) insert(f.id, f.size, evicted);
+    }
+    for (const auto& id : evicted) ::unlink(pathOf(id).c_str());
+
+    LOG_INFO << "File cache: " << entries_.size() << " copies, " << bytes_ << " of " << maxBytes_ << " bytes";
+}
+
+FileCache::Lease FileCache::lookup(const std::string& fileId, std::uint64_t size) {
+    if (dir_.empty()) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    sketch_.increment(keyOf(fileId));
+
+    auto it = entries_.find(fileId);
+    if (it == entries_.end() || it->second.size != size) {
+        ++stats_.misses;
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    ++stats_.hits;
+    return pin(fileId);
+}
+
+FileCache::Lease FileCache::pin(const std::string& fileId) {
+    ++pins_[fileId];
+    return Lease(new std::string(pathOf(fileId)), [this, fileId](const std::string* path) {
+        delete path;
+        unpin(fileId);
+    });
+}
+
+void FileCache::unpin(const std::string& fileId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pins_.find(fileId);
+    if (it == pins_.end() || --it->second > 0) return;
+    pins_.erase(it);
+    // Evicted while served: the file goes now, unless a fill is about to
+    // rename a new copy over it (and unlinked under the lock, for the same reason)
+    if (doomed_.erase(fileId) && fills_.find(fileId) == fills_.end()) ::unlink(pathOf(fileId).c_str());
+}
+
+bool FileCache::admit(const std::string& fileId, std::uint64_t size) const {
+    if (size > maxObjectBytes_) return false;
+    if (bytes_ + reserved_ + size <= maxBytes_ || lru_.empty()) return true;
+    // Full: only for a file asked for more often than the next one out
+    return sketch_.estimate(keyOf(fileId)) > sketch_.estimate(keyOf(lru_.back()));
+}
+
+void FileCache::insert(const std::string& fileId, std::uint64_t size, std::vector<std::string>& evicted) {
+    auto it = entries_.find(fileId);
+    if (it != entries_.end()) {
+        // Renamed over the previous copy
+        bytes_ -= it->second.size;
+        lru_.erase(it->second.lru);
+        entries_.erase(it);
+    }
+
+    lru_.push_front(fileId);
+    entries_[fileId] = Entry{size, lru_.begin()};
+    doomed_.erase(fileId);
+    bytes_ += size;
+
+    while (bytes_ > maxBytes_ && lru_.size() > 1) {
+        const std::string victim = lru_.back();
+        lru_.pop_back();
+        bytes_ -= entries_[victim].size;
+        entries_.erase(victim);
+        // Being served: unlinked with its last lease
+        if (pins_.count(victim)) doomed_.insert(victim);
+        else evicted.push_back(victim);
+        ++stats_.evictions;
+    }
+}
+
+void FileCache::fill(Manifest manifest, FillCallback cb) {
+    const std::string& id = manifest->id;
+    Lease copy;
+    bool fetch = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (dir_.empty() || !admit(id, manifest->size)) {
+            ++stats_.rejected;
+        } else if (auto it = fills_.find(id); it != fills_.end()) {
+            // Someone is already fetching it: wait for that copy
+            ++stats_.coalesced;
+            it->second.push_back({trantor::EventLoop::getEventLoopOfCurrentThread(), std::move(cb)});
+            return;
+        } else if (auto entry = entries_.find(id); entry != entries_.end() && entry->second.size == manifest->size) {
+            // Filled since the lookup
+            copy = pin(id);
+        } else {
+            fills_[id].push_back({trantor::EventLoop::getEventLoopOfCurrentThread(), std::move(cb)});
+            reserved_ += manifest->size;
+            ++stats_.fills;
+            fetch = true;
+        }
+    }
+    if (!fetch) return cb(std::move(copy));
+    startFill(manifest);
+}
+
+void FileCache::startFill(const Manifest& manifest) {
+    struct Fill {
+        int fd = -1;
+        std::string tmpPath;
+        std::uint64_t offset = 0;
+    };
+    auto state = std::make_shared<Fill>();
+    state->tmpPath = dir_ + "/" + kFillPrefix + "XXXXXX";
+    state->fd = ::mkstemp(&state->tmpPath[0]);
+    if (state->fd < 0) {
+        LOG_ERROR << "Cannot create a temp file in " << dir_;
+        return endFill(manifest->id, manifest->size, {}, false);
+    }
+
+    DownloadPipeline::start(manifest, 0, manifest->size,
+        [state](std::string&& data) {
+            const char* p = data.data();
+            std::size_t left = data.size();
+            while (left > 0) {
+                const ssize_t n = ::pwrite(state->fd, p, left, static_cast<off_t>(state->offset));
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                p += n;
+                left -= static_cast<std::size_t>(n);
+                state->offset += static_cast<std::uint64_t>(n);
+            }
+            return true;
+        },
+        [this, state, id = manifest->id, size = manifest->size](bool complete) {
+            // On disk before the rename: a copy that survives a crash is whole
+            if (complete && ::fdatasync(state->fd) != 0) complete = false;
+            ::close(state->fd);
+            endFill(id, size, state->tmpPath, complete);
+        });
+}
+
+void FileCache::endFill(const std::string& fileId, std::uint64_t size, const std::string& tmpPath, bool complete) {
+    const std::string path = pathOf(fileId);
+    if (complete && std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        LOG_WARN << "Cannot move " << tmpPath << " into the file cache";
+        complete = false;
+    }
+    if (!complete && !tmpPath.empty()) ::unlink(tmpPath.c_str());
+
+    std::vector<Waiter> waiters;
+    std::vector<std::string> evicted;
+    Lease copy;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reserved_ -= size;
+        if (complete) insert(fileId, size, evicted);
+        auto it = fills_.find(fileId);
+        if (it != fills_.end()) {
+            waiters = std::move(it->second);
+            fills_.erase(it);
+        }
+        // Pinned before the waiters get to their loops
+        if (complete && !waiters.empty()) copy = pin(fileId);
+    }
+    for (const auto& id : evicted) ::unlink(pathOf(id).c_str());
+
+    // Failed: every waiter falls back to the store on its own
+    for (auto& waiter : waiters) {
+        runOn(waiter.loop, [cb = std::move(waiter.cb), copy] { cb(copy); });
+    }
+}
+
+bool FileCache::adopt(const std::string& fileId, const std::string& path, std::uint64_t size) {
+    if (dir_.empty() || size > maxObjectBytes_) return false;
+
+    if (std::rename(path.c_str(), pathOf(fileId).c_str()) != 0) {
+        LOG_WARN << "Cannot move " << path << " into the file cache";
+        return false;
+    }
+
+    // Just uploaded to a conversation: about to be downloaded by its members
+    std::vector<std::string> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        insert(fileId, size, evicted);
+    }
+    for (const auto& id : evicted) ::unlink(pathOf(id).c_str());
+    return true;
+}
+
+FileCache::Stats FileCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s = stats_;
+    s.entries = entries_.size();
+    s.bytes = bytes_;
+    return s;
+}
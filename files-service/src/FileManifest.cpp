@@ -0,0 +1,104 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/FileManifest.h"
+
+#include <cstring>
+
+namespace {
+
+constexpr char kMagic[4] = {'F', 'M', 'F', '2'};
+
+template <typename T>
+void put(std::string& out, T v) {
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        out.push_back(static_cast<char>(static_cast<std::uint64_t>(v) >> (8 * i) & 0xff));
+    }
+}
+
+void putString(std::string& out, const std::string& s) {
+    put<std::uint32_t>(out, static_cast<std::uint32_t>(s.size()));
+    out += s;
+}
+
+// Bounds-checked reader over the serialized form
+struct Reader {
+    const std::string& data;
+    std::size_t pos = 0;
+
+    template <typename T>
+    bool get(T& v) {
+        if (data.size() - pos < sizeof(T)) return false;
+        std::uint64_t acc = 0;
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            acc |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+        }
+        v = static_cast<T>(acc);
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool getBytes(void* out, std::size_t size) {
+        if (data.size() - pos < size) return false;
+        std::memcpy(out, data.data() + pos, size);
+        pos += size;
+        return true;
+    }
+
+    bool getString(std::string& s) {
+        std::uint32_t size = 0;
+        if (!get(size) || data.size() - pos < size) return false;
+        s.assign(data, pos, size);
+        pos += size;
+        return true;
+    }
+};
+
+} // namespace
+
+std::string FileManifest::serialize() const {
+    std::string out;
+    out.reserve(64 + name.size() + contentType.size() + owner.size() + chunks.size() * 36);
+    out.append(kMagic, sizeof(kMagic));
+    putString(out, name);
+    putString(out, contentType);
+    putString(out, owner);
+    put<std::uint64_t>(out, size);
+    put<std::int64_t>(out, createdAt);
+    put<std::uint32_t>(out, static_cast<std::uint32_t>(chunks.size()));
+    for (const auto& chunk : chunks) {
+        out.append(reinterpret_cast<const char*>(chunk.digest.data()), chunk.digest.size());
+        put<std::uint32_t>(out, chunk.size);
+    }
+    return out;
+}
+
+bool FileManifest::parse(const std::string& data, FileManifest& out) {
+    Reader r{data};
+    char magic[sizeof(kMagic)];
+    if (!r.getBytes(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) return false;
+
+    std::uint32_t count = 0;
+    if (!r.getString(out.name) || !r.getString(out.contentType) || !r.getString(out.owner) ||
+        !r.get(out.size) || !r.get(out.createdAt) || !r.get(count)) {
+        return false;
+    }
+    if ((data.size() - r.pos) != static_cast<std::size_t>(count) * 36) return false;
+
+    out.chunks.resize(count);
+    std::uint64_t total = 0;
+    for (auto& chunk : out.chunks) {
+        if (!r.getBytes(chunk.digest.data(), chunk.digest.size()) || !r.get(chunk.size)) return false;
+        total += chunk.size;
+    }
+    return total == out.size;
+}
+
+std::string FileManifest::objectKey(const std::string& id) {
+    return "files/" + id;
+}
+
+std::string FileManifest::chunkObjectKey(const std::string& chunkName) {
+    return "chunks/" + chunkName;
+}
@@ -0,0 +1,101 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/FilesConfig.h"
+
+#include <trantor/utils/Logger.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+constexpr std::size_t kMinChunkSize = 4u << 10;
+constexpr std::size_t kMaxChunkSize = 64u << 20;
+
+bool parseHexKey(const std::string& hex, std::array<std::uint8_t, 32>& out) {
+    if (hex.size() != out.size() * 2) return false;
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        const int hi = nibble(hex[2 * i]);
+        const int lo = nibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i] = static_cast<std::uint8_t>(hi << 4 | lo);
+    }
+    return true;
+}
+
+FilesConfig load() {
+    FilesConfig c;
+    try {
+        if (const char* v = std::getenv("PORT")) c.port = static_cast<std::uint16_t>(std::stoul(v));
+        if (const char* v = std::getenv("FILES_CDC_MIN_SIZE")) c.cdcMinSize = std::stoull(v);
+        if (const char* v = std::getenv("FILES_CDC_AVG_SIZE")) c.cdcAvgSize = std::stoull(v);
+        if (const char* v = std::getenv("FILES_CDC_MAX_SIZE")) c.cdcMaxSize = std::stoull(v);
+        if (const char* v = std::getenv("FILES_MAX_INFLIGHT_CHUNKS")) c.maxInFlightChunks = std::stoull(v);
+        if (const char* v = std::getenv("FILES_MAX_QUEUED_CHUNKS")) c.maxQueuedChunks = std::stoull(v);
+        if (const char* v = std::getenv("FILES_DOWNLOAD_CONCURRENCY")) c.downloadConcurrency = std::stoull(v);
+        if (const char* v = std::getenv("FILES_INDEX_CAPACITY")) c.indexCapacity = std::stoull(v);
+        if (const char* v = std::getenv("FILES_CACHE_MAX_BYTES")) c.cacheMaxBytes = std::stoull(v);
+        if (const char* v = std::getenv("FILES_CACHE_MAX_OBJECT_BYTES")) c.cacheMaxObjectBytes = std::stoull(v);
+        if (const char* v = std::getenv("FILES_UPLOAD_EXPIRY_HOURS")) c.uploadExpiryHours = static_cast<std::uint32_t>(std::stoul(v));
+        if (const char* v = std::getenv("FILES_MAX_UPLOAD_BYTES")) c.maxUploadBytes = std::stoull(v);
+        if (const char* v = std::getenv("FILES_S3_CONNECTIONS")) c.s3Connections = std::stoull(v);
+        if (const char* v = std::getenv("FILES_AUTH_CACHE_SECONDS")) c.authCacheSeconds = static_cast<std::uint32_t>(std::stoul(v));
+        if (const char* v = std::getenv("FILES_AUTH_CACHE_SIZE")) c.authCacheSize = std::stoull(v);
+    } catch (const std::exception& e) {
+        LOG_WARN << "Invalid FILES_* setting, using defaults: " << e.what();
+    }
+
+    // min <= avg <= max, avg a power of two (its bits make the cut masks)
+    c.cdcMaxSize = std::clamp(c.cdcMaxSize, kMinChunkSize, kMaxChunkSize);
+    c.cdcMinSize = std::clamp(c.cdcMinSize, kMinChunkSize, c.cdcMaxSize);
+    std::size_t avg = kMinChunkSize;
+    while (avg * 2 <= c.cdcAvgSize && avg * 2 <= c.cdcMaxSize) avg *= 2;
+    c.cdcAvgSize = std::max(avg, c.cdcMinSize);
+
+    c.maxInFlightChunks = std::max<std::size_t>(c.maxInFlightChunks, 1);
+    c.downloadConcurrency = std::max<std::size_t>(c.downloadConcurrency, 1);
+    c.s3Connections = std::max<std::size_t>(c.s3Connections, 1);
+    c.cacheMaxObjectBytes = std::min(c.cacheMaxObjectBytes, c.cacheMaxBytes);
+
+    // "minio:9000" in the compose file: plain HTTP inside the network
+    if (const char* v = std::getenv("MINIO_ENDPOINT"); v && *v) {
+        c.s3Endpoint = v;
+        if (c.s3Endpoint.find("://") == std::string::npos) c.s3Endpoint = "http://" + c.s3Endpoint;
+        while (!c.s3Endpoint.empty() && c.s3Endpoint.back() == '/') c.s3Endpoint.pop_back();
+    }
+    if (const char* v = std::getenv("AUTH_SERVICE_URL"); v && *v) {
+        c.authServiceUrl = v;
+        while (!c.authServiceUrl.empty() && c.authServiceUrl.back() == '/') c.authServiceUrl.pop_back();
+    }
+    if (const char* v = std::getenv("MINIO_ACCESS_KEY")) c.s3AccessKey = v;
+    if (const char* v = std::getenv("MINIO_SECRET_KEY")) c.s3SecretKey = v;
+    if (const char* v = std::getenv("MINIO_BUCKET"); v && *v) c.s3Bucket = v;
+    if (const char* v = std::getenv("MINIO_REGION"); v && *v) c.s3Region = v;
+    if (const char* v = std::getenv("FILES_SPOOL_DIR"); v && *v) c.spoolDir = v;
+    if (const char* v = std::getenv("FILES_DATA_DIR"); v && *v) c.dataDir = v;
+    c.cacheDir = c.dataDir + "/cache";
+    if (const char* v = std::getenv("FILES_CACHE_DIR"); v && *v) c.cacheDir = std::string(v) == "off" ? "" : v;
+
+    if (const char* v = std::getenv("FILES_MASTER_KEY"); v && *v) {
+        c.hasMasterKey = parseHexKey(v, c.masterKey);
+        if (!c.hasMasterKey) LOG_ERROR << "FILES_MASTER_KEY must be 64 hex characters, uploads disabled";
+    } else {
+        LOG_WARN << "FILES_MASTER_KEY not set, uploads disabled";
+    }
+    return c;
+}
+
+} // namespace
+
+const FilesConfig& FilesConfig::instance() {
+    static const FilesConfig config = load();
+    return config;
+}
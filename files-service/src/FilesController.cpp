@@ -0,0 +1,601 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/FilesController.h"
+#include "../include/AuthClient.h"
+#include "../include/DownloadPipeline.h"
+#include "../include/FileCache.h"
+#include "../include/UploadPipeline.h"
+#include "../include/UploadSessions.h"
+
+#include <drogon/utils/Utilities.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <map>
+#include <string>
+
+using namespace drogon;
+
+namespace {
+
+constexpr const char* kTusVersion = "1.0.0";
+
+HttpResponsePtr makeJsonError(int code, const std::string& msg) {
+    Json::Value j;
+    j["error"] = msg;
+    auto r = HttpResponse::newHttpJsonResponse(j);
+    r->setStatusCode(static_cast<HttpStatusCode>(code));
+    return r;
+}
+
+// AuthClient status other than 200
+HttpResponsePtr authError(int status) {
+    if (status != 401) return makeJsonError(k502BadGateway, "Authentication unavailable");
+    auto r = makeJsonError(k401Unauthorized, "Missing or invalid Bearer access token");
+    r->addHeader("WWW-Authenticate", "Bearer");
+    return r;
+}
+
+// next runs with the auth user id once the bearer token of req is accepted;
+// otherwise cb gets onError(status)
+void withUser(const HttpRequestPtr& req, std::function<void (const HttpResponsePtr &)>&& cb,
+              HttpResponsePtr (*onError)(int status),
+              std::function<void (const std::string& userId, std::function<void (const HttpResponsePtr &)>&& cb)> next) {
+    AuthClient::instance().verify(AuthClient::bearerToken(req),
+        [cb = std::move(cb), onError, next = std::move(next)](int status, const std::string& userId) mutable {
+            if (status != 200) return cb(onError(status));
+            next(userId, std::move(cb));
+        });
+}
+
+HttpResponsePtr toHttpResponse(const UploadPipeline::Outcome& outcome) {
+    if (outcome.status != 201) return makeJsonError(outcome.status, outcome.error);
+
+    Json::Value j;
+    j["id"] = outcome.id;
+    j["name"] = outcome.name;
+    j["size"] = static_cast<Json::UInt64>(outcome.size);
+    j["chunks"] = static_cast<Json::UInt64>(outcome.chunks);
+    j["encryption"] = "AES-256-GCM";
+    auto r = HttpResponse::newHttpJsonResponse(j);
+    r->setStatusCode(k201Created);
+    return r;
+}
+
+// Decimal digits only, no sign, no overflow
+bool parseUint(const std::string& s, std::uint64_t& out) {
+    if (s.empty() || s.size() > 19 || s.find_first_not_of("0123456789") != std::string::npos) return false;
+    out = std::stoull(s);
+    return true;
+}
+
+std::string httpDate(std::int64_t unixSeconds) {
+    return utils::getHttpFullDate(trantor::Date(unixSeconds * 1000000));
+}
+
+// ---------- Helper 1 : downloads ----------
+
+// Ids are the v4 UUIDs of UploadPipeline, in lower case
+bool validFileId(const std::string& id) {
+    if (id.size() != 36) return false;
+    for (std::size_t i = 0; i < id.size(); ++i) {
+        const bool dash = i == 8 || i == 13 || i == 18 || i == 23;
+        if (dash != (id[i] == '-')) return false;
+        if (!dash && !std::isxdigit(static_cast<unsigned char>(id[i]))) return false;
+        if (std::isupper(static_cast<unsigned char>(id[i]))) return false;
+    }
+    return true;
+}
+
+struct ByteRange {
+    std::uint64_t offset = 0;
+    std::uint64_t length = 0;
+};
+
+enum class RangeResult { Whole, Partial, Unsatisfiable };
+
+// One range of "bytes=a-b", "bytes=a-" or "bytes=-n". Several ranges, or a
+// header that does not parse, get the whole file (RFC 9110 allows ignoring Range)
+RangeResult parseRange(const std::string& header, std::uint64_t size, ByteRange& range) {
+    const std::string prefix = "bytes=";
+    if (header.compare(0, prefix.size(), prefix) != 0) return RangeResult::Whole;
+    const std::string spec = header.substr(prefix.size());
+    const auto dash = spec.find('-');
+    if (dash == std::string::npos || spec.find(',') != std::string::npos) return RangeResult::Whole;
+
+    const std::string first = spec.substr(0, dash);
+    const std::string last = spec.substr(dash + 1);
+    std::uint64_t a = 0, b = 0;
+
+    if (first.empty()) {
+        // Suffix: the last b bytes
+        if (!parseUint(last, b)) return RangeResult::Whole;
+        if (b == 0 || size == 0) return RangeResult::Unsatisfiable;
+        range.length = std::min(b, size);
+        range.offset = size - range.length;
+        return RangeResult::Partial;
+    }
+
+    if (!parseUint(first, a)) return RangeResult::Whole;
+    if (last.empty()) {
+        b = size == 0 ? 0 : size - 1;
+    } else if (!parseUint(last, b) || b < a) {
+        return RangeResult::Whole;
+    }
+    if (a >= size) return RangeResult::Unsatisfiable;
+
+    range.offset = a;
+    range.length = std::min(b, size - 1) - a + 1;
+    return RangeResult::Partial;
+}
+
+// attachment; filename="...", without what would break out of the quotes
+std::string contentDisposition(const std::string& name) {
+    std::string safe;
+    for (unsigned char c : name) {
+        if (c < 0x20 || c == 0x7f || c == '"' || c == '\\') safe += '_';
+        else safe += static_cast<char>(c);
+    }
+    return "attachment; filename=\"" + safe + "\"";
+}
+
+void addFileHeaders(const HttpResponsePtr& r, const FileManifest& manifest,
+                    const ByteRange& range, bool partial) {
+    r->addHeader("ETag", "\"" + manifest.id + "\"");
+    r->addHeader("Last-Modified", httpDate(manifest.createdAt));
+    r->addHeader("Accept-Ranges", "bytes");
+    if (partial) {
+        r->setStatusCode(k206PartialContent);
+        r->addHeader("Content-Range", "bytes " + std::to_string(range.offset) + "-" +
+                     std::to_string(range.offset + range.length - 1) + "/" + std::to_string(manifest.size));
+    }
+}
+
+// From the store, decrypted chunk by chunk. The response starts with the
+// first piece of the file, so that a missing chunk or an unreachable store
+// is still a 502 and not an empty 200
+struct StoreDownload {
+    std::function<void (const HttpResponsePtr &)> respond;     // until the first piece
+    std::shared_ptr<ResponseStream> out;
+    std::string pending;                                        // until out is there
+    bool finished = false;
+};
+
+void streamFromStore(DownloadPipeline::Manifest manifest, ByteRange range, bool partial,
+                     std::function<void (const HttpResponsePtr &)>&& cb) {
+    auto state = std::make_shared<StoreDownload>();
+    state->respond = std::move(cb);
+
+    auto headersFor = [manifest, range, partial](const HttpResponsePtr& r) {
+        r->setContentTypeString(manifest->contentType);
+        r->addHeader("Content-Disposition", contentDisposition(manifest->name));
+        addFileHeaders(r, *manifest, range, partial);
+    };
+
+    DownloadPipeline::start(manifest, range.offset, range.length,
+        [state, headersFor](std::string&& data) {
+            if (state->out) return state->out->send(data);
+            if (!state->respond) {
+                state->pending += data;
+                return true;
+            }
+
+            state->pending = std::move(data);
+            auto r = HttpResponse::newAsyncStreamResponse([state](ResponseStreamPtr stream) {
+                state->out = std::shared_ptr<ResponseStream>(std::move(stream));
+                if (!state->pending.empty()) state->out->send(state->pending);
+                state->pending.clear();
+                if (state->finished) state->out->close();
+            });
+            headersFor(r);
+            auto respond = std::move(state->respond);
+            state->respond = nullptr;
+            respond(r);
+            return true;
+        },
+        [state, headersFor, id = manifest->id](bool complete) {
+            state->finished = true;
+            if (state->respond) {
+                // Nothing sent yet: an empty file, or a failure we can still report
+                auto r = complete ? HttpResponse::newHttpResponse()
+                                  : makeJsonError(k502BadGateway, "Storage unavailable");
+                if (complete) headersFor(r);
+                auto respond = std::move(state->respond);
+                state->respond = nullptr;
+                return respond(r);
+            }
+            // Headers are gone: all the client sees is a body that ends early
+            if (!complete) LOG_WARN << "Download of " << id << " interrupted";
+            if (state->out) state->out->close();
+        });
+}
+
+HttpResponsePtr localFileResponse(const HttpRequestPtr& req, const FileCache::Lease& copy,
+                                  const FileManifest& manifest, const ByteRange& range, bool partial) {
+    // Not unlinked by an eviction before Drogon has it open: Drogon keeps the
+    // request until its response is written (after the ones before it on a
+    // pipelined connection), and opens the file as it writes it
+    req->attributes()->insert("files.cacheLease", copy);
+
+    const std::string& path = *copy;
+    auto r = partial
+        ? HttpResponse::newFileResponse(path, range.offset, range.length, true,
+                                        manifest.name, CT_CUSTOM, manifest.contentType)
+        : HttpResponse::newFileResponse(path, manifest.name, CT_CUSTOM, manifest.contentType);
+    addFileHeaders(r, manifest, range, partial);
+    return r;
+}
+
+HttpResponsePtr notModified(const FileManifest& manifest) {
+    auto r = HttpResponse::newHttpResponse();
+    r->setStatusCode(k304NotModified);
+    r->addHeader("ETag", "\"" + manifest.id + "\"");
+    return r;
+}
+
+// Authenticated GET /files/{id}: owner, validators, range, then the local copy or the store
+void downloadFile(const HttpRequestPtr& req, const std::string& id, const std::string& userId,
+                  std::function<void (const HttpResponsePtr &)>&& cb) {
+    if (!validFileId(id)) return cb(makeJsonError(k404NotFound, "No such file"));
+
+    DownloadPipeline::loadManifest(id, [req, userId, cb = std::move(cb)](int status, DownloadPipeline::Manifest manifest) mutable {
+        if (status == 404) return cb(makeJsonError(k404NotFound, "No such file"));
+        if (status != 200) return cb(makeJsonError(status, "Storage unavailable"));
+        // Someone else's file looks like a missing one
+        if (manifest->owner != userId) return cb(makeJsonError(k404NotFound, "No such file"));
+
+        const std::string etag = "\"" + manifest->id + "\"";
+        if (req->getHeader("if-none-match") == etag) return cb(notModified(*manifest));
+
+        // If-Range: the range only applies to the version the client has
+        ByteRange range{0, manifest->size};
+        bool partial = false;
+        const auto rangeHeader = req->getHeader("range");
+        const auto ifRange = req->getHeader("if-range");
+        if (!rangeHeader.empty() &&
+            (ifRange.empty() || ifRange == etag || ifRange == httpDate(manifest->createdAt))) {
+            switch (parseRange(rangeHeader, manifest->size, range)) {
+            case RangeResult::Unsatisfiable: {
+                auto r = makeJsonError(k416RequestedRangeNotSatisfiable, "Range not satisfiable");
+                r->addHeader("Content-Range", "bytes */" + std::to_string(manifest->size));
+                return cb(r);
+            }
+            case RangeResult::Partial:
+                partial = true;
+                break;
+            case RangeResult::Whole:
+                range = ByteRange{0, manifest->size};
+                break;
+            }
+        }
+
+        // Local copy: sendfile, the bytes never go through userspace
+        auto& cache = FileCache::instance();
+        if (auto copy = cache.lookup(manifest->id, manifest->size)) {
+            return cb(localFileResponse(req, copy, *manifest, range, partial));
+        }
+        if (!cache.enabled()) return streamFromStore(std::move(manifest), range, partial, std::move(cb));
+
+        // Miss: copied once for every request waiting on it, unless not worth a place
+        cache.fill(manifest, [req, manifest, range, partial, cb = std::move(cb)](FileCache::Lease copy) mutable {
+            if (copy) return cb(localFileResponse(req, copy, *manifest, range, partial));
+            streamFromStore(std::move(manifest), range, partial, std::move(cb));
+        });
+    });
+}
+
+// ---------- Helper 2 : tus ----------
+
+HttpResponsePtr tusResponse(HttpStatusCode code) {
+    auto r = HttpResponse::newHttpResponse();
+    r->setStatusCode(code);
+    r->addHeader("Tus-Resumable", kTusVersion);
+    r->addHeader("Cache-Control", "no-store");
+    return r;
+}
+
+HttpResponsePtr tusError(int code, const std::string& msg) {
+    auto r = makeJsonError(code, msg);
+    r->addHeader("Tus-Resumable", kTusVersion);
+    r->addHeader("Cache-Control", "no-store");
+    return r;
+}
+
+HttpResponsePtr tusAuthError(int status) {
+    auto r = authError(status);
+    r->addHeader("Tus-Resumable", kTusVersion);
+    r->addHeader("Cache-Control", "no-store");
+    return r;
+}
+
+// Sessions of other users look like missing ones
+bool ownedBy(const std::optional<UploadSessions::Info>& info, const std::string& userId) {
+    return info && !info->owner.empty() && info->owner == userId;
+}
+
+// Tus-Resumable is ours or absent
+bool tusVersionSupported(const HttpRequestPtr& req) {
+    const auto version = req->getHeader("tus-resumable");
+    return version.empty() || version == kTusVersion;
+}
+
+HttpResponsePtr tusVersionMismatch() {
+    auto r = tusError(k412PreconditionFailed, "Unsupported tus version");
+    r->addHeader("Tus-Version", kTusVersion);
+    return r;
+}
+
+// Upload-Metadata: "key base64,key base64"
+std::map<std::string, std::string> parseMetadata(const std::string& header) {
+    std::map<std::string, std::string> metadata;
+    std::size_t pos = 0;
+    while (pos < header.size()) {
+        auto end = header.find(',', pos);
+        if (end == std::string::npos) end = header.size();
+        std::string pair = header.substr(pos, end - pos);
+        pos = end + 1;
+
+        const auto first = pair.find_first_not_of(' ');
+        if (first == std::string::npos) continue;
+        pair = pair.substr(first);
+        const auto space = pair.find(' ');
+        const std::string key = pair.substr(0, space);
+        metadata[key] = space == std::string::npos ? std::string() : utils::base64Decode(pair.substr(space + 1));
+    }
+    return metadata;
+}
+
+// One PATCH: holds the session lock and the data file while it runs
+struct PatchUpload {
+    UploadSessions::Info info;
+    int fd = -1;
+    std::uint64_t offset = 0;
+    bool tooLarge = false;
+    bool writeFailed = false;
+
+    explicit PatchUpload(UploadSessions::Info i) : info(std::move(i)) {}
+
+    ~PatchUpload() {
+        if (fd >= 0) ::close(fd);
+        UploadSessions::instance().unlock(info.id);
+    }
+
+    void write(const char* data, std::size_t size) {
+        if (writeFailed || tooLarge) return;
+        if (size > info.length - offset) {
+            tooLarge = true;
+            size = static_cast<std::size_t>(info.length - offset);
+        }
+        while (size > 0) {
+            const ssize_t n = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                writeFailed = true;
+                return;
+            }
+            data += n;
+            size -= static_cast<std::size_t>(n);
+            offset += static_cast<std::uint64_t>(n);
+        }
+    }
+};
+
+HttpResponsePtr uploadProgress(const UploadSessions::Info& info, std::uint64_t offset, HttpStatusCode code) {
+    auto r = tusResponse(code);
+    r->addHeader("Upload-Offset", std::to_string(offset));
+    if (!info.fileId.empty()) r->addHeader("X-File-Id", info.fileId);
+    return r;
+}
+
+// All the bytes are there: the file is stored like a direct upload, then
+// the data file becomes its local copy
+void finalizeUpload(std::shared_ptr<PatchUpload> upload, std::function<void (const HttpResponsePtr &)>&& cb) {
+    const auto path = UploadSessions::instance().dataPath(upload->info.id);
+    UploadPipeline::startFromFile(path, upload->info.name, upload->info.contentType, upload->info.owner,
+        [upload, path, cb = std::move(cb)](const UploadPipeline::Outcome& outcome) {
+            if (outcome.status != 201) return cb(tusError(outcome.status, outcome.error));
+
+            auto& sessions = UploadSessions::instance();
+            upload->info.fileId = outcome.id;
+            if (!sessions.setFileId(upload->info.id, outcome.id)) {
+                LOG_WARN << "Cannot record file " << outcome.id << " in upload " << upload->info.id;
+            }
+            if (!FileCache::instance().adopt(outcome.id, path, outcome.size)) ::unlink(path.c_str());
+            cb(uploadProgress(upload->info, upload->offset, k204NoContent));
+        });
+}
+
+void finishPatch(const std::shared_ptr<PatchUpload>& upload, std::function<void (const HttpResponsePtr &)>&& cb) {
+    // Whatever arrived is kept, even from an interrupted request: the client resumes from HEAD
+    if (::fdatasync(upload->fd) != 0) upload->writeFailed = true;
+    ::close(upload->fd);
+    upload->fd = -1;
+
+    if (upload->writeFailed) return cb(tusError(k500InternalServerError, "Cannot store upload"));
+    if (upload->tooLarge) return cb(tusError(k413RequestEntityTooLarge, "Upload-Length exceeded"));
+    if (upload->offset < upload->info.length) return cb(uploadProgress(upload->info, upload->offset, k204NoContent));
+    finalizeUpload(upload, std::move(cb));
+}
+
+} // namespace
+
+void FilesController::upload(const HttpRequestPtr& req,
+                             RequestStreamPtr&& stream,
+                             std::function<void (const HttpResponsePtr &)> &&cb) const {
+    std::string name = req->getParameter("name");
+    if (name.empty()) {
+        return cb(makeJsonError(k400BadRequest, "Query parameter 'name' is required"));
+    }
+    std::string contentType = req->getHeader("content-type");
+    if (contentType.empty()) contentType = "application/octet-stream";
+
+    // The body is only read once the token is accepted (Drogon keeps what
+    // arrives meanwhile until the reader is set)
+    std::shared_ptr<RequestStream> body(std::move(stream));
+    withUser(req, std::move(cb), authError,
+        [req, body, name = std::move(name), contentType = std::move(contentType)](
+            const std::string& userId, std::function<void (const HttpResponsePtr &)>&& cb) mutable {
+            auto pipeline = UploadPipeline::start(std::move(name), std::move(contentType), userId,
+                [cb = std::move(cb)](const UploadPipeline::Outcome& outcome) {
+                    cb(toHttpResponse(outcome));
+                });
+
+            // Body already complete (small request, or streaming off): one pass
+            if (!body) {
+                const auto data = req->body();
+                pipeline->onData(data.data(), data.size());
+                pipeline->onFinish(true);
+                return;
+            }
+
+            // The reader keeps the pipeline alive until the end of the body
+            body->setStreamReader(RequestStreamReader::newReader(
+                [pipeline](const char* data, size_t length) {
+                    pipeline->onData(data, length);
+                },
+                [pipeline](std::exception_ptr error) {
+                    pipeline->onFinish(!error);
+                }));
+        });
+}
+
+void FilesController::download(const HttpRequestPtr& req,
+                               std::function<void (const HttpResponsePtr &)> &&cb,
+                               std::string id) const {
+    withUser(req, std::move(cb), authError,
+        [req, id = std::move(id)](const std::string& userId, std::function<void (const HttpResponsePtr &)>&& cb) {
+            downloadFile(req, id, userId, std::move(cb));
+        });
+}
+
+void FilesController::uploadOptions(const HttpRequestPtr&,
+                                    std::function<void (const HttpResponsePtr &)> &&cb) const {
+    auto r = tusResponse(k204NoContent);
+    r->addHeader("Tus-Version", kTusVersion);
+    r->addHeader("Tus-Extension", "creation,termination,expiration");
+    r->addHeader("Tus-Max-Size", std::to_string(FilesConfig::instance().maxUploadBytes));
+    cb(r);
+}
+
+void FilesController::createUpload(const HttpRequestPtr& req,
+                                   std::function<void (const HttpResponsePtr &)> &&cb) const {
+    if (!tusVersionSupported(req)) return cb(tusVersionMismatch());
+
+    withUser(req, std::move(cb), tusAuthError,
+        [req](const std::string& userId, std::function<void (const HttpResponsePtr &)>&& cb) {
+            const auto& config = FilesConfig::instance();
+            if (!config.hasMasterKey) return cb(tusError(k503ServiceUnavailable, "Uploads are disabled (no master key)"));
+
+            std::uint64_t length = 0;
+            if (!parseUint(req->getHeader("upload-length"), length)) {
+                return cb(tusError(k400BadRequest, "Upload-Length is required"));
+            }
+            if (length > config.maxUploadBytes) return cb(tusError(k413RequestEntityTooLarge, "File too large"));
+
+            auto metadata = parseMetadata(req->getHeader("upload-metadata"));
+            if (metadata["filename"].empty()) return cb(tusError(k400BadRequest, "Upload-Metadata filename is required"));
+            std::string contentType = metadata["filetype"];
+            if (contentType.empty()) contentType = "application/octet-stream";
+
+            auto& sessions = UploadSessions::instance();
+            const auto info = sessions.create(length, metadata["filename"], contentType, userId);
+            if (!info) return cb(tusError(k500InternalServerError, "Cannot create upload"));
+
+            auto r = tusResponse(k201Created);
+            r->addHeader("Location", "/uploads/" + info->id);
+            r->addHeader("Upload-Expires", httpDate(sessions.expiresAt(*info)));
+            cb(r);
+        });
+}
+
+void FilesController::uploadStatus(const HttpRequestPtr& req,
+                                   std::function<void (const HttpResponsePtr &)> &&cb,
+                                   std::string id) const {
+    if (!tusVersionSupported(req)) return cb(tusVersionMismatch());
+
+    withUser(req, std::move(cb), tusAuthError,
+        [id = std::move(id)](const std::string& userId, std::function<void (const HttpResponsePtr &)>&& cb) {
+            auto& sessions = UploadSessions::instance();
+            const auto info = sessions.find(id);
+            if (!ownedBy(info, userId)) return cb(tusResponse(k404NotFound));
+
+            auto r = uploadProgress(*info, sessions.offset(*info), k200OK);
+            r->addHeader("Upload-Length", std::to_string(info->length));
+            r->addHeader("Upload-Expires", httpDate(sessions.expiresAt(*info)));
+            cb(r);
+        });
+}
+
+void FilesController::appendUpload(const HttpRequestPtr& req,
+                                   RequestStreamPtr&& stream,
+                                   std::function<void (const HttpResponsePtr &)> &&cb,
+                                   std::string id) const {
+    if (!tusVersionSupported(req)) return cb(tusVersionMismatch());
+
+    // As for POST /files: nothing is written before the token is accepted
+    std::shared_ptr<RequestStream> body(std::move(stream));
+    withUser(req, std::move(cb), tusAuthError,
+        [req, body, id = std::move(id)](const std::string& userId, std::function<void (const HttpResponsePtr &)>&& cb) {
+            auto& sessions = UploadSessions::instance();
+            auto info = sessions.find(id);
+            if (!ownedBy(info, userId)) return cb(tusError(k404NotFound, "No such upload"));
+            if (req->getHeader("content-type") != "application/offset+octet-stream") {
+                return cb(tusError(k415UnsupportedMediaType, "Content-Type must be application/offset+octet-stream"));
+            }
+            std::uint64_t clientOffset = 0;
+            if (!parseUint(req->getHeader("upload-offset"), clientOffset)) {
+                return cb(tusError(k400BadRequest, "Upload-Offset is required"));
+            }
+            if (!sessions.lock(id)) return cb(tusError(k423Locked, "Upload in progress"));
+
+            auto upload = std::make_shared<PatchUpload>(std::move(*info));
+            upload->offset = sessions.offset(upload->info);
+            if (clientOffset != upload->offset) {
+                auto r = tusError(k409Conflict, "Upload-Offset does not match");
+                r->addHeader("Upload-Offset", std::to_string(upload->offset));
+                return cb(r);
+            }
+            if (!upload->info.fileId.empty()) return cb(uploadProgress(upload->info, upload->offset, k204NoContent));
+
+            upload->fd = ::open(sessions.dataPath(id).c_str(), O_WRONLY | O_CLOEXEC);
+            if (upload->fd < 0) return cb(tusError(k500InternalServerError, "Cannot open upload"));
+
+            if (!body) {
+                const auto data = req->body();
+                upload->write(data.data(), data.size());
+                return finishPatch(upload, std::move(cb));
+            }
+
+            body->setStreamReader(RequestStreamReader::newReader(
+                [upload](const char* data, size_t length) {
+                    upload->write(data, length);
+                },
+                [upload, cb = std::move(cb)](std::exception_ptr) mutable {
+                    finishPatch(upload, std::move(cb));
+                }));
+        });
+}
+
+void FilesController::deleteUpload(const HttpRequestPtr& req,
+                                   std::function<void (const HttpResponsePtr &)> &&cb,
+                                   std::string id) const {
+    if (!tusVersionSupported(req)) return cb(tusVersionMismatch());
+
+    withUser(req, std::move(cb), tusAuthError,
+        [id = std::move(id)](const std::string& userId, std::function<void (const HttpResponsePtr &)>&& cb) {
+            auto& sessions = UploadSessions::instance();
+            if (!ownedBy(sessions.find(id), userId)) return cb(tusError(k404NotFound, "No such upload"));
+            if (!sessions.lock(id)) return cb(tusError(k423Locked, "Upload in progress"));
+
+            // The stored file, if any, stays: only the session goes
+            sessions.remove(id);
+            sessions.unlock(id);
+            cb(tusResponse(k204NoContent));
+        });
+}
@@ -0,0 +1,61 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/FrequencySketch.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr std::size_t kMinWidth = 1u << 10;
+constexpr std::size_t kMaxWidth = 1u << 22;
+
+// splitmix64 finalizer: each row gets its own independent-looking index
+std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+} // namespace
+
+FrequencySketch::FrequencySketch(std::size_t keys) {
+    width_ = kMinWidth;
+    while (width_ < keys && width_ < kMaxWidth) width_ *= 2;
+    counters_.assign(kRows * width_, 0);
+    sampleSize_ = 10 * width_;
+}
+
+std::size_t FrequencySketch::slot(std::uint64_t hash, unsigned row) const {
+    const std::uint64_t h = mix(hash + 0x9e3779b97f4a7c15ull * (row + 1));
+    return row * width_ + static_cast<std::size_t>(h & (width_ - 1));
+}
+
+void FrequencySketch::increment(std::uint64_t hash) {
+    bool added = false;
+    for (unsigned row = 0; row < kRows; ++row) {
+        auto& counter = counters_[slot(hash, row)];
+        if (counter < kMaxCount) {
+            ++counter;
+            added = true;
+        }
+    }
+    if (added && ++additions_ >= sampleSize_) halve();
+}
+
+std::uint32_t FrequencySketch::estimate(std::uint64_t hash) const {
+    std::uint32_t count = kMaxCount;
+    for (unsigned row = 0; row < kRows; ++row) {
+        count = std::min<std::uint32_t>(count, counters_[slot(hash, row)]);
+    }
+    return count;
+}
+
+void FrequencySketch::halve() {
+    for (auto& counter : counters_) counter = static_cast<std::uint8_t>(counter >> 1);
+    additions_ /= 2;
+}
@@ -0,0 +1,339 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/UploadPipeline.h"
+#include "../include/ChunkCipher.h"
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/Logger.h>
+
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+// startFromFile: size of one read, and bytes read before yielding the loop
+constexpr std::size_t kReadSize = 1u << 20;
+constexpr std::size_t kReadBudget = 16u << 20;
+
+std::atomic<std::uint64_t> storedUploads{0};
+std::atomic<std::uint64_t> storedChunks{0};
+std::atomic<std::uint64_t> sentChunks{0};
+std::atomic<std::uint64_t> storedBytes{0};
+std::atomic<std::uint64_t> savedBytes{0};
+
+// Random (v4) UUID, the id of the file and of its manifest
+std::string newFileId() {
+    unsigned char b[16];
+    if (RAND_bytes(b, sizeof(b)) != 1) return {};
+    b[6] = static_cast<unsigned char>((b[6] & 0x0f) | 0x40);
+    b[8] = static_cast<unsigned char>((b[8] & 0x3f) | 0x80);
+
+    char out[37];
+    std::snprintf(out, sizeof(out),
+                  "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+                  b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7],
+                  b[8], b[9], b[10], b[11], b[12], b[13], b[14], b[15]);
+    return out;
+}
+
+} // namespace
+
+std::shared_ptr<UploadPipeline> UploadPipeline::start(std::string name, std::string contentType,
+                                                      std::string owner, Done done) {
+    std::shared_ptr<UploadPipeline> pipeline(
+        new UploadPipeline(std::move(name), std::move(contentType), std::move(owner), std::move(done)));
+    pipeline->begin();
+    return pipeline;
+}
+
+std::shared_ptr<UploadPipeline> UploadPipeline::startFromFile(const std::string& path, std::string name,
+                                                              std::string contentType, std::string owner,
+                                                              Done done) {
+    auto pipeline = start(std::move(name), std::move(contentType), std::move(owner), std::move(done));
+    if (pipeline->failed_) return pipeline;
+
+    pipeline->sourceFd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (pipeline->sourceFd_ < 0) {
+        LOG_ERROR << "Cannot open " << path;
+        pipeline->fail(500, "Cannot read upload");
+        return pipeline;
+    }
+    ::posix_fadvise(pipeline->sourceFd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    pipeline->pull();
+    return pipeline;
+}
+
+UploadPipeline::UploadPipeline(std::string name, std::string contentType, std::string owner, Done done)
+    : config_(FilesConfig::instance()),
+      s3_(S3Client::instance()),
+      index_(ChunkIndex::instance()),
+      chunker_({config_.cdcMinSize, config_.cdcAvgSize, config_.cdcMaxSize}),
+      done_(std::move(done)) {
+    manifest_.name = std::move(name);
+    manifest_.contentType = std::move(contentType);
+    manifest_.owner = std::move(owner);
+}
+
+UploadPipeline::Stats UploadPipeline::stats() {
+    return {storedUploads.load(), storedChunks.load(), sentChunks.load(), storedBytes.load(), savedBytes.load()};
+}
+
+UploadPipeline::~UploadPipeline() {
+    if (spoolFd_ >= 0) ::close(spoolFd_);
+    if (sourceFd_ >= 0) ::close(sourceFd_);
+}
+
+void UploadPipeline::begin() {
+    if (!config_.hasMasterKey) return fail(503, "Uploads are disabled (no master key)");
+    if (manifest_.owner.empty()) return fail(401, "Unknown owner");
+
+    manifest_.id = newFileId();
+    if (manifest_.id.empty()) return fail(500, "Cannot generate file id");
+    manifest_.createdAt = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void UploadPipeline::onData(const char* data, std::size_t size) {
+    if (failed_ || finished_) return;
+
+    received_ += size;
+    if (received_ > config_.maxUploadBytes) return fail(413, "File too large");
+
+    chunker_.feed(data, size, [this](const char* chunk, std::size_t length) {
+        if (!failed_) onChunk(chunk, length);
+    });
+}
+
+void UploadPipeline::onFinish(bool complete) {
+    if (failed_ || finished_) return;
+    if (!complete) return fail(400, "Upload interrupted");
+
+    chunker_.finish([this](const char* chunk, std::size_t length) {
+        if (!failed_) onChunk(chunk, length);
+    });
+    if (failed_) return;
+    finished_ = true;
+    maybeComplete();
+}
+
+void UploadPipeline::onChunk(const char* data, std::size_t size) {
+    FileManifest::ChunkRef ref{};
+    SHA256(reinterpret_cast<const unsigned char*>(data), size, ref.digest.data());
+    ref.size = static_cast<std::uint32_t>(size);
+    manifest_.chunks.push_back(ref);
+    manifest_.size += size;
+
+    const auto id = ChunkCipher::chunkId(config_.masterKey, manifest_.owner, ref.digest.data());
+    auto object = FileManifest::chunkObjectKey(ChunkCipher::chunkName(config_.masterKey, manifest_.owner, ref.digest.data()));
+
+    // Known to the store, or already on its way there: the manifest is enough
+    if (sent_.count(object) || index_.contains(id)) {
+        deduplicatedBytes_ += size;
+        return;
+    }
+
+    Chunk chunk{std::move(object), {}};
+    chunk.data.reserve(size + ChunkCipher::kTagSize);
+    ChunkCipher cipher(ChunkCipher::chunkKey(config_.masterKey, manifest_.owner, ref.digest.data()),
+                       std::string(reinterpret_cast<const char*>(ref.digest.data()), ref.digest.size()));
+    if (!cipher.seal(0, true, data, size, chunk.data)) return fail(500, "Encryption failed");
+
+    sent_.insert(chunk.object);
+    ++newChunks_;
+
+    // FIFO: once chunks are spilled, the next ones follow them to disk
+    if (queued_.size() < config_.maxQueuedChunks && spilled_.empty()) {
+        queued_.push_back(std::move(chunk));
+    } else if (!spill(std::move(chunk))) {
+        return fail(500, "Spool write failed");
+    }
+    pump();
+}
+
+bool UploadPipeline::spill(Chunk&& chunk) {
+    if (spoolFd_ < 0) {
+        std::string path = config_.spoolDir + "/files-upload-XXXXXX";
+        spoolFd_ = ::mkstemp(&path[0]);
+        if (spoolFd_ < 0) {
+            LOG_ERROR << "Cannot create spool file in " << config_.spoolDir;
+            return false;
+        }
+        // Only the descriptor is needed: gone with it, even on a crash
+        ::unlink(path.c_str());
+    }
+
+    const char* p = chunk.data.data();
+    std::size_t left = chunk.data.size();
+    std::uint64_t offset = spoolEnd_;
+    while (left > 0) {
+        const ssize_t n = ::pwrite(spoolFd_, p, left, static_cast<off_t>(offset));
+        if (n <= 0) return false;
+        p += n;
+        left -= static_cast<std::size_t>(n);
+        offset += static_cast<std::uint64_t>(n);
+    }
+
+    spilled_.push_back({std::move(chunk.object), spoolEnd_, chunk.data.size()});
+    spoolEnd_ = offset;
+    return true;
+}
+
+bool UploadPipeline::unspill(Chunk& chunk) {
+    SpilledChunk s = std::move(spilled_.front());
+    spilled_.pop_front();
+
+    chunk.object = std::move(s.object);
+    chunk.data.resize(s.size);
+    std::size_t done = 0;
+    while (done < s.size) {
+        const ssize_t n = ::pread(spoolFd_, &chunk.data[done], s.size - done, static_cast<off_t>(s.offset + done));
+        if (n <= 0) return false;
+        done += static_cast<std::size_t>(n);
+    }
+
+    // Drained: start over at the beginning of the file
+    if (spilled_.empty()) {
+        spoolEnd_ = 0;
+        if (::ftruncate(spoolFd_, 0) != 0) LOG_WARN << "Cannot truncate spool file";
+    }
+    return true;
+}
+
+void UploadPipeline::pump() {
+    if (failed_) return;
+
+    while (inFlight_ < config_.maxInFlightChunks && (!queued_.empty() || !spilled_.empty())) {
+        Chunk chunk;
+        if (!queued_.empty()) {
+            chunk = std::move(queued_.front());
+            queued_.pop_front();
+        } else if (!unspill(chunk)) {
+            return fail(500, "Spool read failed");
+        }
+
+        ++inFlight_;
+        auto self = shared_from_this();
+        const auto object = chunk.object;
+        s3_.putObject(object, std::move(chunk.data), [self, object](const S3Client::Response& r) {
+            --self->inFlight_;
+            if (self->failed_) return;
+            if (!r.ok) {
+                LOG_ERROR << "PutObject " << object << " failed: " << r.error;
+                return self->fail(502, "Storage unavailable");
+            }
+            self->pump();
+            if (self->sourceFd_ >= 0 && !self->pullScheduled_) self->pull();
+            self->maybeComplete();
+        });
+    }
+}
+
+void UploadPipeline::pull() {
+    pullScheduled_ = false;
+
+    std::string buffer(kReadSize, '\0');
+    std::size_t budget = kReadBudget;
+    while (sourceFd_ >= 0 && !failed_ && budget > 0) {
+        // Chunks waiting for the store: the put callbacks resume reading
+        if (queued_.size() >= config_.maxQueuedChunks || !spilled_.empty()) return;
+
+        const ssize_t n = ::read(sourceFd_, &buffer[0], buffer.size());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return fail(500, "Cannot read upload");
+        }
+        if (n == 0) {
+            ::close(sourceFd_);
+            sourceFd_ = -1;
+            return onFinish(true);
+        }
+        onData(buffer.data(), static_cast<std::size_t>(n));
+        budget -= std::min(budget, static_cast<std::size_t>(n));
+    }
+
+    // A large deduplicated file would hold the loop: let other requests in
+    if (sourceFd_ >= 0 && !failed_ && !pullScheduled_) {
+        pullScheduled_ = true;
+        auto self = shared_from_this();
+        trantor::EventLoop::getEventLoopOfCurrentThread()->queueInLoop([self] { self->pull(); });
+    }
+}
+
+void UploadPipeline::maybeComplete() {
+    if (failed_ || completing_ || !finished_) return;
+    if (inFlight_ > 0 || !queued_.empty() || !spilled_.empty()) return;
+
+    completing_ = true;
+    std::string sealed;
+    if (!ChunkCipher::sealBlob(config_.masterKey, manifest_.id, manifest_.serialize(), sealed)) {
+        return fail(500, "Encryption failed");
+    }
+
+    auto self = shared_from_this();
+    s3_.putObject(FileManifest::objectKey(manifest_.id), std::move(sealed), [self](const S3Client::Response& r) {
+        if (!r.ok) {
+            LOG_ERROR << "PutObject " << FileManifest::objectKey(self->manifest_.id) << " failed: " << r.error;
+            return self->fail(502, "Storage unavailable");
+        }
+
+        // Every chunk is in the store now: one more reference each
+        const auto& m = self->manifest_;
+        for (const auto& chunk : m.chunks) {
+            self->index_.add(ChunkCipher::chunkId(self->config_.masterKey, m.owner, chunk.digest.data()), chunk.size);
+        }
+
+        ++storedUploads;
+        storedChunks += m.chunks.size();
+        sentChunks += self->newChunks_;
+        storedBytes += m.size;
+        savedBytes += self->deduplicatedBytes_;
+
+        Outcome outcome;
+        outcome.status = 201;
+        outcome.id = self->manifest_.id;
+        outcome.name = self->manifest_.name;
+        outcome.size = self->manifest_.size;
+        outcome.chunks = self->manifest_.chunks.size();
+        self->finish(outcome);
+    });
+}
+
+void UploadPipeline::fail(int status, const std::string& error) {
+    if (failed_) return;
+    failed_ = true;
+
+    // Nothing more will be sent: let the buffers go now, not with the request
+    queued_.clear();
+    spilled_.clear();
+    if (spoolFd_ >= 0) {
+        ::close(spoolFd_);
+        spoolFd_ = -1;
+    }
+    if (sourceFd_ >= 0) {
+        ::close(sourceFd_);
+        sourceFd_ = -1;
+    }
+
+    Outcome outcome;
+    outcome.status = status;
+    outcome.error = error;
+    finish(outcome);
+}
+
+void UploadPipeline::finish(const Outcome& outcome) {
+    if (!done_) return;
+    auto done = std::move(done_);
+    done_ = nullptr;
+    done(outcome);
+}
@@ -0,0 +1,224 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/UploadSessions.h"
+#include "../include/FilesConfig.h"
+
+#include <trantor/utils/Logger.h>
+
+#include <openssl/rand.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::int64_t nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string toHex(const std::string& s) {
+    static const char* digits = "0123456789abcdef";
+    std::string out;
+    out.reserve(s.size() * 2);
+    for (unsigned char c : s) {
+        out += digits[c >> 4];
+        out += digits[c & 0x0f];
+    }
+    return out;
+}
+
+bool fromHex(const std::string& hex, std::string& out) {
+    if (hex.size() % 2 != 0) return false;
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    };
+    out.clear();
+    for (std::size_t i = 0; i < hex.size(); i += 2) {
+        const int hi = nibble(hex[i]);
+        const int lo = nibble(hex[i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out += static_cast<char>(hi << 4 | lo);
+    }
+    return true;
+}
+
+// 32 lowercase hex characters: also keeps ids from naming other paths
+bool validId(const std::string& id) {
+    return id.size() == 32 && id.find_first_not_of("0123456789abcdef") == std::string::npos;
+}
+
+} // namespace
+
+UploadSessions& UploadSessions::instance() {
+    static UploadSessions sessions;
+    return sessions;
+}
+
+UploadSessions::UploadSessions() {
+    const auto& config = FilesConfig::instance();
+    root_ = config.dataDir + "/uploads";
+    expirySeconds_ = static_cast<std::int64_t>(config.uploadExpiryHours) * 3600;
+
+    std::error_code ec;
+    fs::create_directories(root_, ec);
+    if (ec) LOG_WARN << "Cannot create " << root_ << ": " << ec.message();
+}
+
+std::string UploadSessions::dirOf(const std::string& id) const {
+    return root_ + "/" + id;
+}
+
+std::string UploadSessions::dataPath(const std::string& id) const {
+    return dirOf(id) + "/data";
+}
+
+std::uint64_t UploadSessions::offset(const Info& info) const {
+    if (!info.fileId.empty()) return info.length;
+
+    struct stat st{};
+    if (::stat(dataPath(info.id).c_str(), &st) != 0) return 0;
+    return static_cast<std::uint64_t>(st.st_size);
+}
+
+std::int64_t UploadSessions::expiresAt(const Info& info) const {
+    return info.createdAt + expirySeconds_;
+}
+
+bool UploadSessions::writeInfo(const Info& info) const {
+    const std::string path = dirOf(info.id) + "/info";
+    const std::string tmp = path + ".tmp";
+
+    std::ostringstream out;
+    out << "length " << info.length << "\n"
+        << "created " << info.createdAt << "\n"
+        << "name " << toHex(info.name) << "\n"
+        << "content_type " << toHex(info.contentType) << "\n"
+        << "owner " << toHex(info.owner) << "\n"
+        << "file_id " << info.fileId << "\n";
+    const std::string text = out.str();
+
+    // On disk before the rename: a crash leaves the old info or the new one, never an empty file
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    bool ok = true;
+    for (std::size_t done = 0; ok && done < text.size();) {
+        const ssize_t n = ::write(fd, text.data() + done, text.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) ok = false;
+        else done += static_cast<std::size_t>(n);
+    }
+    ok = ::fsync(fd) == 0 && ok;
+    ::close(fd);
+    return ok && std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+std::optional<UploadSessions::Info> UploadSessions::create(std::uint64_t length, const std::string& name,
+                                                           const std::string& contentType,
+                                                           const std::string& owner) {
+    unsigned char random[16];
+    if (RAND_bytes(random, sizeof(random)) != 1) return std::nullopt;
+
+    Info info;
+    info.id = toHex(std::string(reinterpret_cast<const char*>(random), sizeof(random)));
+    info.length = length;
+    info.createdAt = nowSeconds();
+    info.name = name;
+    info.contentType = contentType;
+    info.owner = owner;
+
+    std::error_code ec;
+    if (!fs::create_directory(dirOf(info.id), ec) || !writeInfo(info)) {
+        LOG_ERROR << "Cannot create upload session in " << root_;
+        fs::remove_all(dirOf(info.id), ec);
+        return std::nullopt;
+    }
+    // Empty data file: offset 0
+    std::ofstream(dataPath(info.id), std::ios::trunc);
+    return info;
+}
+
+std::optional<UploadSessions::Info> UploadSessions::find(const std::string& id) const {
+    if (!validId(id)) return std::nullopt;
+
+    std::ifstream in(dirOf(id) + "/info");
+    if (!in) return std::nullopt;
+
+    Info info;
+    info.id = id;
+    try {
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string key, value;
+            fields >> key >> value;
+            if (key == "length") info.length = std::stoull(value);
+            else if (key == "created") info.createdAt = std::stoll(value);
+            else if (key == "name") fromHex(value, info.name);
+            else if (key == "content_type") fromHex(value, info.contentType);
+            else if (key == "owner") fromHex(value, info.owner);
+            else if (key == "file_id") info.fileId = value;
+        }
+    } catch (const std::exception& e) {
+        // Unreadable (damaged disk, hand edit): the session is lost either way
+        LOG_WARN << "Removing upload session " << id << " with a corrupt info file: " << e.what();
+        std::error_code ec;
+        fs::remove_all(dirOf(id), ec);
+        return std::nullopt;
+    }
+    if (info.createdAt == 0 || expiresAt(info) < nowSeconds()) return std::nullopt;
+    return info;
+}
+
+bool UploadSessions::setFileId(const std::string& id, const std::string& fileId) {
+    auto info = find(id);
+    if (!info) return false;
+    info->fileId = fileId;
+    return writeInfo(*info);
+}
+
+void UploadSessions::remove(const std::string& id) {
+    if (!validId(id)) return;
+    std::error_code ec;
+    fs::remove_all(dirOf(id), ec);
+}
+
+bool UploadSessions::lock(const std::string& id) {
+    std::lock_guard<std::mutex> guard(lockedMutex_);
+    return locked_.insert(id).second;
+}
+
+void UploadSessions::unlock(const std::string& id) {
+    std::lock_guard<std::mutex> guard(lockedMutex_);
+    locked_.erase(id);
+}
+
+void UploadSessions::expire() {
+    std::error_code ec;
+    std::size_t removed = 0;
+    for (const auto& entry : fs::directory_iterator(root_, ec)) {
+        const std::string id = entry.path().filename().string();
+        if (!validId(id) || find(id)) continue;    // live
+
+        // Expired (or unreadable): unless a request is still on it
+        if (!lock(id)) continue;
+        fs::remove_all(entry.path(), ec);
+        unlock(id);
+        ++removed;
+    }
+    if (removed > 0) LOG_INFO << "Removed " << removed << " expired upload sessions";
+}
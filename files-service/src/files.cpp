@@ -3,10 +3,84 @@
 //
 
 #include "../include/files.h"
+#include "../include/ChunkCipher.h"
+#include "../include/ChunkIndex.h"
+#include "../include/Crc32c.h"
+#include "../include/FileCache.h"
+#include "../include/FilesConfig.h"
+#include "../include/S3Client.h"
+#include "../include/UploadPipeline.h"
+#include "../include/UploadSessions.h"
+
+#include <drogon/drogon.h>
+
+#include <filesystem>
 #include <iostream>
 #include <ostream>
 
 
 void FilesService::run () {
     std::cout<<"Service d'échange de fichiers en coours d'execution"<< std::endl;
+
+    const auto& config = FilesConfig::instance();
+    LOG_INFO << "Storage: " << config.s3Endpoint << "/" << config.s3Bucket
+             << ", chunks of " << config.cdcMinSize << ".." << config.cdcMaxSize << " bytes"
+             << (ChunkCipher::hardwareAccelerated() ? ", AES-NI" : ", no AES-NI")
+             << (Crc32c::hardwareAccelerated() ? ", SSE4.2 CRC-32C" : ", software CRC-32C")
+             << ", " << config.downloadConcurrency << " chunks at once per download";
+    // Maps FILES_DATA_DIR/chunks.idx and fills the Bloom filter before any upload
+    ChunkIndex::instance();
+    // Resumable uploads left behind by the previous run, if too old
+    UploadSessions::instance().expire();
+    // Indexes the local copies left by the previous run
+    if (!FileCache::instance().enabled()) LOG_INFO << "No local copies, downloads come from the store";
+    // Where uploads spill the chunks the store does not take fast enough
+    std::error_code ec;
+    std::filesystem::create_directories(config.spoolDir, ec);
+    if (ec) {
+        LOG_ERROR << "Cannot create FILES_SPOOL_DIR " << config.spoolDir << " (" << ec.message()
+                  << "), uploads fail once the store falls behind";
+    }
+
+    drogon::app()
+        .addListener("0.0.0.0", config.port)
+        .setThreadNum(0)
+        // Upload bodies reach the controller as they arrive, never whole in memory
+        .enableRequestStream()
+        .setClientMaxBodySize(config.maxUploadBytes)
+        .registerBeginningAdvice([] {
+            S3Client::instance().createBucket([](const S3Client::Response& r) {
+                if (r.ok) LOG_INFO << "Bucket " << FilesConfig::instance().s3Bucket << " ready";
+                else LOG_ERROR << "Cannot create bucket " << FilesConfig::instance().s3Bucket << ": " << r.error;
+            });
+            drogon::app().getLoop()->runEvery(3600.0, [] { UploadSessions::instance().expire(); });
+        })
+        .registerHandler(
+            "/health",
+            [](const drogon::HttpRequestPtr&,
+               std::function<void (const drogon::HttpResponsePtr &)> &&cb) {
+                Json::Value j;
+                j["status"] = "ok";
+                // Downloads served locally instead of from the store
+                const auto cache = FileCache::instance().stats();
+                j["cache"]["hits"] = static_cast<Json::UInt64>(cache.hits);
+                j["cache"]["misses"] = static_cast<Json::UInt64>(cache.misses);
+                j["cache"]["fills"] = static_cast<Json::UInt64>(cache.fills);
+                j["cache"]["coalesced"] = static_cast<Json::UInt64>(cache.coalesced);
+                j["cache"]["evictions"] = static_cast<Json::UInt64>(cache.evictions);
+                j["cache"]["bytes"] = static_cast<Json::UInt64>(cache.bytes);
+                // What deduplication saved, over every upload (never per upload)
+                const auto uploads = UploadPipeline::stats();
+                j["dedup"]["uploads"] = static_cast<Json::UInt64>(uploads.uploads);
+                j["dedup"]["chunks"] = static_cast<Json::UInt64>(uploads.chunks);
+                j["dedup"]["new_chunks"] = static_cast<Json::UInt64>(uploads.newChunks);
+                j["dedup"]["bytes"] = static_cast<Json::UInt64>(uploads.bytes);
+                j["dedup"]["deduplicated_bytes"] = static_cast<Json::UInt64>(uploads.deduplicatedBytes);
+                auto r = drogon::HttpResponse::newHttpJsonResponse(j);
+                cb(r);
+            },
+            {drogon::Get}
+        )
+        .setLogLevel(trantor::Logger::kInfo)
+        .run();
 }
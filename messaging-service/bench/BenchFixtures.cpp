@@ -0,0 +1,203 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "BenchFixtures.h"
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+using json = nlohmann::json;
+
+namespace bench {
+
+namespace {
+
+// ---------- Helper 1 : ids and timestamps ----------
+std::string uuidOf(unsigned kind, std::size_t n) {
+    char buf[37];
+    std::snprintf(buf, sizeof(buf), "%08x-0000-4000-8000-%012llx",
+                  kind, static_cast<unsigned long long>(n));
+    return buf;
+}
+
+// 2026-01-01T00:00:00+00:00 + offset, the format PostgREST sends for timestamptz
+std::string timestampAt(std::int64_t offsetSeconds) {
+    const std::time_t t = 1767225600 + offsetSeconds;
+    std::tm tm{};
+#ifdef _WIN32
+    gmtime_s(&tm, &t);
+#else
+    gmtime_r(&t, &tm);
+#endif
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S+00:00", &tm);
+    return buf;
+}
+
+const char* const kFirstNames[] = {"Amine", "Sarah", "Yanis", "Lina", "Karim", "Ines", "Hugo", "Nora"};
+const char* const kLastNames[]  = {"Benali", "Martin", "Haddad", "Dubois", "Mansouri", "Petit", "Laurent"};
+
+json conversationRow(const std::string& id, const char* type, const json& name,
+                     const json& directKey, const std::string& createdBy, std::size_t order) {
+    return {
+        {"id", id},
+        {"type", type},
+        {"name", name},
+        {"direct_key", directKey},
+        {"created_by", createdBy},
+        {"created_at", timestampAt(0)},
+        {"updated_at", timestampAt(static_cast<std::int64_t>(order))},
+        {"deleted_at", nullptr}
+    };
+}
+
+json memberRow(std::size_t n, const std::string& conversationId, const std::string& userId, const char* role) {
+    return {
+        {"id", uuidOf(5, n)},
+        {"conversation_id", conversationId},
+        {"user_id", userId},
+        {"role", role},
+        {"joined_at", timestampAt(0)},
+        {"left_at", nullptr}
+    };
+}
+
+// ---------- Helper 2 : base64url (JWT) ----------
+std::string base64Url(const unsigned char* data, std::size_t len) {
+    static const char* const alphabet =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    std::string out;
+    out.reserve((len + 2) / 3 * 4);
+    std::size_t i = 0;
+    for (; i + 2 < len; i += 3) {
+        const unsigned v = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        out += alphabet[(v >> 18) & 63];
+        out += alphabet[(v >> 12) & 63];
+        out += alphabet[(v >> 6) & 63];
+        out += alphabet[v & 63];
+    }
+    if (i + 1 == len) {
+        const unsigned v = data[i] << 16;
+        out += alphabet[(v >> 18) & 63];
+        out += alphabet[(v >> 12) & 63];
+    } else if (i + 2 == len) {
+        const unsigned v = (data[i] << 16) | (data[i + 1] << 8);
+        out += alphabet[(v >> 18) & 63];
+        out += alphabet[(v >> 12) & 63];
+        out += alphabet[(v >> 6) & 63];
+    }
+    return out;
+}
+
+std::string base64Url(const std::string& s) {
+    return base64Url(reinterpret_cast<const unsigned char*>(s.data()), s.size());
+}
+
+} // namespace
+
+std::string Dataset::profileId(std::size_t user) const { return uuidOf(1, user % users); }
+std::string Dataset::authId(std::size_t user) const    { return uuidOf(2, user % users); }
+std::string Dataset::groupId(std::size_t user) const   { return uuidOf(3, user % users); }
+std::string Dataset::directId(std::size_t user) const  { return uuidOf(4, user % users); }
+
+std::string Dataset::directKey(const std::string& a, const std::string& b) {
+    return a <= b ? a + ":" + b : b + ":" + a;
+}
+
+json Dataset::profiles() const {
+    json rows = json::array();
+    for (std::size_t i = 0; i < users; ++i) {
+        rows.push_back({
+            {"id", profileId(i)},
+            {"auth_id", authId(i)},
+            {"first_name", kFirstNames[i % 8]},
+            {"last_name", kLastNames[i % 7]}
+        });
+    }
+    return rows;
+}
+
+json Dataset::conversations() const {
+    json rows = json::array();
+    for (std::size_t i = 0; i < users; ++i) {
+        rows.push_back(conversationRow(groupId(i), "group", "Groupe " + std::to_string(i),
+                                       nullptr, profileId(i), 2 * i));
+        rows.push_back(conversationRow(directId(i), "direct", nullptr,
+                                       directKey(profileId(i), profileId(i + 1)), profileId(i), 2 * i + 1));
+    }
+    return rows;
+}
+
+json Dataset::members() const {
+    json rows = json::array();
+    std::size_t n = 0;
+    const std::size_t size = groupSize < users ? groupSize : users;
+    for (std::size_t i = 0; i < users; ++i) {
+        for (std::size_t k = 0; k < size; ++k) {
+            rows.push_back(memberRow(n++, groupId(i), profileId(i + k), k < 2 ? "owner" : "member"));
+        }
+        if (users > 1) {
+            rows.push_back(memberRow(n++, directId(i), profileId(i), "owner"));
+            rows.push_back(memberRow(n++, directId(i), profileId(i + 1), "owner"));
+        }
+    }
+    return rows;
+}
+
+json Dataset::conversationsPage(std::size_t user) const {
+    const auto me = profileId(user);
+    const auto all = conversations();
+    json page = json::array();
+    for (const auto& m : members()) {
+        if (m["user_id"] != me) continue;
+        for (const auto& c : all) {
+            if (c["id"] != m["conversation_id"]) continue;
+            page.push_back({
+                {"conversation", c},
+                {"role", m["role"]},
+                {"joined_at", m["joined_at"]},
+                {"left_at", nullptr}
+            });
+        }
+    }
+    return page;
+}
+
+std::string option(int argc, char** argv, const std::string& name, const std::string& fallback) {
+    const std::string prefix = "--" + name + "=";
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.compare(0, prefix.size(), prefix) == 0) return arg.substr(prefix.size());
+    }
+    return fallback;
+}
+
+std::string signAccessToken(const std::string& secret, const std::string& sub, std::int64_t ttlSeconds) {
+    const auto now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    const json payload = {
+        {"sub", sub},
+        {"role", "authenticated"},
+        {"aud", "authenticated"},
+        {"iat", now},
+        {"exp", now + ttlSeconds}
+    };
+    const std::string signingInput =
+        base64Url(R"({"alg":"HS256","typ":"JWT"})") + "." + base64Url(payload.dump());
+
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    unsigned int macLen = 0;
+    HMAC(EVP_sha256(), secret.data(), static_cast<int>(secret.size()),
+         reinterpret_cast<const unsigned char*>(signingInput.data()), signingInput.size(),
+         mac, &macLen);
+
+    return signingInput + "." + base64Url(mac, macLen);
+}
+
+} // namespace bench
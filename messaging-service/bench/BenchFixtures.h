@@ -0,0 +1,55 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_BENCHFIXTURES_H
+#define SECURE_CLOUD_BENCHFIXTURES_H
+
+#include <nlohmann/json.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace bench {
+
+// Synthetic, deterministic Supabase dataset shared by the mock server, the
+// load generator and the microbenchmarks: the same options always produce
+// the same ids, so a load generator and a mock started separately agree.
+//
+// For N users:
+//   - user i owns the group conversation group(i); its members are users
+//     i .. i+groupSize-1 (mod N), users i and i+1 are owners;
+//   - users i and i+1 share the direct conversation direct(i).
+// Every user is therefore in groupSize groups and 2 direct conversations.
+struct Dataset {
+    std::size_t users = 1000;
+    std::size_t groupSize = 8;
+
+    // Stable UUID-shaped ids
+    std::string profileId(std::size_t user) const;
+    std::string authId(std::size_t user) const;
+    std::string groupId(std::size_t user) const;
+    std::string directId(std::size_t user) const;
+
+    // Same rule as ConversationService (ordered pair of profile ids)
+    static std::string directKey(const std::string& a, const std::string& b);
+
+    // Rows as PostgREST returns them (select=*)
+    nlohmann::json profiles() const;
+    nlohmann::json conversations() const;
+    nlohmann::json members() const;
+
+    // Upstream body of fetchMyConversations for one user (embedded conversation)
+    nlohmann::json conversationsPage(std::size_t user) const;
+};
+
+// Reads --name=value from argv, else the fallback
+std::string option(int argc, char** argv, const std::string& name, const std::string& fallback);
+
+// HS256 access token accepted by JwtVerifier (sub = authId, exp = now + ttl)
+std::string signAccessToken(const std::string& secret, const std::string& sub, std::int64_t ttlSeconds);
+
+} // namespace bench
+
+#endif //SECURE_CLOUD_BENCHFIXTURES_H
@@ -0,0 +1,212 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+// messaging-bench: microbenchmarks and load tests of the messaging service
+// against an in-process Supabase stand-in.
+//
+//   messaging-bench micro [--filter=parse] [--min-time=0.5] [--repetitions=3]
+//   messaging-bench mock  [--port=54321] [--latency-ms=2] [--jitter-ms=1]
+//   messaging-bench load  --target=http://127.0.0.1:8081 --jwt-secret=... [--rate=500]
+//   messaging-bench all   [--rate=500] [--duration=10] [--latency-ms=2] [--jitter-ms=1]
+//
+// "all" serves the mock and the service from one process (one listener) and
+// load-tests it; "mock" + "load" run them separately, against a real service
+// build started with SUPABASE_URL pointing at the mock.
+//
+// Common options: --users=1000 --group-size=8 (dataset), --threads (server IO
+// loops), --connections=32 --client-threads=2 --warmup=1 --mix=list=4,get=2,...
+// Exit code 1 when --max-error-rate (default 0.01) or --max-p99-ms (0 = off)
+// is exceeded, so a CI job can fail on a regression.
+
+#include "BenchFixtures.h"
+#include "LoadGenerator.h"
+#include "MicroBench.h"
+#include "MockSupabase.h"
+
+#include "../include/JwtVerifier.h"
+#include "Metrics.h"
+#include "../include/SupabaseClient.h"
+
+#include <drogon/drogon.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace {
+
+// ---------- Helper 1 : options ----------
+double number(int argc, char** argv, const char* name, double fallback) {
+    const auto raw = bench::option(argc, argv, name, "");
+    if (raw.empty()) return fallback;
+    try {
+        return std::stod(raw);
+    } catch (const std::exception&) {
+        std::cerr << "[WARN] --" << name << " invalide, valeur ignorée : " << raw << std::endl;
+        return fallback;
+    }
+}
+
+void setEnv(const char* key, const std::string& value, bool overwrite) {
+    if (!overwrite && std::getenv(key)) return;
+#ifdef _WIN32
+    _putenv_s(key, value.c_str());
+#else
+    setenv(key, value.c_str(), 1);
+#endif
+}
+
+bench::Dataset dataset(int argc, char** argv) {
+    bench::Dataset data;
+    data.users = static_cast<std::size_t>(number(argc, argv, "users", 1000));
+    data.groupSize = static_cast<std::size_t>(number(argc, argv, "group-size", 8));
+    return data;
+}
+
+bench::MockOptions mockOptions(int argc, char** argv) {
+    bench::MockOptions options;
+    options.data = dataset(argc, argv);
+    options.latencyMs = number(argc, argv, "latency-ms", 0);
+    options.jitterMs = number(argc, argv, "jitter-ms", 0);
+    return options;
+}
+
+bench::LoadOptions loadOptions(int argc, char** argv, const std::string& target, const std::string& secret) {
+    bench::LoadOptions options;
+    options.target = bench::option(argc, argv, "target", target);
+    options.rate = number(argc, argv, "rate", 500);
+    options.durationSeconds = number(argc, argv, "duration", 10);
+    options.warmupSeconds = number(argc, argv, "warmup", 1);
+    options.connections = static_cast<std::size_t>(number(argc, argv, "connections", 32));
+    options.threads = static_cast<std::size_t>(number(argc, argv, "client-threads", 2));
+    options.timeoutSeconds = number(argc, argv, "timeout", 10);
+    options.jwtSecret = bench::option(argc, argv, "jwt-secret", secret);
+    options.mix = bench::option(argc, argv, "mix", "");
+    options.data = dataset(argc, argv);
+    return options;
+}
+
+// ---------- Helper 2 : load test + thresholds ----------
+int runLoad(const bench::LoadOptions& options, int argc, char** argv) {
+    std::cout << "[INFO] Load test on " << options.target << " : " << options.rate << " req/s for "
+              << options.durationSeconds << "s (+" << options.warmupSeconds << "s warmup), "
+              << options.connections << " connections" << std::endl;
+
+    bench::LoadReport report;
+    try {
+        report = bench::LoadGenerator(options).run();
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << std::endl;
+        return 2;
+    }
+    bench::LoadGenerator::print(report, options.rate);
+
+    const auto& total = report.routes.back();
+    const double maxErrorRate = number(argc, argv, "max-error-rate", 0.01);
+    const double maxP99 = number(argc, argv, "max-p99-ms", 0);
+
+    int code = 0;
+    const double errorRate = total.sent ? static_cast<double>(total.errors) / static_cast<double>(total.sent) : 1.0;
+    if (errorRate > maxErrorRate) {
+        std::cerr << "[FAIL] error rate " << errorRate << " > " << maxErrorRate << std::endl;
+        code = 1;
+    }
+    if (maxP99 > 0 && total.p99Ms > maxP99) {
+        std::cerr << "[FAIL] p99 " << total.p99Ms << " ms > " << maxP99 << " ms" << std::endl;
+        code = 1;
+    }
+    return code;
+}
+
+void serveMock(const bench::MockOptions& options, std::size_t threads, std::uint16_t port,
+               std::unique_ptr<bench::MockSupabase>& holder) {
+    holder = std::make_unique<bench::MockSupabase>(options);
+    holder->registerRoutes(drogon::app());
+    drogon::app()
+        .addListener("127.0.0.1", port)
+        .setThreadNum(threads)
+        .setLogLevel(trantor::Logger::kWarn);
+
+    std::cout << "[INFO] Mock Supabase on 127.0.0.1:" << port << " (" << options.data.users << " users, latency "
+              << options.latencyMs << " ms +/- " << options.jitterMs << " ms)" << std::endl;
+}
+
+void usage() {
+    std::cerr << "usage: messaging-bench micro|mock|load|all [--option=value ...]" << std::endl
+              << "routes for --mix:";
+    for (const auto& name : bench::LoadGenerator::routeNames()) std::cerr << " " << name;
+    std::cerr << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string mode = argc > 1 ? argv[1] : "";
+    const auto threads = static_cast<std::size_t>(number(argc, argv, "threads", 2));
+
+    if (mode == "micro") {
+        return bench::runMicro(bench::option(argc, argv, "filter", ""),
+                               number(argc, argv, "min-time", 0.5),
+                               static_cast<int>(number(argc, argv, "repetitions", 3)));
+    }
+
+    if (mode == "load") {
+        const char* secret = std::getenv("SUPABASE_JWT_SECRET");
+        return runLoad(loadOptions(argc, argv, "http://127.0.0.1:8081", secret ? secret : ""), argc, argv);
+    }
+
+    std::unique_ptr<bench::MockSupabase> mock;
+
+    if (mode == "mock") {
+        const auto port = static_cast<std::uint16_t>(number(argc, argv, "port", 54321));
+        serveMock(mockOptions(argc, argv), threads, port, mock);
+        drogon::app().run();
+        return 0;
+    }
+
+    if (mode == "all") {
+        const auto port = static_cast<std::uint16_t>(number(argc, argv, "port", 18081));
+        const std::string base = "http://127.0.0.1:" + std::to_string(port);
+
+        // The service calls the mock on the same listener
+        setEnv("SUPABASE_URL", base, true);
+        setEnv("SUPABASE_ANON_KEY", "bench-anon-key", false);
+        setEnv("SUPABASE_JWT_SECRET", "bench-jwt-secret", false);
+#ifndef _WIN32
+        if (!std::getenv("MESSAGE_LOG_DIR")) {
+            char dir[] = "/tmp/messaging-bench-XXXXXX";
+            if (mkdtemp(dir)) setEnv("MESSAGE_LOG_DIR", dir, true);
+        }
+#endif
+
+        SupabaseClient::instance();
+        JwtVerifier::instance();
+        serveMock(mockOptions(argc, argv), threads, port, mock);
+        Metrics::instrument(drogon::app());
+
+        const auto options = loadOptions(argc, argv, base, std::getenv("SUPABASE_JWT_SECRET"));
+        int code = 0;
+        std::thread driver;
+        drogon::app().registerBeginningAdvice([&]() {
+            driver = std::thread([&]() {
+                code = runLoad(options, argc, argv);
+                std::cout << "[INFO] Mock requests served: " << mock->served() << std::endl;
+                drogon::app().quit();
+            });
+        });
+        drogon::app().run();
+        if (driver.joinable()) driver.join();
+        return code;
+    }
+
+    usage();
+    return 2;
+}
@@ -0,0 +1,313 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+// Microbenchmarks of the JSON work ConversationService does per request, on
+// upstream bodies shaped like the ones PostgREST sends. The service helpers
+// live in an anonymous namespace, so each case reproduces the helper it is
+// named after; keep them in sync when the service code changes.
+//
+// The parse/ build/ dump/ cases are the nlohmann::json versions the service
+// used before FastJson; they stay as the baseline of the fast/ cases.
+
+#include "BenchFixtures.h"
+#include "MicroBench.h"
+#include "MockSupabase.h"
+
+#include "../include/ConversationRows.h"
+#include "../include/FastJson.h"
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+// ---------- Helper 1 : fixtures ----------
+// 64 users in 50 groups each: a conversations page of 52 rows, 2 of them direct
+struct Fixtures {
+    bench::Dataset data;
+    std::string pageBody;          // fetchMyConversations
+    std::string membersBody;       // listMembers
+    std::string otherMembersBody;  // enrichDirectConversations, step 1
+    std::string profilesBody;      // enrichDirectConversations, step 2
+    json page;
+
+    Fixtures() {
+        data.users = 64;
+        data.groupSize = 50;
+
+        page = data.conversationsPage(0);
+        pageBody = page.dump();
+
+        json members = json::array();
+        for (const auto& m : data.members()) {
+            if (m["conversation_id"] == data.groupId(0)) members.push_back(m);
+        }
+        membersBody = members.dump();
+
+        otherMembersBody = json::array({
+            {{"conversation_id", data.directId(0)}, {"user_id", data.profileId(1)}},
+            {{"conversation_id", data.directId(63)}, {"user_id", data.profileId(63)}}
+        }).dump();
+
+        json profiles = json::array();
+        for (const auto& p : data.profiles()) {
+            if (p["id"] == data.profileId(1) || p["id"] == data.profileId(63)) {
+                profiles.push_back({{"id", p["id"]}, {"first_name", p["first_name"]}, {"last_name", p["last_name"]}});
+            }
+        }
+        profilesBody = profiles.dump();
+    }
+};
+
+const Fixtures& fixtures() {
+    static const Fixtures f;
+    return f;
+}
+
+std::string formatDisplayName(const json& p) {
+    std::string first = p.contains("first_name") && p["first_name"].is_string() ? p["first_name"].get<std::string>() : "";
+    std::string last  = p.contains("last_name") && p["last_name"].is_string() ? p["last_name"].get<std::string>() : "";
+
+    if (!first.empty() && !last.empty()) return first + " " + last;
+    if (!first.empty()) return first;
+    if (!last.empty()) return last;
+    return "Utilisateur";
+}
+
+// ---------- Helper 2 : upstream parsing ----------
+BENCH_CASE("parse/conversations_page_52", [](bench::State& state) {
+    const auto& f = fixtures();
+    state.setBytesPerIteration(f.pageBody.size());
+    while (state.keepRunning()) {
+        auto j = json::parse(f.pageBody, nullptr, false);
+        bench::doNotOptimize(j);
+    }
+});
+
+BENCH_CASE("parse/members_50", [](bench::State& state) {
+    const auto& f = fixtures();
+    state.setBytesPerIteration(f.membersBody.size());
+    while (state.keepRunning()) {
+        auto j = json::parse(f.membersBody, nullptr, false);
+        bench::doNotOptimize(j);
+    }
+});
+
+// fetchMemberRoleAndOwnerCount: parse + count the owners
+BENCH_CASE("parse/owner_count_50", [](bench::State& state) {
+    const auto& f = fixtures();
+    while (state.keepRunning()) {
+        auto rows = json::parse(f.membersBody, nullptr, false);
+        int owners = 0;
+        for (const auto& m : rows) {
+            if (m.is_object() && m.contains("role") && m["role"].is_string() &&
+                m["role"].get<std::string>() == "owner") ++owners;
+        }
+        bench::doNotOptimize(owners);
+    }
+});
+
+// ---------- Helper 3 : response building ----------
+// enrichDirectConversations: index the direct rows, join members + profiles
+BENCH_CASE("build/enrich_direct_names", [](bench::State& state) {
+    const auto& f = fixtures();
+    const auto members = json::parse(f.otherMembersBody);
+    const auto profiles = json::parse(f.profilesBody);
+    while (state.keepRunning()) {
+        json rows = f.page;
+
+        std::unordered_map<std::string, std::vector<size_t>> directRows;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            const auto& conv = rows[i]["conversation"];
+            if (conv["type"].get<std::string>() != "direct") continue;
+            directRows[conv["id"].get<std::string>()].push_back(i);
+        }
+
+        std::unordered_map<std::string, std::string> otherByConv;
+        for (const auto& m : members) {
+            otherByConv.emplace(m["conversation_id"].get<std::string>(), m["user_id"].get<std::string>());
+        }
+        std::unordered_map<std::string, std::string> nameById;
+        for (const auto& p : profiles) {
+            nameById[p["id"].get<std::string>()] = formatDisplayName(p);
+        }
+        for (const auto& [convId, indexes] : directRows) {
+            auto other = otherByConv.find(convId);
+            if (other == otherByConv.end()) continue;
+            auto name = nameById.find(other->second);
+            if (name == nameById.end()) continue;
+            for (size_t i : indexes) {
+                auto& conv = rows[i]["conversation"];
+                conv["display_name"] = name->second;
+                conv["other_user_id"] = other->second;
+            }
+        }
+        bench::doNotOptimize(rows);
+    }
+});
+
+// toHttpResponse: Result::body.dump()
+BENCH_CASE("dump/conversations_page_52", [](bench::State& state) {
+    const auto& f = fixtures();
+    state.setBytesPerIteration(f.pageBody.size());
+    while (state.keepRunning()) {
+        auto body = f.page.dump();
+        bench::doNotOptimize(body);
+    }
+});
+
+// createConversationRowWithDirectKey: insert payload
+BENCH_CASE("build/conversation_payload", [](bench::State& state) {
+    const auto& f = fixtures();
+    const auto me = f.data.profileId(0);
+    const auto key = bench::Dataset::directKey(me, f.data.profileId(1));
+    while (state.keepRunning()) {
+        json convPayload;
+        convPayload["type"] = "direct";
+        convPayload["created_by"] = me;
+        convPayload["direct_key"] = key;
+        auto body = convPayload.dump();
+        bench::doNotOptimize(body);
+    }
+});
+
+// realtimeEvent("member.added", ...): one event per membership change
+BENCH_CASE("build/realtime_event", [](bench::State& state) {
+    const auto& f = fixtures();
+    const auto member = json::parse(f.membersBody)[2];
+    const auto convId = f.data.groupId(0);
+    while (state.keepRunning()) {
+        json event;
+        event["type"] = "member.added";
+        event["conversation_id"] = convId;
+        event["member"] = member;
+        auto body = event.dump();
+        bench::doNotOptimize(body);
+    }
+});
+
+// ---------- Helper 4 : the same work with FastJson (what the service does now) ----------
+// readConversationPage: typed rows, views into the body
+BENCH_CASE("fast/read_conversations_page_52", [](bench::State& state) {
+    const auto& f = fixtures();
+    state.setBytesPerIteration(f.pageBody.size());
+    while (state.keepRunning()) {
+        auto page = readConversationPage(f.pageBody);
+        bench::doNotOptimize(page);
+    }
+});
+
+// fetchMemberRoleAndOwnerCount: MemberRow vector, count + find by 16-byte id
+BENCH_CASE("fast/owner_count_50", [](bench::State& state) {
+    const auto& f = fixtures();
+    Uuid target;
+    Uuid::parse(f.data.profileId(7), target);
+    std::vector<MemberRow> rows;
+    while (state.keepRunning()) {
+        rows.clear();
+        readMemberRows(f.membersBody, rows);
+        const auto owners = std::count_if(rows.begin(), rows.end(),
+            [](const MemberRow& m) { return m.role == MemberRole::Owner; });
+        const auto member = std::find_if(rows.begin(), rows.end(),
+            [&](const MemberRow& m) { return m.userId == target; });
+        bench::doNotOptimize(owners);
+        bench::doNotOptimize(member);
+    }
+});
+
+// writeConversationRows: rows copied as received, display_name appended
+BENCH_CASE("fast/write_conversations_page_52", [](bench::State& state) {
+    const auto& f = fixtures();
+    const auto page = readConversationPage(f.pageBody);
+    state.setBytesPerIteration(f.pageBody.size());
+    while (state.keepRunning()) {
+        std::string out;
+        out.reserve(f.pageBody.size() + 64 * page->rows.size());
+        fastjson::Writer w(out);
+        w.beginArray();
+        for (const auto& r : page->rows) {
+            w.beginObject();
+            fastjson::forEachMember(r.row, [&](std::string_view key, const fastjson::Value& v) {
+                w.rawKey(key);
+                if (key != "conversation") {
+                    w.raw(v.raw);
+                    return;
+                }
+                w.beginObject();
+                fastjson::forEachMember(r.conversation, [&](std::string_view k, const fastjson::Value& cv) {
+                    if (k != "display_name") w.rawKey(k).raw(cv.raw);
+                });
+                w.field("display_name", r.name.empty() ? std::string_view("Groupe") : r.name);
+                w.endObject();
+            });
+            w.endObject();
+        }
+        w.endArray();
+        bench::doNotOptimize(out);
+    }
+});
+
+BENCH_CASE("fast/conversation_payload", [](bench::State& state) {
+    const auto& f = fixtures();
+    const auto me = f.data.profileId(0);
+    const auto key = bench::Dataset::directKey(me, f.data.profileId(1));
+    while (state.keepRunning()) {
+        std::string body;
+        fastjson::Writer(body)
+            .beginObject()
+            .field("direct_key", key)
+            .field("type", "direct")
+            .field("created_by", me)
+            .endObject();
+        bench::doNotOptimize(body);
+    }
+});
+
+// realtimeEvent: the member row is spliced as received
+BENCH_CASE("fast/realtime_event", [](bench::State& state) {
+    const auto& f = fixtures();
+    fastjson::Value rows;
+    fastjson::parse(f.membersBody, rows);
+    std::string member;
+    int i = 0;
+    fastjson::forEachElement(rows, [&](const fastjson::Value& m) {
+        if (i++ == 2) member = std::string(m.raw);
+    });
+    const auto convId = f.data.groupId(0);
+    while (state.keepRunning()) {
+        std::string event;
+        event.reserve(64 + convId.size() + member.size());
+        fastjson::Writer(event)
+            .beginObject()
+            .field("type", "member.added")
+            .field("conversation_id", convId)
+            .key("member").raw(member)
+            .endObject();
+        bench::doNotOptimize(event);
+    }
+});
+
+// ---------- Helper 5 : the stand-in itself (its cost is part of every load-test number) ----------
+BENCH_CASE("mock/list_page", [](bench::State& state) {
+    static const bench::MockSupabase mock(bench::MockOptions{fixtures().data, 0, 0});
+    const bench::MockSupabase::Params params = {
+        {"select", "conversation:conversations!inner(*),role,joined_at,left_at"},
+        {"user_id", "eq." + fixtures().data.profileId(0)},
+        {"left_at", "is.null"},
+        {"conversation.deleted_at", "is.null"},
+        {"order", "conversation(updated_at).desc,conversation(id).desc"},
+        {"limit", "21"}
+    };
+    while (state.keepRunning()) {
+        auto reply = mock.rest("GET", "conversation_members", params, "");
+        bench::doNotOptimize(reply);
+    }
+});
+
+} // namespace
@@ -0,0 +1,294 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "LoadGenerator.h"
+
+#include <drogon/HttpClient.h>
+#include <trantor/net/EventLoopThreadPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+namespace bench {
+
+namespace {
+
+// ---------- Helper 1 : the routes of ConversationController ----------
+struct Request {
+    std::string path;
+    std::vector<std::pair<std::string, std::string>> query;
+    json body;   // null = no body
+};
+
+struct Route {
+    const char* name;
+    drogon::HttpMethod method;
+    Request (*build)(const Dataset& data, std::size_t user);
+};
+
+const std::vector<Route>& allRoutes() {
+    static const std::vector<Route> routes = {
+        {"create_group", drogon::Post, [](const Dataset&, std::size_t) {
+            return Request{"/conversations", {}, {{"type", "group"}, {"name", "bench"}}};
+        }},
+        {"create_direct", drogon::Post, [](const Dataset& d, std::size_t u) {
+            // Already exists in the dataset: exercises the direct_key lookup
+            return Request{"/conversations", {}, {{"type", "direct"}, {"target_user_id", d.profileId(u + 1)}}};
+        }},
+        {"list", drogon::Get, [](const Dataset&, std::size_t) {
+            return Request{"/conversations", {{"limit", "20"}}, nullptr};
+        }},
+        {"changes", drogon::Get, [](const Dataset&, std::size_t) {
+            return Request{"/conversations/changes", {{"since", "2026-01-01T00:00:00Z"}}, nullptr};
+        }},
+        {"get", drogon::Get, [](const Dataset& d, std::size_t u) {
+            return Request{"/conversations/" + d.groupId(u), {}, nullptr};
+        }},
+        {"update", drogon::Patch, [](const Dataset& d, std::size_t u) {
+            return Request{"/conversations/" + d.groupId(u), {}, {{"name", "bench renamed"}}};
+        }},
+        {"delete", drogon::Delete, [](const Dataset& d, std::size_t u) {
+            return Request{"/conversations/" + d.groupId(u), {}, nullptr};
+        }},
+        {"add_member", drogon::Post, [](const Dataset& d, std::size_t u) {
+            // First user after the group's members
+            return Request{"/conversations/" + d.groupId(u) + "/members", {},
+                           {{"user_id", d.profileId(u + d.groupSize)}}};
+        }},
+        {"members_batch", drogon::Post, [](const Dataset& d, std::size_t u) {
+            // The four users after the group's members, in one insert
+            json ids = json::array();
+            for (std::size_t i = 0; i < 4; ++i) ids.push_back(d.profileId(u + d.groupSize + i));
+            return Request{"/conversations/" + d.groupId(u) + "/members:batch", {}, {{"user_ids", ids}}};
+        }},
+        {"members", drogon::Get, [](const Dataset& d, std::size_t u) {
+            return Request{"/conversations/" + d.groupId(u) + "/members", {}, nullptr};
+        }},
+        {"post_message", drogon::Post, [](const Dataset& d, std::size_t u) {
+            return Request{"/conversations/" + d.groupId(u) + "/messages", {},
+                           {{"body", "Bonjour, ceci est un message de test de charge."}}};
+        }},
+        {"messages", drogon::Get, [](const Dataset& d, std::size_t u) {
+            return Request{"/conversations/" + d.groupId(u) + "/messages", {{"limit", "50"}}, nullptr};
+        }},
+        {"update_role", drogon::Patch, [](const Dataset& d, std::size_t u) {
+            return Request{"/conversations/" + d.groupId(u) + "/members/" + d.profileId(u + 2), {},
+                           {{"role", "admin"}}};
+        }},
+        {"delete_member", drogon::Delete, [](const Dataset& d, std::size_t u) {
+            return Request{"/conversations/" + d.groupId(u) + "/members/" + d.profileId(u + 2), {}, nullptr};
+        }},
+    };
+    return routes;
+}
+
+// "list=4,get=2" -> one slot per unit of weight
+std::vector<std::size_t> parseMix(const std::string& mix) {
+    const auto& routes = allRoutes();
+    std::vector<std::size_t> slots;
+    if (mix.empty()) {
+        for (std::size_t i = 0; i < routes.size(); ++i) slots.push_back(i);
+        return slots;
+    }
+
+    std::size_t start = 0;
+    while (start <= mix.size()) {
+        auto end = mix.find(',', start);
+        if (end == std::string::npos) end = mix.size();
+        const std::string item = mix.substr(start, end - start);
+        start = end + 1;
+        if (item.empty()) continue;
+
+        const auto eq = item.find('=');
+        const std::string name = item.substr(0, eq);
+        const std::size_t weight = eq == std::string::npos ? 1 : std::stoul(item.substr(eq + 1));
+
+        auto it = std::find_if(routes.begin(), routes.end(), [&name](const Route& r) { return name == r.name; });
+        if (it == routes.end()) throw std::invalid_argument("unknown route in mix: " + name);
+        slots.insert(slots.end(), weight, static_cast<std::size_t>(it - routes.begin()));
+    }
+    if (slots.empty()) throw std::invalid_argument("empty route mix");
+    return slots;
+}
+
+// ---------- Helper 2 : per-route samples ----------
+struct Recorder {
+    std::mutex mutex;
+    std::vector<std::uint32_t> micros;   // completed, measured requests
+    std::uint64_t sent = 0;
+    std::uint64_t errors = 0;
+};
+
+double percentileMs(const std::vector<std::uint32_t>& sorted, double q) {
+    if (sorted.empty()) return 0;
+    auto rank = static_cast<std::size_t>(std::ceil(q * static_cast<double>(sorted.size())));
+    rank = std::min(std::max<std::size_t>(rank, 1), sorted.size());
+    return sorted[rank - 1] / 1000.0;
+}
+
+RouteReport summarize(const std::string& name, std::vector<std::uint32_t> micros,
+                      std::uint64_t sent, std::uint64_t errors) {
+    std::sort(micros.begin(), micros.end());
+    RouteReport r;
+    r.route = name;
+    r.sent = sent;
+    r.errors = errors;
+    r.p50Ms = percentileMs(micros, 0.50);
+    r.p90Ms = percentileMs(micros, 0.90);
+    r.p99Ms = percentileMs(micros, 0.99);
+    r.p999Ms = percentileMs(micros, 0.999);
+    r.maxMs = micros.empty() ? 0 : micros.back() / 1000.0;
+    return r;
+}
+
+} // namespace
+
+LoadGenerator::LoadGenerator(LoadOptions options)
+    : options_(std::move(options)) {}
+
+std::vector<std::string> LoadGenerator::routeNames() {
+    std::vector<std::string> names;
+    for (const auto& r : allRoutes()) names.emplace_back(r.name);
+    return names;
+}
+
+LoadReport LoadGenerator::run() {
+    const auto& routes = allRoutes();
+    const auto slots = parseMix(options_.mix);
+    const auto& data = options_.data;
+    if (options_.rate <= 0) throw std::invalid_argument("rate must be > 0");
+    if (data.users <= data.groupSize || data.groupSize < 3) {
+        throw std::invalid_argument("dataset needs groupSize >= 3 and more users than groupSize");
+    }
+
+    // One access token per dataset user, signed once
+    std::vector<std::string> bearers;
+    bearers.reserve(data.users);
+    for (std::size_t u = 0; u < data.users; ++u) {
+        bearers.push_back("Bearer " + signAccessToken(options_.jwtSecret, data.authId(u), 24 * 3600));
+    }
+
+    trantor::EventLoopThreadPool pool(std::max<std::size_t>(options_.threads, 1), "bench-client");
+    pool.start();
+    std::vector<drogon::HttpClientPtr> clients;
+    for (std::size_t i = 0; i < std::max<std::size_t>(options_.connections, 1); ++i) {
+        clients.push_back(drogon::HttpClient::newHttpClient(options_.target, pool.getNextLoop()));
+    }
+
+    auto recorders = std::make_shared<std::vector<Recorder>>(routes.size());
+    auto outstanding = std::make_shared<std::atomic<std::uint64_t>>(0);
+
+    const auto period = std::chrono::duration<double>(1.0 / options_.rate);
+    const auto total = static_cast<std::uint64_t>((options_.warmupSeconds + options_.durationSeconds) * options_.rate);
+    const auto firstMeasured = static_cast<std::uint64_t>(options_.warmupSeconds * options_.rate);
+
+    std::mt19937_64 rng(42);
+    const auto start = Clock::now();
+
+    // Open loop: issue everything that is due, then sleep until the next one
+    for (std::uint64_t k = 0; k < total;) {
+        const auto now = Clock::now();
+        for (; k < total; ++k) {
+            const auto due = start + std::chrono::duration_cast<Clock::duration>(period * static_cast<double>(k));
+            if (due > now) break;
+
+            const std::size_t routeIndex = slots[rng() % slots.size()];
+            const std::size_t user = rng() % data.users;
+            const auto& route = routes[routeIndex];
+            const Request call = route.build(data, user);
+
+            auto req = drogon::HttpRequest::newHttpRequest();
+            req->setMethod(route.method);
+            req->setPath(call.path);
+            for (const auto& [key, value] : call.query) req->setParameter(key, value);
+            req->addHeader("Authorization", bearers[user]);
+            if (!call.body.is_null()) {
+                req->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+                req->setBody(call.body.dump());
+            }
+
+            const bool measured = k >= firstMeasured;
+            if (measured) {
+                std::lock_guard<std::mutex> lock((*recorders)[routeIndex].mutex);
+                ++(*recorders)[routeIndex].sent;
+            }
+            outstanding->fetch_add(1, std::memory_order_relaxed);
+
+            clients[k % clients.size()]->sendRequest(
+                req,
+                [recorders, outstanding, routeIndex, due, measured](drogon::ReqResult result,
+                                                                   const drogon::HttpResponsePtr& resp) {
+                    if (measured) {
+                        const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - due).count();
+                        const bool ok = result == drogon::ReqResult::Ok && resp &&
+                                        resp->statusCode() >= 200 && resp->statusCode() < 300;
+                        auto& rec = (*recorders)[routeIndex];
+                        std::lock_guard<std::mutex> lock(rec.mutex);
+                        if (ok) rec.micros.push_back(static_cast<std::uint32_t>(std::min<long long>(micros, UINT32_MAX)));
+                        else ++rec.errors;
+                    }
+                    outstanding->fetch_sub(1, std::memory_order_relaxed);
+                },
+                options_.timeoutSeconds);
+        }
+        if (k < total) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(period * static_cast<double>(k)));
+        }
+    }
+
+    // Drain: every request completes or times out
+    const auto deadline = Clock::now() + std::chrono::duration<double>(options_.timeoutSeconds + 2);
+    while (outstanding->load(std::memory_order_relaxed) > 0 && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count() - options_.warmupSeconds;
+
+    LoadReport report;
+    report.seconds = std::max(elapsed, options_.durationSeconds);
+
+    std::vector<std::uint32_t> all;
+    std::uint64_t sent = 0, errors = 0;
+    for (std::size_t i = 0; i < routes.size(); ++i) {
+        auto& rec = (*recorders)[i];
+        std::lock_guard<std::mutex> lock(rec.mutex);
+        if (rec.sent == 0) continue;
+        all.insert(all.end(), rec.micros.begin(), rec.micros.end());
+        sent += rec.sent;
+        errors += rec.errors;
+        report.routes.push_back(summarize(routes[i].name, rec.micros, rec.sent, rec.errors));
+    }
+    report.throughput = static_cast<double>(all.size()) / report.seconds;
+    report.routes.push_back(summarize("total", std::move(all), sent, errors));
+
+    clients.clear();
+    return report;
+}
+
+void LoadGenerator::print(const LoadReport& report, double targetRate) {
+    std::printf("%-14s %9s %7s %9s %9s %9s %9s %9s\n",
+                "route", "sent", "errors", "p50 ms", "p90 ms", "p99 ms", "p99.9 ms", "max ms");
+    for (const auto& r : report.routes) {
+        std::printf("%-14s %9llu %7llu %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+                    r.route.c_str(),
+                    static_cast<unsigned long long>(r.sent),
+                    static_cast<unsigned long long>(r.errors),
+                    r.p50Ms, r.p90Ms, r.p99Ms, r.p999Ms, r.maxMs);
+    }
+    std::printf("throughput: %.1f req/s (offered %.1f req/s over %.1f s)\n",
+                report.throughput, targetRate, report.seconds);
+}
+
+} // namespace bench
@@ -0,0 +1,71 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_LOADGENERATOR_H
+#define SECURE_CLOUD_LOADGENERATOR_H
+
+#include "BenchFixtures.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+struct LoadOptions {
+    std::string target = "http://127.0.0.1:8081";
+    double rate = 500;              // requests per second, all routes together
+    double durationSeconds = 10;
+    double warmupSeconds = 1;       // sent but not recorded
+    std::size_t connections = 32;
+    std::size_t threads = 2;        // client IO loops
+    double timeoutSeconds = 10;
+    std::string jwtSecret;          // HS256 secret of the service under test
+    std::string mix;                // "list=4,get=2,..." ; empty = every route, weight 1
+    Dataset data;
+};
+
+struct RouteReport {
+    std::string route;
+    std::uint64_t sent = 0;
+    std::uint64_t errors = 0;       // transport errors and non-2xx replies
+    double p50Ms = 0, p90Ms = 0, p99Ms = 0, p999Ms = 0, maxMs = 0;
+};
+
+struct LoadReport {
+    double seconds = 0;
+    double throughput = 0;          // completed requests / s
+    std::vector<RouteReport> routes;   // one per route, then "total"
+};
+
+// Open-loop HTTP load generator over the ConversationController routes.
+//
+// Requests are issued on a fixed schedule (rate) whether or not earlier ones
+// have completed, and each latency is measured from the time the request was
+// due, not the time it left: a stalled server shows up in the percentiles
+// instead of silently lowering the offered load (coordinated omission).
+//
+// Every request acts as a random dataset user on conversations the mock
+// answers for (its own group, its direct conversation...), so the same mix
+// can run indefinitely against the stateless MockSupabase.
+class LoadGenerator {
+public:
+    explicit LoadGenerator(LoadOptions options);
+
+    // Blocks for warmup + duration + drain
+    LoadReport run();
+
+    static void print(const LoadReport& report, double targetRate);
+
+    // Route names accepted in LoadOptions::mix
+    static std::vector<std::string> routeNames();
+
+private:
+    LoadOptions options_;
+};
+
+} // namespace bench
+
+#endif //SECURE_CLOUD_LOADGENERATOR_H
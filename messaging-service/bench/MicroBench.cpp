@@ -0,0 +1,112 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "MicroBench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// ---------- Helper 1 : heap allocation counter ----------
+std::atomic<std::uint64_t> gAllocations{0};
+
+void* countedAlloc(std::size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+// ---------- Helper 2 : registry ----------
+std::vector<std::pair<std::string, bench::MicroCase>>& registry() {
+    static std::vector<std::pair<std::string, bench::MicroCase>> cases;
+    return cases;
+}
+
+struct Batch {
+    double seconds = 0;
+    std::uint64_t allocations = 0;
+};
+
+Batch runBatch(const bench::MicroCase& body, std::uint64_t iterations, std::size_t& bytes) {
+    bench::State state(iterations);
+    const auto allocBefore = gAllocations.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    body(state);
+    const auto stop = std::chrono::steady_clock::now();
+    bytes = state.bytesPerIteration();
+    return {std::chrono::duration<double>(stop - start).count(),
+            gAllocations.load(std::memory_order_relaxed) - allocBefore};
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace bench {
+
+bool registerMicro(const char* name, MicroCase body) {
+    registry().emplace_back(name, std::move(body));
+    return true;
+}
+
+int runMicro(const std::string& filter, double minTimeSeconds, int repetitions) {
+    auto& cases = registry();
+    std::sort(cases.begin(), cases.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::printf("%-40s %12s %14s %12s %10s\n", "case", "ns/op", "ops/s", "allocs/op", "MB/s");
+    int ran = 0;
+    for (const auto& [name, body] : cases) {
+        if (!filter.empty() && name.find(filter) == std::string::npos) continue;
+        ++ran;
+
+        // Calibrate: grow the iteration count until a batch lasts minTime
+        std::size_t bytes = 0;
+        std::uint64_t iterations = 1;
+        Batch batch = runBatch(body, iterations, bytes);
+        while (batch.seconds < minTimeSeconds && iterations < (1ull << 40)) {
+            const double scale = batch.seconds > 0 ? minTimeSeconds / batch.seconds * 1.2 : 10.0;
+            iterations = std::max<std::uint64_t>(iterations + 1,
+                static_cast<std::uint64_t>(static_cast<double>(iterations) * std::min(scale, 10.0)));
+            batch = runBatch(body, iterations, bytes);
+        }
+
+        // Best of the repetitions: the least disturbed run
+        Batch best = batch;
+        for (int r = 1; r < repetitions; ++r) {
+            const Batch again = runBatch(body, iterations, bytes);
+            if (again.seconds < best.seconds) best = again;
+        }
+
+        const double nsPerOp = best.seconds * 1e9 / static_cast<double>(iterations);
+        const double allocsPerOp = static_cast<double>(best.allocations) / static_cast<double>(iterations);
+        char throughput[32] = "-";
+        if (bytes > 0) {
+            std::snprintf(throughput, sizeof(throughput), "%.1f",
+                          static_cast<double>(bytes) * static_cast<double>(iterations) / best.seconds / 1e6);
+        }
+        std::printf("%-40s %12.1f %14.0f %12.1f %10s\n",
+                    name.c_str(), nsPerOp, 1e9 / nsPerOp, allocsPerOp, throughput);
+        std::fflush(stdout);
+    }
+
+    if (ran == 0) {
+        std::fprintf(stderr, "No microbenchmark matches '%s'\n", filter.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace bench
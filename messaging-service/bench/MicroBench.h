@@ -0,0 +1,66 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_MICROBENCH_H
+#define SECURE_CLOUD_MICROBENCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace bench {
+
+// Minimal microbenchmark harness, in the spirit of Google Benchmark:
+//
+//   BENCH_CASE("parse/conversations_page", [](bench::State& state) {
+//       while (state.keepRunning()) { ... }
+//   });
+//
+// Each case runs with a growing iteration count until one batch lasts at
+// least --min-time, then reports the best of --repetitions batches in ns/op,
+// plus heap allocations per iteration (global operator new is counted in
+// this binary).
+class State {
+public:
+    explicit State(std::uint64_t iterations) : remaining_(iterations) {}
+
+    bool keepRunning() { return remaining_-- > 0; }
+
+    // Bytes processed per iteration, reported as MB/s
+    void setBytesPerIteration(std::size_t bytes) { bytes_ = bytes; }
+    std::size_t bytesPerIteration() const { return bytes_; }
+
+private:
+    std::uint64_t remaining_;
+    std::size_t bytes_ = 0;
+};
+
+using MicroCase = std::function<void(State&)>;
+
+// Registered before main() runs (static initialisation)
+bool registerMicro(const char* name, MicroCase body);
+
+// Runs every case whose name contains filter; returns the process exit code
+int runMicro(const std::string& filter, double minTimeSeconds, int repetitions);
+
+// Keeps the optimiser from dropping a computed value
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+} // namespace bench
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+#define BENCH_CASE(name, ...) \
+    static const bool BENCH_CONCAT(benchCase_, __LINE__) = ::bench::registerMicro(name, __VA_ARGS__)
+
+#endif //SECURE_CLOUD_MICROBENCH_H
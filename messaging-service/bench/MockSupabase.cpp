@@ -0,0 +1,639 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "MockSupabase.h"
+
+#include <drogon/HttpResponse.h>
+#include <trantor/net/EventLoop.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+
+using json = nlohmann::json;
+
+namespace bench {
+
+namespace {
+
+// ---------- Helper 1 : PostgREST syntax ----------
+// Splits on sep outside of (...) and "..."
+std::vector<std::string> splitTopLevel(const std::string& s, char sep) {
+    std::vector<std::string> out;
+    std::string cur;
+    int depth = 0;
+    bool quoted = false;
+    for (char c : s) {
+        if (c == '"') quoted = !quoted;
+        else if (!quoted && c == '(') ++depth;
+        else if (!quoted && c == ')') --depth;
+
+        if (c == sep && depth == 0 && !quoted) {
+            out.push_back(std::move(cur));
+            cur.clear();
+        } else {
+            cur += c;
+        }
+    }
+    if (!cur.empty()) out.push_back(std::move(cur));
+    return out;
+}
+
+std::string unquote(const std::string& s) {
+    if (s.size() >= 2 && s.front() == '"' && s.back() == '"') return s.substr(1, s.size() - 2);
+    return s;
+}
+
+// A cell as PostgREST compares it in a filter
+std::string cellText(const json& v) {
+    if (v.is_string()) return v.get_ref<const std::string&>();
+    if (v.is_null()) return "null";
+    return v.dump();
+}
+
+struct Condition {
+    std::string column;
+    std::string op;
+    std::string value;
+    bool negate = false;
+};
+
+// expr = "op.value" or "not.op.value"
+bool parseCondition(const std::string& column, const std::string& expr, Condition& out) {
+    out.column = column;
+    std::string rest = expr;
+    if (rest.compare(0, 4, "not.") == 0) {
+        out.negate = true;
+        rest = rest.substr(4);
+    }
+    const auto dot = rest.find('.');
+    if (dot == std::string::npos) return false;
+    out.op = rest.substr(0, dot);
+    out.value = unquote(rest.substr(dot + 1));
+
+    static const char* const ops[] = {"eq", "neq", "gt", "gte", "lt", "lte", "is", "in"};
+    return std::find(std::begin(ops), std::end(ops), out.op) != std::end(ops);
+}
+
+bool matches(const json& row, const Condition& c) {
+    static const json null;
+    auto it = row.find(c.column);
+    const json& cell = it == row.end() ? null : *it;
+
+    bool result = false;
+    if (c.op == "is") {
+        if (c.value == "null") result = cell.is_null();
+        else if (c.value == "true") result = cell.is_boolean() && cell.get<bool>();
+        else if (c.value == "false") result = cell.is_boolean() && !cell.get<bool>();
+    } else if (c.op == "in") {
+        if (!cell.is_null()) {
+            const std::string text = cellText(cell);
+            const std::string list = c.value.size() >= 2 ? c.value.substr(1, c.value.size() - 2) : "";
+            for (const auto& item : splitTopLevel(list, ',')) {
+                if (unquote(item) == text) { result = true; break; }
+            }
+        }
+    } else if (!cell.is_null()) {
+        // Lexicographic order: enough for the ids and ISO timestamps of the dataset
+        const std::string text = cellText(cell);
+        if (c.op == "eq") result = text == c.value;
+        else if (c.op == "neq") result = text != c.value;
+        else if (c.op == "gt") result = text > c.value;
+        else if (c.op == "gte") result = text >= c.value;
+        else if (c.op == "lt") result = text < c.value;
+        else if (c.op == "lte") result = text <= c.value;
+    }
+    return result != c.negate;
+}
+
+// or=(a.op.v,b.op.v) ; nested and(...)/or(...) are accepted as true
+struct OrGroup {
+    std::vector<Condition> any;
+    bool alwaysTrue = false;
+};
+
+bool parseOr(const std::string& value, OrGroup& out) {
+    if (value.size() < 2 || value.front() != '(' || value.back() != ')') return false;
+    for (const auto& item : splitTopLevel(value.substr(1, value.size() - 2), ',')) {
+        if (item.compare(0, 4, "and(") == 0 || item.compare(0, 3, "or(") == 0) {
+            out.alwaysTrue = true;
+            continue;
+        }
+        const auto dot = item.find('.');
+        if (dot == std::string::npos) return false;
+        Condition c;
+        if (!parseCondition(item.substr(0, dot), item.substr(dot + 1), c)) return false;
+        out.any.push_back(std::move(c));
+    }
+    return true;
+}
+
+bool matchesAll(const json& row, const std::vector<Condition>& where, const std::vector<OrGroup>& ors) {
+    for (const auto& c : where) {
+        if (!matches(row, c)) return false;
+    }
+    for (const auto& group : ors) {
+        if (group.alwaysTrue) continue;
+        bool any = false;
+        for (const auto& c : group.any) {
+            if (matches(row, c)) { any = true; break; }
+        }
+        if (!any) return false;
+    }
+    return true;
+}
+
+// select=a,b,alias:table!inner(cols)
+struct Embed {
+    bool present = false;
+    std::string alias;
+    std::string table;
+    std::string foreignKey;   // column of the parent row
+    std::vector<std::string> columns;
+    bool inner = false;
+};
+
+struct Select {
+    bool all = true;
+    std::vector<std::string> columns;
+    Embed embed;
+};
+
+Select parseSelect(const std::string& value) {
+    Select sel;
+    sel.all = false;
+    for (const auto& item : splitTopLevel(value, ',')) {
+        const auto paren = item.find('(');
+        if (paren == std::string::npos) {
+            if (item == "*") sel.all = true;
+            else sel.columns.push_back(item);
+            continue;
+        }
+
+        Embed& e = sel.embed;
+        e.present = true;
+        std::string head = item.substr(0, paren);
+        const auto colon = head.find(':');
+        if (colon != std::string::npos) {
+            e.alias = head.substr(0, colon);
+            head = head.substr(colon + 1);
+        }
+        const auto bang = head.find('!');
+        if (bang != std::string::npos) {
+            e.inner = head.substr(bang + 1) == "inner";
+            head = head.substr(0, bang);
+        }
+        e.table = head;
+        if (e.alias.empty()) e.alias = head;
+        // conversations -> conversation_id
+        e.foreignKey = (head.size() > 1 && head.back() == 's' ? head.substr(0, head.size() - 1) : head) + "_id";
+
+        const std::string inside = item.substr(paren + 1, item.size() - paren - 2);
+        for (const auto& col : splitTopLevel(inside, ',')) {
+            if (col != "*") e.columns.push_back(col);
+        }
+    }
+    return sel;
+}
+
+// order=col.desc,alias(col).asc
+struct OrderKey {
+    bool embedded = false;
+    std::string column;
+    bool desc = false;
+};
+
+std::vector<OrderKey> parseOrder(const std::string& value) {
+    std::vector<OrderKey> keys;
+    for (auto item : splitTopLevel(value, ',')) {
+        OrderKey key;
+        const auto dot = item.rfind('.');
+        if (dot != std::string::npos && item.find(')', dot) == std::string::npos) {
+            const std::string dir = item.substr(dot + 1);
+            if (dir == "desc" || dir == "asc") {
+                key.desc = dir == "desc";
+                item = item.substr(0, dot);
+            }
+        }
+        const auto paren = item.find('(');
+        if (paren != std::string::npos) {
+            key.embedded = true;
+            key.column = item.substr(paren + 1, item.size() - paren - 2);
+        } else {
+            key.column = item;
+        }
+        keys.push_back(std::move(key));
+    }
+    return keys;
+}
+
+json projectColumns(const json& row, bool all, const std::vector<std::string>& columns) {
+    if (all || columns.empty()) return row;
+    json out = json::object();
+    for (const auto& col : columns) {
+        auto it = row.find(col);
+        out[col] = it == row.end() ? json() : *it;
+    }
+    return out;
+}
+
+// ---------- Helper 2 : replies ----------
+MockSupabase::Reply reply(int status, const json& body) {
+    return {status, body.dump()};
+}
+
+MockSupabase::Reply pgError(int status, const std::string& code, const std::string& message) {
+    return reply(status, {{"code", code}, {"message", message}, {"details", nullptr}, {"hint", nullptr}});
+}
+
+std::string nowTimestamp() {
+    const std::time_t t = std::time(nullptr);
+    std::tm tm{};
+#ifdef _WIN32
+    gmtime_s(&tm, &t);
+#else
+    gmtime_r(&t, &tm);
+#endif
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S+00:00", &tm);
+    return buf;
+}
+
+// ---------- Helper 3 : JWT payload (GoTrue stand-in, signature not checked) ----------
+bool decodeBase64Url(const std::string& in, std::string& out) {
+    out.clear();
+    unsigned buffer = 0;
+    int bits = 0;
+    for (char c : in) {
+        int v;
+        if (c >= 'A' && c <= 'Z') v = c - 'A';
+        else if (c >= 'a' && c <= 'z') v = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') v = c - '0' + 52;
+        else if (c == '-' || c == '+') v = 62;
+        else if (c == '_' || c == '/') v = 63;
+        else if (c == '=') break;
+        else return false;
+        buffer = (buffer << 6) | static_cast<unsigned>(v);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out += static_cast<char>((buffer >> bits) & 0xFF);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+MockSupabase::MockSupabase(MockOptions options)
+    : options_(std::move(options)) {
+    load("profiles", options_.data.profiles(), {"id", "auth_id"});
+    load("conversations", options_.data.conversations(), {"id", "direct_key"});
+    load("conversation_members", options_.data.members(), {"conversation_id", "user_id"});
+}
+
+void MockSupabase::load(const std::string& name, json rows, const std::vector<std::string>& indexed) {
+    auto& t = tables_[name];
+    t.rows.reserve(rows.size());
+    for (auto& row : rows) {
+        const std::size_t i = t.rows.size();
+        for (const auto& col : indexed) {
+            if (row.contains(col) && row[col].is_string()) {
+                t.index[col][row[col].get<std::string>()].push_back(i);
+            }
+        }
+        t.rows.push_back(std::move(row));
+    }
+}
+
+const MockSupabase::Table* MockSupabase::table(const std::string& name) const {
+    auto it = tables_.find(name);
+    return it == tables_.end() ? nullptr : &it->second;
+}
+
+std::string MockSupabase::newRowId() const {
+    char id[37];
+    std::snprintf(id, sizeof(id), "%08x-0000-4000-8000-%012llx", 9u,
+                  static_cast<unsigned long long>(nextId_.fetch_add(1, std::memory_order_relaxed)));
+    return id;
+}
+
+double MockSupabase::delaySeconds() const {
+    if (options_.latencyMs <= 0 && options_.jitterMs <= 0) return 0;
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    std::uniform_real_distribution<double> jitter(-options_.jitterMs, options_.jitterMs);
+    return std::max(0.0, options_.latencyMs + jitter(rng)) / 1000.0;
+}
+
+MockSupabase::Reply MockSupabase::rest(const std::string& method,
+                                       const std::string& name,
+                                       const Params& params,
+                                       const std::string& body) const {
+    served_.fetch_add(1, std::memory_order_relaxed);
+
+    const Table* t = table(name);
+    if (!t) {
+        return pgError(404, "42P01", "relation \"public." + name + "\" does not exist");
+    }
+
+    // 1) Query string
+    Select sel;
+    std::vector<Condition> where, embedWhere;
+    std::vector<OrGroup> ors, embedOrs;
+    std::vector<OrderKey> order;
+    long limit = -1;
+
+    for (const auto& [key, value] : params) {
+        if (key == "select") { sel = parseSelect(value); continue; }
+        if (key == "order") { order = parseOrder(value); continue; }
+        if (key == "limit") {
+            try { limit = std::stol(value); } catch (const std::exception&) {
+                return pgError(400, "PGRST100", "invalid limit");
+            }
+            continue;
+        }
+
+        const auto dot = key.find('.');
+        const bool onEmbed = dot != std::string::npos;
+        const std::string column = onEmbed ? key.substr(dot + 1) : key;
+
+        if (column == "or") {
+            OrGroup group;
+            if (!parseOr(value, group)) return pgError(400, "PGRST100", "failed to parse logic tree (" + value + ")");
+            (onEmbed ? embedOrs : ors).push_back(std::move(group));
+        } else {
+            Condition c;
+            if (!parseCondition(column, value, c)) return pgError(400, "PGRST100", "failed to parse filter (" + value + ")");
+            (onEmbed ? embedWhere : where).push_back(std::move(c));
+        }
+    }
+
+    // 2) Candidate rows: the smallest bucket of an indexed eq / in filter
+    std::vector<std::size_t> candidates;
+    bool narrowed = false;
+    for (const auto& c : where) {
+        if (c.negate || (c.op != "eq" && c.op != "in")) continue;
+        auto col = t->index.find(c.column);
+        if (col == t->index.end()) continue;
+
+        std::vector<std::size_t> bucket;
+        if (c.op == "eq") {
+            auto it = col->second.find(c.value);
+            if (it != col->second.end()) bucket = it->second;
+        } else {
+            const std::string list = c.value.size() >= 2 ? c.value.substr(1, c.value.size() - 2) : "";
+            for (const auto& item : splitTopLevel(list, ',')) {
+                auto it = col->second.find(unquote(item));
+                if (it != col->second.end()) bucket.insert(bucket.end(), it->second.begin(), it->second.end());
+            }
+        }
+        if (!narrowed || bucket.size() < candidates.size()) candidates = std::move(bucket);
+        narrowed = true;
+    }
+    if (!narrowed) {
+        candidates.resize(t->rows.size());
+        for (std::size_t i = 0; i < candidates.size(); ++i) candidates[i] = i;
+    }
+
+    // 3) Writes: answered with the representation, never applied
+    if (method == "POST") {
+        auto input = json::parse(body, nullptr, false);
+        if (input.is_object()) input = json::array({input});
+        if (!input.is_array()) return pgError(400, "PGRST102", "Empty or invalid json");
+
+        json out = json::array();
+        for (auto& row : input) {
+            if (!row.is_object()) return pgError(400, "PGRST102", "All object keys must match");
+
+            if (name == "conversations" && row.contains("direct_key") && row["direct_key"].is_string()) {
+                const auto& keys = t->index.at("direct_key");
+                if (keys.count(row["direct_key"].get<std::string>())) {
+                    return pgError(409, "23505", "duplicate key value violates unique constraint \"conversations_direct_key_key\"");
+                }
+            }
+            if (name == "conversation_members" && row.contains("conversation_id") && row.contains("user_id")) {
+                const auto& byUser = t->index.at("user_id");
+                auto it = byUser.find(cellText(row["user_id"]));
+                if (it != byUser.end()) {
+                    for (auto i : it->second) {
+                        const auto& m = t->rows[i];
+                        if (m["conversation_id"] == row["conversation_id"] && m["left_at"].is_null()) {
+                            return pgError(409, "23505", "duplicate key value violates unique constraint \"conversation_members_active_key\"");
+                        }
+                    }
+                }
+            }
+
+            const auto now = nowTimestamp();
+            if (!row.contains("id")) row["id"] = newRowId();
+            if (name == "conversations") {
+                if (!row.contains("name")) row["name"] = nullptr;
+                if (!row.contains("direct_key")) row["direct_key"] = nullptr;
+                row["created_at"] = now;
+                row["updated_at"] = now;
+                row["deleted_at"] = nullptr;
+            } else if (name == "conversation_members") {
+                row["joined_at"] = now;
+                row["left_at"] = nullptr;
+            }
+            out.push_back(projectColumns(row, sel.all, sel.columns));
+        }
+        return reply(201, out);
+    }
+
+    if (method == "PATCH" || method == "DELETE") {
+        json patch = json::object();
+        if (method == "PATCH") {
+            patch = json::parse(body, nullptr, false);
+            if (!patch.is_object()) return pgError(400, "PGRST102", "Empty or invalid json");
+        }
+        json out = json::array();
+        for (auto i : candidates) {
+            const auto& row = t->rows[i];
+            if (!matchesAll(row, where, ors)) continue;
+            json copy = row;
+            copy.update(patch);
+            out.push_back(projectColumns(copy, sel.all, sel.columns));
+        }
+        return reply(200, out);
+    }
+
+    if (method != "GET" && method != "HEAD") {
+        return pgError(405, "PGRST117", "Unsupported HTTP method: " + method);
+    }
+
+    // 4) Reads: filter, embed, order, limit, project
+    const Table* embedTable = nullptr;
+    if (sel.embed.present) {
+        embedTable = table(sel.embed.table);
+        if (!embedTable) return pgError(400, "PGRST200", "Could not find a relationship for '" + sel.embed.table + "'");
+    }
+
+    std::vector<std::pair<const json*, const json*>> hits;
+    for (auto i : candidates) {
+        const auto& row = t->rows[i];
+        if (!matchesAll(row, where, ors)) continue;
+
+        const json* embedded = nullptr;
+        if (embedTable) {
+            auto fk = row.find(sel.embed.foreignKey);
+            if (fk != row.end() && fk->is_string()) {
+                const auto& ids = embedTable->index.at("id");
+                auto it = ids.find(fk->get<std::string>());
+                if (it != ids.end() && matchesAll(embedTable->rows[it->second.front()], embedWhere, embedOrs)) {
+                    embedded = &embedTable->rows[it->second.front()];
+                }
+            }
+            if (!embedded && sel.embed.inner) continue;
+        }
+        hits.emplace_back(&row, embedded);
+    }
+
+    if (!order.empty()) {
+        std::stable_sort(hits.begin(), hits.end(), [&order](const auto& a, const auto& b) {
+            for (const auto& key : order) {
+                const json* ra = key.embedded ? a.second : a.first;
+                const json* rb = key.embedded ? b.second : b.first;
+                const std::string va = ra && ra->contains(key.column) ? cellText((*ra)[key.column]) : "";
+                const std::string vb = rb && rb->contains(key.column) ? cellText((*rb)[key.column]) : "";
+                if (va == vb) continue;
+                return key.desc ? va > vb : va < vb;
+            }
+            return false;
+        });
+    }
+    if (limit >= 0 && hits.size() > static_cast<std::size_t>(limit)) {
+        hits.resize(static_cast<std::size_t>(limit));
+    }
+
+    json out = json::array();
+    for (const auto& [row, embedded] : hits) {
+        json item = projectColumns(*row, sel.all, sel.columns);
+        if (sel.embed.present) {
+            item[sel.embed.alias] = embedded ? projectColumns(*embedded, false, sel.embed.columns) : json();
+        }
+        out.push_back(std::move(item));
+    }
+    return reply(200, out);
+}
+
+MockSupabase::Reply MockSupabase::rpc(const std::string& function, const std::string& body) const {
+    served_.fetch_add(1, std::memory_order_relaxed);
+
+    if (function != "create_direct_conversation") {
+        return pgError(404, "PGRST202", "Could not find the function public." + function + " in the schema cache");
+    }
+
+    // sql/001_create_direct_conversation.sql, without the auth.uid() check
+    const auto args = json::parse(body, nullptr, false);
+    if (!args.is_object() || !args.contains("p_caller") || !args.contains("p_target") ||
+        !args["p_caller"].is_string() || !args["p_target"].is_string()) {
+        return pgError(400, "PGRST102", "Empty or invalid json");
+    }
+    const auto caller = args["p_caller"].get<std::string>();
+    const auto target = args["p_target"].get<std::string>();
+    if (caller == target) {
+        return pgError(400, "22023", "Cannot create a direct conversation with yourself");
+    }
+
+    if (!table("profiles")->index.at("id").count(target)) {
+        return reply(200, {{"created", false}, {"conversation", nullptr}});
+    }
+
+    const std::string key = caller < target ? caller + ":" + target : target + ":" + caller;
+    const auto* conversations = table("conversations");
+    const auto& byKey = conversations->index.at("direct_key");
+    if (auto it = byKey.find(key); it != byKey.end()) {
+        const auto& row = conversations->rows[it->second.front()];
+        if (!row["deleted_at"].is_null()) {
+            return pgError(409, "23505", "duplicate key value violates unique constraint \"conversations_direct_key_key\"");
+        }
+        return reply(200, {{"created", false}, {"conversation", row}});
+    }
+
+    // Answered as created, never applied (like the REST writes)
+    const auto now = nowTimestamp();
+    return reply(200, {{"created", true}, {"conversation", {
+        {"id", newRowId()},
+        {"type", "direct"},
+        {"name", nullptr},
+        {"direct_key", key},
+        {"created_by", caller},
+        {"created_at", now},
+        {"updated_at", now},
+        {"deleted_at", nullptr}
+    }}});
+}
+
+MockSupabase::Reply MockSupabase::authUser(const std::string& authorization) const {
+    served_.fetch_add(1, std::memory_order_relaxed);
+
+    const std::string prefix = "Bearer ";
+    if (authorization.compare(0, prefix.size(), prefix) != 0) {
+        return reply(401, {{"code", 401}, {"msg", "This endpoint requires a Bearer token"}});
+    }
+    const std::string token = authorization.substr(prefix.size());
+    const auto first = token.find('.');
+    const auto second = token.find('.', first == std::string::npos ? first : first + 1);
+    std::string payload;
+    if (first == std::string::npos || second == std::string::npos ||
+        !decodeBase64Url(token.substr(first + 1, second - first - 1), payload)) {
+        return reply(401, {{"code", 401}, {"msg", "invalid JWT"}});
+    }
+
+    const auto claims = json::parse(payload, nullptr, false);
+    if (!claims.is_object() || !claims.contains("sub") || !claims["sub"].is_string()) {
+        return reply(401, {{"code", 401}, {"msg", "invalid claim: missing sub claim"}});
+    }
+    return reply(200, {
+        {"id", claims["sub"]},
+        {"aud", "authenticated"},
+        {"role", claims.value("role", "authenticated")}
+    });
+}
+
+void MockSupabase::registerRoutes(drogon::HttpAppFramework& app) {
+    auto respond = [this](Reply r, std::function<void(const drogon::HttpResponsePtr&)>&& cb) {
+        auto resp = drogon::HttpResponse::newHttpResponse();
+        resp->setStatusCode(static_cast<drogon::HttpStatusCode>(r.status));
+        resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+        resp->setBody(std::move(r.body));
+
+        const double delay = delaySeconds();
+        if (delay <= 0) return cb(resp);
+        trantor::EventLoop::getEventLoopOfCurrentThread()->runAfter(
+            delay, [cb = std::move(cb), resp]() { cb(resp); });
+    };
+
+    app.registerHandler(
+        "/rest/v1/{table}",
+        [this, respond](const drogon::HttpRequestPtr& req,
+                        std::function<void(const drogon::HttpResponsePtr&)>&& cb,
+                        const std::string& name) {
+            Params params;
+            for (const auto& [key, value] : req->getParameters()) params.emplace_back(key, value);
+            respond(rest(req->methodString(), name, params, std::string(req->body())), std::move(cb));
+        },
+        {drogon::Get, drogon::Post, drogon::Patch, drogon::Delete});
+
+    app.registerHandler(
+        "/rest/v1/rpc/{function}",
+        [this, respond](const drogon::HttpRequestPtr& req,
+                        std::function<void(const drogon::HttpResponsePtr&)>&& cb,
+                        const std::string& function) {
+            respond(rpc(function, std::string(req->body())), std::move(cb));
+        },
+        {drogon::Post});
+
+    app.registerHandler(
+        "/auth/v1/user",
+        [this, respond](const drogon::HttpRequestPtr& req,
+                        std::function<void(const drogon::HttpResponsePtr&)>&& cb) {
+            respond(authUser(req->getHeader("Authorization")), std::move(cb));
+        },
+        {drogon::Get});
+}
+
+} // namespace bench
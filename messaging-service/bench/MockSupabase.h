@@ -0,0 +1,88 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_MOCKSUPABASE_H
+#define SECURE_CLOUD_MOCKSUPABASE_H
+
+#include "BenchFixtures.h"
+
+#include <drogon/HttpAppFramework.h>
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+struct MockOptions {
+    Dataset data;
+    double latencyMs = 0;   // added to every reply
+    double jitterMs = 0;    // +/- uniform around latencyMs
+};
+
+// In-process stand-in for Supabase: the subset of PostgREST (/rest/v1/{table},
+// /rest/v1/rpc/{function}) and GoTrue (/auth/v1/user) that
+// ConversationService uses, over the synthetic Dataset.
+//
+// PostgREST subset: select with columns, * and one embedded resource
+// (alias:table!inner(cols)); filters eq, neq, gt, gte, lt, lte, is, in and
+// flat or=(...) lists (an and(...) inside an or is taken as true, so keyset
+// cursors do not advance past the first page); order on a column or an
+// embedded column; limit.
+//
+// RPC: create_direct_conversation (sql/001_create_direct_conversation.sql),
+// minus the auth.uid() check.
+//
+// Writes are validated (unique keys -> 409 23505) and answered with the
+// representation, but never applied: the dataset stays the same for the
+// whole run, so a load test can repeat any mix of routes.
+class MockSupabase {
+public:
+    using Params = std::vector<std::pair<std::string, std::string>>;
+
+    struct Reply {
+        int status = 200;
+        std::string body;
+    };
+
+    explicit MockSupabase(MockOptions options);
+
+    // The PostgREST / GoTrue routes, replying after latency +/- jitter
+    void registerRoutes(drogon::HttpAppFramework& app);
+
+    // Synchronous core of the routes (params already URL-decoded)
+    Reply rest(const std::string& method,
+               const std::string& table,
+               const Params& params,
+               const std::string& body) const;
+    Reply rpc(const std::string& function, const std::string& body) const;
+    Reply authUser(const std::string& authorization) const;
+
+    std::uint64_t served() const { return served_.load(std::memory_order_relaxed); }
+
+private:
+    struct Table {
+        std::vector<nlohmann::json> rows;
+        // column -> value -> row indexes
+        std::unordered_map<std::string, std::unordered_map<std::string, std::vector<std::size_t>>> index;
+    };
+
+    void load(const std::string& name, nlohmann::json rows, const std::vector<std::string>& indexed);
+    const Table* table(const std::string& name) const;
+
+    std::string newRowId() const;
+    double delaySeconds() const;
+
+    MockOptions options_;
+    std::unordered_map<std::string, Table> tables_;
+    mutable std::atomic<std::uint64_t> nextId_{1};
+    mutable std::atomic<std::uint64_t> served_{0};
+};
+
+} // namespace bench
+
+#endif //SECURE_CLOUD_MOCKSUPABASE_H
@@ -21,6 +21,11 @@ public:
     ADD_METHOD_TO(ConversationController::listConversations,
                   "/conversations", drogon::Get);
 
+    // GET /conversations/changes?since= → conversations changed after a watermark
+    // (registered before /conversations/{id} so "changes" is not taken for an id)
+    ADD_METHOD_TO(ConversationController::listConversationChanges,
+                  "/conversations/changes", drogon::Get);
+
     // GET /conversations/{id} → conversation details by ID
     ADD_METHOD_TO(ConversationController::getConversation,
                   "/conversations/{id}", drogon::Get);
@@ -37,10 +42,22 @@ public:
     ADD_METHOD_TO(ConversationController::addMember,
                   "/conversations/{id}/members", drogon::Post);
 
+    // POST /conversations/{id}/members:batch {"user_ids": [...]} → add up to 100 members at once
+    ADD_METHOD_TO(ConversationController::addMembers,
+                  "/conversations/{id}/members:batch", drogon::Post);
+
     // GET /conversations/{id}/members → list members of a conversation
     ADD_METHOD_TO(ConversationController::listMembers,
                   "/conversations/{id}/members", drogon::Get);
 
+    // POST /conversations/{id}/messages {"body": "..."} → append a message
+    ADD_METHOD_TO(ConversationController::postMessage,
+                  "/conversations/{id}/messages", drogon::Post);
+
+    // GET /conversations/{id}/messages?after=&before=&limit= → read messages by seq
+    ADD_METHOD_TO(ConversationController::listMessages,
+                  "/conversations/{id}/messages", drogon::Get);
+
     // PATCH /conversations/{id}/members/{userId} → update member role
     ADD_METHOD_TO(ConversationController::updateMemberRole,
                   "/conversations/{id}/members/{userId}", drogon::Patch);
@@ -58,6 +75,9 @@ public:
     void listConversations(const drogon::HttpRequestPtr& req,
                        std::function<void (const drogon::HttpResponsePtr &)> &&cb) const;
 
+    void listConversationChanges(const drogon::HttpRequestPtr& req,
+                                 std::function<void (const drogon::HttpResponsePtr &)> &&cb) const;
+
     void getConversation(const drogon::HttpRequestPtr& req,
                          std::function<void (const drogon::HttpResponsePtr &)> &&cb,
                          const std::string& conversationId) const;
@@ -74,10 +94,22 @@ public:
                    std::function<void (const drogon::HttpResponsePtr &)> &&cb,
                    const std::string& conversationId) const;
 
+    void addMembers(const drogon::HttpRequestPtr& req,
+                    std::function<void (const drogon::HttpResponsePtr &)> &&cb,
+                    const std::string& conversationId) const;
+
     void listMembers(const drogon::HttpRequestPtr& req,
                      std::function<void (const drogon::HttpResponsePtr &)> &&cb,
                      const std::string& conversationId) const;
 
+    void postMessage(const drogon::HttpRequestPtr& req,
+                     std::function<void (const drogon::HttpResponsePtr &)> &&cb,
+                     const std::string& conversationId) const;
+
+    void listMessages(const drogon::HttpRequestPtr& req,
+                      std::function<void (const drogon::HttpResponsePtr &)> &&cb,
+                      const std::string& conversationId) const;
+
     void updateMemberRole(const drogon::HttpRequestPtr& req,
                       std::function<void (const drogon::HttpResponsePtr &)> &&cb,
                       const std::string& conversationId,
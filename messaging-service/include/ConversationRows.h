@@ -0,0 +1,92 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_CONVERSATIONROWS_H
+#define SECURE_CLOUD_CONVERSATIONROWS_H
+
+#include "FastJson.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Typed, compact views of the conversation_members / conversations rows
+// PostgREST sends. The parsers read the response buffer once (FastJson) and
+// fill flat vectors: ids are 16-byte values, roles and types are enums, and
+// whatever is sent back to clients stays a view of the buffer.
+
+// A UUID as its 16 bytes. The nil value stands for "absent or not a UUID".
+struct Uuid {
+    std::array<std::uint8_t, 16> bytes{};
+
+    // Canonical 8-4-4-4-12 text, either case
+    static bool parse(std::string_view text, Uuid& out);
+
+    bool isNil() const;
+    // Lowercase canonical text, as Postgres prints it
+    std::string str() const;
+    void appendTo(std::string& out) const;
+
+    bool operator==(const Uuid& o) const { return bytes == o.bytes; }
+    bool operator!=(const Uuid& o) const { return bytes != o.bytes; }
+    bool operator<(const Uuid& o) const { return bytes < o.bytes; }
+};
+
+enum class MemberRole : std::uint8_t { None, Member, Owner, Admin, Other };
+enum class ConversationType : std::uint8_t { None, Direct, Group, Other };
+
+MemberRole parseMemberRole(std::string_view text);
+ConversationType parseConversationType(std::string_view text);
+const char* memberRoleName(MemberRole role);    // "" for None / Other
+
+// Owners and admins manage a conversation
+inline bool canManage(MemberRole role) { return role == MemberRole::Owner || role == MemberRole::Admin; }
+
+// One conversation_members row (any subset of id, conversation_id, user_id, role)
+struct MemberRow {
+    Uuid id;
+    Uuid conversationId;
+    Uuid userId;
+    MemberRole role = MemberRole::None;
+    std::string_view raw;    // the row as received
+};
+
+// Rows of a JSON array body; false when the body is not an array.
+// raw views point into body.
+bool readMemberRows(std::string_view body, std::vector<MemberRow>& out);
+
+// One row of "conversation_members?select=conversation:conversations!inner(*),role,..."
+struct ConversationRow {
+    fastjson::Value row;             // the membership row as received
+    fastjson::Value conversation;    // its embedded conversation
+    Uuid id;                         // conversation.id
+    ConversationType type = ConversationType::None;
+    MemberRole role = MemberRole::None;
+    std::string_view name;
+    std::string_view updatedAt;
+    bool hasDisplayName = false;
+
+    // Filled by the display name enrichment
+    std::optional<std::string> displayName;
+    Uuid otherUserId;
+};
+
+// The upstream body and the rows read from it (the views point into body,
+// so a page is shared, never copied)
+struct ConversationPage {
+    std::string body;
+    std::vector<ConversationRow> rows;
+    std::deque<std::string> decoded;   // escaped strings of the rows
+};
+
+// nullptr when the body is not a JSON array
+std::shared_ptr<ConversationPage> readConversationPage(const std::string& body);
+
+#endif //SECURE_CLOUD_CONVERSATIONROWS_H
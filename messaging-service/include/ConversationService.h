@@ -6,27 +6,98 @@
 #define SECURE_CLOUD_CONVERSATIONSERVICE_H
 
 #include <nlohmann/json.hpp>
+#include <cstdint>
+#include <functional>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
+// Every operation exists in two flavours:
+//  - a synchronous one returning the Result (blocks the calling thread);
+//  - a non-blocking one taking a Callback. Called from a Drogon handler, the
+//    upstream calls are driven by that IO loop and `done` runs on it.
+// Reads go through ConversationStore (PostgREST or libpq, CONVERSATION_STORE);
+// writes and token checks always use Supabase.
 class ConversationService {
 public:
     struct Result {
-        int statusCode;
-        nlohmann::json body;
+        int statusCode = 0;
+        nlohmann::json body = {};
+        std::vector<std::pair<std::string, std::string>> headers = {};  // extra response headers
+        std::string rawBody = {};  // already serialized JSON, sent instead of body when set
     };
 
-    // Create a new conversation
+    // One page of the conversations list, newest first (keyset on the
+    // conversation's updated_at, id). The cursor of the next page is sent
+    // back in the "X-Next-Cursor" header and is opaque to clients.
+    struct PageRequest {
+        int limit = 50;           // 1..200
+        std::string cursor;       // empty = first page
+        std::string since;        // ISO-8601; only conversations updated after it
+        std::string ifNoneMatch;  // If-None-Match of the request (304 when still current)
+    };
+
+    // Window of a conversation's message log (sequence numbers start at 1).
+    // after > 0: messages with seq > after, oldest first;
+    // otherwise the `limit` messages before `before` (0 = the newest ones).
+    struct MessagesQuery {
+        std::uint64_t after = 0;
+        std::uint64_t before = 0;
+        int limit = 50;           // 1..500
+    };
+
+    // Delta sync: conversations changed after a watermark, oldest first.
+    // Deleted conversations (deleted_at set) and the ones the caller left (left_at
+    // set) are included so clients can drop them; joined ones come in as updated.
+    struct ChangesRequest {
+        std::string since;        // ISO-8601 or the "watermark" of the previous answer
+        int limit = 100;          // 1..500
+    };
+
+    using Callback = std::function<void(Result)>;
+
+    // Create a new conversation. With CONVERSATION_CREATE_RPC=1 a direct
+    // conversation is created by one transactional Postgres function
+    // (sql/001_create_direct_conversation.sql) instead of five REST calls.
+    // A group can start with memberIds (at most 100), added with the owner
+    // in one insert; the answer then has "members", as for addMembers.
     Result createConversation(
         const std::string& accessToken,
         const std::string& type,
         const std::optional<std::string>& name,
-        const std::optional<std::string>& targetUserId
+        const std::optional<std::string>& targetUserId,
+        const std::vector<std::string>& memberIds = {}
+    );
+    void createConversation(
+        const std::string& accessToken,
+        const std::string& type,
+        const std::optional<std::string>& name,
+        const std::optional<std::string>& targetUserId,
+        const std::vector<std::string>& memberIds,
+        Callback done
     );
 
-    // List all conversations where the current user is a member
+    // List the conversations where the current user is a member (one page)
     Result listMyConversations(
-        const std::string& accessToken
+        const std::string& accessToken,
+        const PageRequest& page
+    );
+    void listMyConversations(
+        const std::string& accessToken,
+        const PageRequest& page,
+        Callback done
+    );
+
+    // Conversations created / updated / deleted after the watermark
+    Result listConversationChanges(
+        const std::string& accessToken,
+        const ChangesRequest& changes
+    );
+    void listConversationChanges(
+        const std::string& accessToken,
+        const ChangesRequest& changes,
+        Callback done
     );
 
     // take the conversationId as parameter
@@ -34,6 +105,11 @@ public:
         const std::string& accessToken,
         const std::string& conversationId
     );
+    void getConversationById(
+        const std::string& accessToken,
+        const std::string& conversationId,
+        Callback done
+    );
 
     // Update conversation (only name if you're owner )
     Result updateConversation(
@@ -41,12 +117,23 @@ public:
     const std::string& conversationId,
     const std::optional<std::string>& name
     );
+    void updateConversation(
+        const std::string& accessToken,
+        const std::string& conversationId,
+        const std::optional<std::string>& name,
+        Callback done
+    );
 
     // Delete a conversation (only if you're owner)
     Result deleteConversation(
         const std::string& accessToken,
         const std::string& conversationId
     );
+    void deleteConversation(
+        const std::string& accessToken,
+        const std::string& conversationId,
+        Callback done
+    );
 
     // Add a user as member to a conversation
     Result addMember(
@@ -54,11 +141,41 @@ public:
         const std::string& conversationId,
         const std::string& userId
     );
+    void addMember(
+        const std::string& accessToken,
+        const std::string& conversationId,
+        const std::string& userId,
+        Callback done
+    );
+
+    // Add up to 100 users at once (owner/admin only): one profiles lookup,
+    // one memberships lookup, one bulk insert. Answers 200
+    // {"results": [{"user_id", "status", "member"?}]} in request order, with
+    // status "added" (+ the member row), "already_member", "not_found" or "invalid_id".
+    Result addMembers(
+        const std::string& accessToken,
+        const std::string& conversationId,
+        const std::vector<std::string>& userIds
+    );
+    void addMembers(
+        const std::string& accessToken,
+        const std::string& conversationId,
+        const std::vector<std::string>& userIds,
+        Callback done
+    );
 
-    // List members of a conversation (only if caller is member)
+    // List members of a conversation (only if caller is member).
+    // Answers 304 when ifNoneMatch still matches the member set.
     Result listMembers(
         const std::string& accessToken,
-        const std::string& conversationId
+        const std::string& conversationId,
+        const std::string& ifNoneMatch = {}
+    );
+    void listMembers(
+        const std::string& accessToken,
+        const std::string& conversationId,
+        const std::string& ifNoneMatch,
+        Callback done
     );
 
     // Update role of a member in a conversation (owner/admin only)
@@ -68,6 +185,39 @@ public:
         const std::string& userId,
         const std::string& role
     );
+    void updateMemberRole(
+        const std::string& accessToken,
+        const std::string& conversationId,
+        const std::string& userId,
+        const std::string& role,
+        Callback done
+    );
+
+    // Post a message in a conversation (caller must be a member)
+    Result postMessage(
+        const std::string& accessToken,
+        const std::string& conversationId,
+        const std::string& text
+    );
+    void postMessage(
+        const std::string& accessToken,
+        const std::string& conversationId,
+        const std::string& text,
+        Callback done
+    );
+
+    // Read messages of a conversation (caller must be a member)
+    Result listMessages(
+        const std::string& accessToken,
+        const std::string& conversationId,
+        const MessagesQuery& query
+    );
+    void listMessages(
+        const std::string& accessToken,
+        const std::string& conversationId,
+        const MessagesQuery& query,
+        Callback done
+    );
 
     // Delete a member from a conversation
     Result deleteMember(
@@ -75,6 +225,17 @@ public:
         const std::string& conversationId,
         const std::string& userId
     );
+    void deleteMember(
+        const std::string& accessToken,
+        const std::string& conversationId,
+        const std::string& userId,
+        Callback done
+    );
+
+    // Caller's profile id and the ids of their live conversations
+    // ({"profile_id": ..., "conversation_ids": [...]}), used to subscribe a WebSocket
+    Result listMyConversationIds(const std::string& accessToken);
+    void listMyConversationIds(const std::string& accessToken, Callback done);
 };
 
-#endif //SECURE_CLOUD_CONVERSATIONSERVICE_H
\ No newline at end of file
+#endif //SECURE_CLOUD_CONVERSATIONSERVICE_H
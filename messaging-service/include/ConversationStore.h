@@ -0,0 +1,108 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_CONVERSATIONSTORE_H
+#define SECURE_CLOUD_CONVERSATIONSTORE_H
+
+#include "SupabaseClient.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Storage behind the hot read queries of ConversationService.
+//
+// Every query answers what PostgREST would for it: a JSON array of rows with
+// the columns documented below, so the service reads both backends with the
+// same code. Errors come back as a non-2xx status with a PostgREST-style
+// {"code", "message"} body, transport failures as ok == false.
+//
+// Two implementations, chosen once by CONVERSATION_STORE:
+//  - "postgrest" (default): /rest/v1 through SupabaseClient, as the caller
+//    (JWT, row level security);
+//  - "postgres": straight to Postgres with libpq (PgStore.h): a pool of
+//    connections, prepared statements, pipeline mode, JSON built by Postgres.
+//    Access checks are then only the service's own membership checks.
+//
+// Writes, GoTrue and the create-time lookups always go through PostgREST.
+// The callback runs on the calling IO loop (inline inside a
+// SupabaseClient::BlockingScope or off any loop).
+class ConversationStore {
+public:
+    using Response = SupabaseClient::Response;
+    using Callback = std::function<void(const Response&)>;
+
+    // Credentials of the request (used by the PostgREST store)
+    struct Caller {
+        std::string base;           // SUPABASE_URL
+        std::string anonKey;
+        std::string accessToken;
+    };
+
+    // Conversations of a profile, newest first: (updated_at, id) desc
+    struct PageQuery {
+        std::string profileId;
+        int limit = 0;
+        std::string since;          // updated_at > since (empty = no bound)
+        std::string beforeUpdatedAt;  // keyset: (updated_at, id) < (beforeUpdatedAt, beforeId)
+        std::string beforeId;         // (both empty on the first page)
+    };
+
+    // Conversations changed after a watermark, oldest first, including the
+    // deleted ones and the memberships left after the watermark
+    struct ChangesQuery {
+        std::string profileId;
+        int limit = 0;
+        std::string afterUpdatedAt;
+        std::string afterId;        // empty: updated_at > afterUpdatedAt only
+    };
+
+    virtual ~ConversationStore() = default;
+
+    virtual const char* name() const = 0;
+
+    // [{"id"}] the profile of an auth user (at most one row)
+    virtual void profileIdByAuthId(const Caller& caller, const std::string& authUserId, Callback cb) = 0;
+
+    // [{"id", "first_name", "last_name"}]
+    virtual void profileNames(const Caller& caller, const std::vector<std::string>& profileIds, Callback cb) = 0;
+
+    // [{"conversation": {conversations row}, "role", "joined_at", "left_at"}]
+    virtual void conversationPage(const Caller& caller, const PageQuery& query, Callback cb) = 0;
+    virtual void conversationChanges(const Caller& caller, const ChangesQuery& query, Callback cb) = 0;
+    // Same rows, for one conversation of the profile (live membership and conversation)
+    virtual void conversationOfMember(const Caller& caller,
+                                      const std::string& profileId,
+                                      const std::string& conversationId,
+                                      Callback cb) = 0;
+
+    // [{"conversation_id"}] live conversations of a profile
+    virtual void conversationIds(const Caller& caller, const std::string& profileId, Callback cb) = 0;
+
+    // [{"id", "role"}] the active membership of a profile (at most one row)
+    virtual void membership(const Caller& caller,
+                            const std::string& conversationId,
+                            const std::string& profileId,
+                            Callback cb) = 0;
+
+    // [{"id", "conversation_id", "user_id", "role", "joined_at", "left_at"}] active members
+    virtual void activeMembers(const Caller& caller, const std::string& conversationId, Callback cb) = 0;
+
+    // [{"user_id"}] the ones of profileIds that are active members
+    virtual void membersAmong(const Caller& caller,
+                              const std::string& conversationId,
+                              const std::vector<std::string>& profileIds,
+                              Callback cb) = 0;
+
+    // [{"conversation_id", "user_id"}] active members of the conversations, but profileId
+    virtual void otherMembers(const Caller& caller,
+                              const std::vector<std::string>& conversationIds,
+                              const std::string& profileId,
+                              Callback cb) = 0;
+
+    // The store selected by CONVERSATION_STORE (created on first use)
+    static ConversationStore& instance();
+};
+
+#endif //SECURE_CLOUD_CONVERSATIONSTORE_H
@@ -0,0 +1,182 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_FASTJSON_H
+#define SECURE_CLOUD_FASTJSON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Allocation-free JSON reading and writing for the request hot path.
+//
+// Reading: parse() validates a document once and hands back a Value, a view
+// of the source text. Objects and arrays are walked in place with
+// forEachMember() / forEachElement(), and only the fields a caller needs are
+// decoded; strings without escapes (ids, timestamps, roles...) come back as
+// views of the buffer, with no copy. The source must outlive every Value.
+//
+// Writing: Writer appends straight to a std::string that becomes the HTTP
+// body (or the upstream payload), with commas handled for the caller. Raw
+// values already in JSON form (a row received from PostgREST) are spliced
+// as is, without a parse / dump round trip.
+namespace fastjson {
+
+enum class Type { Invalid, Null, Bool, Number, String, Object, Array };
+
+struct Value {
+    Type type = Type::Invalid;
+    std::string_view raw;    // exact source text, quotes included for strings
+
+    bool valid() const { return type != Type::Invalid; }
+    bool isNull() const { return type == Type::Null; }
+    bool isString() const { return type == Type::String; }
+    bool isObject() const { return type == Type::Object; }
+    bool isArray() const { return type == Type::Array; }
+
+    // String contents: a view of the source when there is no escape,
+    // otherwise decoded into scratch. Empty for non-strings.
+    std::string_view str(std::string& scratch) const;
+    // Decoded copy (empty for non-strings)
+    std::string string() const;
+
+    bool asBool(bool& out) const;
+    bool asInt64(std::int64_t& out) const;
+};
+
+// Whole text must be one JSON value (surrounding whitespace allowed)
+bool parse(std::string_view text, Value& out);
+
+// Walks an object / array value produced by parse() (already validated).
+// Member keys are given as their raw text between the quotes: compare them
+// with plain ASCII names directly. A callback returning bool stops the walk
+// by returning false.
+template <typename F> void forEachMember(const Value& object, F&& f);
+template <typename F> void forEachElement(const Value& array, F&& f);
+
+// First member named key (Invalid when absent or not an object)
+Value member(const Value& object, std::string_view key);
+// First element of an array, or the value itself when it is an object
+// (PostgREST answers writes with [row] or row, depending on Prefer)
+Value firstRow(const Value& value);
+
+// Appends s as a quoted JSON string
+void appendQuoted(std::string& out, std::string_view s);
+
+class Writer {
+public:
+    // Nesting up to 64 levels
+    explicit Writer(std::string& out) : out_(out) {}
+
+    Writer& beginObject() { separate(); out_.push_back('{'); push(); return *this; }
+    Writer& endObject()   { --depth_; out_.push_back('}'); return *this; }
+    Writer& beginArray()  { separate(); out_.push_back('['); push(); return *this; }
+    Writer& endArray()    { --depth_; out_.push_back(']'); return *this; }
+
+    // Key of the next member (escaped here)
+    Writer& key(std::string_view k);
+    // Key already in JSON form (the text between the quotes, as forEachMember gives it)
+    Writer& rawKey(std::string_view k);
+
+    Writer& string(std::string_view s) { separate(); appendQuoted(out_, s); return *this; }
+    Writer& number(std::int64_t v);
+    Writer& number(std::uint64_t v);
+    Writer& boolean(bool v) { separate(); out_ += v ? "true" : "false"; return *this; }
+    Writer& null() { separate(); out_ += "null"; return *this; }
+    // A value already serialized (must be valid JSON)
+    Writer& raw(std::string_view json) { separate(); out_.append(json.data(), json.size()); return *this; }
+
+    // Convenience: key + value
+    Writer& field(std::string_view k, std::string_view s) { return key(k).string(s); }
+    Writer& field(std::string_view k, const char* s) { return key(k).string(s); }
+    Writer& field(std::string_view k, std::int64_t v) { return key(k).number(v); }
+    Writer& field(std::string_view k, std::uint64_t v) { return key(k).number(v); }
+    Writer& field(std::string_view k, bool v) { return key(k).boolean(v); }
+
+private:
+    // A comma before every value but the first of its container, none after a key
+    void separate() {
+        if (afterKey_) { afterKey_ = false; return; }
+        if (depth_ == 0) return;
+        const std::uint64_t bit = 1ull << (depth_ - 1);
+        if (nonEmpty_ & bit) out_.push_back(',');
+        nonEmpty_ |= bit;
+    }
+    void push() {
+        ++depth_;
+        nonEmpty_ &= ~(1ull << (depth_ - 1));
+    }
+
+    std::string& out_;
+    int depth_ = 0;
+    std::uint64_t nonEmpty_ = 0;   // bit d-1: the container at depth d has a value
+    bool afterKey_ = false;
+};
+
+// ---------- implementation details of the walkers ----------
+namespace detail {
+// Past the value starting at p (whitespace skipped first), nullptr when invalid
+const char* skipValue(const char* p, const char* end, Type& type, int depth);
+// Same on text parse() already validated: no checks, strings and nesting only
+const char* skipParsed(const char* p, const char* end, Type& type);
+const char* skipSpace(const char* p, const char* end);
+}
+
+template <typename F>
+void forEachMember(const Value& object, F&& f) {
+    if (object.type != Type::Object) return;
+    const char* p = object.raw.data() + 1;
+    const char* end = object.raw.data() + object.raw.size() - 1;
+    p = detail::skipSpace(p, end);
+    while (p < end && *p == '"') {
+        Type keyType;
+        const char* keyEnd = detail::skipParsed(p, end, keyType);
+        const std::string_view key(p + 1, static_cast<std::size_t>(keyEnd - p - 2));
+
+        p = detail::skipSpace(keyEnd, end);
+        if (p >= end || *p != ':') return;
+        const char* start = detail::skipSpace(p + 1, end);
+        Value value;
+        p = detail::skipParsed(start, end, value.type);
+        value.raw = std::string_view(start, static_cast<std::size_t>(p - start));
+        if constexpr (std::is_same_v<decltype(f(key, value)), bool>) {
+            if (!f(key, value)) return;
+        } else {
+            f(key, value);
+        }
+
+        p = detail::skipSpace(p, end);
+        if (p >= end || *p != ',') return;
+        p = detail::skipSpace(p + 1, end);
+    }
+}
+
+template <typename F>
+void forEachElement(const Value& array, F&& f) {
+    if (array.type != Type::Array) return;
+    const char* p = array.raw.data() + 1;
+    const char* end = array.raw.data() + array.raw.size() - 1;
+    p = detail::skipSpace(p, end);
+    while (p < end) {
+        Value value;
+        const char* start = p;
+        p = detail::skipParsed(start, end, value.type);
+        value.raw = std::string_view(start, static_cast<std::size_t>(p - start));
+        if constexpr (std::is_same_v<decltype(f(value)), bool>) {
+            if (!f(value)) return;
+        } else {
+            f(value);
+        }
+
+        p = detail::skipSpace(p, end);
+        if (p >= end || *p != ',') return;
+        p = detail::skipSpace(p + 1, end);
+    }
+}
+
+} // namespace fastjson
+
+#endif //SECURE_CLOUD_FASTJSON_H
@@ -0,0 +1,35 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_INTERNALCONTROLLER_H
+#define SECURE_CLOUD_INTERNALCONTROLLER_H
+
+#pragma once
+#include <drogon/HttpController.h>
+#include <drogon/drogon.h>
+
+// Service-to-service routes (not meant to be exposed publicly).
+// Every call must carry the "X-Internal-Token" header matching INTERNAL_API_TOKEN;
+// when INTERNAL_API_TOKEN is not set these routes answer 403.
+class InternalController final
+    : public drogon::HttpController<InternalController> {
+public:
+    METHOD_LIST_BEGIN
+    // POST /internal/cache/profiles/invalidate {"auth_id": "..."} → forget a deleted account
+    ADD_METHOD_TO(InternalController::invalidateProfile,
+                  "/internal/cache/profiles/invalidate", drogon::Post);
+
+    // GET /internal/cache/stats → hit/miss counters of the in-process caches
+    ADD_METHOD_TO(InternalController::cacheStats,
+                  "/internal/cache/stats", drogon::Get);
+    METHOD_LIST_END
+
+    void invalidateProfile(const drogon::HttpRequestPtr& req,
+                           std::function<void (const drogon::HttpResponsePtr &)> &&cb) const;
+
+    void cacheStats(const drogon::HttpRequestPtr& req,
+                    std::function<void (const drogon::HttpResponsePtr &)> &&cb) const;
+};
+
+#endif //SECURE_CLOUD_INTERNALCONTROLLER_H
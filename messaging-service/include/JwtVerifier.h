@@ -0,0 +1,93 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_JWTVERIFIER_H
+#define SECURE_CLOUD_JWTVERIFIER_H
+
+#include <openssl/evp.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Local verification of the Supabase access tokens (replaces the
+// /auth/v1/user round trip at the start of every messaging request).
+//
+// Configuration (environment):
+//  - SUPABASE_JWT_SECRET   : HS256 project secret
+//  - SUPABASE_JWKS_FILE    : JWKS document on disk (RS256 / ES256 keys)
+//  - SUPABASE_JWKS_URL     : JWKS document fetched once at startup
+//  - JWT_REMOTE_FALLBACK   : "0" to refuse tokens we cannot check locally
+//                            (default: ask GoTrue for them, as before)
+//  - JWT_CACHE_SIZE        : max number of verified tokens kept (default 10000)
+//
+// A token is accepted until its `exp`, with no leeway (30 s of clock skew
+// are tolerated on `nbf` only), and only for the "authenticated" audience
+// of user sessions. Verified tokens are kept in an LRU keyed by the
+// SHA-256 of the token and dropped as soon as their `exp` is reached.
+class JwtVerifier {
+public:
+    struct Claims {
+        std::string sub;        // auth user id
+        std::string role;
+        std::int64_t exp = 0;   // unix seconds
+    };
+
+    enum class Outcome {
+        Valid,      // claims filled
+        Rejected,   // bad signature, expired, malformed... (error filled)
+        Remote      // cannot decide locally, validate with GoTrue
+    };
+
+    struct Verdict {
+        Outcome outcome = Outcome::Rejected;
+        Claims claims;
+        std::string error;
+    };
+
+    static JwtVerifier& instance();
+
+    Verdict verify(const std::string& token);
+
+    // Cache the user id GoTrue returned for a token we could not verify
+    // ourselves (kept until the token's own exp).
+    void rememberRemote(const std::string& token, const std::string& sub);
+
+    // exp claim of a token already accepted (the signature is not checked
+    // again), 0 when it has none
+    static std::int64_t expiryOf(const std::string& token);
+
+    JwtVerifier(const JwtVerifier&) = delete;
+    JwtVerifier& operator=(const JwtVerifier&) = delete;
+
+private:
+    JwtVerifier();
+
+    using PKey = std::shared_ptr<EVP_PKEY>;
+
+    void loadJwks(const std::string& document);
+    PKey keyFor(const std::string& kid, const std::string& alg) const;
+
+    bool lookup(const std::string& key, Claims& out);
+    void store(const std::string& key, const Claims& claims);
+
+    std::string hsSecret_;
+    std::unordered_map<std::string, PKey> keys_;   // kid -> public key
+    bool remoteFallback_ = true;
+
+    // LRU: front = most recently used
+    struct Entry {
+        std::string key;
+        Claims claims;
+    };
+    std::size_t capacity_ = 10000;
+    std::list<Entry> lru_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    std::mutex mutex_;
+};
+
+#endif //SECURE_CLOUD_JWTVERIFIER_H
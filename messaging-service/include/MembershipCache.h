@@ -0,0 +1,92 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_MEMBERSHIPCACHE_H
+#define SECURE_CLOUD_MEMBERSHIPCACHE_H
+
+#include "ConversationRows.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// (conversation_id, profile_id) -> role, in process, for the authorization
+// checks that precede every conversation read or update.
+//
+// Open addressing over flat arrays of 40-byte slots (the two 16-byte ids,
+// the role, an expiry in seconds). A key lives in the window of 8 slots
+// starting at its hash: lookups scan that window, inserts take a free or
+// expired slot of it, else evict the entry of the window closest to expiry.
+// The slots are split over shards (one mutex each) like ProfileIdCache.
+//
+// "Not a member" is cached too (MemberRole::None). The service writes its
+// own member mutations through; the ones of other replicas arrive as Redis
+// invalidations (RedisCache::onInvalidate). The short TTL covers changes
+// made outside of the service.
+//
+// Configuration (environment):
+//  - MEMBERSHIP_CACHE_TTL_SECONDS : entry lifetime (default 15, 0 disables the cache)
+//  - MEMBERSHIP_CACHE_SIZE        : slots over all shards (default 65536)
+class MembershipCache {
+public:
+    struct Stats {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t evictions;
+        std::uint64_t invalidations;
+        std::size_t size;
+    };
+
+    static MembershipCache& instance();
+
+    // nullopt when unknown; MemberRole::None when known not to be a member
+    std::optional<MemberRole> get(const Uuid& conversationId, const Uuid& profileId);
+    void put(const Uuid& conversationId, const Uuid& profileId, MemberRole role);
+
+    void invalidate(const Uuid& conversationId, const Uuid& profileId);
+    // Every entry of a conversation (scans all the slots)
+    void invalidateConversation(const Uuid& conversationId);
+    void clear();
+
+    Stats stats() const;
+
+    MembershipCache(const MembershipCache&) = delete;
+    MembershipCache& operator=(const MembershipCache&) = delete;
+
+private:
+    MembershipCache();
+
+    struct Slot {
+        Uuid conversationId;
+        Uuid profileId;
+        std::uint32_t expiresAt = 0;   // seconds since start_; 0 = free
+        MemberRole role = MemberRole::None;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::vector<Slot> slots;       // power of two
+    };
+
+    static constexpr std::size_t kShards = 16;
+    static constexpr std::size_t kWindow = 8;
+
+    static std::uint64_t hash(const Uuid& conversationId, const Uuid& profileId);
+    std::uint32_t now() const;
+
+    std::array<Shard, kShards> shards_;
+    std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+    std::uint32_t ttlSeconds_ = 15;
+
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> evictions_{0};
+    std::atomic<std::uint64_t> invalidations_{0};
+};
+
+#endif //SECURE_CLOUD_MEMBERSHIPCACHE_H
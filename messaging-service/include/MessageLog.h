@@ -0,0 +1,147 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_MESSAGELOG_H
+#define SECURE_CLOUD_MESSAGELOG_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace trantor { class EventLoop; }
+
+// Append-only message storage, one log per conversation.
+//
+// Layout: <MESSAGE_LOG_DIR>/<conversationId>/<firstSeq>.log (+ .idx)
+//  - a .log segment is a sequence of records
+//      [u32 length][u32 crc32][u64 seq][i64 unix ms][payload]
+//    where length counts everything after itself and the crc covers
+//    seq, timestamp and payload. A new segment starts when the current one
+//    reaches MESSAGE_SEGMENT_BYTES (default 64 MiB);
+//  - the .idx file is a sparse index of (seq, offset) pairs, one every
+//    ~4 KiB of log, used to seek by sequence number. It can always be
+//    rebuilt from the .log.
+//
+// Sequence numbers start at 1 and have no gap inside a conversation.
+//
+// Writes go through a single writer thread that group-commits: everything
+// queued while the previous batch was syncing is written, then each touched
+// segment gets one fdatasync() before the callbacks run.
+//
+// Reads map the segments (mmap) and hand out views into the mapping; the
+// views stay valid as long as the ReadResult is alive.
+//
+// POSIX only (mmap / fdatasync), like the Linux container we ship.
+class MessageLog {
+public:
+    struct Appended {
+        bool ok = false;
+        std::uint64_t seq = 0;
+        std::int64_t timestampMs = 0;
+        std::string payload;    // record as stored
+        std::string error;
+    };
+
+    // Builds the payload once the sequence number and timestamp are known
+    using PayloadBuilder = std::function<std::string(std::uint64_t seq, std::int64_t timestampMs)>;
+    using AppendCallback = std::function<void(const Appended&)>;
+
+    struct Mapping;
+
+    struct ReadResult {
+        bool ok = false;
+        std::string error;
+        std::vector<std::string_view> payloads;   // ascending seq
+        std::uint64_t firstSeq = 0;
+        std::uint64_t lastSeq = 0;                // last seq in the whole log
+        std::vector<std::shared_ptr<const Mapping>> pins;
+    };
+
+    static MessageLog& instance();
+
+    // Queue one append. cb runs on replyLoop (or on the writer thread when
+    // replyLoop is null) once the record is durable.
+    void append(const std::string& conversationId,
+                PayloadBuilder build,
+                trantor::EventLoop* replyLoop,
+                AppendCallback cb);
+
+    // Up to `limit` records with seq >= fromSeq
+    ReadResult readFrom(const std::string& conversationId, std::uint64_t fromSeq, std::size_t limit);
+
+    // The `limit` records just before beforeSeq (0 = the newest ones), ascending
+    ReadResult readBefore(const std::string& conversationId, std::uint64_t beforeSeq, std::size_t limit);
+
+    MessageLog(const MessageLog&) = delete;
+    MessageLog& operator=(const MessageLog&) = delete;
+
+private:
+    MessageLog();
+    ~MessageLog();
+
+    struct IndexEntry {
+        std::uint64_t seq;
+        std::uint64_t offset;
+    };
+
+    struct Segment {
+        std::uint64_t baseSeq = 0;
+        std::string logPath;
+        std::string idxPath;
+        std::uint64_t size = 0;              // committed bytes
+        std::uint64_t lastSeq = 0;           // 0 while empty
+        std::uint64_t lastIndexedOffset = 0;
+        std::vector<IndexEntry> index;
+        std::shared_ptr<const Mapping> mapping;
+    };
+
+    struct ConversationLog {
+        std::string dir;
+        std::mutex mutex;                    // guards segments / nextSeq for readers
+        std::map<std::uint64_t, std::shared_ptr<Segment>> segments;
+        std::uint64_t nextSeq = 1;
+    };
+
+    struct Pending {
+        std::string conversationId;
+        PayloadBuilder build;
+        trantor::EventLoop* replyLoop;
+        AppendCallback cb;
+    };
+
+    std::shared_ptr<ConversationLog> open(const std::string& conversationId, bool create, std::string& error);
+    void recover(ConversationLog& log);
+    void recoverSegment(Segment& seg, bool isLast);
+
+    // Caller holds log.mutex
+    ReadResult readRangeLocked(ConversationLog& log, std::uint64_t fromSeq, std::size_t limit);
+    std::shared_ptr<const Mapping> mappingFor(Segment& seg);
+
+    void writerLoop();
+    void commitBatch(std::vector<Pending>& batch);
+
+    std::string root_;
+    std::uint64_t segmentBytes_ = 64ull * 1024 * 1024;
+    std::size_t maxBatch_ = 1024;
+
+    std::mutex logsMutex_;
+    std::unordered_map<std::string, std::shared_ptr<ConversationLog>> logs_;
+
+    std::mutex queueMutex_;
+    std::condition_variable queueCv_;
+    std::deque<Pending> queue_;
+    bool stopping_ = false;
+    std::thread writer_;
+};
+
+#endif //SECURE_CLOUD_MESSAGELOG_H
@@ -0,0 +1,95 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_PGSTORE_H
+#define SECURE_CLOUD_PGSTORE_H
+
+#include "ConversationStore.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace trantor { class EventLoop; }
+struct pg_conn;   // PGconn of libpq-fe.h
+
+// ConversationStore straight over libpq (CONVERSATION_STORE=postgres).
+//
+// PG_POOL_SIZE connections (default 4), each driven by its own thread. A
+// thread takes every query queued while it was busy (at most 64) and sends
+// them as one pipeline: one write, one round trip, a Sync after each query
+// so a failing query does not abort the others. Every statement is prepared
+// once per connection and returns a single json column built by Postgres,
+// shaped like the PostgREST answer.
+//
+// Connection: PG_CONNINFO (libpq conninfo or URI), else DB_HOST, DB_PORT,
+// DB_NAME (default "securecloud"), DB_USER, DB_PASSWORD; the PG* variables
+// of libpq fill in the rest. A broken connection is reopened for the next
+// batch; the queries of the batch that hit the failure answer ok == false.
+//
+// The role used bypasses row level security: access is only checked by
+// the service (membership before every read of a conversation).
+class PgStore final : public ConversationStore {
+public:
+    PgStore();
+    ~PgStore() override;
+
+    const char* name() const override { return "postgres"; }
+
+    void profileIdByAuthId(const Caller& caller, const std::string& authUserId, Callback cb) override;
+    void profileNames(const Caller& caller, const std::vector<std::string>& profileIds, Callback cb) override;
+
+    void conversationPage(const Caller& caller, const PageQuery& query, Callback cb) override;
+    void conversationChanges(const Caller& caller, const ChangesQuery& query, Callback cb) override;
+    void conversationOfMember(const Caller& caller,
+                              const std::string& profileId,
+                              const std::string& conversationId,
+                              Callback cb) override;
+    void conversationIds(const Caller& caller, const std::string& profileId, Callback cb) override;
+
+    void membership(const Caller& caller,
+                    const std::string& conversationId,
+                    const std::string& profileId,
+                    Callback cb) override;
+    void activeMembers(const Caller& caller, const std::string& conversationId, Callback cb) override;
+    void membersAmong(const Caller& caller,
+                      const std::string& conversationId,
+                      const std::vector<std::string>& profileIds,
+                      Callback cb) override;
+    void otherMembers(const Caller& caller,
+                      const std::vector<std::string>& conversationIds,
+                      const std::string& profileId,
+                      Callback cb) override;
+
+    PgStore(const PgStore&) = delete;
+    PgStore& operator=(const PgStore&) = delete;
+
+private:
+    // One prepared statement execution; an empty param is sent as NULL
+    struct Query {
+        const char* statement;
+        std::vector<std::string> params;
+        trantor::EventLoop* replyLoop;
+        Callback cb;
+    };
+
+    void submit(const char* statement, std::vector<std::string> params, Callback cb);
+    void workerLoop();
+    void runBatch(pg_conn*& conn, std::vector<Query>& batch);
+
+    std::string conninfo_;
+    std::size_t maxBatch_ = 64;
+
+    std::mutex queueMutex_;
+    std::condition_variable queueCv_;
+    std::deque<Query> queue_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+#endif //SECURE_CLOUD_PGSTORE_H
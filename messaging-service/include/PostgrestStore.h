@@ -0,0 +1,44 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_POSTGRESTSTORE_H
+#define SECURE_CLOUD_POSTGRESTSTORE_H
+
+#include "ConversationStore.h"
+
+// ConversationStore over Supabase's PostgREST (/rest/v1), with the caller's
+// JWT so row level security applies. Lists of ids go out as in.(...)
+// filters, 100 ids per request; the chunks run in parallel and their rows
+// are merged into one array.
+class PostgrestStore final : public ConversationStore {
+public:
+    const char* name() const override { return "postgrest"; }
+
+    void profileIdByAuthId(const Caller& caller, const std::string& authUserId, Callback cb) override;
+    void profileNames(const Caller& caller, const std::vector<std::string>& profileIds, Callback cb) override;
+
+    void conversationPage(const Caller& caller, const PageQuery& query, Callback cb) override;
+    void conversationChanges(const Caller& caller, const ChangesQuery& query, Callback cb) override;
+    void conversationOfMember(const Caller& caller,
+                              const std::string& profileId,
+                              const std::string& conversationId,
+                              Callback cb) override;
+    void conversationIds(const Caller& caller, const std::string& profileId, Callback cb) override;
+
+    void membership(const Caller& caller,
+                    const std::string& conversationId,
+                    const std::string& profileId,
+                    Callback cb) override;
+    void activeMembers(const Caller& caller, const std::string& conversationId, Callback cb) override;
+    void membersAmong(const Caller& caller,
+                      const std::string& conversationId,
+                      const std::vector<std::string>& profileIds,
+                      Callback cb) override;
+    void otherMembers(const Caller& caller,
+                      const std::vector<std::string>& conversationIds,
+                      const std::string& profileId,
+                      Callback cb) override;
+};
+
+#endif //SECURE_CLOUD_POSTGRESTSTORE_H
@@ -0,0 +1,82 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_PROFILEIDCACHE_H
+#define SECURE_CLOUD_PROFILEIDCACHE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+// authUserId -> profileId map shared by all IO threads.
+//
+// The key space is split over independent shards (one mutex each) so the
+// loops rarely contend. Every shard is an LRU bounded to its share of the
+// size cap, and entries expire after the TTL.
+//
+// Configuration (environment):
+//  - PROFILE_CACHE_TTL_SECONDS : entry lifetime (default 300, 0 disables the cache)
+//  - PROFILE_CACHE_SIZE        : max entries over all shards (default 50000)
+class ProfileIdCache {
+public:
+    struct Stats {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t evictions;
+        std::uint64_t invalidations;
+        std::size_t size;
+    };
+
+    static ProfileIdCache& instance();
+
+    std::optional<std::string> get(const std::string& authUserId);
+    void put(const std::string& authUserId, const std::string& profileId);
+
+    // Drop one user (account deleted) or everything
+    void invalidate(const std::string& authUserId);
+    void clear();
+
+    Stats stats() const;
+
+    ProfileIdCache(const ProfileIdCache&) = delete;
+    ProfileIdCache& operator=(const ProfileIdCache&) = delete;
+
+private:
+    ProfileIdCache();
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string authUserId;
+        std::string profileId;
+        Clock::time_point expiresAt;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> lru;   // front = most recently used
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    };
+
+    static constexpr std::size_t kShards = 16;
+
+    Shard& shardFor(const std::string& authUserId);
+
+    std::array<Shard, kShards> shards_;
+    std::chrono::seconds ttl_{300};
+    std::size_t perShardCapacity_ = 50000 / kShards;
+
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> evictions_{0};
+    std::atomic<std::uint64_t> invalidations_{0};
+};
+
+#endif //SECURE_CLOUD_PROFILEIDCACHE_H
@@ -0,0 +1,40 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_REALTIMECONTROLLER_H
+#define SECURE_CLOUD_REALTIMECONTROLLER_H
+
+#pragma once
+#include <drogon/WebSocketController.h>
+
+// GET /ws (WebSocket upgrade) → push events of the caller's conversations.
+// Auth: "Authorization: Bearer <token>" or ?access_token=<token> (browsers
+// cannot set headers on a WebSocket). The query string ends up in the
+// access logs of proxies and load balancers, bearer token included: keep
+// such logs private, or strip the parameter from them. The token is checked
+// at the upgrade only, and the socket is closed (1008) when it expires.
+// Server → client only:
+//   {"type":"ready","conversations":N}
+//   {"type":"message.created","conversation_id":...,"message":{...}}
+//   {"type":"member.added"|"member.updated"|"member.removed","conversation_id":...,"member":[...]}
+//   {"type":"conversation.created"|"conversation.deleted","conversation_id":...,"conversation":{...}}
+// Missed events are read back through the REST routes (GET .../messages?after=).
+class RealtimeController final
+    : public drogon::WebSocketController<RealtimeController> {
+public:
+    WS_PATH_LIST_BEGIN
+    WS_PATH_ADD("/ws");
+    WS_PATH_LIST_END
+
+    void handleNewConnection(const drogon::HttpRequestPtr& req,
+                             const drogon::WebSocketConnectionPtr& conn) override;
+
+    void handleNewMessage(const drogon::WebSocketConnectionPtr& conn,
+                          std::string&& message,
+                          const drogon::WebSocketMessageType& type) override;
+
+    void handleConnectionClosed(const drogon::WebSocketConnectionPtr& conn) override;
+};
+
+#endif //SECURE_CLOUD_REALTIMECONTROLLER_H
@@ -0,0 +1,101 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_REALTIMEHUB_H
+#define SECURE_CLOUD_REALTIMEHUB_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace drogon { class WebSocketConnection; }
+namespace trantor { class EventLoop; }
+
+// Fan-out of real-time events to the WebSocket subscribers.
+//
+// Each IO loop owns its subscriber table (thread_local): a socket is only ever
+// touched by the loop that accepted it, so delivering an event takes no lock
+// shared between loops. publish() hands one shared copy of the event to every
+// loop that has sockets, and each loop walks its own
+// conversation -> subscribers index.
+//
+// Slow consumers: at most WS_WINDOW_BYTES (default 64 KiB) may be sent to a
+// socket without acknowledgement. When the window is full the hub sends a
+// ping and queues the next events; the matching pong can only come back once
+// the peer has read everything sent before the ping, and it reopens the
+// window. A socket with more than WS_MAX_QUEUE (default 256) queued events is
+// closed.
+class RealtimeHub {
+public:
+    using Connection = std::shared_ptr<drogon::WebSocketConnection>;
+
+    struct Stats {
+        std::size_t sockets = 0;
+        std::uint64_t delivered = 0;
+        std::uint64_t evicted = 0;
+    };
+
+    static RealtimeHub& instance();
+
+    // --- Called on the loop that owns the socket ---
+    void attach(const Connection& conn,
+                const std::string& profileId,
+                const std::vector<std::string>& conversationIds);
+    void detach(const Connection& conn);
+    void onPong(const Connection& conn, const std::string& payload);
+
+    // --- Thread-safe, callable from any thread ---
+    // Deliver event to the subscribers of the conversation
+    void publish(const std::string& conversationId, std::string event);
+    // Subscribe the sockets of profileId first, then deliver
+    void memberJoined(const std::string& conversationId, const std::string& profileId, std::string event);
+    // Deliver first (the leaving member sees it), then unsubscribe profileId
+    void memberLeft(const std::string& conversationId, const std::string& profileId, std::string event);
+    // Deliver, then drop every subscription to the conversation
+    void conversationClosed(const std::string& conversationId, std::string event);
+
+    Stats stats() const;
+
+    RealtimeHub(const RealtimeHub&) = delete;
+    RealtimeHub& operator=(const RealtimeHub&) = delete;
+
+private:
+    RealtimeHub();
+
+    struct Subscriber;
+    struct LoopTable;
+    using Event = std::shared_ptr<const std::string>;
+    using LoopTask = void (*)(RealtimeHub&, LoopTable&, const std::string&, const std::string&, const Event&);
+
+    void registerCurrentLoop();
+    // Runs task on every registered loop, against that loop's table
+    void broadcast(LoopTask task, const std::string& conversationId, const std::string& profileId, std::string event);
+
+    void deliverAll(LoopTable& table, const std::string& conversationId, const Event& event);
+    void deliver(LoopTable& table, Subscriber& sub, const Event& event);
+    void sendProbe(LoopTable& table, Subscriber& sub, drogon::WebSocketConnection& conn);
+
+    // Table of the loop running on this thread (null until its first socket)
+    static thread_local LoopTable* localTable_;
+
+    std::size_t windowBytes_ = 64 * 1024;
+    std::size_t maxQueue_ = 256;
+
+    // Written once per loop (first socket), read without lock by publishers
+    static constexpr std::size_t kMaxLoops = 256;
+    std::mutex registerMutex_;
+    std::array<std::atomic<trantor::EventLoop*>, kMaxLoops> loops_{};
+    std::atomic<std::size_t> loopCount_{0};
+
+    std::atomic<std::size_t> sockets_{0};
+    std::atomic<std::uint64_t> delivered_{0};
+    std::atomic<std::uint64_t> evicted_{0};
+};
+
+#endif //SECURE_CLOUD_REALTIMEHUB_H
@@ -0,0 +1,125 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_REDISCACHE_H
+#define SECURE_CLOUD_REDISCACHE_H
+
+#include "Metrics.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace drogon::nosql {
+class RedisClient;
+class RedisSubscriber;
+}
+
+// Cache tier shared by every messaging-service replica, in Redis.
+//
+// Holds the answers of the lookups each replica would otherwise repeat
+// against the store (caller profile id, membership of a caller, profile
+// names), as received. One "fast" Drogon Redis client per IO loop: the
+// commands of a loop share its connection and are pipelined on it, and
+// their callbacks run back on that loop. Outside of an IO loop (blocking
+// calls) the cache is skipped.
+//
+// Redis errors and timeouts count as misses; empty answers are not cached.
+// A lookup racing with a mutation may put back a stale entry: the TTL
+// bounds how long it stays, every entry being a key of its own (SET EX,
+// never extended by later writes).
+// Memberships are one key per (conversation, profile), listed in a set per
+// conversation, so a mutation drops the entries it touches (DEL, or all the
+// listed ones for the whole conversation) and then publishes on "<prefix>invalidate" for replicas keeping a local copy:
+// "<replica> <conversationId>[ <profileId>,<profileId>...]", where replica
+// (host:pid) lets each one skip its own messages. A change of the profile
+// behind an auth user id is published on the same channel as
+// "<replica> profile:<authUserId>" (conversation ids are UUIDs, no clash).
+//
+// Configuration (environment):
+//  - REDIS_HOST              : enables the cache (unset = disabled)
+//  - REDIS_PORT              : default 6379
+//  - REDIS_PASSWORD, REDIS_DB: default none / 0
+//  - REDIS_CACHE_TTL_SECONDS : entry lifetime (default 60, 0 disables the cache)
+//  - REDIS_TIMEOUT_MS        : per command (default 100)
+//  - REDIS_KEY_PREFIX        : default "messaging:"
+class RedisCache {
+public:
+    // A key, listed in the index set when index is set
+    struct Slot {
+        std::string key;
+        std::string index;
+    };
+
+    // nullopt: miss (or Redis unavailable)
+    using Lookup = std::function<void(std::optional<std::string>)>;
+
+    static RedisCache& instance();
+
+    static Slot profileOfAuthUser(const std::string& authUserId);
+    static Slot profileNames(const std::string& profileId);
+    static Slot membership(const std::string& conversationId, const std::string& profileId);
+
+    // False when disabled or off an IO loop: callers go straight to the store
+    bool usable() const;
+
+    void get(const Slot& slot, Lookup cb);
+    void put(const Slot& slot, const std::string& value);
+
+    // Drop the cached memberships of these profiles (every membership of the
+    // conversation when profileIds is empty) and publish the invalidation
+    void invalidateMembers(const std::string& conversationId,
+                           const std::vector<std::string>& profileIds = {});
+
+    // Drop the cached profile id of this auth user and publish the invalidation
+    void invalidateProfile(const std::string& authUserId);
+
+    // Invalidations published by the other replicas (profileIds empty: the
+    // whole conversation). Runs on the thread of a dedicated Redis
+    // connection, subscribed at the first registration.
+    using InvalidationListener =
+        std::function<void(const std::string& conversationId, const std::vector<std::string>& profileIds)>;
+    void onInvalidate(InvalidationListener listener);
+
+    // Profile invalidations published by the other replicas (same thread)
+    using ProfileInvalidationListener = std::function<void(const std::string& authUserId)>;
+    void onProfileInvalidate(ProfileInvalidationListener listener);
+
+    RedisCache(const RedisCache&) = delete;
+    RedisCache& operator=(const RedisCache&) = delete;
+
+private:
+    RedisCache();
+
+    void subscribe();    // listenersMutex_ held
+    void publish(const std::shared_ptr<drogon::nosql::RedisClient>& client, const std::string& message);
+    void dispatch(const std::string& message);
+
+    bool enabled_ = false;
+    std::string prefix_ = "messaging:";
+    std::chrono::seconds ttl_{60};
+    std::string replica_;
+
+    // Connection settings, kept for the subscriber connection
+    std::string ip_;
+    unsigned short port_ = 6379;
+    std::string password_;
+    unsigned int db_ = 0;
+
+    std::mutex listenersMutex_;
+    std::vector<InvalidationListener> listeners_;
+    std::vector<ProfileInvalidationListener> profileListeners_;
+    std::shared_ptr<drogon::nosql::RedisClient> subscriberClient_;
+    std::shared_ptr<drogon::nosql::RedisSubscriber> subscriber_;
+
+    Metrics::Id hits_ = 0;
+    Metrics::Id misses_ = 0;
+    Metrics::Id errors_ = 0;
+};
+
+#endif //SECURE_CLOUD_REDISCACHE_H
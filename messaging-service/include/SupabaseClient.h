@@ -0,0 +1,105 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#ifndef SECURE_CLOUD_SUPABASECLIENT_H
+#define SECURE_CLOUD_SUPABASECLIENT_H
+
+#include <curl/curl.h>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace trantor { class EventLoop; }
+
+// Shared HTTP client for every Supabase (PostgREST / GoTrue) call.
+//
+// Each thread (so each Drogon IO loop) keeps its own reusable easy handle:
+// the TCP/TLS connections it opens stay alive between calls and HTTP/2 is
+// negotiated when the upstream allows it. DNS answers and TLS sessions are
+// shared between all threads through a single curl share handle.
+//
+// performAsync() never blocks: on an IO loop thread the transfer is driven
+// by a curl_multi handle owned by that loop, so the number of calls in
+// flight is only bounded by memory.
+//
+// Identical concurrent GETs (same URL, apikey and bearer token) are
+// coalesced: the first one goes upstream, the others wait for its response,
+// which is handed to every waiter on its own loop (single-flight).
+//
+// Every transfer is bounded in time, so a stalled upstream always ends in
+// an error response (for the caller and for every coalesced waiter):
+//  - SUPABASE_CONNECT_TIMEOUT_MS : connection setup (default 5000)
+//  - SUPABASE_TIMEOUT_MS         : whole transfer (default 15000)
+class SupabaseClient {
+public:
+    struct Request {
+        std::string method = "GET";
+        std::string url;
+        std::string apiKey;
+        std::string bearer;
+        std::string body;
+        bool returnRepresentation = false;   // adds "Prefer: return=representation"
+    };
+
+    struct Response {
+        bool ok = false;        // false when the transfer itself failed (no HTTP status)
+        long httpCode = 0;
+        std::string body;
+        std::string error;      // curl error message when !ok
+    };
+
+    using Callback = std::function<void(const Response&)>;
+
+    struct Stats {
+        std::uint64_t upstream = 0;     // asynchronous transfers actually started
+        std::uint64_t coalesced = 0;    // GETs that joined a transfer already in flight
+    };
+
+    // While alive, performAsync() on this thread runs inline (blocking) and
+    // calls back before returning. Used by the synchronous service variants.
+    class BlockingScope {
+    public:
+        BlockingScope();
+        ~BlockingScope();
+        BlockingScope(const BlockingScope&) = delete;
+        BlockingScope& operator=(const BlockingScope&) = delete;
+
+        // True while a BlockingScope is alive on the calling thread
+        static bool active();
+    private:
+        bool previous_;
+    };
+
+    static SupabaseClient& instance();
+
+    // Blocking call on the pooled handle of the calling thread
+    Response perform(const Request& req);
+
+    // Non-blocking call; cb runs on the calling IO loop. Outside of an IO loop
+    // (or inside a BlockingScope) this falls back to perform().
+    void performAsync(Request req, Callback cb);
+
+    Stats stats() const;
+
+    SupabaseClient(const SupabaseClient&) = delete;
+    SupabaseClient& operator=(const SupabaseClient&) = delete;
+
+private:
+    SupabaseClient();
+
+    void startTransfer(trantor::EventLoop* loop, Request req, Callback cb);
+    CURL* threadHandle();
+    void applyOptions(CURL* c, const Request& req, curl_slist* headers, std::string* out);
+
+    static void lockShare(CURL*, curl_lock_data data, curl_lock_access, void* userptr);
+    static void unlockShare(CURL*, curl_lock_data data, void* userptr);
+
+    CURLSH* share_ = nullptr;
+    long connectTimeoutMs_ = 5000;
+    long timeoutMs_ = 15000;
+    std::mutex shareLocks_[CURL_LOCK_DATA_LAST];
+};
+
+#endif //SECURE_CLOUD_SUPABASECLIENT_H
@@ -0,0 +1,87 @@
+-- Direct conversations in one round trip (CONVERSATION_CREATE_RPC=1).
+--
+-- create_direct_conversation(p_caller, p_target) does, in one transaction:
+--   1. check that p_caller is the profile of the JWT (auth.uid());
+--   2. insert the conversation, or take the live one with the same direct_key;
+--   3. when it was created, insert both memberships (both owners).
+--
+-- Answer (jsonb):
+--   {"created": true|false, "conversation": {...}}   the conversation row
+--   {"created": false, "conversation": null}         p_target does not exist
+--
+-- A soft-deleted conversation holding the direct_key raises 23505, as the
+-- plain POST /rest/v1/conversations does (409 through PostgREST).
+--
+-- SECURITY INVOKER: the row level security policies of the caller apply,
+-- exactly as for the REST calls the service makes otherwise.
+
+-- ON CONFLICT needs a unique index on direct_key (skipped when the
+-- conversations_direct_key_key constraint already exists)
+create unique index if not exists conversations_direct_key_key
+    on public.conversations (direct_key);
+
+create or replace function public.create_direct_conversation(p_caller uuid, p_target uuid)
+returns jsonb
+language plpgsql
+security invoker
+set search_path = public
+as $$
+declare
+    v_key  text;
+    v_conv conversations;
+begin
+    if not exists (select 1 from profiles where id = p_caller and auth_id = auth.uid()) then
+        raise exception 'Caller profile does not belong to the current user'
+            using errcode = '42501';
+    end if;
+
+    if p_caller = p_target then
+        raise exception 'Cannot create a direct conversation with yourself'
+            using errcode = '22023';
+    end if;
+
+    if not exists (select 1 from profiles where id = p_target) then
+        return jsonb_build_object('created', false, 'conversation', null);
+    end if;
+
+    -- Same key as makeDirectKey() in ConversationService.cpp: byte order, lowercase
+    v_key := least(p_caller::text collate "C", p_target::text collate "C")
+             || ':' ||
+             greatest(p_caller::text collate "C", p_target::text collate "C");
+
+    -- A concurrent call with the same key waits here for the first one to
+    -- commit, then finds its row below: no duplicate, no half-created pair
+    insert into conversations (type, direct_key, created_by)
+    values ('direct', v_key, p_caller)
+    on conflict (direct_key) do nothing
+    returning * into v_conv;
+
+    if found then
+        insert into conversation_members (conversation_id, user_id, role)
+        values (v_conv.id, p_caller, 'owner'),
+               (v_conv.id, p_target, 'owner');
+
+        return jsonb_build_object('created', true, 'conversation', to_jsonb(v_conv));
+    end if;
+
+    select * into v_conv from conversations where direct_key = v_key;
+
+    if not found then
+        raise exception 'Direct conversation % is not visible to the caller', v_key
+            using errcode = '42501';
+    end if;
+
+    if v_conv.deleted_at is not null then
+        raise exception 'duplicate key value violates unique constraint "conversations_direct_key_key"'
+            using errcode = '23505';
+    end if;
+
+    return jsonb_build_object('created', false, 'conversation', to_jsonb(v_conv));
+end;
+$$;
+
+revoke all on function public.create_direct_conversation(uuid, uuid) from public;
+grant execute on function public.create_direct_conversation(uuid, uuid) to authenticated;
+
+-- Let PostgREST see the new function without a restart
+notify pgrst, 'reload schema';
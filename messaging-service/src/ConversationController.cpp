@@ -4,10 +4,14 @@
 
 #include "../include/ConversationController.h"
 #include "../include/ConversationService.h"
+#include "../include/FastJson.h"
 
-#include <json/json.h>
+#include <cstdint>
 #include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
 using namespace drogon;
 
@@ -21,10 +25,12 @@ std::string getBearerToken(const HttpRequestPtr& req) {
 }
 
 HttpResponsePtr makeJsonError(HttpStatusCode code, const std::string& msg) {
-    Json::Value j;
-    j["error"] = msg;
-    auto r = HttpResponse::newHttpJsonResponse(j);
+    std::string body;
+    fastjson::Writer(body).beginObject().field("error", msg).endObject();
+    auto r = HttpResponse::newHttpResponse();
     r->setStatusCode(code);
+    r->setContentTypeCode(CT_APPLICATION_JSON);
+    r->setBody(std::move(body));
     return r;
 }
 
@@ -36,6 +42,63 @@ HttpResponsePtr unauthorized(const std::string& msg) {
     return makeJsonError(drogon::k401Unauthorized, msg);
 }
 
+// Request body as a JSON object, read in place (the request outlives the handler)
+bool readJsonBody(const HttpRequestPtr& req, fastjson::Value& out) {
+    return fastjson::parse(req->body(), out) && out.isObject();
+}
+
+// Array of strings (profile ids); false on any other value
+bool readStringArray(const fastjson::Value& field, std::vector<std::string>& out) {
+    if (!field.isArray()) return false;
+    bool ok = true;
+    fastjson::forEachElement(field, [&](const fastjson::Value& v) {
+        if (!v.isString()) return ok = false;
+        out.push_back(v.string());
+        return true;
+    });
+    return ok;
+}
+
+// Optional positive integer query parameter; false when present but not a number
+bool readIntParam(const HttpRequestPtr& req, const std::string& name, int& out) {
+    const auto& raw = req->getParameter(name);
+    if (raw.empty()) return true;
+    try {
+        size_t used = 0;
+        out = std::stoi(raw, &used);
+        return used == raw.size();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Optional sequence number query parameter; false when present but not a number
+bool readSeqParam(const HttpRequestPtr& req, const std::string& name, std::uint64_t& out) {
+    const auto& raw = req->getParameter(name);
+    if (raw.empty()) return true;
+    if (raw.find_first_not_of("0123456789") != std::string::npos) return false;
+    try {
+        out = std::stoull(raw);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Build the HTTP response from a service result (the serialized body is moved, not copied)
+HttpResponsePtr toHttpResponse(ConversationService::Result&& result) {
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setStatusCode(static_cast<HttpStatusCode>(result.statusCode));
+    if (result.statusCode != 304) {   // Not Modified has no body
+        resp->setContentTypeCode(CT_APPLICATION_JSON);
+        resp->setBody(result.rawBody.empty() ? result.body.dump() : std::move(result.rawBody));
+    }
+    for (const auto& [name, value] : result.headers) {
+        resp->addHeader(name, value);
+    }
+    return resp;
+}
+
 } // namespace
 
 void ConversationController::createConversation(
@@ -43,19 +106,28 @@ void ConversationController::createConversation(
     std::function<void (const drogon::HttpResponsePtr &)> &&cb) const {
 
     // 1) Receive and validate the JSON body
-    const auto body = req->getJsonObject();
-    if (!body) {
+    fastjson::Value body;
+    if (!readJsonBody(req, body)) {
         return cb(makeJsonError(k400BadRequest, "Body must be JSON"));
     }
 
-    if (!body->isMember("type") || !(*body)["type"].isString()) {
+    // One pass over the body for the four fields
+    fastjson::Value typeField, nameField, targetField, membersField;
+    fastjson::forEachMember(body, [&](std::string_view key, const fastjson::Value& v) {
+        if (key == "type") typeField = v;
+        else if (key == "name") nameField = v;
+        else if (key == "target_user_id") targetField = v;
+        else if (key == "member_ids") membersField = v;
+    });
+
+    if (!typeField.isString()) {
         return cb(makeJsonError(
             k400BadRequest,
             "Field 'type' is required and must be a string ('direct'|'group')"
         ));
     }
 
-    const std::string type = (*body)["type"].asString();
+    const std::string type = typeField.string();
     if (type != "direct" && type != "group") {
         return cb(makeJsonError(
             k400BadRequest,
@@ -64,25 +136,34 @@ void ConversationController::createConversation(
     }
 
     std::optional<std::string> name;
-    if (body->isMember("name") && (*body)["name"].isString()) {
-        name = (*body)["name"].asString();
+    if (nameField.isString()) {
+        name = nameField.string();
     }
 
     // target_user_id for direct
     std::optional<std::string> targetUserId;
     if (type == "direct") {
-        if (!body->isMember("target_user_id") || !(*body)["target_user_id"].isString()) {
+        if (!targetField.isString()) {
             return cb(makeJsonError(
                 k400BadRequest,
                 "Field 'target_user_id' is required for type='direct' and must be a string (profile id)"
             ));
         }
-        targetUserId = (*body)["target_user_id"].asString();
+        targetUserId = targetField.string();
+    }
+
+    // member_ids for group (optional)
+    std::vector<std::string> memberIds;
+    if (membersField.valid() && !readStringArray(membersField, memberIds)) {
+        return cb(makeJsonError(
+            k400BadRequest,
+            "Field 'member_ids' must be an array of strings (profile ids)"
+        ));
     }
 
     // If group, target_user_id is not allowed
     if (type == "group") {
-        if (body->isMember("target_user_id")) {
+        if (targetField.valid()) {
             return cb(makeJsonError(
                 k400BadRequest,
                 "Field 'target_user_id' is not allowed for type='group'"
@@ -96,22 +177,11 @@ void ConversationController::createConversation(
         return cb(makeJsonError(k401Unauthorized, "Missing Bearer access token"));
     }
 
-    // 3) Call the business service
+    // 3) Call the business service (non-blocking, the response is sent from the callback)
     ConversationService service;
-    auto result = service.createConversation(
-        token,
-        type,
-        name,
-        targetUserId
-    );
-
-    // 4) Build the HTTP response from the result
-    auto resp = drogon::HttpResponse::newHttpResponse();
-    resp->setStatusCode(static_cast<drogon::HttpStatusCode>(result.statusCode));
-    resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
-    resp->setBody(result.body.dump());
-
-    return cb(resp);
+    service.createConversation(token, type, name, targetUserId, memberIds, [cb = std::move(cb)](ConversationService::Result result) {
+        cb(toHttpResponse(std::move(result)));
+    });
 }
 
 void ConversationController::listConversations(
@@ -123,14 +193,40 @@ void ConversationController::listConversations(
         return cb(makeJsonError(k401Unauthorized, "Missing Bearer access token"));
     }
 
+    // Pagination: ?limit=&cursor=&since= (ranges checked by the service)
+    ConversationService::PageRequest page;
+    if (!readIntParam(req, "limit", page.limit)) {
+        return cb(badRequest("'limit' must be an integer"));
+    }
+    page.cursor = req->getParameter("cursor");
+    page.since = req->getParameter("since");
+    page.ifNoneMatch = req->getHeader("if-none-match");
+
     ConversationService service;
-    auto result = service.listMyConversations(token);
+    service.listMyConversations(token, page, [cb = std::move(cb)](ConversationService::Result result) {
+        cb(toHttpResponse(std::move(result)));
+    });
+}
 
-    auto resp = HttpResponse::newHttpResponse();
-    resp->setStatusCode(static_cast<HttpStatusCode>(result.statusCode));
-    resp->setContentTypeCode(CT_APPLICATION_JSON);
-    resp->setBody(result.body.dump());
-    return cb(resp);
+void ConversationController::listConversationChanges(
+    const drogon::HttpRequestPtr& req,
+    std::function<void (const drogon::HttpResponsePtr &)> &&cb) const {
+
+    const auto token = getBearerToken(req);
+    if (token.empty()) {
+        return cb(makeJsonError(k401Unauthorized, "Missing Bearer access token"));
+    }
+
+    ConversationService::ChangesRequest changes;
+    changes.since = req->getParameter("since");
+    if (!readIntParam(req, "limit", changes.limit)) {
+        return cb(badRequest("'limit' must be an integer"));
+    }
+
+    ConversationService service;
+    service.listConversationChanges(token, changes, [cb = std::move(cb)](ConversationService::Result result) {
+        cb(toHttpResponse(std::move(result)));
+    });
 }
 
 void ConversationController::getConversation(
@@ -148,13 +244,9 @@ void ConversationController::getConversation(
     }
 
     ConversationService service;
-    auto result = service.getConversationById(token, conversationId);
-
-    auto resp = HttpResponse::newHttpResponse();
-    resp->setStatusCode(static_cast<HttpStatusCode>(result.statusCode));
-    resp->setContentTypeCode(CT_APPLICATION_JSON);
-    resp->setBody(result.body.dump());
-    return cb(resp);
+    service.getConversationById(token, conversationId, [cb = std::move(cb)](ConversationService::Result result) {
+        cb(toHttpResponse(std::move(result)));
+    });
 }
 
 void ConversationController::updateConversation(
@@ -171,17 +263,17 @@ void ConversationController::updateConversation(
         return cb(badRequest("Missing conversation id"));
     }
 
-    const auto body = req->getJsonObject();
-    if (!body) {
+    fastjson::Value body;
+    if (!readJsonBody(req, body)) {
         return cb(badRequest("Body must be JSON"));
     }
 
     std::optional<std::string> name;
-    if (body->isMember("name")) {
-        if (!(*body)["name"].isString()) {
+    if (const auto field = fastjson::member(body, "name"); field.valid()) {
+        if (!field.isString()) {
             return cb(badRequest("Field 'name' must be a string"));
         }
-        name = (*body)["name"].asString();
+        name = field.string();
     }
 
     if (!name.has_value()) {
@@ -189,13 +281,9 @@ void ConversationController::updateConversation(
     }
 
     ConversationService service;
-    auto result = service.updateConversation(token, conversationId, name);
-
-    auto resp = drogon::HttpResponse::newHttpResponse();
-    resp->setStatusCode(static_cast<drogon::HttpStatusCode>(result.statusCode));
-    resp->setContentTypeCode(CT_APPLICATION_JSON);
-    resp->setBody(result.body.dump());
-    return cb(resp);
+    service.updateConversation(token, conversationId, name, [cb = std::move(cb)](ConversationService::Result result) {
+        cb(toHttpResponse(std::move(result)));
+    });
 }
 
 void ConversationController::deleteConversation(
@@ -213,13 +301,9 @@ void ConversationController::deleteConversation(
     }
 
     ConversationService service;
-    auto result = service.deleteConversation(token, conversationId);
-
-    auto resp = drogon::HttpResponse::newHttpResponse();
-    resp->setStatusCode(static_cast<drogon::HttpStatusCode>(result.statusCode));
-    resp->setContentTypeCode(CT_APPLICATION_JSON);
-    resp->setBody(result.body.dump());
-    return cb(resp);
+    service.deleteConversation(token, conversationId, [cb = std::move(cb)](ConversationService::Result result) {
+        cb(toHttpResponse(std::move(result)));
+    });
 }
 
 void ConversationController::addMember(
@@ -236,25 +320,52 @@ void ConversationController::addMember(
         return cb(badRequest("Missing conversation id"));
     }
 
-    const auto body = req->getJsonObject();
-    if (!body) {
+    fastjson::Value body;
+    if (!readJsonBody(req, body)) {
         return cb(badRequest("Body must be JSON"));
     }
 
-    if (!body->isMember("user_id") || !(*body)["user_id"].isString()) {
+    const auto userField = fastjson::member(body, "user_id");
+    if (!userField.isString()) {
         return cb(badRequest("Field 'user_id' is required and must be a string (profile id)"));
     }
 
-    const std::string userId = (*body)["user_id"].asString();
+    const std::string userId = userField.string();
 
     ConversationService service;
-    auto result = service.addMember(token, conversationId, userId);
+    service.addMember(token, conversationId, userId, [cb = std::move(cb)](ConversationService::Result result) {
+        cb(toHttpResponse(std::move(result)));
+    });
+}
+
+void ConversationController::addMembers(
+    const drogon::HttpRequestPtr& req,
+    std::function<void (const drogon::HttpResponsePtr &)> &&cb,
+    const std::string& conversationId) const {
 
-    auto resp = drogon::HttpResponse::newHttpResponse();
-    resp->setStatusCode(static_cast<drogon::HttpStatusCode>(result.statusCode));
-    resp->setContentTypeCode(CT_APPLICATION_JSON);
-    resp->setBody(result.body.dump());
-    return cb(resp);
+    const auto token = getBearerToken(req);
+    if (token.empty()) {
+        return cb(unauthorized("Missing Bearer access token"));
+    }
+
+    if (conversationId.empty()) {
+        return cb(badRequest("Missing conversation id"));
+    }
+
+    fastjson::Value body;
+    if (!readJsonBody(req, body)) {
+        return cb(badRequest("Body must be JSON"));
+    }
+
+    std::vector<std::string> userIds;
+    if (!readStringArray(fastjson::member(body, "user_ids"), userIds)) {
+        return cb(badRequest("Field 'user_ids' is required and must be an array of strings (profile ids)"));
+    }
+
+    ConversationService service;
+    service.addMembers(token, conversationId, userIds, [cb = std::move(cb)](ConversationService::Result result) {
+        cb(toHttpResponse(std::move(result)));
+    });
 }
 
 void ConversationController::listMembers(
@@ -272,13 +383,63 @@ void ConversationController::listMembers(
     }
 
     ConversationService service;
-    auto result = service.listMembers(token, conversationId);
+    service.listMembers(token, conversationId, req->getHeader("if-none-match"), [cb = std::move(cb)](ConversationService::Result result) {
+        cb(toHttpResponse(std::move(result)));
+    });
+}
+
+void ConversationController::postMessage(
+    const drogon::HttpRequestPtr& req,
+    std::function<void (const drogon::HttpResponsePtr &)> &&cb,
+    const std::string& conversationId) const {
+
+    const auto token = getBearerToken(req);
+    if (token.empty()) {
+        return cb(unauthorized("Missing Bearer access token"));
+    }
+
+    if (conversationId.empty()) {
+        return cb(badRequest("Missing conversation id"));
+    }
+
+    fastjson::Value body;
+    const auto text = readJsonBody(req, body) ? fastjson::member(body, "body") : fastjson::Value{};
+    if (!text.isString()) {
+        return cb(badRequest("Field 'body' is required and must be a string"));
+    }
+
+    ConversationService service;
+    service.postMessage(token, conversationId, text.string(), [cb = std::move(cb)](ConversationService::Result result) {
+        cb(toHttpResponse(std::move(result)));
+    });
+}
 
-    auto resp = drogon::HttpResponse::newHttpResponse();
-    resp->setStatusCode(static_cast<drogon::HttpStatusCode>(result.statusCode));
-    resp->setContentTypeCode(CT_APPLICATION_JSON);
-    resp->setBody(result.body.dump());
-    return cb(resp);
+void ConversationController::listMessages(
+    const drogon::HttpRequestPtr& req,
+    std::function<void (const drogon::HttpResponsePtr &)> &&cb,
+    const std::string& conversationId) const {
+
+    const auto token = getBearerToken(req);
+    if (token.empty()) {
+        return cb(unauthorized("Missing Bearer access token"));
+    }
+
+    if (conversationId.empty()) {
+        return cb(badRequest("Missing conversation id"));
+    }
+
+    ConversationService::MessagesQuery query;
+    if (!readSeqParam(req, "after", query.after) || !readSeqParam(req, "before", query.before)) {
+        return cb(badRequest("'after' and 'before' must be sequence numbers"));
+    }
+    if (!readIntParam(req, "limit", query.limit)) {
+        return cb(badRequest("'limit' must be an integer"));
+    }
+
+    ConversationService service;
+    service.listMessages(token, conversationId, query, [cb = std::move(cb)](ConversationService::Result result) {
+        cb(toHttpResponse(std::move(result)));
+    });
 }
 
 void ConversationController::updateMemberRole(
@@ -299,28 +460,25 @@ void ConversationController::updateMemberRole(
         return cb(badRequest("Missing user id"));
     }
 
-    const auto body = req->getJsonObject();
-    if (!body) {
+    fastjson::Value body;
+    if (!readJsonBody(req, body)) {
         return cb(badRequest("Body must be JSON"));
     }
 
-    if (!body->isMember("role") || !(*body)["role"].isString()) {
+    const auto roleField = fastjson::member(body, "role");
+    if (!roleField.isString()) {
         return cb(badRequest("Field 'role' is required and must be a string"));
     }
 
-    const std::string role = (*body)["role"].asString();
+    const std::string role = roleField.string();
     if (role != "owner" && role != "member") {
         return cb(badRequest("Field 'role' must be either 'owner' or 'member'"));
     }
 
     ConversationService service;
-    auto result = service.updateMemberRole(token, conversationId, userId, role);
-
-    auto resp = drogon::HttpResponse::newHttpResponse();
-    resp->setStatusCode(static_cast<drogon::HttpStatusCode>(result.statusCode));
-    resp->setContentTypeCode(CT_APPLICATION_JSON);
-    resp->setBody(result.body.dump());
-    return cb(resp);
+    service.updateMemberRole(token, conversationId, userId, role, [cb = std::move(cb)](ConversationService::Result result) {
+        cb(toHttpResponse(std::move(result)));
+    });
 }
 
 void ConversationController::deleteMember(
@@ -342,11 +500,7 @@ void ConversationController::deleteMember(
     }
 
     ConversationService service;
-    auto result = service.deleteMember(token, conversationId, userId);
-
-    auto resp = drogon::HttpResponse::newHttpResponse();
-    resp->setStatusCode(static_cast<drogon::HttpStatusCode>(result.statusCode));
-    resp->setContentTypeCode(CT_APPLICATION_JSON);
-    resp->setBody(result.body.dump());
-    return cb(resp);
+    service.deleteMember(token, conversationId, userId, [cb = std::move(cb)](ConversationService::Result result) {
+        cb(toHttpResponse(std::move(result)));
+    });
 }
\ No newline at end of file
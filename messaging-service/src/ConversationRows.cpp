@@ -0,0 +1,153 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/ConversationRows.h"
+
+namespace {
+
+// ---------- Helper 1 : hex ----------
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// ---------- Helper 2 : string members ----------
+// Ids, roles and types never contain escapes: an escaped value is taken as is
+// and simply does not match.
+std::string_view plainText(const fastjson::Value& v) {
+    if (!v.isString()) return {};
+    return v.raw.substr(1, v.raw.size() - 2);
+}
+
+Uuid uuidOf(const fastjson::Value& v) {
+    Uuid id;
+    Uuid::parse(plainText(v), id);
+    return id;
+}
+
+// Decoded when escaped, into store (stable addresses)
+std::string_view textOf(const fastjson::Value& v, std::deque<std::string>& store) {
+    if (!v.isString()) return {};
+    std::string scratch;
+    const auto s = v.str(scratch);
+    if (s.data() != scratch.data()) return s;
+    store.push_back(std::move(scratch));
+    return store.back();
+}
+
+} // namespace
+
+bool Uuid::parse(std::string_view text, Uuid& out) {
+    if (text.size() != 36) return false;
+
+    Uuid id;
+    std::size_t b = 0;
+    for (std::size_t i = 0; i < 36;) {
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            if (text[i] != '-') return false;
+            ++i;
+            continue;
+        }
+        const int hi = hexValue(text[i]);
+        const int lo = hexValue(text[i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        id.bytes[b++] = static_cast<std::uint8_t>((hi << 4) | lo);
+        i += 2;
+    }
+    out = id;
+    return true;
+}
+
+bool Uuid::isNil() const {
+    for (auto byte : bytes) {
+        if (byte) return false;
+    }
+    return true;
+}
+
+void Uuid::appendTo(std::string& out) const {
+    static const char* hex = "0123456789abcdef";
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) out.push_back('-');
+        out.push_back(hex[bytes[i] >> 4]);
+        out.push_back(hex[bytes[i] & 0x0F]);
+    }
+}
+
+std::string Uuid::str() const {
+    std::string out;
+    out.reserve(36);
+    appendTo(out);
+    return out;
+}
+
+MemberRole parseMemberRole(std::string_view text) {
+    if (text.empty()) return MemberRole::None;
+    if (text == "member") return MemberRole::Member;
+    if (text == "owner") return MemberRole::Owner;
+    if (text == "admin") return MemberRole::Admin;
+    return MemberRole::Other;
+}
+
+ConversationType parseConversationType(std::string_view text) {
+    if (text.empty()) return ConversationType::None;
+    if (text == "direct") return ConversationType::Direct;
+    if (text == "group") return ConversationType::Group;
+    return ConversationType::Other;
+}
+
+const char* memberRoleName(MemberRole role) {
+    switch (role) {
+        case MemberRole::Member: return "member";
+        case MemberRole::Owner:  return "owner";
+        case MemberRole::Admin:  return "admin";
+        default:                 return "";
+    }
+}
+
+bool readMemberRows(std::string_view body, std::vector<MemberRow>& out) {
+    fastjson::Value list;
+    if (!fastjson::parse(body, list) || !list.isArray()) return false;
+
+    fastjson::forEachElement(list, [&](const fastjson::Value& row) {
+        MemberRow m;
+        m.raw = row.raw;
+        fastjson::forEachMember(row, [&](std::string_view key, const fastjson::Value& v) {
+            if (key == "id") m.id = uuidOf(v);
+            else if (key == "conversation_id") m.conversationId = uuidOf(v);
+            else if (key == "user_id") m.userId = uuidOf(v);
+            else if (key == "role") m.role = parseMemberRole(plainText(v));
+        });
+        out.push_back(m);
+    });
+    return true;
+}
+
+std::shared_ptr<ConversationPage> readConversationPage(const std::string& body) {
+    auto page = std::make_shared<ConversationPage>();
+    page->body = body;
+
+    fastjson::Value list;
+    if (!fastjson::parse(page->body, list) || !list.isArray()) return nullptr;
+
+    fastjson::forEachElement(list, [&](const fastjson::Value& row) {
+        ConversationRow r;
+        r.row = row;
+        fastjson::forEachMember(row, [&](std::string_view key, const fastjson::Value& v) {
+            if (key == "conversation") r.conversation = v;
+            else if (key == "role") r.role = parseMemberRole(plainText(v));
+        });
+        fastjson::forEachMember(r.conversation, [&](std::string_view key, const fastjson::Value& v) {
+            if (key == "id") r.id = uuidOf(v);
+            else if (key == "type") r.type = parseConversationType(plainText(v));
+            else if (key == "name") r.name = textOf(v, page->decoded);
+            else if (key == "updated_at") r.updatedAt = textOf(v, page->decoded);
+            else if (key == "display_name") r.hasDisplayName = true;
+        });
+        page->rows.push_back(std::move(r));
+    });
+    return page;
+}
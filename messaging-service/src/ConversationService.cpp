@@ -3,25 +3,43 @@
 //
 
 #include "../include/ConversationService.h"
-
-#include <curl/curl.h>
+#include "../include/ConversationRows.h"
+#include "../include/ConversationStore.h"
+#include "../include/FastJson.h"
+#include "../include/JwtVerifier.h"
+#include "../include/MembershipCache.h"
+#include "../include/MessageLog.h"
+#include "Metrics.h"
+#include "../include/ProfileIdCache.h"
+#include "../include/RealtimeHub.h"
+#include "../include/RedisCache.h"
+#include "../include/SupabaseClient.h"
+
+#include <openssl/sha.h>
+#include <trantor/net/EventLoop.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <future>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 using nlohmann::json;
 
 namespace {
 
-size_t writeCb(char* ptr, size_t size, size_t nmemb, void* userdata) {
-    auto* s = static_cast<std::string*>(userdata);
-    s->append(ptr, size * nmemb);
-    return size * nmemb;
-}
-
 ConversationService::Result makeError(int status, const std::string& msg) {
     ConversationService::Result r;
     r.statusCode = status;
@@ -29,189 +47,285 @@ ConversationService::Result makeError(int status, const std::string& msg) {
     return r;
 }
 
-// Struct to easily pass Supabase config to helpers
-struct SupabaseEnv {
-    std::string base;
-    std::string anonKey;
-    std::string accessToken;
+// Supabase config + caller token, passed to the helpers and to the conversation store
+using SupabaseEnv = ConversationStore::Caller;
+
+// State of one service call, shared by all its (possibly asynchronous) steps
+struct Call {
+    SupabaseEnv env;
+    ConversationService::Callback done;
+    bool finished = false;
+
+    void complete(ConversationService::Result r) {
+        if (finished) return;
+        finished = true;
+        done(std::move(r));
+    }
 };
+using CallPtr = std::shared_ptr<Call>;
 
-// ---------- Helper 1 : receive the authUserId via /auth/v1/user ----------
-bool fetchAuthUserId(const SupabaseEnv& env,
-                     std::string& authUserId,
-                     ConversationService::Result& errOut) {
-    std::string meUrl = env.base + "/auth/v1/user";
+// Continuations: helpers report success through Then<...> and errors through Fail
+template <typename... Args>
+using Then = std::function<void(Args...)>;
+using Fail = std::function<void(ConversationService::Result)>;
+
+Fail failWith(const CallPtr& call) {
+    return [call](ConversationService::Result r) { call->complete(std::move(r)); };
+}
 
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        errOut = makeError(500, "curl init failed (/auth/v1/user)");
-        return false;
+// Read SUPABASE_URL/ANON_KEY and build the call state (answers 500 itself when missing)
+CallPtr startCall(const std::string& accessToken, ConversationService::Callback& done) {
+    const char* base = std::getenv("SUPABASE_URL");
+    const char* anon = std::getenv("SUPABASE_ANON_KEY");
+    if (!base || !anon) {
+        done(makeError(500, "Missing SUPABASE_URL/ANON_KEY"));
+        return nullptr;
     }
 
-    std::string response;
-    long code = 0;
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, ("apikey: " + env.anonKey).c_str());
-    headers = curl_slist_append(headers, ("Authorization: Bearer " + env.accessToken).c_str());
-    headers = curl_slist_append(headers, "Content-Type: application/json");
+    auto call = std::make_shared<Call>();
+    call->env = SupabaseEnv{ std::string(base), std::string(anon), accessToken };
+    call->done = std::move(done);
+    return call;
+}
 
-    curl_easy_setopt(curl, CURLOPT_URL, meUrl.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+// Latency histogram + curl error counter of one upstream helper.
+// op is a string literal, so its address is a stable key.
+struct UpstreamMetrics {
+    Metrics::Id latency;
+    Metrics::Id curlErrors;
+};
 
-    auto cres = curl_easy_perform(curl);
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
+const UpstreamMetrics& upstreamMetrics(const char* op) {
+    thread_local std::unordered_map<const char*, UpstreamMetrics> byOp;
+    auto it = byOp.find(op);
+    if (it != byOp.end()) return it->second;
+
+    auto& metrics = Metrics::instance();
+    const auto labels = Metrics::label("op", op);
+    UpstreamMetrics m{
+        metrics.histogram("supabase_request_duration_seconds", labels, "Supabase round trip, by service helper"),
+        metrics.counter("supabase_transport_errors_total", labels, "Supabase calls that failed in curl (no HTTP answer), by service helper"),
+    };
+    return byOp.emplace(op, m).first->second;
+}
 
-    if (cres != CURLE_OK) {
-        errOut = makeError(500, "curl perform failed (/auth/v1/user)");
-        return false;
-    }
-    if (code != 200) {
-        ConversationService::Result r;
-        r.statusCode = static_cast<int>(code);
-        r.body = response.empty() ? json::object() : json::parse(response, nullptr, false);
-        if (r.body.is_discarded()) r.body = json::object();
-        errOut = r;
-        return false;
-    }
+Metrics::Id upstreamInFlight() {
+    static const auto id = Metrics::instance().gauge(
+        "supabase_requests_in_flight", "", "Supabase calls waiting for their answer");
+    return id;
+}
 
-    auto j = json::parse(response, nullptr, false);
-    if (j.is_discarded() || !j.contains("id")) {
-        errOut = makeError(500, "Cannot extract user id from Supabase response");
-        return false;
-    }
+// One upstream round trip started by `send`, measured under `op`.
+// An exception thrown by `next` ends the call with a 500.
+template <typename Send>
+void callUpstream(const CallPtr& call,
+                  const char* op,
+                  Send&& send,
+                  Then<const SupabaseClient::Response&> next) {
+    const auto& metrics = upstreamMetrics(op);
+    const auto inFlight = upstreamInFlight();
+    const auto started = std::chrono::steady_clock::now();
+    Metrics::instance().add(inFlight, 1);
+
+    send([call, next = std::move(next), metrics, inFlight, started](const SupabaseClient::Response& resp) {
+        auto& m = Metrics::instance();
+        m.add(inFlight, -1);
+        m.observe(metrics.latency, static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - started).count()));
+        if (!resp.ok) m.add(metrics.curlErrors);
+
+        try {
+            next(resp);
+        } catch (const std::exception& e) {
+            call->complete(makeError(500, e.what()));
+        }
+    });
+}
 
-    authUserId = j["id"].get<std::string>();
-    return true;
+// Send one request through the shared pooled client. Writes ask for
+// "Prefer: return=representation".
+void callSupabase(const CallPtr& call,
+                  const char* op,
+                  const std::string& method,
+                  const std::string& url,
+                  const std::string& body,
+                  Then<const SupabaseClient::Response&> next) {
+    SupabaseClient::Request req;
+    req.method = method;
+    req.url = url;
+    req.apiKey = call->env.anonKey;
+    req.bearer = call->env.accessToken;
+    req.body = body;
+    req.returnRepresentation = (method != "GET");
+
+    callUpstream(call, op, [&req](SupabaseClient::Callback cb) {
+        SupabaseClient::instance().performAsync(std::move(req), std::move(cb));
+    }, std::move(next));
 }
 
-// ---------- Helper 2 : receive the profileId via /rest/v1/profiles ----------
-bool fetchProfileId(const SupabaseEnv& env,
-                    const std::string& authUserId,
-                    std::string& profileId,
-                    ConversationService::Result& errOut) {
-    std::string profileUrl =
-        env.base +
-        "/rest/v1/profiles?select=id&auth_id=eq." + authUserId + "&limit=1";
-
-    CURL* cProf = curl_easy_init();
-    if (!cProf) {
-        errOut = makeError(500, "curl init failed (profiles)");
-        return false;
-    }
-
-    std::string profResp;
-    long profCode = 0;
-    struct curl_slist* hProf = nullptr;
-    hProf = curl_slist_append(hProf, ("apikey: " + env.anonKey).c_str());
-    hProf = curl_slist_append(hProf, ("Authorization: Bearer " + env.accessToken).c_str());
-    hProf = curl_slist_append(hProf, "Content-Type: application/json");
-
-    curl_easy_setopt(cProf, CURLOPT_URL, profileUrl.c_str());
-    curl_easy_setopt(cProf, CURLOPT_HTTPHEADER, hProf);
-    curl_easy_setopt(cProf, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(cProf, CURLOPT_WRITEDATA, &profResp);
-
-    auto resProf = curl_easy_perform(cProf);
-    curl_easy_getinfo(cProf, CURLINFO_RESPONSE_CODE, &profCode);
-    curl_slist_free_all(hProf);
-    curl_easy_cleanup(cProf);
-
-    if (resProf != CURLE_OK) {
-        errOut = makeError(500, "curl perform failed (profiles)");
-        return false;
-    }
-    if (profCode != 200) {
-        ConversationService::Result r;
-        r.statusCode = static_cast<int>(profCode);
-        r.body = profResp.empty() ? json::object() : json::parse(profResp, nullptr, false);
-        if (r.body.is_discarded()) r.body = json::object();
-        errOut = r;
-        return false;
-    }
-
-    auto jp = json::parse(profResp, nullptr, false);
-    if (jp.is_discarded() || !jp.is_array() || jp.empty() || !jp[0].contains("id")) {
-        errOut = makeError(400, "No profile found for the current authenticated user");
-        return false;
-    }
-
-    profileId = jp[0]["id"].get<std::string>();
-    return true;
+void callSupabase(const CallPtr& call,
+                  const char* op,
+                  const std::string& method,
+                  const std::string& url,
+                  Then<const SupabaseClient::Response&> next) {
+    callSupabase(call, op, method, url, std::string{}, std::move(next));
 }
 
-// ---------- Helper 3 : create the conversation via /rest/v1/conversations ----------
-bool createConversationRow(const SupabaseEnv& env,
-                           const std::string& type,
-                           const std::optional<std::string>& name,
-                           const std::string& profileId,
-                           json& convObj,
-                           long& convHttpCode,
-                           ConversationService::Result& errOut) {
-    std::string convUrl = env.base + "/rest/v1/conversations";
+// Forward a non-2xx Supabase answer as-is (status + JSON body when parsable)
+ConversationService::Result upstreamError(const SupabaseClient::Response& resp) {
+    ConversationService::Result r;
+    r.statusCode = static_cast<int>(resp.httpCode);
+    r.body = resp.body.empty() ? json::object() : json::parse(resp.body, nullptr, false);
+    if (r.body.is_discarded()) r.body = json::object();
+    return r;
+}
 
-    json convPayload;
-    if (name.has_value() && !name->empty()) {
-        convPayload["name"] = *name;
-    }
-    convPayload["type"]       = type;
-    convPayload["created_by"] = profileId;
+// Parse a 2xx body in place, falling back to an empty array
+fastjson::Value parseOrEmptyArray(const std::string& body) {
+    fastjson::Value v;
+    if (body.empty() || !fastjson::parse(body, v)) fastjson::parse("[]", v);
+    return v;
+}
 
-    const std::string convBody = convPayload.dump();
+bool isEmptyArray(const fastjson::Value& v) {
+    if (!v.isArray()) return false;
+    bool empty = true;
+    fastjson::forEachElement(v, [&](const fastjson::Value&) { empty = false; return false; });
+    return empty;
+}
 
-    CURL* cConv = curl_easy_init();
-    if (!cConv) {
-        errOut = makeError(500, "curl init failed (conversations)");
-        return false;
-    }
+// First row of a write answer, kept as received ("{}" when there is no body)
+std::string writtenRow(const fastjson::Value& reply) {
+    const auto row = fastjson::firstRow(reply);
+    if (row.valid()) return std::string(row.raw);
+    return reply.valid() ? std::string(reply.raw) : std::string("{}");
+}
+
+// Answer whose body is already serialized JSON
+ConversationService::Result rawResult(int status, std::string body) {
+    return {status, nullptr, {}, std::move(body)};
+}
 
-    std::string convResp;
-    struct curl_slist* hConv = nullptr;
-    hConv = curl_slist_append(hConv, ("apikey: " + env.anonKey).c_str());
-    hConv = curl_slist_append(hConv, ("Authorization: Bearer " + env.accessToken).c_str());
-    hConv = curl_slist_append(hConv, "Content-Type: application/json");
-    hConv = curl_slist_append(hConv, "Prefer: return=representation");
+// Runs an asynchronous service call to completion on the calling thread.
+// Supabase calls run inline here; message log appends complete on the
+// writer thread, hence the wait.
+template <typename Start>
+ConversationService::Result runBlocking(Start&& start) {
+    SupabaseClient::BlockingScope blocking;
+    auto promise = std::make_shared<std::promise<ConversationService::Result>>();
+    auto result = promise->get_future();
+    start([promise](ConversationService::Result r) { promise->set_value(std::move(r)); });
+    return result.get();
+}
 
-    curl_easy_setopt(cConv, CURLOPT_URL, convUrl.c_str());
-    curl_easy_setopt(cConv, CURLOPT_HTTPHEADER, hConv);
-    curl_easy_setopt(cConv, CURLOPT_POST, 1L);
-    curl_easy_setopt(cConv, CURLOPT_POSTFIELDS, convBody.c_str());
-    curl_easy_setopt(cConv, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(cConv, CURLOPT_WRITEDATA, &convResp);
+// ---------- Helper 0 : store reads through the Redis cache tier (RedisCache.h) ----------
+// `send` may run after this returns: it must own what it captures
+template <typename Send>
+void cachedStoreRead(const CallPtr& call,
+                     const char* op,
+                     RedisCache::Slot slot,
+                     Send send,
+                     Then<const SupabaseClient::Response&> next) {
+    auto& cache = RedisCache::instance();
+    if (!cache.usable()) return callUpstream(call, op, send, std::move(next));
+
+    cache.get(slot, [call, op, slot, send, next](std::optional<std::string> hit) {
+        if (hit) {
+            SupabaseClient::Response resp;
+            resp.ok = true;
+            resp.httpCode = 200;
+            resp.body = std::move(*hit);
+            try {
+                return next(resp);
+            } catch (const std::exception& e) {
+                return call->complete(makeError(500, e.what()));
+            }
+        }
 
-    auto resConv = curl_easy_perform(cConv);
-    curl_easy_getinfo(cConv, CURLINFO_RESPONSE_CODE, &convHttpCode);
-    curl_slist_free_all(hConv);
-    curl_easy_cleanup(cConv);
+        callUpstream(call, op, send, [slot, next](const SupabaseClient::Response& resp) {
+            if (resp.ok && resp.httpCode == 200 && !isEmptyArray(parseOrEmptyArray(resp.body))) {
+                RedisCache::instance().put(slot, resp.body);
+            }
+            next(resp);
+        });
+    });
+}
 
-    if (resConv != CURLE_OK) {
-        errOut = makeError(500, "curl perform failed (create conversation)");
-        return false;
+// ---------- Helper 1 : receive the authUserId (JWT "sub", checked locally or via /auth/v1/user) ----------
+void fetchAuthUserId(const CallPtr& call,
+                     const Fail& fail,
+                     Then<const std::string&> next) {
+    auto verdict = JwtVerifier::instance().verify(call->env.accessToken);
+    if (verdict.outcome == JwtVerifier::Outcome::Valid) {
+        return next(verdict.claims.sub);
     }
-
-    auto jc = convResp.empty()
-              ? json::array()
-              : json::parse(convResp, nullptr, false);
-    if (jc.is_discarded()) {
-        errOut = makeError(500, "Cannot parse conversation response from Supabase");
-        return false;
+    if (verdict.outcome == JwtVerifier::Outcome::Rejected) {
+        return fail(makeError(401, verdict.error));
     }
 
-    // Supabase may return an array; we take the first object
-    convObj = jc;
-    if (jc.is_array() && !jc.empty()) {
-        convObj = jc[0];
-    }
+    // Remote fallback: no local key for this token
+    std::string meUrl = call->env.base + "/auth/v1/user";
+
+    callSupabase(call, "fetchAuthUserId", "GET", meUrl, [call, fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (/auth/v1/user)"));
+        }
+        if (resp.httpCode != 200) {
+            return fail(upstreamError(resp));
+        }
+
+        fastjson::Value j;
+        const auto id = fastjson::parse(resp.body, j) ? fastjson::member(j, "id") : fastjson::Value{};
+        if (!id.isString()) {
+            return fail(makeError(500, "Cannot extract user id from Supabase response"));
+        }
+
+        const auto authUserId = id.string();
+        JwtVerifier::instance().rememberRemote(call->env.accessToken, authUserId);
+        next(authUserId);
+    });
+}
 
-    if (!convObj.contains("id")) {
-        errOut = makeError(500, "Conversation created but id missing in response");
-        return false;
+// ---------- Helper 2 : receive the profileId (ProfileIdCache, Redis, else the conversation store) ----------
+void fetchProfileId(const CallPtr& call,
+                    const std::string& authUserId,
+                    const Fail& fail,
+                    Then<const std::string&> next) {
+    if (auto cached = ProfileIdCache::instance().get(authUserId)) {
+        return next(*cached);
     }
 
-    return true;
+    cachedStoreRead(call, "fetchProfileId", RedisCache::profileOfAuthUser(authUserId), [call, authUserId](auto cb) {
+        ConversationStore::instance().profileIdByAuthId(call->env, authUserId, std::move(cb));
+    }, [authUserId, fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (profiles)"));
+        }
+        if (resp.httpCode != 200) {
+            return fail(upstreamError(resp));
+        }
+
+        fastjson::Value jp;
+        const auto id = fastjson::parse(resp.body, jp) && jp.isArray()
+                        ? fastjson::member(fastjson::firstRow(jp), "id") : fastjson::Value{};
+        if (!id.isString()) {
+            return fail(makeError(400, "No profile found for the current authenticated user"));
+        }
+
+        const auto profileId = id.string();
+        ProfileIdCache::instance().put(authUserId, profileId);
+        next(profileId);
+    });
+}
+
+// ---------- Helpers 1 + 2 : access token -> caller profileId ----------
+void resolveCallerProfile(const CallPtr& call,
+                          const Fail& fail,
+                          Then<const std::string&> next) {
+    fetchAuthUserId(call, fail, [call, fail, next](const std::string& authUserId) {
+        fetchProfileId(call, authUserId, fail, next);
+    });
 }
 
 std::string makeDirectKey(const std::string& a, const std::string& b) {
@@ -220,11 +334,12 @@ std::string makeDirectKey(const std::string& a, const std::string& b) {
     return b + ":" + a;
 }
 
-bool fetchDirectConversationByKey(const SupabaseEnv& env,
-                                 const std::string& directKey,
-                                 nlohmann::json& outConv,
-                                 ConversationService::Result& errOut) {
-    std::string url = env.base +
+// ---------- Helper 3 : find a live direct conversation by its direct_key ----------
+void fetchDirectConversationByKey(const CallPtr& call,
+                                  const std::string& directKey,
+                                  const Fail& fail,
+                                  Then<std::string> next) {
+    std::string url = call->env.base +
         "/rest/v1/conversations"
         "?select=*"
         "&type=eq.direct"
@@ -232,640 +347,852 @@ bool fetchDirectConversationByKey(const SupabaseEnv& env,
         "&deleted_at=is.null"
         "&limit=1";
 
-    CURL* c = curl_easy_init();
-    if (!c) {
-        errOut = makeError(500, "curl init failed (fetchDirectConversationByKey)");
-        return false;
-    }
-
-    std::string resp;
-    long httpCode = 0;
-    struct curl_slist* h = nullptr;
-    h = curl_slist_append(h, ("apikey: " + env.anonKey).c_str());
-    h = curl_slist_append(h, ("Authorization: Bearer " + env.accessToken).c_str());
-    h = curl_slist_append(h, "Content-Type: application/json");
-
-    curl_easy_setopt(c, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(c, CURLOPT_HTTPHEADER, h);
-    curl_easy_setopt(c, CURLOPT_HTTPGET, 1L);
-    curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(c, CURLOPT_WRITEDATA, &resp);
-
-    auto res = curl_easy_perform(c);
-    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &httpCode);
-    curl_slist_free_all(h);
-    curl_easy_cleanup(c);
-
-    if (res != CURLE_OK) {
-        errOut = makeError(500, "curl perform failed (fetchDirectConversationByKey)");
-        return false;
-    }
+    callSupabase(call, "fetchDirectConversationByKey", "GET", url, [fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (fetchDirectConversationByKey)"));
+        }
 
-    if (httpCode != 200) {
-        ConversationService::Result r;
-        r.statusCode = static_cast<int>(httpCode);
-        r.body = resp.empty() ? nlohmann::json::object() : nlohmann::json::parse(resp, nullptr, false);
-        if (r.body.is_discarded()) r.body = nlohmann::json::object();
-        errOut = r;
-        return false;
-    }
+        if (resp.httpCode != 200) {
+            return fail(upstreamError(resp));
+        }
 
-    auto j = nlohmann::json::parse(resp, nullptr, false);
-    if (j.is_discarded()) {
-        errOut = makeError(500, "Cannot parse direct conversation search response");
-        return false;
-    }
+        fastjson::Value j;
+        if (!fastjson::parse(resp.body, j)) {
+            return fail(makeError(500, "Cannot parse direct conversation search response"));
+        }
 
-    if (j.is_array() && !j.empty()) {
-        outConv = j[0];
-        return true;
-    }
+        const auto row = j.isArray() ? fastjson::firstRow(j) : fastjson::Value{};
+        if (row.isObject()) {
+            return next(std::string(row.raw));
+        }
 
-    outConv = nlohmann::json::object();
-    return true; // no error, just not found
+        next(std::string()); // no error, just not found
+    });
 }
 
-bool createConversationRowWithDirectKey(const SupabaseEnv& env,
-                                       const std::string& type,
-                                       const std::optional<std::string>& name,
-                                       const std::string& profileId,
-                                       const std::optional<std::string>& directKey,
-                                       nlohmann::json& convObj,
-                                       long& convHttpCode,
-                                       ConversationService::Result& errOut) {
-    std::string convUrl = env.base + "/rest/v1/conversations";
+// A row written by PostgREST, kept as received
+struct WrittenRow {
+    std::string row;
+    std::string id;
+};
 
-    nlohmann::json convPayload;
+// ---------- Helper 4 : create the conversation via /rest/v1/conversations ----------
+void createConversationRowWithDirectKey(const CallPtr& call,
+                                        const std::string& type,
+                                        const std::optional<std::string>& name,
+                                        const std::string& profileId,
+                                        const std::optional<std::string>& directKey,
+                                        const Fail& fail,
+                                        Then<const WrittenRow&> next) {
+    std::string convUrl = call->env.base + "/rest/v1/conversations";
+
+    std::string convPayload;
+    fastjson::Writer w(convPayload);
+    w.beginObject();
     if (name.has_value() && !name->empty()) {
-        convPayload["name"] = *name;
+        w.field("name", *name);
     }
     if (directKey.has_value() && !directKey->empty()) {
-        convPayload["direct_key"] = *directKey;
-    }
-    convPayload["type"]       = type;
-    convPayload["created_by"] = profileId;
-
-    const std::string convBody = convPayload.dump();
-
-    CURL* cConv = curl_easy_init();
-    if (!cConv) {
-        errOut = makeError(500, "curl init failed (conversations)");
-        return false;
+        w.field("direct_key", *directKey);
     }
+    w.field("type", type).field("created_by", profileId).endObject();
 
-    std::string convResp;
-    struct curl_slist* hConv = nullptr;
-    hConv = curl_slist_append(hConv, ("apikey: " + env.anonKey).c_str());
-    hConv = curl_slist_append(hConv, ("Authorization: Bearer " + env.accessToken).c_str());
-    hConv = curl_slist_append(hConv, "Content-Type: application/json");
-    hConv = curl_slist_append(hConv, "Prefer: return=representation");
-
-    curl_easy_setopt(cConv, CURLOPT_URL, convUrl.c_str());
-    curl_easy_setopt(cConv, CURLOPT_HTTPHEADER, hConv);
-    curl_easy_setopt(cConv, CURLOPT_POST, 1L);
-    curl_easy_setopt(cConv, CURLOPT_POSTFIELDS, convBody.c_str());
-    curl_easy_setopt(cConv, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(cConv, CURLOPT_WRITEDATA, &convResp);
-
-    auto resConv = curl_easy_perform(cConv);
-    curl_easy_getinfo(cConv, CURLINFO_RESPONSE_CODE, &convHttpCode);
-    curl_slist_free_all(hConv);
-    curl_easy_cleanup(cConv);
-
-    if (resConv != CURLE_OK) {
-        errOut = makeError(500, "curl perform failed (create conversation)");
-        return false;
-    }
-
-    auto jc = convResp.empty()
-              ? nlohmann::json::array()
-              : nlohmann::json::parse(convResp, nullptr, false);
-    if (jc.is_discarded()) {
-        errOut = makeError(500, "Cannot parse conversation response from Supabase");
-        return false;
-    }
+    callSupabase(call, "createConversationRowWithDirectKey", "POST", convUrl, convPayload, [fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (create conversation)"));
+        }
 
-    convObj = jc;
-    if (jc.is_array() && !jc.empty()) {
-        convObj = jc[0];
-    }
+        fastjson::Value jc;
+        if (!resp.body.empty() && !fastjson::parse(resp.body, jc)) {
+            return fail(makeError(500, "Cannot parse conversation response from Supabase"));
+        }
 
-    if (!convObj.contains("id")) {
-        errOut = makeError(500, "Conversation created but id missing in response");
-        return false;
-    }
+        // Supabase may return an array; we take the first object
+        const auto convObj = fastjson::firstRow(jc);
+        const auto id = fastjson::member(convObj, "id");
+        if (!id.isString()) {
+            return fail(makeError(500, "Conversation created but id missing in response"));
+        }
 
-    return true;
+        next(WrittenRow{std::string(convObj.raw), id.string()});
+    });
 }
 
-bool fetchOtherParticipantId(const SupabaseEnv& env,
+void fetchOtherParticipantId(const CallPtr& call,
                              const std::string& conversationId,
                              const std::string& callerProfileId,
-                             std::string& outOtherProfileId,
-                             ConversationService::Result& errOut) {
-    std::string url = env.base +
-        "/rest/v1/conversation_members"
-        "?select=user_id"
-        "&conversation_id=eq." + conversationId +
-        "&left_at=is.null"
-        "&user_id=neq." + callerProfileId +
-        "&limit=1";
-
-    CURL* c = curl_easy_init();
-    if (!c) {
-        errOut = makeError(500, "curl init failed (fetchOtherParticipantId)");
-        return false;
-    }
-
-    std::string resp;
-    long httpCode = 0;
-    struct curl_slist* h = nullptr;
-    h = curl_slist_append(h, ("apikey: " + env.anonKey).c_str());
-    h = curl_slist_append(h, ("Authorization: Bearer " + env.accessToken).c_str());
-    h = curl_slist_append(h, "Content-Type: application/json");
+                             const Fail& fail,
+                             Then<const std::string&> next) {
+    callUpstream(call, "fetchOtherParticipantId", [&](auto cb) {
+        ConversationStore::instance().otherMembers(call->env, {conversationId}, callerProfileId, std::move(cb));
+    }, [fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (fetchOtherParticipantId)"));
+        }
 
-    curl_easy_setopt(c, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(c, CURLOPT_HTTPHEADER, h);
-    curl_easy_setopt(c, CURLOPT_HTTPGET, 1L);
-    curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(c, CURLOPT_WRITEDATA, &resp);
+        if (resp.httpCode != 200) {
+            return fail(upstreamError(resp));
+        }
 
-    auto res = curl_easy_perform(c);
-    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &httpCode);
-    curl_slist_free_all(h);
-    curl_easy_cleanup(c);
+        fastjson::Value j;
+        const auto userId = fastjson::parse(resp.body, j) && j.isArray()
+                            ? fastjson::member(fastjson::firstRow(j), "user_id") : fastjson::Value{};
+        if (!userId.isString()) {
+            return fail(makeError(404, "Direct conversation other participant not found"));
+        }
 
-    if (res != CURLE_OK) {
-        errOut = makeError(500, "curl perform failed (fetchOtherParticipantId)");
-        return false;
-    }
+        next(userId.string());
+    });
+}
 
-    if (httpCode != 200) {
-        ConversationService::Result r;
-        r.statusCode = static_cast<int>(httpCode);
-        r.body = resp.empty() ? nlohmann::json::object() : nlohmann::json::parse(resp, nullptr, false);
-        if (r.body.is_discarded()) r.body = nlohmann::json::object();
-        errOut = r;
-        return false;
-    }
+// "First Last" from a profiles row (fallback "Utilisateur")
+std::string formatDisplayName(const fastjson::Value& p) {
+    std::string firstScratch, lastScratch;
+    const auto first = fastjson::member(p, "first_name").str(firstScratch);
+    const auto last  = fastjson::member(p, "last_name").str(lastScratch);
 
-    auto j = nlohmann::json::parse(resp, nullptr, false);
-    if (j.is_discarded() || !j.is_array() || j.empty() || !j[0].contains("user_id")) {
-        errOut = makeError(404, "Direct conversation other participant not found");
-        return false;
+    if (!first.empty() && !last.empty()) {
+        std::string out;
+        out.reserve(first.size() + 1 + last.size());
+        return out.append(first).append(" ").append(last);
     }
-
-    outOtherProfileId = j[0]["user_id"].get<std::string>();
-    return true;
+    if (!first.empty()) return std::string(first);
+    if (!last.empty()) return std::string(last);
+    return "Utilisateur";
 }
 
-bool fetchProfileDisplayName(const SupabaseEnv& env,
+void fetchProfileDisplayName(const CallPtr& call,
                              const std::string& profileId,
-                             std::string& outName,
-                             ConversationService::Result& errOut) {
-    std::string url = env.base +
-        "/rest/v1/profiles?select=first_name,last_name&id=eq." + profileId + "&limit=1";
-
-    CURL* c = curl_easy_init();
-    if (!c) {
-        errOut = makeError(500, "curl init failed (fetchProfileDisplayName)");
-        return false;
-    }
+                             const Fail& fail,
+                             Then<const std::string&> next) {
+    cachedStoreRead(call, "fetchProfileDisplayName", RedisCache::profileNames(profileId), [call, profileId](auto cb) {
+        ConversationStore::instance().profileNames(call->env, {profileId}, std::move(cb));
+    }, [fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (fetchProfileDisplayName)"));
+        }
 
-    std::string resp;
-    long httpCode = 0;
-    struct curl_slist* h = nullptr;
-    h = curl_slist_append(h, ("apikey: " + env.anonKey).c_str());
-    h = curl_slist_append(h, ("Authorization: Bearer " + env.accessToken).c_str());
-    h = curl_slist_append(h, "Content-Type: application/json");
+        if (resp.httpCode != 200) {
+            return fail(upstreamError(resp));
+        }
 
-    curl_easy_setopt(c, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(c, CURLOPT_HTTPHEADER, h);
-    curl_easy_setopt(c, CURLOPT_HTTPGET, 1L);
-    curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(c, CURLOPT_WRITEDATA, &resp);
+        fastjson::Value j;
+        const auto row = fastjson::parse(resp.body, j) && j.isArray() ? fastjson::firstRow(j) : fastjson::Value{};
+        if (!row.valid()) {
+            return fail(makeError(404, "Profile not found for display name"));
+        }
 
-    auto res = curl_easy_perform(c);
-    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &httpCode);
-    curl_slist_free_all(h);
-    curl_easy_cleanup(c);
+        next(formatDisplayName(row));
+    });
+}
 
-    if (res != CURLE_OK) {
-        errOut = makeError(500, "curl perform failed (fetchProfileDisplayName)");
-        return false;
-    }
+// ---------- Helper 4a : conversation rows (ConversationRows.h), written back ----------
+using PagePtr = std::shared_ptr<ConversationPage>;
 
-    if (httpCode != 200) {
-        ConversationService::Result r;
-        r.statusCode = static_cast<int>(httpCode);
-        r.body = resp.empty() ? nlohmann::json::object() : nlohmann::json::parse(resp, nullptr, false);
-        if (r.body.is_discarded()) r.body = nlohmann::json::object();
-        errOut = r;
-        return false;
-    }
+// Group conversations: display_name = name (fallback "Groupe")
+void setGroupDisplayName(ConversationRow& r) {
+    if (r.hasDisplayName) return;
+    r.displayName = r.name.empty() ? std::string("Groupe") : std::string(r.name);
+}
 
-    auto j = nlohmann::json::parse(resp, nullptr, false);
-    if (j.is_discarded() || !j.is_array() || j.empty()) {
-        errOut = makeError(404, "Profile not found for display name");
-        return false;
+// The row as received, plus display_name / other_user_id when they were set
+void writeConversationRow(fastjson::Writer& w, const ConversationRow& r) {
+    if (!r.displayName) {
+        w.raw(r.row.raw);
+        return;
     }
 
-    const auto& p = j[0];
-    std::string first = p.contains("first_name") && p["first_name"].is_string() ? p["first_name"].get<std::string>() : "";
-    std::string last  = p.contains("last_name") && p["last_name"].is_string() ? p["last_name"].get<std::string>() : "";
-
-    if (!first.empty() && !last.empty()) outName = first + " " + last;
-    else if (!first.empty()) outName = first;
-    else if (!last.empty()) outName = last;
-    else outName = "Utilisateur";
+    w.beginObject();
+    fastjson::forEachMember(r.row, [&](std::string_view key, const fastjson::Value& v) {
+        w.rawKey(key);
+        if (key != "conversation") {
+            w.raw(v.raw);
+            return;
+        }
+        w.beginObject();
+        fastjson::forEachMember(r.conversation, [&](std::string_view k, const fastjson::Value& cv) {
+            if (k == "display_name" || (!r.otherUserId.isNil() && k == "other_user_id")) return;
+            w.rawKey(k).raw(cv.raw);
+        });
+        w.field("display_name", *r.displayName);
+        if (!r.otherUserId.isNil()) w.field("other_user_id", r.otherUserId.str());
+        w.endObject();
+    });
+    w.endObject();
+}
 
-    return true;
+std::string writeConversationRows(const ConversationPage& page) {
+    std::string out;
+    out.reserve(page.body.size() + 64 * page.rows.size());
+    fastjson::Writer w(out);
+    w.beginArray();
+    for (const auto& r : page.rows) writeConversationRow(w, r);
+    w.endArray();
+    return out;
 }
 
-void enrichDisplayNameIfDirect(const SupabaseEnv& env,
+// Never fails: when a lookup fails the row is handed back unchanged
+void enrichDisplayNameIfDirect(const CallPtr& call,
                                const std::string& callerProfileId,
-                               nlohmann::json& membershipRow,
-                               ConversationService::Result& errOut) {
-    if (!membershipRow.is_object() || !membershipRow.contains("conversation")) return;
-    auto& conv = membershipRow["conversation"];
-    if (!conv.is_object() || !conv.contains("type") || !conv["type"].is_string()) return;
-
-    const std::string type = conv["type"].get<std::string>();
-    if (type != "direct") {
-        // Pour group, si tu veux unifier : display_name = name (fallback)
-        if (!conv.contains("display_name")) {
-            if (conv.contains("name") && conv["name"].is_string() && !conv["name"].get<std::string>().empty())
-                conv["display_name"] = conv["name"].get<std::string>();
-            else
-                conv["display_name"] = "Groupe";
-        }
-        return;
-    }
-
-    if (!conv.contains("id") || !conv["id"].is_string()) return;
-    const std::string conversationId = conv["id"].get<std::string>();
-
-    std::string otherId;
-    if (!fetchOtherParticipantId(env, conversationId, callerProfileId, otherId, errOut)) {
-        return; // errOut déjà rempli si nécessaire
-    }
+                               const PagePtr& page,
+                               Then<> next) {
+    auto& r = page->rows.front();
+    if (!r.conversation.isObject() || r.type == ConversationType::None) return next();
+
+    if (r.type != ConversationType::Direct) {
+        setGroupDisplayName(r);
+        return next();
+    }
+
+    if (r.id.isNil()) return next();
+    const std::string conversationId = r.id.str();
+
+    const Fail keepRow = [next](const ConversationService::Result&) { next(); };
+
+    fetchOtherParticipantId(call, conversationId, callerProfileId, keepRow,
+        [call, page, next, keepRow](const std::string& otherId) {
+            fetchProfileDisplayName(call, otherId, keepRow, [page, next, otherId](const std::string& display) {
+                auto& row = page->rows.front();
+                row.displayName = display;
+                Uuid::parse(otherId, row.otherUserId);
+                next();
+            });
+        });
+}
 
-    std::string display;
-    if (!fetchProfileDisplayName(env, otherId, display, errOut)) {
-        return;
-    }
+// ---------- Helper 4b : display_name of every row of a conversations list ----------
+// Two batched lookups whatever the number of direct conversations: the other
+// participants of all of them, then all their profiles.
+// The joins run over sorted vectors of 16-byte ids.
+// Never fails: rows that cannot be enriched are kept as-is.
+void enrichAllDisplayNames(const CallPtr& call,
+                           const std::string& callerProfileId,
+                           const PagePtr& page,
+                           Then<> next) {
+    // (conversation id, row index) of the direct conversations, sorted by id
+    using DirectRows = std::vector<std::pair<Uuid, size_t>>;
+    auto directRows = std::make_shared<DirectRows>();
+
+    for (size_t i = 0; i < page->rows.size(); ++i) {
+        auto& r = page->rows[i];
+        if (!r.conversation.isObject() || r.type == ConversationType::None) continue;
+
+        if (r.type != ConversationType::Direct) {
+            setGroupDisplayName(r);
+            continue;
+        }
+        if (!r.id.isNil()) directRows->emplace_back(r.id, i);
+    }
+
+    if (directRows->empty()) return next();
+    std::sort(directRows->begin(), directRows->end());
+
+    std::vector<std::string> directIds;
+    for (size_t i = 0; i < directRows->size(); ++i) {
+        if (i == 0 || (*directRows)[i].first != (*directRows)[i - 1].first) {
+            directIds.push_back((*directRows)[i].first.str());
+        }
+    }
+
+    // 1) other participant of every direct conversation
+    callUpstream(call, "enrichAllDisplayNames", [&](auto cb) {
+        ConversationStore::instance().otherMembers(call->env, directIds, callerProfileId, std::move(cb));
+    }, [call, page, directRows, next](const SupabaseClient::Response& resp) {
+        std::vector<MemberRow> members;
+        if (!resp.ok || resp.httpCode != 200 || !readMemberRows(resp.body, members)) return next();
+
+        // First other participant of each conversation, on all its rows
+        std::vector<Uuid> otherIds;
+        for (const auto& m : members) {
+            if (m.conversationId.isNil() || m.userId.isNil()) continue;
+            auto it = std::lower_bound(directRows->begin(), directRows->end(),
+                                       std::make_pair(m.conversationId, size_t{0}));
+            if (it == directRows->end() || it->first != m.conversationId) continue;
+            if (!page->rows[it->second].otherUserId.isNil()) continue;
+
+            for (; it != directRows->end() && it->first == m.conversationId; ++it) {
+                page->rows[it->second].otherUserId = m.userId;
+            }
+            otherIds.push_back(m.userId);
+        }
+        std::sort(otherIds.begin(), otherIds.end());
+        otherIds.erase(std::unique(otherIds.begin(), otherIds.end()), otherIds.end());
+
+        std::vector<std::string> otherIdTexts;
+        otherIdTexts.reserve(otherIds.size());
+        for (const auto& id : otherIds) otherIdTexts.push_back(id.str());
+
+        // 2) their profiles, then join in memory
+        callUpstream(call, "enrichAllDisplayNames", [&](auto cb) {
+            ConversationStore::instance().profileNames(call->env, otherIdTexts, std::move(cb));
+        }, [page, directRows, next](const SupabaseClient::Response& profiles) {
+            fastjson::Value rows;
+            if (!profiles.ok || profiles.httpCode != 200 ||
+                !fastjson::parse(profiles.body, rows) || !rows.isArray()) {
+                return next();
+            }
 
-    conv["display_name"] = display;
-    conv["other_user_id"] = otherId;
+            std::vector<std::pair<Uuid, std::string>> names;
+            fastjson::forEachElement(rows, [&](const fastjson::Value& p) {
+                Uuid id;
+                std::string scratch;
+                if (Uuid::parse(fastjson::member(p, "id").str(scratch), id)) {
+                    names.emplace_back(id, formatDisplayName(p));
+                }
+            });
+            std::stable_sort(names.begin(), names.end(),
+                             [](const auto& a, const auto& b) { return a.first < b.first; });
+
+            for (const auto& [convId, i] : *directRows) {
+                auto& r = page->rows[i];
+                if (r.otherUserId.isNil()) continue;
+                auto name = std::lower_bound(names.begin(), names.end(), r.otherUserId,
+                    [](const auto& entry, const Uuid& id) { return entry.first < id; });
+                if (name == names.end() || name->first != r.otherUserId) {
+                    r.otherUserId = Uuid{};   // not enriched: the row stays as received
+                    continue;
+                }
+                r.displayName = name->second;
+            }
+            next();
+        });
+    });
 }
 
-// ---------- Helper 4a : insert a member into conversation_members ----------
-bool insertMemberWithRole(const SupabaseEnv& env,
+// ---------- Helper 5a : insert a member into conversation_members ----------
+void insertMemberWithRole(const CallPtr& call,
                           const std::string& conversationId,
                           const std::string& profileId,
                           const std::string& role,
-                          nlohmann::json* outRow,
-                          ConversationService::Result& errOut) {
-    std::string memberUrl = env.base + "/rest/v1/conversation_members";
-
-    json memberPayload;
-    memberPayload["conversation_id"] = conversationId;
-    memberPayload["user_id"]         = profileId;
-    memberPayload["role"]            = role;
-
-    const std::string memberBody = memberPayload.dump();
-
-    CURL* cMem = curl_easy_init();
-    if (!cMem) {
-        errOut = makeError(500, "curl init failed (conversation_members)");
-        return false;
-    }
-
-    std::string memResp;
-    long memCode = 0;
-    struct curl_slist* hMem = nullptr;
-    hMem = curl_slist_append(hMem, ("apikey: " + env.anonKey).c_str());
-    hMem = curl_slist_append(hMem, ("Authorization: Bearer " + env.accessToken).c_str());
-    hMem = curl_slist_append(hMem, "Content-Type: application/json");
-    hMem = curl_slist_append(hMem, "Prefer: return=representation");
-
-    curl_easy_setopt(cMem, CURLOPT_URL, memberUrl.c_str());
-    curl_easy_setopt(cMem, CURLOPT_HTTPHEADER, hMem);
-    curl_easy_setopt(cMem, CURLOPT_POST, 1L);
-    curl_easy_setopt(cMem, CURLOPT_POSTFIELDS, memberBody.c_str());
-    curl_easy_setopt(cMem, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(cMem, CURLOPT_WRITEDATA, &memResp);
-
-    auto resMem = curl_easy_perform(cMem);
-    curl_easy_getinfo(cMem, CURLINFO_RESPONSE_CODE, &memCode);
-    curl_slist_free_all(hMem);
-    curl_easy_cleanup(cMem);
-
-    if (resMem != CURLE_OK) {
-        errOut = makeError(500, "curl perform failed (conversation_members)");
-        return false;
-    }
-
-    if (memCode != 200 && memCode != 201) {
-        ConversationService::Result r;
-        r.statusCode = static_cast<int>(memCode);
-        r.body = memResp.empty() ? json::object() : json::parse(memResp, nullptr, false);
-        if (r.body.is_discarded()) r.body = json::object();
-        errOut = r;
-        return false;
-    }
-
-    if (outRow) {
-        if (!memResp.empty()) {
-            auto j = json::parse(memResp, nullptr, false);
-            if (!j.is_discarded()) {
-                *outRow = j;
-                if (j.is_array() && !j.empty()) {
-                    *outRow = j[0];
-                }
-            } else {
-                *outRow = json::object();
-            }
-        } else {
-            *outRow = json::object();
+                          const Fail& fail,
+                          Then<std::string> next) {
+    std::string memberUrl = call->env.base + "/rest/v1/conversation_members";
+
+    std::string memberPayload;
+    fastjson::Writer(memberPayload)
+        .beginObject()
+        .field("conversation_id", conversationId)
+        .field("user_id", profileId)
+        .field("role", role)
+        .endObject();
+
+    callSupabase(call, "insertMemberWithRole", "POST", memberUrl, memberPayload, [fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (conversation_members)"));
         }
-    }
 
-    return true;
+        if (resp.httpCode != 200 && resp.httpCode != 201) {
+            return fail(upstreamError(resp));
+        }
+
+        fastjson::Value j;
+        if (!resp.body.empty()) fastjson::parse(resp.body, j);
+        next(writtenRow(j));
+    });
 }
 
-// ---------- Helper 4b : insert the creator as owner ----------
-bool insertOwnerMember(const SupabaseEnv& env,
+// ---------- Helper 5b : insert the creator as owner ----------
+void insertOwnerMember(const CallPtr& call,
                        const std::string& conversationId,
                        const std::string& profileId,
-                       ConversationService::Result& errOut) {
-    nlohmann::json dummy;
-    return insertMemberWithRole(env, conversationId, profileId, "owner", &dummy, errOut);
+                       const Fail& fail,
+                       Then<> next) {
+    insertMemberWithRole(call, conversationId, profileId, "owner", fail,
+                         [next](const std::string&) { next(); });
 }
 
-// ---------- Helper 5: List all conversations of a profile ----------
-bool fetchMyConversations(const SupabaseEnv& env,
-                          const std::string& profileId,
-                          nlohmann::json& out,
-                          ConversationService::Result& errOut) {
-    std::string url = env.base +
-        "/rest/v1/conversation_members"
-    "?select=conversation:conversations!inner(*),role,joined_at,left_at"
-        "&user_id=eq." + profileId +
-        "&left_at=is.null"
-        "&conversation.deleted_at=is.null";
+// ---------- Helper 5c : direct conversation + both members in one transaction ----------
+// POST /rest/v1/rpc/create_direct_conversation (sql/001_create_direct_conversation.sql).
+// Replaces ensureProfileExists + fetchDirectConversationByKey +
+// createConversationRowWithDirectKey + 2 x insertMemberWithRole.
+// next(row, created): created is false when the conversation already existed.
+bool createDirectViaRpc() {
+    static const bool enabled = [] {
+        const char* flag = std::getenv("CONVERSATION_CREATE_RPC");
+        if (!flag) return false;
+        const std::string v(flag);
+        return v == "1" || v == "true" || v == "on";
+    }();
+    return enabled;
+}
 
-    CURL* c = curl_easy_init();
-    if (!c) {
-        errOut = makeError(500, "curl init failed (list conversations)");
-        return false;
-    }
+void createDirectConversationRpc(const CallPtr& call,
+                                 const std::string& callerProfileId,
+                                 const std::string& targetProfileId,
+                                 const Fail& fail,
+                                 Then<const WrittenRow&, bool> next) {
+    std::string url = call->env.base + "/rest/v1/rpc/create_direct_conversation";
 
-    std::string resp;
-    long httpCode = 0;
-    struct curl_slist* h = nullptr;
-    h = curl_slist_append(h, ("apikey: " + env.anonKey).c_str());
-    h = curl_slist_append(h, ("Authorization: Bearer " + env.accessToken).c_str());
-    h = curl_slist_append(h, "Content-Type: application/json");
+    std::string payload;
+    fastjson::Writer(payload)
+        .beginObject()
+        .field("p_caller", callerProfileId)
+        .field("p_target", targetProfileId)
+        .endObject();
 
-    curl_easy_setopt(c, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(c, CURLOPT_HTTPHEADER, h);
-    curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(c, CURLOPT_WRITEDATA, &resp);
+    callSupabase(call, "createDirectConversationRpc", "POST", url, payload, [fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (create_direct_conversation)"));
+        }
 
-    auto res = curl_easy_perform(c);
-    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &httpCode);
-    curl_slist_free_all(h);
-    curl_easy_cleanup(c);
+        if (resp.httpCode != 200) {
+            return fail(upstreamError(resp));
+        }
 
-    if (res != CURLE_OK) {
-        errOut = makeError(500, "curl perform failed (list conversations)");
-        return false;
-    }
+        fastjson::Value j;
+        if (!fastjson::parse(resp.body, j) || !j.isObject()) {
+            return fail(makeError(500, "Cannot parse create_direct_conversation response"));
+        }
+
+        const auto conv = fastjson::member(j, "conversation");
+        if (conv.isNull()) {
+            return fail(makeError(404, "Target profile not found"));
+        }
+
+        const auto id = fastjson::member(conv, "id");
+        bool created = false;
+        if (!id.isString() || !fastjson::member(j, "created").asBool(created)) {
+            return fail(makeError(500, "Cannot parse create_direct_conversation response"));
+        }
+
+        next(WrittenRow{std::string(conv.raw), id.string()}, created);
+    });
+}
+
+// ---------- Helper 5d : several members in one insert (members:batch, group creation) ----------
+// The profiles and the active memberships of all the ids are read with one
+// in.(...) query each, in parallel, then every new member goes in with one
+// bulk POST. Each id gets its own outcome instead of failing the batch.
+constexpr std::size_t kMaxBatchMembers = 100;   // a single request per lookup
 
-    if (httpCode != 200) {
-        ConversationService::Result r;
-        r.statusCode = static_cast<int>(httpCode);
-        r.body = resp.empty() ? nlohmann::json::object() : nlohmann::json::parse(resp, nullptr, false);
-        if (r.body.is_discarded()) r.body = nlohmann::json::object();
-        errOut = r;
-        return false;
+enum class BatchOutcome { Pending, Added, InvalidId, NotFound, AlreadyMember };
+
+struct BatchEntry {
+    std::string userId;     // as sent
+    Uuid id;
+    BatchOutcome outcome = BatchOutcome::Pending;
+    std::string row;        // the inserted conversation_members row (Added)
+};
+using MemberBatch = std::shared_ptr<std::vector<BatchEntry>>;
+
+const char* batchOutcomeName(BatchOutcome outcome) {
+    switch (outcome) {
+        case BatchOutcome::Added:         return "added";
+        case BatchOutcome::InvalidId:     return "invalid_id";
+        case BatchOutcome::NotFound:      return "not_found";
+        case BatchOutcome::AlreadyMember: return "already_member";
+        default:                          return "pending";
     }
+}
 
-    auto j = nlohmann::json::parse(resp, nullptr, false);
-    if (j.is_discarded()) {
-        errOut = makeError(500, "Cannot parse conversations list from Supabase");
-        return false;
+// Unique ids, in request order; the ones that are not UUIDs are settled at once
+MemberBatch makeMemberBatch(const std::vector<std::string>& userIds) {
+    auto batch = std::make_shared<std::vector<BatchEntry>>();
+    batch->reserve(userIds.size());
+    for (const auto& userId : userIds) {
+        BatchEntry e;
+        e.userId = userId;
+        if (!Uuid::parse(userId, e.id)) e.outcome = BatchOutcome::InvalidId;
+
+        const bool duplicate = std::any_of(batch->begin(), batch->end(), [&e](const BatchEntry& other) {
+            return e.outcome == BatchOutcome::InvalidId ? other.userId == e.userId
+                                                        : other.outcome != BatchOutcome::InvalidId && other.id == e.id;
+        });
+        if (!duplicate) batch->push_back(std::move(e));
+    }
+    return batch;
+}
+
+std::vector<std::string> pendingIds(const std::vector<BatchEntry>& batch) {
+    std::vector<std::string> ids;
+    for (const auto& e : batch) {
+        if (e.outcome == BatchOutcome::Pending) ids.push_back(e.id.str());
     }
+    return ids;
+}
 
-    out = j;
-    return true;
+// Settles not_found / already_member; conversationId is empty for a
+// conversation being created (no memberships to look up yet)
+void settleMemberBatch(const CallPtr& call,
+                       const std::string& conversationId,
+                       const MemberBatch& batch,
+                       const Fail& fail,
+                       Then<> next) {
+    const auto ids = pendingIds(*batch);
+    if (ids.empty()) return next();
+
+    struct Join {
+        int pending = 0;
+        bool failed = false;
+        std::vector<Uuid> profiles;
+        std::vector<Uuid> members;
+    };
+    auto join = std::make_shared<Join>();
+    join->pending = conversationId.empty() ? 1 : 2;
+
+    const Fail failOnce = [join, fail](ConversationService::Result r) {
+        if (join->failed) return;
+        join->failed = true;
+        fail(std::move(r));
+    };
+    // Ids of one lookup answer, sorted
+    const auto collect = [join, failOnce](const SupabaseClient::Response& resp,
+                                          const char* column,
+                                          std::vector<Uuid>& out) {
+        if (join->failed) return false;
+
+        fastjson::Value rows;
+        if (!resp.ok || resp.httpCode != 200 || !fastjson::parse(resp.body, rows) || !rows.isArray()) {
+            failOnce(resp.ok ? upstreamError(resp) : makeError(500, "curl perform failed (settleMemberBatch)"));
+            return false;
+        }
+
+        std::string scratch;
+        fastjson::forEachElement(rows, [&](const fastjson::Value& row) {
+            Uuid id;
+            if (Uuid::parse(fastjson::member(row, column).str(scratch), id)) out.push_back(id);
+        });
+        std::sort(out.begin(), out.end());
+        return true;
+    };
+    const auto joined = [join, batch, next]() {
+        if (--join->pending > 0) return;
+        for (auto& e : *batch) {
+            if (e.outcome != BatchOutcome::Pending) continue;
+            if (!std::binary_search(join->profiles.begin(), join->profiles.end(), e.id)) {
+                e.outcome = BatchOutcome::NotFound;
+            } else if (std::binary_search(join->members.begin(), join->members.end(), e.id)) {
+                e.outcome = BatchOutcome::AlreadyMember;
+            }
+        }
+        next();
+    };
+
+    callUpstream(call, "settleMemberBatch", [&](auto cb) {
+        ConversationStore::instance().profileNames(call->env, ids, std::move(cb));
+    }, [join, collect, joined](const SupabaseClient::Response& resp) {
+        if (collect(resp, "id", join->profiles)) joined();
+    });
+
+    if (conversationId.empty()) return;
+
+    callUpstream(call, "settleMemberBatch", [&](auto cb) {
+        ConversationStore::instance().membersAmong(call->env, conversationId, ids, std::move(cb));
+    }, [join, collect, joined](const SupabaseClient::Response& resp) {
+        if (collect(resp, "user_id", join->members)) joined();
+    });
 }
 
-// ---------- Helper 6: Get conversation by ID ----------
-bool fetchConversationById(const SupabaseEnv& env,
-                           const std::string& profileId,
-                           const std::string& conversationId,
-                           nlohmann::json& out,
-                           ConversationService::Result& errOut) {
-    std::string url = env.base +
-        "/rest/v1/conversation_members"
-    "?select=conversation:conversations!inner(*),role,joined_at,left_at"
-        "&user_id=eq." + profileId +
-        "&conversation_id=eq." + conversationId +
-        "&left_at=is.null"
-        "&conversation.deleted_at=is.null";
+// One POST for the owner (when ownerId is set) and every pending entry,
+// which become Added with their row
+void insertMemberBatch(const CallPtr& call,
+                       const std::string& conversationId,
+                       const MemberBatch& batch,
+                       const std::string& ownerId,
+                       const Fail& fail,
+                       Then<> next) {
+    std::string payload;
+    fastjson::Writer w(payload);
+    std::size_t rows = 0;
+    const auto member = [&](const std::string& profileId, const char* role) {
+        w.beginObject()
+            .field("conversation_id", conversationId)
+            .field("user_id", profileId)
+            .field("role", role)
+            .endObject();
+        ++rows;
+    };
+
+    w.beginArray();
+    if (!ownerId.empty()) member(ownerId, "owner");
+    for (const auto& e : *batch) {
+        if (e.outcome == BatchOutcome::Pending) member(e.id.str(), "member");
+    }
+    w.endArray();
+
+    if (rows == 0) return next();
+
+    callSupabase(call, "insertMemberBatch", "POST", call->env.base + "/rest/v1/conversation_members", payload,
+        [batch, fail, next](const SupabaseClient::Response& resp) {
+            if (!resp.ok) {
+                return fail(makeError(500, "curl perform failed (conversation_members batch)"));
+            }
 
-    CURL* c = curl_easy_init();
-    if (!c) {
-        errOut = makeError(500, "curl init failed (get conversation)");
-        return false;
-    }
+            if (resp.httpCode != 200 && resp.httpCode != 201) {
+                return fail(upstreamError(resp));
+            }
 
-    std::string resp;
-    long httpCode = 0;
-    struct curl_slist* h = nullptr;
-    h = curl_slist_append(h, ("apikey: " + env.anonKey).c_str());
-    h = curl_slist_append(h, ("Authorization: Bearer " + env.accessToken).c_str());
-    h = curl_slist_append(h, "Content-Type: application/json");
+            std::vector<MemberRow> inserted;
+            readMemberRows(resp.body, inserted);
+            for (auto& e : *batch) {
+                if (e.outcome != BatchOutcome::Pending) continue;
+                e.outcome = BatchOutcome::Added;
+                const auto row = std::find_if(inserted.begin(), inserted.end(),
+                    [&e](const MemberRow& m) { return m.userId == e.id; });
+                if (row != inserted.end()) e.row = std::string(row->raw);
+            }
+            next();
+        });
+}
 
-    curl_easy_setopt(c, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(c, CURLOPT_HTTPHEADER, h);
-    curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(c, CURLOPT_WRITEDATA, &resp);
+// [{"user_id": ..., "status": ..., "member": row}, ...]
+void writeMemberBatch(fastjson::Writer& w, const std::vector<BatchEntry>& batch) {
+    w.beginArray();
+    for (const auto& e : batch) {
+        w.beginObject()
+            .field("user_id", e.userId)
+            .field("status", batchOutcomeName(e.outcome));
+        if (!e.row.empty()) w.key("member").raw(e.row);
+        w.endObject();
+    }
+    w.endArray();
+}
 
-    auto res = curl_easy_perform(c);
-    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &httpCode);
-    curl_slist_free_all(h);
-    curl_easy_cleanup(c);
+// ---------- Helper 6a: page cursors ("updated_at\nid", base64url) ----------
+struct Keyset {
+    std::string updatedAt;
+    std::string id;
+};
 
-    if (res != CURLE_OK) {
-        errOut = makeError(500, "curl perform failed (get conversation)");
-        return false;
-    }
+const char* const kBase64Url = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
 
-    if (httpCode != 200) {
-        ConversationService::Result r;
-        r.statusCode = static_cast<int>(httpCode);
-        r.body = resp.empty() ? nlohmann::json::object() : nlohmann::json::parse(resp, nullptr, false);
-        if (r.body.is_discarded()) r.body = nlohmann::json::object();
-        errOut = r;
-        return false;
+std::string base64UrlEncode(const std::string& in) {
+    std::string out;
+    unsigned int buffer = 0;
+    int bits = 0;
+    for (unsigned char c : in) {
+        buffer = (buffer << 8) | c;
+        bits += 8;
+        while (bits >= 6) {
+            bits -= 6;
+            out.push_back(kBase64Url[(buffer >> bits) & 0x3F]);
+        }
     }
+    if (bits > 0) out.push_back(kBase64Url[(buffer << (6 - bits)) & 0x3F]);
+    return out;
+}
 
-    auto j = nlohmann::json::parse(resp, nullptr, false);
-    if (j.is_discarded()) {
-        errOut = makeError(500, "Cannot parse conversation from Supabase");
-        return false;
+bool base64UrlDecode(const std::string& in, std::string& out) {
+    out.clear();
+    unsigned int buffer = 0;
+    int bits = 0;
+    for (char c : in) {
+        const char* pos = std::strchr(kBase64Url, c);
+        if (!pos || c == '\0') return false;
+        buffer = (buffer << 6) | static_cast<unsigned int>(pos - kBase64Url);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<char>((buffer >> bits) & 0xFF));
+        }
     }
+    return true;
+}
 
-    if (!j.is_array() || j.empty()) {
-        errOut = makeError(404, "Conversation not found or user is not a member");
-        return false;
+// Timestamps as PostgREST returns them: 2025-12-03T10:00:00.123456+00:00
+bool looksLikeTimestamp(const std::string& v) {
+    if (v.empty() || v.size() > 40) return false;
+    for (char c : v) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != ':' && c != '.' && c != '+' && c != '-') return false;
     }
+    return true;
+}
 
-    out = j[0];
+bool looksLikeUuid(const std::string& v) {
+    if (v.empty() || v.size() > 36) return false;
+    for (char c : v) {
+        if (!std::isxdigit(static_cast<unsigned char>(c)) && c != '-') return false;
+    }
     return true;
 }
 
-// ------------- Helper 7: Check update rights ----------
-bool checkConversationUpdateRights(const SupabaseEnv& env,
-                                   const std::string& profileId,
-                                   const std::string& conversationId,
-                                   std::string& outRole,
-                                   ConversationService::Result& errOut) {
-    std::string url = env.base +
-        "/rest/v1/conversation_members"
-        "?select=role"
-        "&user_id=eq." + profileId +
-        "&conversation_id=eq." + conversationId +
-        "&left_at=is.null"
-        "&limit=1";
+std::string encodeCursor(const Keyset& k) {
+    return base64UrlEncode(k.updatedAt + "\n" + k.id);
+}
 
-    CURL* c = curl_easy_init();
-    if (!c) {
-        errOut = makeError(500, "curl init failed (checkConversationUpdateRights)");
-        return false;
+bool decodeCursor(const std::string& cursor, Keyset& out) {
+    std::string raw;
+    if (!base64UrlDecode(cursor, raw)) return false;
+    const auto nl = raw.find('\n');
+    if (nl == std::string::npos) return false;
+    out.updatedAt = raw.substr(0, nl);
+    out.id = raw.substr(nl + 1);
+    return looksLikeTimestamp(out.updatedAt) && looksLikeUuid(out.id);
+}
+
+// ---------- Helper 6: List one page of the conversations of a profile ----------
+// Ordered by (conversation.updated_at, conversation.id) desc. Asks for
+// limit + 1 rows so the caller knows whether there is a next page.
+void fetchMyConversations(const CallPtr& call,
+                          const std::string& profileId,
+                          int limit,
+                          const std::optional<Keyset>& after,
+                          const std::string& since,
+                          const Fail& fail,
+                          Then<PagePtr> next) {
+    ConversationStore::PageQuery query;
+    query.profileId = profileId;
+    query.limit = limit + 1;
+    query.since = since;
+    if (after) {
+        query.beforeUpdatedAt = after->updatedAt;
+        query.beforeId = after->id;
     }
 
-    std::string resp;
-    long httpCode = 0;
-    struct curl_slist* h = nullptr;
-    h = curl_slist_append(h, ("apikey: " + env.anonKey).c_str());
-    h = curl_slist_append(h, ("Authorization: Bearer " + env.accessToken).c_str());
-    h = curl_slist_append(h, "Content-Type: application/json");
+    callUpstream(call, "fetchMyConversations", [&](auto cb) {
+        ConversationStore::instance().conversationPage(call->env, query, std::move(cb));
+    }, [fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (list conversations)"));
+        }
+
+        if (resp.httpCode != 200) {
+            return fail(upstreamError(resp));
+        }
 
-    curl_easy_setopt(c, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(c, CURLOPT_HTTPHEADER, h);
-    curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(c, CURLOPT_WRITEDATA, &resp);
+        auto page = readConversationPage(resp.body);
+        if (!page) {
+            return fail(makeError(500, "Cannot parse conversations list from Supabase"));
+        }
 
-    auto res = curl_easy_perform(c);
-    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &httpCode);
-    curl_slist_free_all(h);
-    curl_easy_cleanup(c);
+        next(std::move(page));
+    });
+}
 
-    if (res != CURLE_OK) {
-        errOut = makeError(500, "curl perform failed (checkConversationUpdateRights)");
-        return false;
-    }
+// ---------- Helper 7: Get conversation by ID ----------
+void fetchConversationById(const CallPtr& call,
+                           const std::string& profileId,
+                           const std::string& conversationId,
+                           const Fail& fail,
+                           Then<PagePtr> next) {
+    callUpstream(call, "fetchConversationById", [&](auto cb) {
+        ConversationStore::instance().conversationOfMember(call->env, profileId, conversationId, std::move(cb));
+    }, [fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (get conversation)"));
+        }
 
-    if (httpCode != 200) {
-        ConversationService::Result r;
-        r.statusCode = static_cast<int>(httpCode);
-        r.body = resp.empty() ? nlohmann::json::object() : nlohmann::json::parse(resp, nullptr, false);
-        if (r.body.is_discarded()) r.body = nlohmann::json::object();
-        errOut = r;
-        return false;
-    }
+        if (resp.httpCode != 200) {
+            return fail(upstreamError(resp));
+        }
 
-    auto j = nlohmann::json::parse(resp, nullptr, false);
-    if (j.is_discarded() || !j.is_array() || j.empty()) {
-        errOut = makeError(404, "Conversation not found or user is not a member");
-        return false;
-    }
+        auto page = readConversationPage(resp.body);
+        fastjson::Value j;
+        if (!page && !fastjson::parse(resp.body, j)) {
+            return fail(makeError(500, "Cannot parse conversation from Supabase"));
+        }
 
-    auto role = j[0].value("role", std::string{});
-    if (role != "owner" && role != "admin") {
-        errOut = makeError(403, "User is not allowed to update this conversation");
-        return false;
-    }
+        if (!page || page->rows.empty()) {
+            return fail(makeError(404, "Conversation not found or user is not a member"));
+        }
 
-    outRole = role;
-    return true;
+        page->rows.resize(1);
+        next(std::move(page));
+    });
 }
 
-// ------------- Helper 8: Update conversation name ----------
-    bool patchConversationRow(const SupabaseEnv& env,
-                          const std::string& conversationId,
-                          const nlohmann::json& payload,
-                          nlohmann::json& out,
-                          ConversationService::Result& errOut) {
-    std::string url = env.base +
-        "/rest/v1/conversations?id=eq." + conversationId;
+// ---------- Helper 7b : roles kept in memory (MembershipCache.h) ----------
+// MemberRole::None: known not to be a member. Ids that are not UUIDs are never cached.
+std::optional<MemberRole> cachedRole(const std::string& conversationId, const std::string& profileId) {
+    Uuid conversation, profile;
+    if (!Uuid::parse(conversationId, conversation) || !Uuid::parse(profileId, profile)) return std::nullopt;
+    return MembershipCache::instance().get(conversation, profile);
+}
 
-    CURL* c = curl_easy_init();
-    if (!c) {
-        errOut = makeError(500, "curl init failed (patchConversationRow)");
-        return false;
-    }
+void rememberRole(const std::string& conversationId, const std::string& profileId, MemberRole role) {
+    Uuid conversation, profile;
+    if (!Uuid::parse(conversationId, conversation) || !Uuid::parse(profileId, profile)) return;
+    MembershipCache::instance().put(conversation, profile, role);
+}
 
-    std::string resp;
-    long httpCode = 0;
-    struct curl_slist* h = nullptr;
-    h = curl_slist_append(h, ("apikey: " + env.anonKey).c_str());
-    h = curl_slist_append(h, ("Authorization: Bearer " + env.accessToken).c_str());
-    h = curl_slist_append(h, "Content-Type: application/json");
-    h = curl_slist_append(h, "Prefer: return=representation");
+// Role of a membership lookup answer; a row without a known role still is a member
+MemberRole roleOfMembership(const std::vector<MemberRow>& rows) {
+    if (rows.empty()) return MemberRole::None;
+    return rows.front().role == MemberRole::None ? MemberRole::Other : rows.front().role;
+}
 
-    const std::string body = payload.dump();
+// After a member mutation: write-through here, invalidation for the other replicas
+void membersChanged(const std::string& conversationId,
+                    const std::vector<std::string>& profileIds,
+                    MemberRole role) {
+    for (const auto& profileId : profileIds) rememberRole(conversationId, profileId, role);
+    RedisCache::instance().invalidateMembers(conversationId, profileIds);
+}
 
-    curl_easy_setopt(c, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(c, CURLOPT_HTTPHEADER, h);
-    curl_easy_setopt(c, CURLOPT_CUSTOMREQUEST, "PATCH");
-    curl_easy_setopt(c, CURLOPT_POSTFIELDS, body.c_str());
-    curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(c, CURLOPT_WRITEDATA, &resp);
+// ------------- Helper 8: Check update rights ----------
+void checkConversationUpdateRights(const CallPtr& call,
+                                   const std::string& profileId,
+                                   const std::string& conversationId,
+                                   const Fail& fail,
+                                   Then<MemberRole> next) {
+    const auto manage = [fail, next](MemberRole role) {
+        if (role == MemberRole::None) {
+            return fail(makeError(404, "Conversation not found or user is not a member"));
+        }
+        if (!canManage(role)) {
+            return fail(makeError(403, "User is not allowed to update this conversation"));
+        }
+        next(role);
+    };
+    if (auto role = cachedRole(conversationId, profileId)) return manage(*role);
 
-    auto res = curl_easy_perform(c);
-    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &httpCode);
-    curl_slist_free_all(h);
-    curl_easy_cleanup(c);
+    cachedStoreRead(call, "checkConversationUpdateRights", RedisCache::membership(conversationId, profileId),
+                    [call, conversationId, profileId](auto cb) {
+        ConversationStore::instance().membership(call->env, conversationId, profileId, std::move(cb));
+    }, [conversationId, profileId, fail, manage](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (checkConversationUpdateRights)"));
+        }
 
-    if (res != CURLE_OK) {
-        errOut = makeError(500, "curl perform failed (patchConversationRow)");
-        return false;
-    }
+        if (resp.httpCode != 200) {
+            return fail(upstreamError(resp));
+        }
 
-    if (httpCode != 200 && httpCode != 204) {
-        ConversationService::Result r;
-        r.statusCode = static_cast<int>(httpCode);
-        r.body = resp.empty() ? nlohmann::json::object() : nlohmann::json::parse(resp, nullptr, false);
-        if (r.body.is_discarded()) r.body = nlohmann::json::object();
-        errOut = r;
-        return false;
-    }
+        std::vector<MemberRow> rows;
+        if (!readMemberRows(resp.body, rows)) {
+            return fail(makeError(404, "Conversation not found or user is not a member"));
+        }
 
-    if (resp.empty()) {
-        out = nlohmann::json::object();
-        return true;
-    }
+        const auto role = roleOfMembership(rows);
+        rememberRole(conversationId, profileId, role);
+        manage(role);
+    });
+}
 
-    auto j = nlohmann::json::parse(resp, nullptr, false);
-    if (j.is_discarded()) {
-        errOut = makeError(500, "Cannot parse updated conversation from Supabase");
-        return false;
-    }
+// ------------- Helper 9: Update conversation row ----------
+void patchConversationRow(const CallPtr& call,
+                          const std::string& conversationId,
+                          const std::string& payload,
+                          const Fail& fail,
+                          Then<std::string> next) {
+    std::string url = call->env.base +
+        "/rest/v1/conversations?id=eq." + conversationId;
 
-    out = j;
-    if (j.is_array() && !j.empty()) {
-        out = j[0];
-    }
+    callSupabase(call, "patchConversationRow", "PATCH", url, payload, [fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (patchConversationRow)"));
+        }
 
-    return true;
+        if (resp.httpCode != 200 && resp.httpCode != 204) {
+            return fail(upstreamError(resp));
+        }
+
+        if (resp.body.empty()) {
+            return next(std::string("{}"));
+        }
+
+        fastjson::Value j;
+        if (!fastjson::parse(resp.body, j)) {
+            return fail(makeError(500, "Cannot parse updated conversation from Supabase"));
+        }
+
+        next(writtenRow(j));
+    });
 }
 
-// ----------- Helper 9: Get current time in ISO 8601 UTC ----------
+// ----------- Helper 10: Get current time in ISO 8601 UTC ----------
+// Microseconds, as Postgres keeps them: an updated_at written now must not
+// sort before a watermark taken earlier in the same second
 std::string nowIsoUtc() {
     using namespace std::chrono;
     auto now = system_clock::now();
@@ -876,1104 +1203,1360 @@ std::string nowIsoUtc() {
 #else
     gmtime_r(&t, &tm);
 #endif
+    const auto micros = duration_cast<microseconds>(now.time_since_epoch()).count() % 1000000;
+    char fraction[8];
+    std::snprintf(fraction, sizeof(fraction), ".%06d", static_cast<int>(micros));
+
     std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%dT%H:%M:%SZ");
+    oss << std::put_time(&tm, "%Y-%m-%dT%H:%M:%S") << fraction << "Z";
     return oss.str();
 }
 
-// ---------- Helper 10: ensure a profile exists by id ----------
-bool ensureProfileExists(const SupabaseEnv& env,
-                         const std::string& profileId,
-                         ConversationService::Result& errOut) {
-    std::string url = env.base +
-        "/rest/v1/profiles?select=id&id=eq." + profileId + "&limit=1";
-
-    CURL* c = curl_easy_init();
-    if (!c) {
-        errOut = makeError(500, "curl init failed (ensureProfileExists)");
-        return false;
-    }
+// ----------- Helper 10b: move a conversation past the change watermarks ----------
+// /conversations/changes is keyed on conversations.updated_at: after a
+// member joins or leaves, the conversation must come after the watermark
+// of that member. The membership is already written, so a failed touch
+// does not fail the call; the conversation then shows up with its next
+// update.
+void touchConversation(const CallPtr& call, const std::string& conversationId, Then<> next) {
+    std::string url = call->env.base +
+        "/rest/v1/conversations?id=eq." + conversationId;
 
-    std::string resp;
-    long httpCode = 0;
-    struct curl_slist* h = nullptr;
-    h = curl_slist_append(h, ("apikey: " + env.anonKey).c_str());
-    h = curl_slist_append(h, ("Authorization: Bearer " + env.accessToken).c_str());
-    h = curl_slist_append(h, "Content-Type: application/json");
+    std::string payload;
+    fastjson::Writer(payload).beginObject().field("updated_at", nowIsoUtc()).endObject();
 
-    curl_easy_setopt(c, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(c, CURLOPT_HTTPHEADER, h);
-    curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(c, CURLOPT_WRITEDATA, &resp);
+    callSupabase(call, "touchConversation", "PATCH", url, payload,
+                 [next](const SupabaseClient::Response&) { next(); });
+}
 
-    auto res = curl_easy_perform(c);
-    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &httpCode);
-    curl_slist_free_all(h);
-    curl_easy_cleanup(c);
+// ----------- Helper 10c: members coming back ----------
+// A member who left keeps their row (left_at set, for /conversations/changes):
+// adding them again brings that row back instead of inserting a second
+// one. Every pending entry with such a row becomes Added with it.
+void reviveMemberBatch(const CallPtr& call,
+                       const std::string& conversationId,
+                       const MemberBatch& batch,
+                       const Fail& fail,
+                       Then<> next) {
+    const auto ids = pendingIds(*batch);
+    if (ids.empty()) return next();
+
+    std::string list;
+    for (const auto& id : ids) {
+        if (!list.empty()) list.push_back(',');
+        list += id;
+    }
+    std::string url = call->env.base +
+        "/rest/v1/conversation_members"
+        "?conversation_id=eq." + conversationId +
+        "&user_id=in.(" + list + ")"
+        "&left_at=not.is.null";
+
+    std::string payload;
+    fastjson::Writer(payload)
+        .beginObject()
+        .field("role", "member")
+        .field("joined_at", nowIsoUtc())
+        .key("left_at").null()
+        .endObject();
+
+    callSupabase(call, "reviveMemberBatch", "PATCH", url, payload, [batch, fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (reviveMemberBatch)"));
+        }
+
+        if (resp.httpCode != 200 && resp.httpCode != 204) {
+            return fail(upstreamError(resp));
+        }
+
+        std::vector<MemberRow> revived;
+        readMemberRows(resp.body, revived);
+        for (auto& e : *batch) {
+            if (e.outcome != BatchOutcome::Pending) continue;
+            const auto row = std::find_if(revived.begin(), revived.end(),
+                [&e](const MemberRow& m) { return m.userId == e.id; });
+            if (row == revived.end()) continue;
+            e.outcome = BatchOutcome::Added;
+            e.row = std::string(row->raw);
+        }
+        next();
+    });
+}
 
-    if (res != CURLE_OK) {
-        errOut = makeError(500, "curl perform failed (ensureProfileExists)");
-        return false;
-    }
+// ---------- Helper 11: ensure a profile exists by id ----------
+void ensureProfileExists(const CallPtr& call,
+                         const std::string& profileId,
+                         const Fail& fail,
+                         Then<> next) {
+    cachedStoreRead(call, "ensureProfileExists", RedisCache::profileNames(profileId), [call, profileId](auto cb) {
+        ConversationStore::instance().profileNames(call->env, {profileId}, std::move(cb));
+    }, [fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (ensureProfileExists)"));
+        }
 
-    if (httpCode != 200) {
-        ConversationService::Result r;
-        r.statusCode = static_cast<int>(httpCode);
-        r.body = resp.empty() ? nlohmann::json::object() : nlohmann::json::parse(resp, nullptr, false);
-        if (r.body.is_discarded()) r.body = nlohmann::json::object();
-        errOut = r;
-        return false;
-    }
+        if (resp.httpCode != 200) {
+            return fail(upstreamError(resp));
+        }
 
-    auto j = nlohmann::json::parse(resp, nullptr, false);
-    if (j.is_discarded() || !j.is_array() || j.empty()) {
-        errOut = makeError(404, "Target profile not found");
-        return false;
-    }
+        fastjson::Value j;
+        if (!fastjson::parse(resp.body, j) || !j.isArray() || isEmptyArray(j)) {
+            return fail(makeError(404, "Target profile not found"));
+        }
 
-    return true;
+        next();
+    });
 }
 
-// ---------- Helper 11: ensure caller can view the conversation (is a member) ----------
-bool ensureCanViewConversation(const SupabaseEnv& env,
+// ---------- Helper 12: ensure caller can view the conversation (is a member) ----------
+void ensureCanViewConversation(const CallPtr& call,
                                const std::string& profileId,
                                const std::string& conversationId,
-                               ConversationService::Result& errOut) {
-    std::string url = env.base +
-        "/rest/v1/conversation_members"
-        "?select=id"
-        "&conversation_id=eq." + conversationId +
-        "&user_id=eq." + profileId +
-        "&left_at=is.null";
-
-    CURL* c = curl_easy_init();
-    if (!c) {
-        errOut = makeError(500, "curl init failed (ensureCanViewConversation)");
-        return false;
+                               const Fail& fail,
+                               Then<> next) {
+    if (auto role = cachedRole(conversationId, profileId)) {
+        if (*role == MemberRole::None) return fail(makeError(403, "You are not a member of this conversation"));
+        return next();
     }
 
-    std::string resp;
-    long httpCode = 0;
-    struct curl_slist* h = nullptr;
-    h = curl_slist_append(h, ("apikey: " + env.anonKey).c_str());
-    h = curl_slist_append(h, ("Authorization: Bearer " + env.accessToken).c_str());
-    h = curl_slist_append(h, "Content-Type: application/json");
-
-    curl_easy_setopt(c, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(c, CURLOPT_HTTPHEADER, h);
-    curl_easy_setopt(c, CURLOPT_HTTPGET, 1L);
-    curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(c, CURLOPT_WRITEDATA, &resp);
-
-    auto res = curl_easy_perform(c);
-    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &httpCode);
-    curl_slist_free_all(h);
-    curl_easy_cleanup(c);
-
-    if (res != CURLE_OK) {
-        errOut = makeError(500, "curl perform failed (ensureCanViewConversation)");
-        return false;
-    }
-
-    if (httpCode != 200) {
-        ConversationService::Result r;
-        r.statusCode = static_cast<int>(httpCode);
-        r.body = resp.empty() ? nlohmann::json::object() : nlohmann::json::parse(resp, nullptr, false);
-        if (r.body.is_discarded()) r.body = nlohmann::json::object();
-        errOut = r;
-        return false;
-    }
-
-    auto j = nlohmann::json::parse(resp, nullptr, false);
-    if (j.is_discarded() || !j.is_array() || j.empty()) {
-        errOut = makeError(403, "You are not a member of this conversation");
-        return false;
-    }
-
-    return true;
-}
-
-// ---------- Helper 12: get member role and count owners for a conversation ----------
-bool fetchMemberRoleAndOwnerCount(const SupabaseEnv& env,
-                                  const std::string& conversationId,
-                                  const std::string& userId,
-                                  std::string& outMemberRole,
-                                  int& outOwnerCount,
-                                  ConversationService::Result& errOut) {
-    std::string url = env.base +
-        "/rest/v1/conversation_members"
-        "?select=user_id,role"
-        "&conversation_id=eq." + conversationId +
-        "&left_at=is.null";
-
-    CURL* c = curl_easy_init();
-    if (!c) {
-        errOut = makeError(500, "curl init failed (fetchMemberRoleAndOwnerCount)");
-        return false;
-    }
-
-    std::string resp;
-    long httpCode = 0;
-    struct curl_slist* h = nullptr;
-    h = curl_slist_append(h, ("apikey: " + env.anonKey).c_str());
-    h = curl_slist_append(h, ("Authorization: Bearer " + env.accessToken).c_str());
-    h = curl_slist_append(h, "Content-Type: application/json");
-
-    curl_easy_setopt(c, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(c, CURLOPT_HTTPHEADER, h);
-    curl_easy_setopt(c, CURLOPT_HTTPGET, 1L);
-    curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, writeCb);
-    curl_easy_setopt(c, CURLOPT_WRITEDATA, &resp);
-
-    auto res = curl_easy_perform(c);
-    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &httpCode);
-    curl_slist_free_all(h);
-    curl_easy_cleanup(c);
-
-    if (res != CURLE_OK) {
-        errOut = makeError(500, "curl perform failed (fetchMemberRoleAndOwnerCount)");
-        return false;
-    }
-
-    if (httpCode != 200) {
-        ConversationService::Result r;
-        r.statusCode = static_cast<int>(httpCode);
-        r.body = resp.empty()
-            ? nlohmann::json::object()
-            : nlohmann::json::parse(resp, nullptr, false);
-        if (r.body.is_discarded()) r.body = nlohmann::json::object();
-        errOut = r;
-        return false;
-    }
-
-    nlohmann::json j = nlohmann::json::array();
-    if (!resp.empty()) {
-        j = nlohmann::json::parse(resp, nullptr, false);
-        if (j.is_discarded()) {
-            j = nlohmann::json::array();
-        }
-    }
-
-    outOwnerCount = 0;
-    bool found = false;
-    outMemberRole.clear();
-
-    if (j.is_array()) {
-        for (const auto& row : j) {
-            if (!row.is_object()) continue;
-            const auto itUser = row.find("user_id");
-            const auto itRole = row.find("role");
-            if (itRole != row.end() && itRole->is_string()) {
-                if (itRole->get<std::string>() == "owner") {
-                    ++outOwnerCount;
-                }
-            }
-            if (itUser != row.end() && itUser->is_string() &&
-                itUser->get<std::string>() == userId &&
-                itRole != row.end() && itRole->is_string()) {
-                outMemberRole = itRole->get<std::string>();
-                found = true;
-            }
+    cachedStoreRead(call, "ensureCanViewConversation", RedisCache::membership(conversationId, profileId),
+                    [call, conversationId, profileId](auto cb) {
+        ConversationStore::instance().membership(call->env, conversationId, profileId, std::move(cb));
+    }, [conversationId, profileId, fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (ensureCanViewConversation)"));
         }
-    }
 
-    if (!found) {
-        errOut = makeError(404, "Member not found in this conversation");
-        return false;
-    }
-
-    return true;
-}
-
-} // namespace
-
-
-ConversationService::Result ConversationService::createConversation(
-    const std::string& accessToken,
-    const std::string& type,
-    const std::optional<std::string>& name,
-    const std::optional<std::string>& targetUserId
-) {
-    try {
-        if (accessToken.empty()) {
-            return makeError(401, "Missing Bearer access token");
+        if (resp.httpCode != 200) {
+            return fail(upstreamError(resp));
         }
 
-        if (type != "direct" && type != "group") {
-            return makeError(400, "Field 'type' must be 'direct' or 'group'");
+        std::vector<MemberRow> rows;
+        if (!readMemberRows(resp.body, rows)) {
+            return fail(makeError(403, "You are not a member of this conversation"));
         }
 
-        const char* base = std::getenv("SUPABASE_URL");
-        const char* anon = std::getenv("SUPABASE_ANON_KEY");
-        if (!base || !anon) {
-            return makeError(500, "Missing SUPABASE_URL/ANON_KEY");
+        const auto role = roleOfMembership(rows);
+        rememberRole(conversationId, profileId, role);
+        if (role == MemberRole::None) {
+            return fail(makeError(403, "You are not a member of this conversation"));
         }
 
-        SupabaseEnv env{ std::string(base), std::string(anon), accessToken };
-        ConversationService::Result err;
+        next();
+    });
+}
 
-        // 1) authUserId
-        std::string authUserId;
-        if (!fetchAuthUserId(env, authUserId, err)) {
-            return err;
+// ---------- Helper 13: get member role and count owners for a conversation ----------
+void fetchMemberRoleAndOwnerCount(const CallPtr& call,
+                                  const std::string& conversationId,
+                                  const std::string& userId,
+                                  const Fail& fail,
+                                  Then<MemberRole, int> next) {
+    callUpstream(call, "fetchMemberRoleAndOwnerCount", [&](auto cb) {
+        ConversationStore::instance().activeMembers(call->env, conversationId, std::move(cb));
+    }, [fail, next, conversationId, userId](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (fetchMemberRoleAndOwnerCount)"));
         }
 
-        // 2) caller profileId
-        std::string callerProfileId;
-        if (!fetchProfileId(env, authUserId, callerProfileId, err)) {
-            return err;
+        if (resp.httpCode != 200) {
+            return fail(upstreamError(resp));
         }
 
-        // GROUP: comportement actuel
-        if (type == "group") {
-            nlohmann::json convObj;
-            long convHttpCode = 0;
-
-            if (!createConversationRowWithDirectKey(env, type, name, callerProfileId, std::nullopt, convObj, convHttpCode, err)) {
-                return err;
-            }
+        std::vector<MemberRow> rows;
+        readMemberRows(resp.body, rows);
 
-            const std::string conversationId = convObj["id"].get<std::string>();
-            if (!insertOwnerMember(env, conversationId, callerProfileId, err)) {
-                return err;
+        // Every active member of the conversation: warm the role cache
+        Uuid conversation;
+        if (Uuid::parse(conversationId, conversation)) {
+            for (const auto& m : rows) {
+                if (m.userId.isNil()) continue;
+                MembershipCache::instance().put(conversation, m.userId,
+                                                m.role == MemberRole::None ? MemberRole::Other : m.role);
             }
-
-            ConversationService::Result r;
-            r.statusCode = 201;
-            r.body = convObj;
-            return r;
-        }
-
-        // DIRECT: target_user_id obligatoire
-        if (!targetUserId.has_value() || targetUserId->empty()) {
-            return makeError(400, "Field 'target_user_id' is required for type='direct'");
-        }
-
-        const std::string targetProfileId = *targetUserId;
-
-        if (targetProfileId == callerProfileId) {
-            return makeError(400, "Cannot create a direct conversation with yourself");
-        }
-
-        // vérifier que le profil cible existe
-        if (!ensureProfileExists(env, targetProfileId, err)) {
-            return err;
         }
 
-        // 3) direct_key
-        const std::string directKey = makeDirectKey(callerProfileId, targetProfileId);
+        const int ownerCount = static_cast<int>(std::count_if(rows.begin(), rows.end(),
+            [](const MemberRow& m) { return m.role == MemberRole::Owner; }));
 
-        // 4) si existe déjà → retourner (200)
-        nlohmann::json existing;
-        if (!fetchDirectConversationByKey(env, directKey, existing, err)) {
-            return err;
-        }
+        Uuid target;
+        const auto member = Uuid::parse(userId, target)
+            ? std::find_if(rows.begin(), rows.end(), [&](const MemberRow& m) {
+                  return m.userId == target && m.role != MemberRole::None;
+              })
+            : rows.end();
 
-        if (existing.is_object() && existing.contains("id")) {
-            ConversationService::Result r;
-            r.statusCode = 200;
-            r.body = existing;
-            return r;
+        if (member == rows.end()) {
+            return fail(makeError(404, "Member not found in this conversation"));
         }
 
-        // 5) créer la conversation direct (name ignoré)
-        nlohmann::json convObj;
-        long convHttpCode = 0;
-
-        if (!createConversationRowWithDirectKey(env, "direct", std::nullopt, callerProfileId, directKey, convObj, convHttpCode, err)) {
-            return err;
-        }
-
-        const std::string conversationId = convObj["id"].get<std::string>();
-
-        // 6) ajouter les 2 membres : caller owner, target member
-        if (!insertOwnerMember(env, conversationId, callerProfileId, err)) {
-            return err;
-        }
-
-        nlohmann::json dummy;
-        if (!insertMemberWithRole(env, conversationId, targetProfileId, "owner", &dummy, err)) {
-            return err;
-        }
+        next(member->role, ownerCount);
+    });
+}
 
-        ConversationService::Result r;
-        r.statusCode = 201;
-        r.body = convObj;
-        return r;
+// ---------- Helper 14: ETags / If-None-Match ----------
+// Weak validator: SHA-256 (truncated) of what the answer depends on
+std::string makeEtag(const std::string& material) {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(material.data()), material.size(), digest);
 
-    } catch (const std::exception& e) {
-        return makeError(500, e.what());
+    static const char* hex = "0123456789abcdef";
+    std::string tag = "W/\"";
+    for (int i = 0; i < 16; ++i) {
+        tag.push_back(hex[digest[i] >> 4]);
+        tag.push_back(hex[digest[i] & 0x0F]);
     }
+    tag.push_back('"');
+    return tag;
 }
 
-ConversationService::Result ConversationService::listMyConversations(
-    const std::string& accessToken
-) {
-    try {
-        if (accessToken.empty()) {
-            return makeError(401, "Missing Bearer access token");
-        }
+// Weak comparison against an If-None-Match list ("*" matches anything)
+bool etagMatches(const std::string& ifNoneMatch, const std::string& etag) {
+    if (ifNoneMatch.empty()) return false;
+
+    auto opaque = [](std::string t) {
+        if (t.rfind("W/", 0) == 0) t.erase(0, 2);
+        return t;
+    };
+    const std::string wanted = opaque(etag);
+
+    std::stringstream ss(ifNoneMatch);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        const auto b = item.find_first_not_of(" \t");
+        const auto e = item.find_last_not_of(" \t");
+        if (b == std::string::npos) continue;
+        item = item.substr(b, e - b + 1);
+        if (item == "*" || opaque(item) == wanted) return true;
+    }
+    return false;
+}
 
-        const char* base = std::getenv("SUPABASE_URL");
-        const char* anon = std::getenv("SUPABASE_ANON_KEY");
-        if (!base || !anon) {
-            return makeError(500, "Missing SUPABASE_URL/ANON_KEY");
-        }
+ConversationService::Result notModified(const std::string& etag) {
+    ConversationService::Result r{304, nullptr, {}, {}};
+    r.headers.emplace_back("ETag", etag);
+    return r;
+}
 
-        SupabaseEnv env{ std::string(base), std::string(anon), accessToken };
-        ConversationService::Result err;
+// Validator of a conversations page: the caller, the page asked for and, for
+// every row, (conversation id, updated_at, role). A conversation that is
+// updated, deleted, left or joined changes the tag.
+std::string conversationsPageEtag(const std::string& profileId,
+                                  const ConversationService::PageRequest& page,
+                                  const ConversationPage& rows) {
+    std::string material = profileId + "|" + std::to_string(page.limit) + "|" + page.cursor + "|" + page.since;
+    material.reserve(material.size() + rows.rows.size() * 96);
+    for (const auto& r : rows.rows) {
+        if (!r.conversation.valid()) continue;
+        material.append("|");
+        if (!r.id.isNil()) r.id.appendTo(material);
+        material.append(",").append(r.updatedAt)
+                .append(",").append(memberRoleName(r.role));
+    }
+    return makeEtag(material);
+}
 
-        // 1) authUserId
-        std::string authUserId;
-        if (!fetchAuthUserId(env, authUserId, err)) {
-            return err;
-        }
+// ---------- Helper 15: conversations changed after a keyset watermark ----------
+// Includes deleted conversations and memberships left after the watermark,
+// ordered by (updated_at, id) asc; asks for limit + 1 rows. Joins and leaves
+// are in it because they touch conversations.updated_at (touchConversation)
+// and leaving only sets left_at.
+void fetchConversationChanges(const CallPtr& call,
+                              const std::string& profileId,
+                              const Keyset& after,
+                              bool afterIsTimestampOnly,
+                              int limit,
+                              const Fail& fail,
+                              Then<PagePtr> next) {
+    ConversationStore::ChangesQuery query;
+    query.profileId = profileId;
+    query.limit = limit + 1;
+    query.afterUpdatedAt = after.updatedAt;
+    if (!afterIsTimestampOnly) query.afterId = after.id;
+
+    callUpstream(call, "fetchConversationChanges", [&](auto cb) {
+        ConversationStore::instance().conversationChanges(call->env, query, std::move(cb));
+    }, [fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (conversation changes)"));
+        }
+
+        if (resp.httpCode != 200) {
+            return fail(upstreamError(resp));
+        }
+
+        auto page = readConversationPage(resp.body);
+        if (!page) {
+            return fail(makeError(500, "Cannot parse conversation changes from Supabase"));
+        }
+
+        next(std::move(page));
+    });
+}
 
-        // 2) profileId
-        std::string profileId;
-        if (!fetchProfileId(env, authUserId, profileId, err)) {
-            return err;
-        }
+// ---------- Helper 16: messages ----------
+constexpr std::size_t kMaxMessageBytes = 16 * 1024;
 
-        // 3) conversation lists
-        nlohmann::json list;
-        if (!fetchMyConversations(env, profileId, list, err)) {
-            return err;
-        }
+std::string isoUtcFromMs(std::int64_t ms) {
+    const std::time_t t = static_cast<std::time_t>(ms / 1000);
+    std::tm tm{};
+#ifdef _WIN32
+    gmtime_s(&tm, &t);
+#else
+    gmtime_r(&t, &tm);
+#endif
+    char millis[8];
+    std::snprintf(millis, sizeof(millis), ".%03d", static_cast<int>(ms % 1000));
 
-        // 4) enrich display_name
-        if (list.is_array()) {
-            for (auto& row : list) {
-                enrichDisplayNameIfDirect(env, profileId, row, err);
-                // si err est rempli ici, on ne casse pas toute la liste : on continue
-                err.statusCode = 0;
-                err.body = nlohmann::json::object();
-            }
-        }
+    std::ostringstream oss;
+    oss << std::put_time(&tm, "%Y-%m-%dT%H:%M:%S") << millis << "Z";
+    return oss.str();
+}
 
-        ConversationService::Result r;
-        r.statusCode = 200;
-        r.body = list;
-        return r;
+// Loop the append acknowledgement must come back to (none in a blocking call)
+trantor::EventLoop* replyLoop() {
+    if (SupabaseClient::BlockingScope::active()) return nullptr;
+    return trantor::EventLoop::getEventLoopOfCurrentThread();
+}
+
+// The stored records already are JSON objects: join them without re-parsing
+std::string joinJsonArray(const std::vector<std::string_view>& items) {
+    std::size_t total = 2;
+    for (const auto& item : items) total += item.size() + 1;
 
-    } catch (const std::exception& e) {
-        return makeError(500, e.what());
+    std::string out;
+    out.reserve(total);
+    out.push_back('[');
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        if (i) out.push_back(',');
+        out.append(items[i].data(), items[i].size());
     }
+    out.push_back(']');
+    return out;
 }
 
-ConversationService::Result ConversationService::getConversationById(
-    const std::string& accessToken,
-    const std::string& conversationId
-) {
-    try {
-        if (accessToken.empty()) {
-            return makeError(401, "Missing Bearer access token");
-        }
-        if (conversationId.empty()) {
-            return makeError(400, "Missing conversation id");
-        }
+// ---------- Helper 17: real-time events (pushed to the WebSocket subscribers) ----------
+// data already is JSON (a row as Supabase sent it, a stored message): embedded as is
+std::string realtimeEvent(const char* type, const std::string& conversationId, const char* field, std::string_view data) {
+    std::string event;
+    event.reserve(64 + conversationId.size() + data.size());
+    fastjson::Writer(event)
+        .beginObject()
+        .field("type", type)
+        .field("conversation_id", conversationId)
+        .key(field).raw(data)
+        .endObject();
+    return event;
+}
 
-        const char* base = std::getenv("SUPABASE_URL");
-        const char* anon = std::getenv("SUPABASE_ANON_KEY");
-        if (!base || !anon) {
-            return makeError(500, "Missing SUPABASE_URL/ANON_KEY");
+void fetchMyConversationIds(const CallPtr& call,
+                            const std::string& profileId,
+                            const Fail& fail,
+                            Then<json> next) {
+    callUpstream(call, "fetchMyConversationIds", [&](auto cb) {
+        ConversationStore::instance().conversationIds(call->env, profileId, std::move(cb));
+    }, [fail, next](const SupabaseClient::Response& resp) {
+        if (!resp.ok) {
+            return fail(makeError(500, "curl perform failed (list conversation ids)"));
         }
 
-        SupabaseEnv env{ std::string(base), std::string(anon), accessToken };
-        ConversationService::Result err;
-
-        // 1) authUserId
-        std::string authUserId;
-        if (!fetchAuthUserId(env, authUserId, err)) {
-            return err;
+        if (resp.httpCode != 200) {
+            return fail(upstreamError(resp));
         }
 
-        // 2) profileId
-        std::string profileId;
-        if (!fetchProfileId(env, authUserId, profileId, err)) {
-            return err;
+        fastjson::Value rows;
+        if (!fastjson::parse(resp.body, rows) || !rows.isArray()) {
+            return fail(makeError(500, "Cannot parse conversation ids from Supabase"));
         }
 
-        // 3) Conversation if the user is a member
-        nlohmann::json convRow;
-        if (!fetchConversationById(env, profileId, conversationId, convRow, err)) {
-            return err;
-        }
+        json ids = json::array();
+        fastjson::forEachElement(rows, [&](const fastjson::Value& row) {
+            const auto id = fastjson::member(row, "conversation_id");
+            if (id.isString()) ids.push_back(id.string());
+        });
+        next(std::move(ids));
+    });
+}
 
-        // 4) enrich display_name
-        enrichDisplayNameIfDirect(env, profileId, convRow, err);
+} // namespace
 
-        ConversationService::Result r;
-        r.statusCode = 200;
-        r.body = convRow;
-        return r;
 
-    } catch (const std::exception& e) {
-        return makeError(500, e.what());
-    }
-}
+// ===================== Non-blocking operations =====================
 
-ConversationService::Result ConversationService::updateConversation(
+void ConversationService::createConversation(
     const std::string& accessToken,
-    const std::string& conversationId,
-    const std::optional<std::string>& name
+    const std::string& type,
+    const std::optional<std::string>& name,
+    const std::optional<std::string>& targetUserId,
+    const std::vector<std::string>& memberIds,
+    Callback done
 ) {
-    try {
-        if (accessToken.empty()) {
-            return makeError(401, "Missing Bearer access token");
-        }
-        if (conversationId.empty()) {
-            return makeError(400, "Missing conversation id");
-        }
-        if (!name.has_value()) {
-            return makeError(400, "Missing 'name' field");
-        }
-
-        const char* base = std::getenv("SUPABASE_URL");
-        const char* anon = std::getenv("SUPABASE_ANON_KEY");
-        if (!base || !anon) {
-            return makeError(500, "Missing SUPABASE_URL/ANON_KEY");
-        }
+    if (accessToken.empty()) {
+        return done(makeError(401, "Missing Bearer access token"));
+    }
 
-        SupabaseEnv env{
-            std::string(base),
-            std::string(anon),
-            accessToken
-        };
+    if (type != "direct" && type != "group") {
+        return done(makeError(400, "Field 'type' must be 'direct' or 'group'"));
+    }
 
-        ConversationService::Result err;
+    if (!memberIds.empty() && type != "group") {
+        return done(makeError(400, "Field 'member_ids' is only allowed for type='group'"));
+    }
 
-        // 1) Auth user
-        std::string authUserId;
-        if (!fetchAuthUserId(env, authUserId, err)) {
-            return err;
-        }
+    if (memberIds.size() > kMaxBatchMembers) {
+        return done(makeError(400, "Field 'member_ids' must hold at most " + std::to_string(kMaxBatchMembers) + " profile ids"));
+    }
 
-        // 2) Caller profile
-        std::string profileId;
-        if (!fetchProfileId(env, authUserId, profileId, err)) {
-            return err;
-        }
+    auto call = startCall(accessToken, done);
+    if (!call) return;
+    const auto fail = failWith(call);
 
-        // 3) Vérifier droits (owner/admin)
-        std::string callerRole;
-        if (!checkConversationUpdateRights(env, profileId, conversationId, callerRole, err)) {
-            return err;
-        }
+    // 1) + 2) caller profileId
+    resolveCallerProfile(call, fail, [=](const std::string& callerProfileId) {
+        // GROUP: le créateur (owner) et les member_ids éventuels, en un seul insert
+        if (type == "group") {
+            auto batch = makeMemberBatch(memberIds);
+            Uuid caller;
+            if (Uuid::parse(callerProfileId, caller)) {
+                for (auto& e : *batch) {
+                    if (e.outcome == BatchOutcome::Pending && e.id == caller) e.outcome = BatchOutcome::AlreadyMember;
+                }
+            }
 
-        // 4) Lire la conversation pour connaître son type
-        nlohmann::json convRow;
-        if (!fetchConversationById(env, profileId, conversationId, convRow, err)) {
-            return err;
+            settleMemberBatch(call, std::string(), batch, fail, [=]() {
+                createConversationRowWithDirectKey(call, type, name, callerProfileId, std::nullopt, fail,
+                    [=](const WrittenRow& conv) {
+                        const std::string& conversationId = conv.id;
+                        insertMemberBatch(call, conversationId, batch, callerProfileId, fail, [=]() {
+                            touchConversation(call, conversationId, [=]() {
+                                const auto event = realtimeEvent("conversation.created", conversationId, "conversation", conv.row);
+                                auto& hub = RealtimeHub::instance();
+                                hub.memberJoined(conversationId, callerProfileId, event);
+                                for (const auto& e : *batch) {
+                                    if (e.outcome == BatchOutcome::Added) hub.memberJoined(conversationId, e.id.str(), event);
+                                }
+
+                                if (memberIds.empty()) return call->complete(rawResult(201, conv.row));
+
+                                // The row as created, plus "members": the outcome of each member id
+                                fastjson::Value row;
+                                fastjson::parse(conv.row, row);
+                                std::string body;
+                                fastjson::Writer w(body);
+                                w.beginObject();
+                                fastjson::forEachMember(row, [&](std::string_view key, const fastjson::Value& v) {
+                                    if (key != "members") w.rawKey(key).raw(v.raw);
+                                });
+                                w.key("members");
+                                writeMemberBatch(w, *batch);
+                                w.endObject();
+                                call->complete(rawResult(201, std::move(body)));
+                            });
+                        });
+                    });
+            });
+            return;
         }
 
-        if (!convRow.is_object() || !convRow.contains("conversation") || !convRow["conversation"].is_object()) {
-            return makeError(500, "Unexpected conversation read format");
+        // DIRECT: target_user_id obligatoire
+        if (!targetUserId.has_value() || targetUserId->empty()) {
+            return call->complete(makeError(400, "Field 'target_user_id' is required for type='direct'"));
         }
 
-        const auto& conv = convRow["conversation"];
-        if (!conv.contains("type") || !conv["type"].is_string()) {
-            return makeError(500, "Conversation type missing");
-        }
+        const std::string targetProfileId = *targetUserId;
 
-        const std::string type = conv["type"].get<std::string>();
-        if (type == "direct") {
-            // Interdit : cohérence option B (nom dynamique)
-            return makeError(409, "Direct conversations cannot be renamed");
+        if (targetProfileId == callerProfileId) {
+            return call->complete(makeError(400, "Cannot create a direct conversation with yourself"));
         }
 
-        // 5) Update name (group only)
-        std::string url = env.base +
-            "/rest/v1/conversations?id=eq." + conversationId;
-
-        nlohmann::json payload;
-        payload["name"] = *name;
-        const std::string body = payload.dump();
+        // Conversation créée : les deux membres sont notifiés
+        const auto announce = [=](const WrittenRow& conv) {
+            const std::string& conversationId = conv.id;
+            const auto event = realtimeEvent("conversation.created", conversationId, "conversation", conv.row);
+            auto& hub = RealtimeHub::instance();
+            hub.memberJoined(conversationId, callerProfileId, event);
+            hub.memberJoined(conversationId, targetProfileId, event);
+            call->complete(rawResult(201, conv.row));
+        };
 
-        CURL* c = curl_easy_init();
-        if (!c) {
-            return makeError(500, "curl init failed (updateConversation)");
+        // 3) à 6) en une seule transaction côté Postgres
+        if (createDirectViaRpc()) {
+            createDirectConversationRpc(call, callerProfileId, targetProfileId, fail,
+                [=](const WrittenRow& conv, bool created) {
+                    if (!created) return call->complete(rawResult(200, conv.row));
+                    announce(conv);
+                });
+            return;
         }
 
-        std::string resp;
-        long httpCode = 0;
-        struct curl_slist* h = nullptr;
-        h = curl_slist_append(h, ("apikey: " + env.anonKey).c_str());
-        h = curl_slist_append(h, ("Authorization: Bearer " + env.accessToken).c_str());
-        h = curl_slist_append(h, "Content-Type: application/json");
-        h = curl_slist_append(h, "Prefer: return=representation");
+        // vérifier que le profil cible existe
+        ensureProfileExists(call, targetProfileId, fail, [=]() {
+            // 3) direct_key
+            const std::string directKey = makeDirectKey(callerProfileId, targetProfileId);
+
+            // 4) si existe déjà → retourner (200)
+            fetchDirectConversationByKey(call, directKey, fail, [=](std::string existing) {
+                fastjson::Value row;
+                if (fastjson::parse(existing, row) && fastjson::member(row, "id").valid()) {
+                    return call->complete(rawResult(200, std::move(existing)));
+                }
 
-        curl_easy_setopt(c, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(c, CURLOPT_HTTPHEADER, h);
-        curl_easy_setopt(c, CURLOPT_CUSTOMREQUEST, "PATCH");
-        curl_easy_setopt(c, CURLOPT_POSTFIELDS, body.c_str());
-        curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, writeCb);
-        curl_easy_setopt(c, CURLOPT_WRITEDATA, &resp);
+                // 5) créer la conversation direct (name ignoré)
+                createConversationRowWithDirectKey(call, "direct", std::nullopt, callerProfileId, directKey, fail,
+                    [=](const WrittenRow& conv) {
+                        const std::string& conversationId = conv.id;
+
+                        // 6) ajouter les 2 membres : caller owner, target member
+                        insertOwnerMember(call, conversationId, callerProfileId, fail, [=]() {
+                            insertMemberWithRole(call, conversationId, targetProfileId, "owner", fail,
+                                [=](const std::string&) {
+                                    touchConversation(call, conversationId, [=]() { announce(conv); });
+                                });
+                        });
+                    });
+            });
+        });
+    });
+}
 
-        auto res = curl_easy_perform(c);
-        curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &httpCode);
-        curl_slist_free_all(h);
-        curl_easy_cleanup(c);
+void ConversationService::listMyConversations(
+    const std::string& accessToken,
+    const PageRequest& page,
+    Callback done
+) {
+    if (accessToken.empty()) {
+        return done(makeError(401, "Missing Bearer access token"));
+    }
 
-        if (res != CURLE_OK) {
-            return makeError(500, "curl perform failed (updateConversation)");
-        }
+    if (page.limit < 1 || page.limit > 200) {
+        return done(makeError(400, "'limit' must be between 1 and 200"));
+    }
 
-        if (httpCode != 200) {
-            ConversationService::Result r;
-            r.statusCode = static_cast<int>(httpCode);
-            r.body = resp.empty()
-                ? nlohmann::json::object()
-                : nlohmann::json::parse(resp, nullptr, false);
-            if (r.body.is_discarded()) r.body = nlohmann::json::object();
-            return r;
+    std::optional<Keyset> after;
+    if (!page.cursor.empty()) {
+        Keyset k;
+        if (!decodeCursor(page.cursor, k)) {
+            return done(makeError(400, "Invalid cursor"));
         }
+        after = k;
+    }
+
+    if (!page.since.empty() && !looksLikeTimestamp(page.since)) {
+        return done(makeError(400, "'since' must be an ISO-8601 timestamp"));
+    }
+
+    auto call = startCall(accessToken, done);
+    if (!call) return;
+    const auto fail = failWith(call);
+    const int limit = page.limit;
+    const std::string since = page.since;
 
-        nlohmann::json j;
-        if (!resp.empty()) {
-            j = nlohmann::json::parse(resp, nullptr, false);
-            if (j.is_discarded()) {
-                j = nlohmann::json::array();
+    // 1) + 2) profileId
+    resolveCallerProfile(call, fail, [=](const std::string& profileId) {
+        // 3) one page of conversations (+1 row to detect the next page)
+        fetchMyConversations(call, profileId, limit, after, since, fail, [=](const PagePtr& rows) {
+            // 304 when the client's copy is current: no enrichment, no serialization
+            const auto etag = conversationsPageEtag(profileId, page, *rows);
+            if (etagMatches(page.ifNoneMatch, etag)) {
+                return call->complete(notModified(etag));
             }
-        } else {
-            j = nlohmann::json::array();
-        }
 
-        ConversationService::Result r;
-        r.statusCode = 200;
-        r.body = j;
-        return r;
+            std::string nextCursor;
+            if (rows->rows.size() > static_cast<size_t>(limit)) {
+                rows->rows.resize(static_cast<size_t>(limit));
+                const auto& last = rows->rows.back();
+                if (!last.updatedAt.empty() && !last.id.isNil()) {
+                    nextCursor = encodeCursor({std::string(last.updatedAt), last.id.str()});
+                }
+            }
 
-    } catch (const std::exception& e) {
-        return makeError(500, e.what());
-    }
+            // 4) enrich display_name (a row that cannot be enriched is kept as-is)
+            enrichAllDisplayNames(call, profileId, rows, [call, rows, nextCursor, etag]() {
+                Result r = rawResult(200, writeConversationRows(*rows));
+                r.headers.emplace_back("ETag", etag);
+                if (!nextCursor.empty()) r.headers.emplace_back("X-Next-Cursor", nextCursor);
+                call->complete(std::move(r));
+            });
+        });
+    });
 }
 
-ConversationService::Result ConversationService::deleteConversation(
+void ConversationService::listConversationChanges(
     const std::string& accessToken,
-    const std::string& conversationId
+    const ChangesRequest& changes,
+    Callback done
 ) {
-    try {
-        if (accessToken.empty()) {
-            return makeError(401, "Missing Bearer access token");
-        }
-        if (conversationId.empty()) {
-            return makeError(400, "Missing conversation id");
-        }
-
-        const char* base = std::getenv("SUPABASE_URL");
-        const char* anon = std::getenv("SUPABASE_ANON_KEY");
-        if (!base || !anon) {
-            return makeError(500, "Missing SUPABASE_URL/ANON_KEY");
-        }
-
-        SupabaseEnv env{
-            std::string(base),
-            std::string(anon),
-            accessToken
-        };
-
-        ConversationService::Result err;
-
-        // 1) authUserId
-        std::string authUserId;
-        if (!fetchAuthUserId(env, authUserId, err)) {
-            return err;
-        }
+    if (accessToken.empty()) {
+        return done(makeError(401, "Missing Bearer access token"));
+    }
 
-        // 2) profileId
-        std::string profileId;
-        if (!fetchProfileId(env, authUserId, profileId, err)) {
-            return err;
-        }
+    if (changes.limit < 1 || changes.limit > 500) {
+        return done(makeError(400, "'limit' must be between 1 and 500"));
+    }
 
-        // 3) Check rights (owner/admin)
-        std::string role;
-        if (!checkConversationUpdateRights(env, profileId, conversationId, role, err)) {
-            return err;
+    // since = previous watermark (exact keyset) or a plain timestamp
+    Keyset after;
+    bool timestampOnly = false;
+    if (changes.since.empty()) {
+        return done(makeError(400, "Missing 'since' parameter"));
+    }
+    if (!decodeCursor(changes.since, after)) {
+        if (!looksLikeTimestamp(changes.since)) {
+            return done(makeError(400, "'since' must be an ISO-8601 timestamp or a watermark"));
         }
+        after = Keyset{changes.since, {}};
+        timestampOnly = true;
+    }
 
-        // 4) Soft delete : put deleted_at (and updated_at) to now
-        nlohmann::json payload;
-        const auto ts = nowIsoUtc();
-        payload["deleted_at"] = ts;
-        payload["updated_at"] = ts;
+    auto call = startCall(accessToken, done);
+    if (!call) return;
+    const auto fail = failWith(call);
+    const int limit = changes.limit;
+    const std::string since = changes.since;
 
-        nlohmann::json updated;
-        if (!patchConversationRow(env, conversationId, payload, updated, err)) {
-            return err;
-        }
+    // 1) + 2) profileId
+    resolveCallerProfile(call, fail, [=](const std::string& profileId) {
+        // 3) changed rows after the watermark (+1 row to detect more)
+        fetchConversationChanges(call, profileId, after, timestampOnly, limit, fail, [=](const PagePtr& rows) {
+            const bool hasMore = rows->rows.size() > static_cast<size_t>(limit);
+            if (hasMore) rows->rows.resize(static_cast<size_t>(limit));
 
-        ConversationService::Result r;
-        r.statusCode = 200;
-        r.body = updated;
-        return r;
+            // New watermark = last row returned (unchanged when nothing moved)
+            std::string watermark = since;
+            if (!rows->rows.empty()) {
+                const auto& last = rows->rows.back();
+                if (!last.updatedAt.empty() && !last.id.isNil()) {
+                    watermark = encodeCursor({std::string(last.updatedAt), last.id.str()});
+                }
+            }
 
-    } catch (const std::exception& e) {
-        return makeError(500, e.what());
-    }
+            // 4) enrich display_name like the full list
+            enrichAllDisplayNames(call, profileId, rows, [call, rows, watermark, hasMore]() {
+                std::string body;
+                body.reserve(rows->body.size() + 64 * rows->rows.size() + 128);
+                fastjson::Writer w(body);
+                w.beginObject().key("conversations").beginArray();
+                for (const auto& r : rows->rows) writeConversationRow(w, r);
+                w.endArray()
+                 .field("watermark", watermark)
+                 .field("has_more", hasMore)
+                 .endObject();
+                call->complete(rawResult(200, std::move(body)));
+            });
+        });
+    });
 }
 
-ConversationService::Result ConversationService::addMember(
+void ConversationService::getConversationById(
     const std::string& accessToken,
     const std::string& conversationId,
-    const std::string& userId
+    Callback done
 ) {
-    try {
-        if (accessToken.empty()) {
-            return makeError(401, "Missing Bearer access token");
-        }
-        if (conversationId.empty()) {
-            return makeError(400, "Missing conversation id");
-        }
-        if (userId.empty()) {
-            return makeError(400, "Missing user id");
-        }
-
-        const char* base = std::getenv("SUPABASE_URL");
-        const char* anon = std::getenv("SUPABASE_ANON_KEY");
-        if (!base || !anon) {
-            return makeError(500, "Missing SUPABASE_URL/ANON_KEY");
-        }
-
-        SupabaseEnv env{
-            std::string(base),
-            std::string(anon),
-            accessToken
-        };
+    if (accessToken.empty()) {
+        return done(makeError(401, "Missing Bearer access token"));
+    }
+    if (conversationId.empty()) {
+        return done(makeError(400, "Missing conversation id"));
+    }
 
-        ConversationService::Result err;
+    auto call = startCall(accessToken, done);
+    if (!call) return;
+    const auto fail = failWith(call);
 
-        // 1) authUserId
-        std::string authUserId;
-        if (!fetchAuthUserId(env, authUserId, err)) {
-            return err;
-        }
+    // 1) + 2) profileId
+    resolveCallerProfile(call, fail, [=](const std::string& profileId) {
+        // 3) Conversation if the user is a member
+        fetchConversationById(call, profileId, conversationId, fail, [=](const PagePtr& row) {
+            // 4) enrich display_name
+            enrichDisplayNameIfDirect(call, profileId, row, [call, row]() {
+                std::string body;
+                fastjson::Writer w(body);
+                writeConversationRow(w, row->rows.front());
+                call->complete(rawResult(200, std::move(body)));
+            });
+        });
+    });
+}
 
-        // 2) Caller's profileId
-        std::string profileId;
-        if (!fetchProfileId(env, authUserId, profileId, err)) {
-            return err;
-        }
+void ConversationService::updateConversation(
+    const std::string& accessToken,
+    const std::string& conversationId,
+    const std::optional<std::string>& name,
+    Callback done
+) {
+    if (accessToken.empty()) {
+        return done(makeError(401, "Missing Bearer access token"));
+    }
+    if (conversationId.empty()) {
+        return done(makeError(400, "Missing conversation id"));
+    }
+    if (!name.has_value()) {
+        return done(makeError(400, "Missing 'name' field"));
+    }
 
-        // 3) Check rights (owner/admin)
-        std::string role;
-        if (!checkConversationUpdateRights(env, profileId, conversationId, role, err)) {
-            return err;
-        }
+    auto call = startCall(accessToken, done);
+    if (!call) return;
+    const auto fail = failWith(call);
 
-        // 4) Check that the target profile exists
-        if (!ensureProfileExists(env, userId, err)) {
-            return err;
-        }
+    // 1) + 2) Caller profile
+    resolveCallerProfile(call, fail, [=](const std::string& profileId) {
+        // 3) Vérifier droits (owner/admin)
+        checkConversationUpdateRights(call, profileId, conversationId, fail, [=](MemberRole) {
+            // 4) Lire la conversation pour connaître son type
+            fetchConversationById(call, profileId, conversationId, fail, [=](const PagePtr& convRow) {
+                const auto& row = convRow->rows.front();
+                if (!row.conversation.isObject()) {
+                    return call->complete(makeError(500, "Unexpected conversation read format"));
+                }
 
-        // 5) Insert the member with role 'member'
-        nlohmann::json inserted;
-        if (!insertMemberWithRole(env, conversationId, userId, "member", &inserted, err)) {
-            return err;
-        }
+                if (row.type == ConversationType::None) {
+                    return call->complete(makeError(500, "Conversation type missing"));
+                }
 
-        ConversationService::Result r;
-        r.statusCode = 201;
-        r.body = inserted;
-        return r;
+                if (row.type == ConversationType::Direct) {
+                    // Interdit : cohérence option B (nom dynamique)
+                    return call->complete(makeError(409, "Direct conversations cannot be renamed"));
+                }
 
-    } catch (const std::exception& e) {
-        return makeError(500, e.what());
-    }
+                // 5) Update name (group only)
+                std::string url = call->env.base +
+                    "/rest/v1/conversations?id=eq." + conversationId;
+
+                std::string payload;
+                fastjson::Writer(payload)
+                    .beginObject()
+                    .field("name", *name)
+                    .field("updated_at", nowIsoUtc())   // moves it up in the keyset-ordered list
+                    .endObject();
+
+                callSupabase(call, "updateConversation", "PATCH", url, payload, [call](const SupabaseClient::Response& resp) {
+                    if (!resp.ok) {
+                        return call->complete(makeError(500, "curl perform failed (updateConversation)"));
+                    }
+
+                    if (resp.httpCode != 200) {
+                        return call->complete(upstreamError(resp));
+                    }
+
+                    call->complete(rawResult(200, std::string(parseOrEmptyArray(resp.body).raw)));
+                });
+            });
+        });
+    });
 }
 
-ConversationService::Result ConversationService::listMembers(
+void ConversationService::deleteConversation(
     const std::string& accessToken,
-    const std::string& conversationId
+    const std::string& conversationId,
+    Callback done
 ) {
-    try {
-        if (accessToken.empty()) {
-            return makeError(401, "Missing Bearer access token");
-        }
-        if (conversationId.empty()) {
-            return makeError(400, "Missing conversation id");
-        }
-
-        const char* base = std::getenv("SUPABASE_URL");
-        const char* anon = std::getenv("SUPABASE_ANON_KEY");
-        if (!base || !anon) {
-            return makeError(500, "Missing SUPABASE_URL/ANON_KEY");
-        }
-
-        SupabaseEnv env{
-            std::string(base),
-            std::string(anon),
-            accessToken
-        };
+    if (accessToken.empty()) {
+        return done(makeError(401, "Missing Bearer access token"));
+    }
+    if (conversationId.empty()) {
+        return done(makeError(400, "Missing conversation id"));
+    }
 
-        ConversationService::Result err;
+    auto call = startCall(accessToken, done);
+    if (!call) return;
+    const auto fail = failWith(call);
 
-        // 1) Recover the authenticated user (authUserId)
-        std::string authUserId;
-        if (!fetchAuthUserId(env, authUserId, err)) {
-            return err;
-        }
+    // 1) + 2) profileId
+    resolveCallerProfile(call, fail, [=](const std::string& profileId) {
+        // 3) Check rights (owner/admin)
+        checkConversationUpdateRights(call, profileId, conversationId, fail, [=](MemberRole) {
+            // 4) Soft delete : put deleted_at (and updated_at) to now
+            std::string payload;
+            const auto ts = nowIsoUtc();
+            fastjson::Writer(payload)
+                .beginObject()
+                .field("deleted_at", ts)
+                .field("updated_at", ts)
+                .endObject();
+
+            patchConversationRow(call, conversationId, payload, fail, [call, conversationId](std::string updated) {
+                if (Uuid conversation; Uuid::parse(conversationId, conversation)) {
+                    MembershipCache::instance().invalidateConversation(conversation);
+                }
+                RedisCache::instance().invalidateMembers(conversationId);
+                RealtimeHub::instance().conversationClosed(conversationId,
+                    realtimeEvent("conversation.deleted", conversationId, "conversation", updated));
+                call->complete(rawResult(200, std::move(updated)));
+            });
+        });
+    });
+}
 
-        // 2) Recover the caller's profileId
-        std::string profileId;
-        if (!fetchProfileId(env, authUserId, profileId, err)) {
-            return err;
-        }
+void ConversationService::addMember(
+    const std::string& accessToken,
+    const std::string& conversationId,
+    const std::string& userId,
+    Callback done
+) {
+    if (accessToken.empty()) {
+        return done(makeError(401, "Missing Bearer access token"));
+    }
+    if (conversationId.empty()) {
+        return done(makeError(400, "Missing conversation id"));
+    }
+    if (userId.empty()) {
+        return done(makeError(400, "Missing user id"));
+    }
 
-        // 3) check rights (is member)
-        if (!ensureCanViewConversation(env, profileId, conversationId, err)) {
-            return err;
-        }
+    auto call = startCall(accessToken, done);
+    if (!call) return;
+    const auto fail = failWith(call);
 
-        // 4) Recover the list of active members of the conversation
-        std::string url = env.base +
-            "/rest/v1/conversation_members"
-            "?select=id,conversation_id,user_id,role,joined_at,left_at"
-            "&conversation_id=eq." + conversationId +
-            "&left_at=is.null";
+    // 1) + 2) Caller's profileId
+    resolveCallerProfile(call, fail, [=](const std::string& profileId) {
+        // 3) Check rights (owner/admin)
+        checkConversationUpdateRights(call, profileId, conversationId, fail, [=](MemberRole) {
+            // 4) Check that the target profile exists
+            ensureProfileExists(call, userId, fail, [=]() {
+                Then<const std::string&> added = [=](const std::string& row) {
+                    touchConversation(call, conversationId, [=]() {
+                        membersChanged(conversationId, {userId}, MemberRole::Member);
+                        RealtimeHub::instance().memberJoined(conversationId, userId,
+                            realtimeEvent("member.added", conversationId, "member", row));
+                        call->complete(rawResult(201, row));
+                    });
+                };
+
+                // 5) Back with their previous row if they left, else inserted with role 'member'
+                auto batch = makeMemberBatch({userId});
+                reviveMemberBatch(call, conversationId, batch, fail, [=]() {
+                    const auto& e = batch->front();
+                    if (e.outcome == BatchOutcome::Added) return added(e.row);
+                    insertMemberWithRole(call, conversationId, userId, "member", fail, added);
+                });
+            });
+        });
+    });
+}
 
-        CURL* c = curl_easy_init();
-        if (!c) {
-            return makeError(500, "curl init failed (listMembers)");
-        }
+void ConversationService::addMembers(
+    const std::string& accessToken,
+    const std::string& conversationId,
+    const std::vector<std::string>& userIds,
+    Callback done
+) {
+    if (accessToken.empty()) {
+        return done(makeError(401, "Missing Bearer access token"));
+    }
+    if (conversationId.empty()) {
+        return done(makeError(400, "Missing conversation id"));
+    }
+    if (userIds.empty() || userIds.size() > kMaxBatchMembers) {
+        return done(makeError(400, "Field 'user_ids' must hold 1 to " + std::to_string(kMaxBatchMembers) + " profile ids"));
+    }
 
-        std::string resp;
-        long httpCode = 0;
-        struct curl_slist* h = nullptr;
-        h = curl_slist_append(h, ("apikey: " + env.anonKey).c_str());
-        h = curl_slist_append(h, ("Authorization: Bearer " + env.accessToken).c_str());
-        h = curl_slist_append(h, "Content-Type: application/json");
+    auto call = startCall(accessToken, done);
+    if (!call) return;
+    const auto fail = failWith(call);
+    auto batch = makeMemberBatch(userIds);
 
-        curl_easy_setopt(c, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(c, CURLOPT_HTTPHEADER, h);
-        curl_easy_setopt(c, CURLOPT_HTTPGET, 1L);
-        curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, writeCb);
-        curl_easy_setopt(c, CURLOPT_WRITEDATA, &resp);
+    // 1) + 2) Caller's profileId
+    resolveCallerProfile(call, fail, [=](const std::string& profileId) {
+        // 3) Check rights (owner/admin)
+        checkConversationUpdateRights(call, profileId, conversationId, fail, [=](MemberRole) {
+            // 4) Which ids are profiles, which already are members (one query each)
+            settleMemberBatch(call, conversationId, batch, fail, [=]() {
+                // 5) Members who left come back, one insert for all the others (role 'member')
+                reviveMemberBatch(call, conversationId, batch, fail, [=]() {
+                    insertMemberBatch(call, conversationId, batch, std::string(), fail, [=]() {
+                        Then<> announce = [=]() {
+                            std::vector<std::string> added;
+                            auto& hub = RealtimeHub::instance();
+                            for (const auto& e : *batch) {
+                                if (e.outcome != BatchOutcome::Added) continue;
+                                added.push_back(e.id.str());
+                                hub.memberJoined(conversationId, e.id.str(),
+                                    realtimeEvent("member.added", conversationId, "member",
+                                                  e.row.empty() ? std::string_view("{}") : std::string_view(e.row)));
+                            }
+                            if (!added.empty()) membersChanged(conversationId, added, MemberRole::Member);
+
+                            std::string body;
+                            fastjson::Writer w(body);
+                            w.beginObject().key("results");
+                            writeMemberBatch(w, *batch);
+                            w.endObject();
+                            call->complete(rawResult(200, std::move(body)));
+                        };
+
+                        const bool anyAdded = std::any_of(batch->begin(), batch->end(),
+                            [](const BatchEntry& e) { return e.outcome == BatchOutcome::Added; });
+                        if (!anyAdded) return announce();
+                        touchConversation(call, conversationId, announce);
+                    });
+                });
+            });
+        });
+    });
+}
 
-        auto res = curl_easy_perform(c);
-        curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &httpCode);
-        curl_slist_free_all(h);
-        curl_easy_cleanup(c);
+void ConversationService::listMembers(
+    const std::string& accessToken,
+    const std::string& conversationId,
+    const std::string& ifNoneMatch,
+    Callback done
+) {
+    if (accessToken.empty()) {
+        return done(makeError(401, "Missing Bearer access token"));
+    }
+    if (conversationId.empty()) {
+        return done(makeError(400, "Missing conversation id"));
+    }
 
-        if (res != CURLE_OK) {
-            return makeError(500, "curl perform failed (listMembers)");
-        }
+    auto call = startCall(accessToken, done);
+    if (!call) return;
+    const auto fail = failWith(call);
 
-        if (httpCode != 200) {
-            ConversationService::Result r;
-            r.statusCode = static_cast<int>(httpCode);
-            r.body = resp.empty() ? nlohmann::json::object() : nlohmann::json::parse(resp, nullptr, false);
-            if (r.body.is_discarded()) r.body = nlohmann::json::object();
-            return r;
-        }
+    // 1) + 2) Recover the caller's profileId
+    resolveCallerProfile(call, fail, [=](const std::string& profileId) {
+        // 3) check rights (is member)
+        ensureCanViewConversation(call, profileId, conversationId, fail, [=]() {
+            // 4) Recover the list of active members of the conversation
+            callUpstream(call, "listMembers", [&](auto cb) {
+                ConversationStore::instance().activeMembers(call->env, conversationId, std::move(cb));
+            }, [call, profileId, ifNoneMatch](const SupabaseClient::Response& resp) {
+                if (!resp.ok) {
+                    return call->complete(makeError(500, "curl perform failed (listMembers)"));
+                }
 
-        nlohmann::json j;
-        if (!resp.empty()) {
-            j = nlohmann::json::parse(resp, nullptr, false);
-            if (j.is_discarded()) {
-                j = nlohmann::json::array();
-            }
-        } else {
-            j = nlohmann::json::array();
-        }
+                if (resp.httpCode != 200) {
+                    return call->complete(upstreamError(resp));
+                }
 
-        ConversationService::Result r;
-        r.statusCode = 200;
-        r.body = j;
-        return r;
+                // The member rows are small: hash them as received
+                const auto etag = makeEtag(profileId + "|" + resp.body);
+                if (etagMatches(ifNoneMatch, etag)) {
+                    return call->complete(notModified(etag));
+                }
 
-    } catch (const std::exception& e) {
-        return makeError(500, e.what());
-    }
+                Result r = rawResult(200, std::string(parseOrEmptyArray(resp.body).raw));
+                r.headers.emplace_back("ETag", etag);
+                call->complete(std::move(r));
+            });
+        });
+    });
 }
 
-ConversationService::Result ConversationService::updateMemberRole(
+void ConversationService::updateMemberRole(
     const std::string& accessToken,
     const std::string& conversationId,
     const std::string& userId,
-    const std::string& role
+    const std::string& role,
+    Callback done
 ) {
-    try {
-        if (accessToken.empty()) {
-            return makeError(401, "Missing Bearer access token");
-        }
-        if (conversationId.empty()) {
-            return makeError(400, "Missing conversation id");
-        }
-        if (userId.empty()) {
-            return makeError(400, "Missing user id");
-        }
-        if (role != "owner" && role != "member") {
-            return makeError(400, "Role must be either 'owner' or 'member'");
-        }
-
-        const char* base = std::getenv("SUPABASE_URL");
-        const char* anon = std::getenv("SUPABASE_ANON_KEY");
-        if (!base || !anon) {
-            return makeError(500, "Missing SUPABASE_URL/ANON_KEY");
-        }
-
-        SupabaseEnv env{
-            std::string(base),
-            std::string(anon),
-            accessToken
-        };
-
-        ConversationService::Result err;
-
-        // 1) Recover the authenticated user (authUserId)
-        std::string authUserId;
-        if (!fetchAuthUserId(env, authUserId, err)) {
-            return err;
-        }
+    if (accessToken.empty()) {
+        return done(makeError(401, "Missing Bearer access token"));
+    }
+    if (conversationId.empty()) {
+        return done(makeError(400, "Missing conversation id"));
+    }
+    if (userId.empty()) {
+        return done(makeError(400, "Missing user id"));
+    }
+    if (role != "owner" && role != "member") {
+        return done(makeError(400, "Role must be either 'owner' or 'member'"));
+    }
 
-        // 2) Recover the caller's profileId
-        std::string profileId;
-        if (!fetchProfileId(env, authUserId, profileId, err)) {
-            return err;
-        }
+    auto call = startCall(accessToken, done);
+    if (!call) return;
+    const auto fail = failWith(call);
 
+    // 1) + 2) Recover the caller's profileId
+    resolveCallerProfile(call, fail, [=](const std::string& profileId) {
         // 3) Recover the caller's role
-        std::string callerRole;
-        if (!checkConversationUpdateRights(env, profileId, conversationId, callerRole, err)) {
-            return err;
-        }
-
-        // 4) Check that the target profile exists
-        if (!ensureProfileExists(env, userId, err)) {
-            return err;
-        }
-
-        // 5) Recover the target member's current role + number of owners
-        std::string currentMemberRole;
-        int ownerCount = 0;
-        if (!fetchMemberRoleAndOwnerCount(env, conversationId, userId,
-                                          currentMemberRole, ownerCount, err)) {
-            return err;
-        }
-
-        // 6) Cannot downgrade the last owner to member
-        if (currentMemberRole == "owner" && role == "member" && ownerCount <= 1) {
-            // 409 = Conflict
-            return makeError(409, "Cannot downgrade the last owner of the conversation");
-        }
-
-        // 7) Update the member's role (only if left_at IS NULL)
-        std::string url = env.base +
-            "/rest/v1/conversation_members"
-            "?conversation_id=eq." + conversationId +
-            "&user_id=eq." + userId +
-            "&left_at=is.null";
-
-        nlohmann::json payload;
-        payload["role"] = role;
-        const std::string body = payload.dump();
-
-        CURL* c = curl_easy_init();
-        if (!c) {
-            return makeError(500, "curl init failed (updateMemberRole)");
-        }
+        checkConversationUpdateRights(call, profileId, conversationId, fail, [=](MemberRole) {
+            // 4) Check that the target profile exists
+            ensureProfileExists(call, userId, fail, [=]() {
+                // 5) Recover the target member's current role + number of owners
+                fetchMemberRoleAndOwnerCount(call, conversationId, userId, fail,
+                    [=](MemberRole currentMemberRole, int ownerCount) {
+                        // 6) Cannot downgrade the last owner to member
+                        if (currentMemberRole == MemberRole::Owner && role == "member" && ownerCount <= 1) {
+                            // 409 = Conflict
+                            return call->complete(makeError(409, "Cannot downgrade the last owner of the conversation"));
+                        }
+
+                        // 7) Update the member's role (only if left_at IS NULL)
+                        std::string url = call->env.base +
+                            "/rest/v1/conversation_members"
+                            "?conversation_id=eq." + conversationId +
+                            "&user_id=eq." + userId +
+                            "&left_at=is.null";
+
+                        std::string payload;
+                        fastjson::Writer(payload).beginObject().field("role", role).endObject();
+
+                        callSupabase(call, "updateMemberRole", "PATCH", url, payload, [call, conversationId, userId, role](const SupabaseClient::Response& resp) {
+                            if (!resp.ok) {
+                                return call->complete(makeError(500, "curl perform failed (updateMemberRole)"));
+                            }
+
+                            if (resp.httpCode != 200) {
+                                return call->complete(upstreamError(resp));
+                            }
+
+                            const auto j = parseOrEmptyArray(resp.body);
+
+                            // If nothing was updated → the member does not exist or has already left the conversation
+                            if (isEmptyArray(j)) {
+                                return call->complete(makeError(404, "Member not found in this conversation or already left"));
+                            }
+
+                            membersChanged(conversationId, {userId}, parseMemberRole(role));
+                            RealtimeHub::instance().publish(conversationId,
+                                realtimeEvent("member.updated", conversationId, "member", j.raw));
+                            call->complete(rawResult(200, std::string(j.raw)));
+                        });
+                    });
+            });
+        });
+    });
+}
 
-        std::string resp;
-        long httpCode = 0;
-        struct curl_slist* h = nullptr;
-        h = curl_slist_append(h, ("apikey: " + env.anonKey).c_str());
-        h = curl_slist_append(h, ("Authorization: Bearer " + env.accessToken).c_str());
-        h = curl_slist_append(h, "Content-Type: application/json");
-        h = curl_slist_append(h, "Prefer: return=representation");
+void ConversationService::postMessage(
+    const std::string& accessToken,
+    const std::string& conversationId,
+    const std::string& text,
+    Callback done
+) {
+    if (accessToken.empty()) {
+        return done(makeError(401, "Missing Bearer access token"));
+    }
+    if (conversationId.empty()) {
+        return done(makeError(400, "Missing conversation id"));
+    }
+    if (text.empty()) {
+        return done(makeError(400, "Field 'body' must be a non-empty string"));
+    }
+    if (text.size() > kMaxMessageBytes) {
+        return done(makeError(413, "Message body is too long"));
+    }
 
-        curl_easy_setopt(c, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(c, CURLOPT_HTTPHEADER, h);
-        curl_easy_setopt(c, CURLOPT_CUSTOMREQUEST, "PATCH");
-        curl_easy_setopt(c, CURLOPT_POSTFIELDS, body.c_str());
-        curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, writeCb);
-        curl_easy_setopt(c, CURLOPT_WRITEDATA, &resp);
+    auto call = startCall(accessToken, done);
+    if (!call) return;
+    const auto fail = failWith(call);
 
-        auto res = curl_easy_perform(c);
-        curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &httpCode);
-        curl_slist_free_all(h);
-        curl_easy_cleanup(c);
+    // 1) + 2) Recover the caller's profileId
+    resolveCallerProfile(call, fail, [=](const std::string& profileId) {
+        // 3) check rights (is member)
+        ensureCanViewConversation(call, profileId, conversationId, fail, [=]() {
+            // 4) append to the conversation log; answered once durable
+            MessageLog::instance().append(
+                conversationId,
+                [conversationId, profileId, text](std::uint64_t seq, std::int64_t timestampMs) {
+                    std::string message;
+                    message.reserve(160 + text.size());
+                    fastjson::Writer(message)
+                        .beginObject()
+                        .field("seq", seq)
+                        .field("conversation_id", conversationId)
+                        .field("sender_id", profileId)
+                        .field("body", text)
+                        .field("created_at", isoUtcFromMs(timestampMs))
+                        .endObject();
+                    return message;
+                },
+                replyLoop(),
+                [call, conversationId](const MessageLog::Appended& appended) {
+                    if (!appended.ok) {
+                        return call->complete(makeError(500, appended.error));
+                    }
+                    RealtimeHub::instance().publish(conversationId,
+                        realtimeEvent("message.created", conversationId, "message", appended.payload));
+                    call->complete(rawResult(201, appended.payload));
+                });
+        });
+    });
+}
 
-        if (res != CURLE_OK) {
-            return makeError(500, "curl perform failed (updateMemberRole)");
-        }
+void ConversationService::listMessages(
+    const std::string& accessToken,
+    const std::string& conversationId,
+    const MessagesQuery& query,
+    Callback done
+) {
+    if (accessToken.empty()) {
+        return done(makeError(401, "Missing Bearer access token"));
+    }
+    if (conversationId.empty()) {
+        return done(makeError(400, "Missing conversation id"));
+    }
+    if (query.limit < 1 || query.limit > 500) {
+        return done(makeError(400, "'limit' must be between 1 and 500"));
+    }
+    if (query.after > 0 && query.before > 0) {
+        return done(makeError(400, "Use either 'after' or 'before', not both"));
+    }
 
-        if (httpCode != 200) {
-            ConversationService::Result r;
-            r.statusCode = static_cast<int>(httpCode);
-            r.body = resp.empty()
-                ? nlohmann::json::object()
-                : nlohmann::json::parse(resp, nullptr, false);
-            if (r.body.is_discarded()) r.body = nlohmann::json::object();
-            return r;
-        }
+    auto call = startCall(accessToken, done);
+    if (!call) return;
+    const auto fail = failWith(call);
 
-        nlohmann::json j;
-        if (!resp.empty()) {
-            j = nlohmann::json::parse(resp, nullptr, false);
-            if (j.is_discarded()) {
-                j = nlohmann::json::array();
+    // 1) + 2) Recover the caller's profileId
+    resolveCallerProfile(call, fail, [=](const std::string& profileId) {
+        // 3) check rights (is member)
+        ensureCanViewConversation(call, profileId, conversationId, fail, [=]() {
+            // 4) read the log (mmapped segments, no parsing of the records)
+            auto& log = MessageLog::instance();
+            const auto limit = static_cast<std::size_t>(query.limit);
+            auto page = query.after > 0
+                ? log.readFrom(conversationId, query.after + 1, limit)
+                : log.readBefore(conversationId, query.before, limit);
+
+            if (!page.ok) {
+                return call->complete(makeError(500, page.error.empty() ? "Cannot read messages" : page.error));
             }
-        } else {
-            j = nlohmann::json::array();
-        }
-
-        // If nothing was updated → the member does not exist or has already left the conversation
-        if (j.is_array() && j.empty()) {
-            return makeError(404, "Member not found in this conversation or already left");
-        }
-
-        ConversationService::Result r;
-        r.statusCode = 200;
-        r.body = j;
-        return r;
 
-    } catch (const std::exception& e) {
-        return makeError(500, e.what());
-    }
+            Result r = rawResult(200, joinJsonArray(page.payloads));
+            r.headers.emplace_back("X-Last-Seq", std::to_string(page.lastSeq));
+            call->complete(std::move(r));
+        });
+    });
 }
 
-ConversationService::Result ConversationService::deleteMember(
+void ConversationService::deleteMember(
     const std::string& accessToken,
     const std::string& conversationId,
-    const std::string& userId
+    const std::string& userId,
+    Callback done
 ) {
-    try {
-        if (accessToken.empty()) {
-            return makeError(401, "Missing Bearer access token");
-        }
-        if (conversationId.empty()) {
-            return makeError(400, "Missing conversation id");
-        }
-        if (userId.empty()) {
-            return makeError(400, "Missing user id");
-        }
-
-        const char* base = std::getenv("SUPABASE_URL");
-        const char* anon = std::getenv("SUPABASE_ANON_KEY");
-        if (!base || !anon) {
-            return makeError(500, "Missing SUPABASE_URL/ANON_KEY");
-        }
-
-        SupabaseEnv env{
-            std::string(base),
-            std::string(anon),
-            accessToken
+    if (accessToken.empty()) {
+        return done(makeError(401, "Missing Bearer access token"));
+    }
+    if (conversationId.empty()) {
+        return done(makeError(400, "Missing conversation id"));
+    }
+    if (userId.empty()) {
+        return done(makeError(400, "Missing user id"));
+    }
+
+    auto call = startCall(accessToken, done);
+    if (!call) return;
+    const auto fail = failWith(call);
+
+    // 1) + 2) Recover the caller's profileId
+    resolveCallerProfile(call, fail, [=](const std::string& profileId) {
+        Then<> removeMember = [=]() {
+            // 3) Check that the target profile exists
+            ensureProfileExists(call, userId, fail, [=]() {
+                // 4) Recover the target member's role + owner count (404 if member not found)
+                fetchMemberRoleAndOwnerCount(call, conversationId, userId, fail,
+                    [=](MemberRole memberRole, int ownerCount) {
+                        // 5) Empêcher de supprimer le dernier owner
+                        if (memberRole == MemberRole::Owner && ownerCount <= 1) {
+                            return call->complete(makeError(409, "Cannot remove the last owner of the conversation"));
+                        }
+
+                        // 6) Soft delete : put left_at to now (kept for /conversations/changes)
+                        std::string url = call->env.base +
+                            "/rest/v1/conversation_members"
+                            "?conversation_id=eq." + conversationId +
+                            "&user_id=eq." + userId +
+                            "&left_at=is.null";
+
+                        std::string payload;
+                        fastjson::Writer(payload).beginObject().field("left_at", nowIsoUtc()).endObject();
+
+                        callSupabase(call, "deleteMember", "PATCH", url, payload, [call, conversationId, userId](const SupabaseClient::Response& resp) {
+                            if (!resp.ok) {
+                                return call->complete(makeError(500, "curl perform failed (deleteMember)"));
+                            }
+
+                            if (resp.httpCode != 200 && resp.httpCode != 204) {
+                                return call->complete(upstreamError(resp));
+                            }
+
+                            const auto j = parseOrEmptyArray(resp.body);
+
+                            // Si aucune ligne modifiée → le membre n'était pas (ou plus) dans cette conversation
+                            if (isEmptyArray(j)) {
+                                return call->complete(makeError(404, "Member not found in this conversation"));
+                            }
+
+                            std::string removed(j.raw);
+
+                            touchConversation(call, conversationId, [call, conversationId, userId, removed]() {
+                                membersChanged(conversationId, {userId}, MemberRole::None);
+                                RealtimeHub::instance().memberLeft(conversationId, userId,
+                                    realtimeEvent("member.removed", conversationId, "member", removed));
+                                call->complete(rawResult(200, removed));
+                            });
+                        });
+                    });
+            });
         };
 
-        ConversationService::Result err;
-
-        // 1) Recover the authenticated user (authUserId)
-        std::string authUserId;
-        if (!fetchAuthUserId(env, authUserId, err)) {
-            return err;
-        }
-
-        // 2) Recover the caller's profileId
-        std::string profileId;
-        if (!fetchProfileId(env, authUserId, profileId, err)) {
-            return err;
-        }
-
         const bool isSelf = (profileId == userId);
 
         if (!isSelf) {
             // The caller is removing another member -> they must be owner/admin
-            std::string callerRole;
-            if (!checkConversationUpdateRights(env, profileId, conversationId, callerRole, err)) {
-                return err;
-            }
+            checkConversationUpdateRights(call, profileId, conversationId, fail,
+                                          [removeMember](MemberRole) { removeMember(); });
         } else {
             // The user is removing themselves -> they must at least be a member of the conversation
-            if (!ensureCanViewConversation(env, profileId, conversationId, err)) {
-                return err;
-            }
+            ensureCanViewConversation(call, profileId, conversationId, fail, removeMember);
         }
+    });
+}
 
-        // 3) Check that the target profile exists
-        if (!ensureProfileExists(env, userId, err)) {
-            return err;
-        }
 
-        // 4) Recover the target member's role + owner count
-        std::string memberRole;
-        int ownerCount = 0;
-        if (!fetchMemberRoleAndOwnerCount(env, conversationId, userId,
-                                          memberRole, ownerCount, err)) {
-            return err; // include 404 if member not found
-        }
+void ConversationService::listMyConversationIds(const std::string& accessToken, Callback done) {
+    if (accessToken.empty()) {
+        return done(makeError(401, "Missing Bearer access token"));
+    }
 
-        // 5) Empêcher de supprimer le dernier owner
-        if (memberRole == "owner" && ownerCount <= 1) {
-            return makeError(409, "Cannot remove the last owner of the conversation");
-        }
+    auto call = startCall(accessToken, done);
+    if (!call) return;
+    const auto fail = failWith(call);
 
-        // 6) DELETE on conversation_members (hard delete)
-        std::string url = env.base +
-            "/rest/v1/conversation_members"
-            "?conversation_id=eq." + conversationId +
-            "&user_id=eq." + userId;
+    resolveCallerProfile(call, fail, [=](const std::string& profileId) {
+        fetchMyConversationIds(call, profileId, fail, [=](json ids) {
+            json body;
+            body["profile_id"] = profileId;
+            body["conversation_ids"] = std::move(ids);
+            call->complete({200, std::move(body), {}, {}});
+        });
+    });
+}
 
-        CURL* c = curl_easy_init();
-        if (!c) {
-            return makeError(500, "curl init failed (deleteMember)");
-        }
+// ===================== Synchronous operations =====================
 
-        std::string resp;
-        long httpCode = 0;
-        struct curl_slist* h = nullptr;
-        h = curl_slist_append(h, ("apikey: " + env.anonKey).c_str());
-        h = curl_slist_append(h, ("Authorization: Bearer " + env.accessToken).c_str());
-        h = curl_slist_append(h, "Content-Type: application/json");
-        h = curl_slist_append(h, "Prefer: return=representation");
+ConversationService::Result ConversationService::createConversation(
+    const std::string& accessToken,
+    const std::string& type,
+    const std::optional<std::string>& name,
+    const std::optional<std::string>& targetUserId,
+    const std::vector<std::string>& memberIds
+) {
+    return runBlocking([&](Callback done) {
+        createConversation(accessToken, type, name, targetUserId, memberIds, std::move(done));
+    });
+}
 
-        curl_easy_setopt(c, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(c, CURLOPT_HTTPHEADER, h);
-        curl_easy_setopt(c, CURLOPT_CUSTOMREQUEST, "DELETE");
-        curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, writeCb);
-        curl_easy_setopt(c, CURLOPT_WRITEDATA, &resp);
+ConversationService::Result ConversationService::listMyConversations(
+    const std::string& accessToken,
+    const PageRequest& page
+) {
+    return runBlocking([&](Callback done) {
+        listMyConversations(accessToken, page, std::move(done));
+    });
+}
 
-        auto res = curl_easy_perform(c);
-        curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &httpCode);
-        curl_slist_free_all(h);
-        curl_easy_cleanup(c);
+ConversationService::Result ConversationService::listConversationChanges(
+    const std::string& accessToken,
+    const ChangesRequest& changes
+) {
+    return runBlocking([&](Callback done) {
+        listConversationChanges(accessToken, changes, std::move(done));
+    });
+}
 
-        if (res != CURLE_OK) {
-            return makeError(500, "curl perform failed (deleteMember)");
-        }
+ConversationService::Result ConversationService::getConversationById(
+    const std::string& accessToken,
+    const std::string& conversationId
+) {
+    return runBlocking([&](Callback done) {
+        getConversationById(accessToken, conversationId, std::move(done));
+    });
+}
 
-        if (httpCode != 200 && httpCode != 204) {
-            ConversationService::Result r;
-            r.statusCode = static_cast<int>(httpCode);
-            r.body = resp.empty()
-                ? nlohmann::json::object()
-                : nlohmann::json::parse(resp, nullptr, false);
-            if (r.body.is_discarded()) r.body = nlohmann::json::object();
-            return r;
-        }
+ConversationService::Result ConversationService::updateConversation(
+    const std::string& accessToken,
+    const std::string& conversationId,
+    const std::optional<std::string>& name
+) {
+    return runBlocking([&](Callback done) {
+        updateConversation(accessToken, conversationId, name, std::move(done));
+    });
+}
 
-        nlohmann::json j;
-        if (!resp.empty()) {
-            j = nlohmann::json::parse(resp, nullptr, false);
-            if (j.is_discarded()) {
-                j = nlohmann::json::array();
-            }
-        } else {
-            j = nlohmann::json::array();
-        }
+ConversationService::Result ConversationService::deleteConversation(
+    const std::string& accessToken,
+    const std::string& conversationId
+) {
+    return runBlocking([&](Callback done) {
+        deleteConversation(accessToken, conversationId, std::move(done));
+    });
+}
 
-        // Si aucune ligne supprimée → le membre n'était pas dans cette conversation
-        if (j.is_array() && j.empty()) {
-            return makeError(404, "Member not found in this conversation");
-        }
+ConversationService::Result ConversationService::addMember(
+    const std::string& accessToken,
+    const std::string& conversationId,
+    const std::string& userId
+) {
+    return runBlocking([&](Callback done) {
+        addMember(accessToken, conversationId, userId, std::move(done));
+    });
+}
 
-        ConversationService::Result r;
-        r.statusCode = 200;
-        r.body = j;
-        return r;
+ConversationService::Result ConversationService::addMembers(
+    const std::string& accessToken,
+    const std::string& conversationId,
+    const std::vector<std::string>& userIds
+) {
+    return runBlocking([&](Callback done) {
+        addMembers(accessToken, conversationId, userIds, std::move(done));
+    });
+}
 
-    } catch (const std::exception& e) {
-        return makeError(500, e.what());
-    }
-}
\ No newline at end of file
+ConversationService::Result ConversationService::listMembers(
+    const std::string& accessToken,
+    const std::string& conversationId,
+    const std::string& ifNoneMatch
+) {
+    return runBlocking([&](Callback done) {
+        listMembers(accessToken, conversationId, ifNoneMatch, std::move(done));
+    });
+}
+
+ConversationService::Result ConversationService::updateMemberRole(
+    const std::string& accessToken,
+    const std::string& conversationId,
+    const std::string& userId,
+    const std::string& role
+) {
+    return runBlocking([&](Callback done) {
+        updateMemberRole(accessToken, conversationId, userId, role, std::move(done));
+    });
+}
+
+ConversationService::Result ConversationService::deleteMember(
+    const std::string& accessToken,
+    const std::string& conversationId,
+    const std::string& userId
+) {
+    return runBlocking([&](Callback done) {
+        deleteMember(accessToken, conversationId, userId, std::move(done));
+    });
+}
+
+ConversationService::Result ConversationService::postMessage(
+    const std::string& accessToken,
+    const std::string& conversationId,
+    const std::string& text
+) {
+    return runBlocking([&](Callback done) {
+        postMessage(accessToken, conversationId, text, std::move(done));
+    });
+}
+
+ConversationService::Result ConversationService::listMessages(
+    const std::string& accessToken,
+    const std::string& conversationId,
+    const MessagesQuery& query
+) {
+    return runBlocking([&](Callback done) {
+        listMessages(accessToken, conversationId, query, std::move(done));
+    });
+}
+
+ConversationService::Result ConversationService::listMyConversationIds(const std::string& accessToken) {
+    return runBlocking([&](Callback done) {
+        listMyConversationIds(accessToken, std::move(done));
+    });
+}
@@ -0,0 +1,36 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/ConversationStore.h"
+#include "../include/PostgrestStore.h"
+#ifdef MESSAGING_WITH_LIBPQ
+#include "../include/PgStore.h"
+#endif
+
+#include <trantor/utils/Logger.h>
+
+#include <cstdlib>
+#include <string>
+
+ConversationStore& ConversationStore::instance() {
+    // Never destroyed: the Postgres workers keep running until exit
+    static ConversationStore* store = []() -> ConversationStore* {
+        const char* kind = std::getenv("CONVERSATION_STORE");
+        const std::string v = kind ? kind : "";
+
+        if (v == "postgres") {
+#ifdef MESSAGING_WITH_LIBPQ
+            return new PgStore();
+#else
+            LOG_WARN << "CONVERSATION_STORE=postgres but this build has no libpq, using PostgREST";
+#endif
+        } else if (!v.empty() && v != "postgrest") {
+            LOG_WARN << "Ignoring unknown CONVERSATION_STORE " << v << ", using PostgREST";
+        }
+
+        LOG_INFO << "Conversation store: postgrest";
+        return new PostgrestStore();
+    }();
+    return *store;
+}
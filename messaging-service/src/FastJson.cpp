@@ -0,0 +1,385 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/FastJson.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace fastjson {
+
+namespace {
+
+constexpr int kMaxDepth = 64;
+
+bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// ---------- Helper 1 : scanners (validate and return the end, nullptr on error) ----------
+const char* skipString(const char* p, const char* end) {
+    ++p;   // opening quote
+    while (p < end) {
+        const auto c = static_cast<unsigned char>(*p);
+        if (c == '"') return p + 1;
+        if (c < 0x20) return nullptr;
+        if (c != '\\') { ++p; continue; }
+
+        if (++p >= end) return nullptr;
+        switch (*p) {
+            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                ++p;
+                break;
+            case 'u':
+                if (end - p < 5) return nullptr;
+                for (int i = 1; i <= 4; ++i) {
+                    if (hexValue(p[i]) < 0) return nullptr;
+                }
+                p += 5;
+                break;
+            default:
+                return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+const char* skipNumber(const char* p, const char* end) {
+    if (p < end && *p == '-') ++p;
+    if (p >= end) return nullptr;
+    if (*p == '0') {
+        ++p;
+    } else if (isDigit(*p)) {
+        while (p < end && isDigit(*p)) ++p;
+    } else {
+        return nullptr;
+    }
+    if (p < end && *p == '.') {
+        ++p;
+        if (p >= end || !isDigit(*p)) return nullptr;
+        while (p < end && isDigit(*p)) ++p;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        if (p < end && (*p == '+' || *p == '-')) ++p;
+        if (p >= end || !isDigit(*p)) return nullptr;
+        while (p < end && isDigit(*p)) ++p;
+    }
+    return p;
+}
+
+const char* skipLiteral(const char* p, const char* end, const char* word) {
+    const std::size_t n = std::strlen(word);
+    if (static_cast<std::size_t>(end - p) < n || std::memcmp(p, word, n) != 0) return nullptr;
+    return p + n;
+}
+
+// ---------- Helper 2 : UTF-8 for \uXXXX escapes ----------
+void appendUtf8(std::string& out, unsigned cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+unsigned readHex4(const char* p) {
+    unsigned v = 0;
+    for (int i = 0; i < 4; ++i) v = (v << 4) | static_cast<unsigned>(hexValue(p[i]));
+    return v;
+}
+
+// Inner text of a validated string -> decoded bytes
+void decodeInto(std::string_view inner, std::string& out) {
+    out.clear();
+    out.reserve(inner.size());
+    const char* p = inner.data();
+    const char* end = p + inner.size();
+    while (p < end) {
+        if (*p != '\\') { out.push_back(*p++); continue; }
+        ++p;
+        switch (*p) {
+            case 'b': out.push_back('\b'); ++p; break;
+            case 'f': out.push_back('\f'); ++p; break;
+            case 'n': out.push_back('\n'); ++p; break;
+            case 'r': out.push_back('\r'); ++p; break;
+            case 't': out.push_back('\t'); ++p; break;
+            case 'u': {
+                unsigned cp = readHex4(p + 1);
+                p += 5;
+                // Surrogate pair
+                if (cp >= 0xD800 && cp <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                    const unsigned low = readHex4(p + 2);
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        p += 6;
+                    }
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default: out.push_back(*p++); break;   // " \ /
+        }
+    }
+}
+
+} // namespace
+
+namespace detail {
+
+const char* skipSpace(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) ++p;
+    return p;
+}
+
+const char* skipValue(const char* p, const char* end, Type& type, int depth) {
+    type = Type::Invalid;
+    p = skipSpace(p, end);
+    if (p >= end) return nullptr;
+
+    switch (*p) {
+        case '"':
+            type = Type::String;
+            return skipString(p, end);
+        case 't':
+            type = Type::Bool;
+            return skipLiteral(p, end, "true");
+        case 'f':
+            type = Type::Bool;
+            return skipLiteral(p, end, "false");
+        case 'n':
+            type = Type::Null;
+            return skipLiteral(p, end, "null");
+        case '{': {
+            if (depth >= kMaxDepth) return nullptr;
+            p = skipSpace(p + 1, end);
+            if (p < end && *p == '}') { type = Type::Object; return p + 1; }
+            while (p < end) {
+                Type t;
+                if (*p != '"') return nullptr;
+                p = skipString(p, end);
+                if (!p) return nullptr;
+                p = skipSpace(p, end);
+                if (p >= end || *p != ':') return nullptr;
+                p = skipValue(p + 1, end, t, depth + 1);
+                if (!p) return nullptr;
+                p = skipSpace(p, end);
+                if (p >= end) return nullptr;
+                if (*p == '}') { type = Type::Object; return p + 1; }
+                if (*p != ',') return nullptr;
+                p = skipSpace(p + 1, end);
+            }
+            return nullptr;
+        }
+        case '[': {
+            if (depth >= kMaxDepth) return nullptr;
+            p = skipSpace(p + 1, end);
+            if (p < end && *p == ']') { type = Type::Array; return p + 1; }
+            while (p < end) {
+                Type t;
+                p = skipValue(p, end, t, depth + 1);
+                if (!p) return nullptr;
+                p = skipSpace(p, end);
+                if (p >= end) return nullptr;
+                if (*p == ']') { type = Type::Array; return p + 1; }
+                if (*p != ',') return nullptr;
+                ++p;
+            }
+            return nullptr;
+        }
+        default:
+            type = Type::Number;
+            return skipNumber(p, end);
+    }
+}
+
+// Already validated: a string ends at the first unescaped quote, a container
+// at the bracket that brings the depth back to zero.
+const char* skipParsed(const char* p, const char* end, Type& type) {
+    auto skipStringBody = [end](const char* q) {
+        while (q < end) {
+            const char* quote = static_cast<const char*>(std::memchr(q, '"', static_cast<std::size_t>(end - q)));
+            if (!quote) return end;
+            // Escaped when preceded by an odd number of backslashes
+            const char* b = quote;
+            while (b > q && b[-1] == '\\') --b;
+            if (((quote - b) & 1) == 0) return quote + 1;
+            q = quote + 1;
+        }
+        return end;
+    };
+
+    switch (*p) {
+        case '"':
+            type = Type::String;
+            return skipStringBody(p + 1);
+        case '{':
+        case '[': {
+            type = *p == '{' ? Type::Object : Type::Array;
+            int depth = 0;
+            for (; p < end; ++p) {
+                switch (*p) {
+                    case '"': p = skipStringBody(p + 1) - 1; break;
+                    case '{': case '[': ++depth; break;
+                    case '}': case ']':
+                        if (--depth == 0) return p + 1;
+                        break;
+                    default: break;
+                }
+            }
+            return end;
+        }
+        case 't': type = Type::Bool; return p + 4;
+        case 'f': type = Type::Bool; return p + 5;
+        case 'n': type = Type::Null; return p + 4;
+        default:
+            type = Type::Number;
+            while (p < end && *p != ',' && *p != '}' && *p != ']' && !isSpace(*p)) ++p;
+            return p;
+    }
+}
+
+} // namespace detail
+
+bool parse(std::string_view text, Value& out) {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    const char* start = detail::skipSpace(begin, end);
+
+    Type type;
+    const char* stop = detail::skipValue(start, end, type, 0);
+    if (!stop || detail::skipSpace(stop, end) != end) {
+        out = Value{};
+        return false;
+    }
+    out.type = type;
+    out.raw = std::string_view(start, static_cast<std::size_t>(stop - start));
+    return true;
+}
+
+std::string_view Value::str(std::string& scratch) const {
+    if (type != Type::String) return {};
+    const std::string_view inner = raw.substr(1, raw.size() - 2);
+    if (inner.find('\\') == std::string_view::npos) return inner;
+    decodeInto(inner, scratch);
+    return scratch;
+}
+
+std::string Value::string() const {
+    std::string scratch;
+    const auto s = str(scratch);
+    return s.data() == scratch.data() ? std::move(scratch) : std::string(s);
+}
+
+bool Value::asBool(bool& out) const {
+    if (type != Type::Bool) return false;
+    out = raw == "true";
+    return true;
+}
+
+bool Value::asInt64(std::int64_t& out) const {
+    if (type != Type::Number) return false;
+    const auto res = std::from_chars(raw.data(), raw.data() + raw.size(), out);
+    return res.ec == std::errc() && res.ptr == raw.data() + raw.size();
+}
+
+Value member(const Value& object, std::string_view key) {
+    Value found;
+    forEachMember(object, [&](std::string_view k, const Value& v) {
+        if (k != key) return true;
+        found = v;
+        return false;
+    });
+    return found;
+}
+
+Value firstRow(const Value& value) {
+    if (value.type == Type::Object) return value;
+    Value found;
+    forEachElement(value, [&](const Value& v) {
+        found = v;
+        return false;
+    });
+    return found;
+}
+
+void appendQuoted(std::string& out, std::string_view s) {
+    static const char* hex = "0123456789abcdef";
+    out.push_back('"');
+    const char* run = s.data();
+    const char* end = s.data() + s.size();
+    for (const char* p = run; p < end; ++p) {
+        const auto c = static_cast<unsigned char>(*p);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        out.append(run, static_cast<std::size_t>(p - run));
+        run = p + 1;
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            default:
+                out += "\\u00";
+                out.push_back(hex[c >> 4]);
+                out.push_back(hex[c & 0x0F]);
+        }
+    }
+    out.append(run, static_cast<std::size_t>(end - run));
+    out.push_back('"');
+}
+
+Writer& Writer::key(std::string_view k) {
+    separate();
+    appendQuoted(out_, k);
+    out_.push_back(':');
+    afterKey_ = true;
+    return *this;
+}
+
+Writer& Writer::rawKey(std::string_view k) {
+    separate();
+    out_.push_back('"');
+    out_.append(k.data(), k.size());
+    out_ += "\":";
+    afterKey_ = true;
+    return *this;
+}
+
+Writer& Writer::number(std::int64_t v) {
+    separate();
+    char buf[24];
+    const auto res = std::to_chars(buf, buf + sizeof(buf), v);
+    out_.append(buf, static_cast<std::size_t>(res.ptr - buf));
+    return *this;
+}
+
+Writer& Writer::number(std::uint64_t v) {
+    separate();
+    char buf[24];
+    const auto res = std::to_chars(buf, buf + sizeof(buf), v);
+    out_.append(buf, static_cast<std::size_t>(res.ptr - buf));
+    return *this;
+}
+
+} // namespace fastjson
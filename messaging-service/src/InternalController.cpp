@@ -0,0 +1,82 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/InternalController.h"
+#include "../include/ProfileIdCache.h"
+#include "../include/RedisCache.h"
+
+#include <openssl/crypto.h>
+#include <json/json.h>
+#include <cstdlib>
+#include <string>
+
+using namespace drogon;
+
+namespace {
+
+HttpResponsePtr makeJsonError(HttpStatusCode code, const std::string& msg) {
+    Json::Value j;
+    j["error"] = msg;
+    auto r = HttpResponse::newHttpJsonResponse(j);
+    r->setStatusCode(code);
+    return r;
+}
+
+// Constant-time compare of X-Internal-Token with INTERNAL_API_TOKEN
+bool isTrustedCaller(const HttpRequestPtr& req) {
+    const char* expected = std::getenv("INTERNAL_API_TOKEN");
+    if (!expected || !*expected) return false;
+
+    const auto& given = req->getHeader("x-internal-token");
+    const std::string secret(expected);
+    return given.size() == secret.size() &&
+           CRYPTO_memcmp(given.data(), secret.data(), secret.size()) == 0;
+}
+
+} // namespace
+
+void InternalController::invalidateProfile(
+    const drogon::HttpRequestPtr& req,
+    std::function<void (const drogon::HttpResponsePtr &)> &&cb) const {
+
+    if (!isTrustedCaller(req)) {
+        return cb(makeJsonError(k403Forbidden, "Forbidden"));
+    }
+
+    const auto body = req->getJsonObject();
+    if (!body || !body->isMember("auth_id") || !(*body)["auth_id"].isString()) {
+        return cb(makeJsonError(k400BadRequest, "Field 'auth_id' is required"));
+    }
+
+    // Local copy, shared Redis entry, then the other replicas' local copies
+    const auto authId = (*body)["auth_id"].asString();
+    ProfileIdCache::instance().invalidate(authId);
+    RedisCache::instance().invalidateProfile(authId);
+
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setStatusCode(k204NoContent);
+    return cb(resp);
+}
+
+void InternalController::cacheStats(
+    const drogon::HttpRequestPtr& req,
+    std::function<void (const drogon::HttpResponsePtr &)> &&cb) const {
+
+    if (!isTrustedCaller(req)) {
+        return cb(makeJsonError(k403Forbidden, "Forbidden"));
+    }
+
+    const auto s = ProfileIdCache::instance().stats();
+
+    Json::Value profiles;
+    profiles["hits"] = static_cast<Json::UInt64>(s.hits);
+    profiles["misses"] = static_cast<Json::UInt64>(s.misses);
+    profiles["evictions"] = static_cast<Json::UInt64>(s.evictions);
+    profiles["invalidations"] = static_cast<Json::UInt64>(s.invalidations);
+    profiles["size"] = static_cast<Json::UInt64>(s.size);
+
+    Json::Value j;
+    j["profile_ids"] = profiles;
+    return cb(HttpResponse::newHttpJsonResponse(j));
+}
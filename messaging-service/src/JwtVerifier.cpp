@@ -0,0 +1,446 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/JwtVerifier.h"
+#include "../include/SupabaseClient.h"
+
+#include <nlohmann/json.hpp>
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/ec.h>
+#include <openssl/hmac.h>
+#include <openssl/param_build.h>
+#include <openssl/sha.h>
+#include <trantor/utils/Logger.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using nlohmann::json;
+
+namespace {
+
+// Clock skew tolerated on nbf only: a token is never accepted past its exp
+constexpr std::int64_t kLeewaySeconds = 30;
+
+// Audience of the user sessions GoTrue issues
+constexpr const char* kAudience = "authenticated";
+
+// ---------- Helper 1 : base64url (no padding) ----------
+bool base64UrlDecode(const std::string& in, std::string& out) {
+    static const auto table = [] {
+        std::vector<int> t(256, -1);
+        const std::string alphabet =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+        for (size_t i = 0; i < alphabet.size(); ++i) t[static_cast<unsigned char>(alphabet[i])] = static_cast<int>(i);
+        t['+'] = 62;    // tolerate plain base64 in JWKS files
+        t['/'] = 63;
+        return t;
+    }();
+
+    out.clear();
+    out.reserve(in.size() * 3 / 4);
+    unsigned int buffer = 0;
+    int bits = 0;
+    for (unsigned char c : in) {
+        if (c == '=') break;
+        const int v = table[c];
+        if (v < 0) return false;
+        buffer = (buffer << 6) | static_cast<unsigned int>(v);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<char>((buffer >> bits) & 0xFF));
+        }
+    }
+    return true;
+}
+
+std::string sha256(const std::string& data) {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(data.data()), data.size(), digest);
+    return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+std::int64_t nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// ---------- Helper 2 : split "header.payload.signature" ----------
+struct JwtParts {
+    std::string signingInput;   // "header.payload" as received
+    json header;
+    json payload;
+    std::string signature;      // raw bytes
+};
+
+bool splitJwt(const std::string& token, JwtParts& parts) {
+    const auto dot1 = token.find('.');
+    if (dot1 == std::string::npos) return false;
+    const auto dot2 = token.find('.', dot1 + 1);
+    if (dot2 == std::string::npos || token.find('.', dot2 + 1) != std::string::npos) return false;
+
+    std::string header, payload;
+    if (!base64UrlDecode(token.substr(0, dot1), header)) return false;
+    if (!base64UrlDecode(token.substr(dot1 + 1, dot2 - dot1 - 1), payload)) return false;
+    if (!base64UrlDecode(token.substr(dot2 + 1), parts.signature)) return false;
+
+    parts.header = json::parse(header, nullptr, false);
+    parts.payload = json::parse(payload, nullptr, false);
+    if (!parts.header.is_object() || !parts.payload.is_object()) return false;
+
+    parts.signingInput = token.substr(0, dot2);
+    return true;
+}
+
+// ---------- Helper 3 : public keys from JWK members ----------
+EVP_PKEY* pkeyFromParams(const char* type, OSSL_PARAM_BLD* bld) {
+    EVP_PKEY* pkey = nullptr;
+    OSSL_PARAM* params = OSSL_PARAM_BLD_to_param(bld);
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_from_name(nullptr, type, nullptr);
+    if (params && ctx && EVP_PKEY_fromdata_init(ctx) > 0) {
+        EVP_PKEY_fromdata(ctx, &pkey, EVP_PKEY_PUBLIC_KEY, params);
+    }
+    EVP_PKEY_CTX_free(ctx);
+    OSSL_PARAM_free(params);
+    return pkey;
+}
+
+EVP_PKEY* rsaKeyFromJwk(const json& jwk) {
+    std::string n, e;
+    if (!base64UrlDecode(jwk.value("n", ""), n) || !base64UrlDecode(jwk.value("e", ""), e)) return nullptr;
+    if (n.empty() || e.empty()) return nullptr;
+
+    BIGNUM* bn = BN_bin2bn(reinterpret_cast<const unsigned char*>(n.data()), static_cast<int>(n.size()), nullptr);
+    BIGNUM* be = BN_bin2bn(reinterpret_cast<const unsigned char*>(e.data()), static_cast<int>(e.size()), nullptr);
+    OSSL_PARAM_BLD* bld = OSSL_PARAM_BLD_new();
+
+    EVP_PKEY* pkey = nullptr;
+    if (bn && be && bld &&
+        OSSL_PARAM_BLD_push_BN(bld, OSSL_PKEY_PARAM_RSA_N, bn) &&
+        OSSL_PARAM_BLD_push_BN(bld, OSSL_PKEY_PARAM_RSA_E, be)) {
+        pkey = pkeyFromParams("RSA", bld);
+    }
+    OSSL_PARAM_BLD_free(bld);
+    BN_free(bn);
+    BN_free(be);
+    return pkey;
+}
+
+EVP_PKEY* ecKeyFromJwk(const json& jwk) {
+    if (jwk.value("crv", "") != "P-256") return nullptr;
+
+    std::string x, y;
+    if (!base64UrlDecode(jwk.value("x", ""), x) || !base64UrlDecode(jwk.value("y", ""), y)) return nullptr;
+    if (x.size() != 32 || y.size() != 32) return nullptr;
+
+    // Uncompressed point: 0x04 || X || Y
+    std::string point = std::string(1, '\x04') + x + y;
+
+    OSSL_PARAM_BLD* bld = OSSL_PARAM_BLD_new();
+    EVP_PKEY* pkey = nullptr;
+    if (bld &&
+        OSSL_PARAM_BLD_push_utf8_string(bld, OSSL_PKEY_PARAM_GROUP_NAME, "prime256v1", 0) &&
+        OSSL_PARAM_BLD_push_octet_string(bld, OSSL_PKEY_PARAM_PUB_KEY, point.data(), point.size())) {
+        pkey = pkeyFromParams("EC", bld);
+    }
+    OSSL_PARAM_BLD_free(bld);
+    return pkey;
+}
+
+// JWS ES256 signatures are raw r||s, OpenSSL wants DER
+bool es256SignatureToDer(const std::string& raw, std::string& der) {
+    if (raw.size() != 64) return false;
+
+    ECDSA_SIG* sig = ECDSA_SIG_new();
+    BIGNUM* r = BN_bin2bn(reinterpret_cast<const unsigned char*>(raw.data()), 32, nullptr);
+    BIGNUM* s = BN_bin2bn(reinterpret_cast<const unsigned char*>(raw.data()) + 32, 32, nullptr);
+    if (!sig || !r || !s || !ECDSA_SIG_set0(sig, r, s)) {
+        BN_free(r);
+        BN_free(s);
+        ECDSA_SIG_free(sig);
+        return false;
+    }
+
+    const int len = i2d_ECDSA_SIG(sig, nullptr);
+    der.assign(len > 0 ? static_cast<size_t>(len) : 0, '\0');
+    auto* p = reinterpret_cast<unsigned char*>(&der[0]);
+    const bool ok = len > 0 && i2d_ECDSA_SIG(sig, &p) == len;
+    ECDSA_SIG_free(sig);   // owns r and s
+    return ok;
+}
+
+// ---------- Helper 4 : signature checks ----------
+bool verifyHs256(const std::string& secret, const JwtParts& parts) {
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    unsigned int macLen = 0;
+    HMAC(EVP_sha256(),
+         secret.data(), static_cast<int>(secret.size()),
+         reinterpret_cast<const unsigned char*>(parts.signingInput.data()), parts.signingInput.size(),
+         mac, &macLen);
+
+    return macLen == parts.signature.size() &&
+           CRYPTO_memcmp(mac, parts.signature.data(), macLen) == 0;
+}
+
+bool verifyAsymmetric(EVP_PKEY* key, const std::string& signature, const JwtParts& parts) {
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    if (!ctx) return false;
+
+    const bool ok =
+        EVP_DigestVerifyInit(ctx, nullptr, EVP_sha256(), nullptr, key) == 1 &&
+        EVP_DigestVerify(ctx,
+                         reinterpret_cast<const unsigned char*>(signature.data()), signature.size(),
+                         reinterpret_cast<const unsigned char*>(parts.signingInput.data()),
+                         parts.signingInput.size()) == 1;
+    EVP_MD_CTX_free(ctx);
+    return ok;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return {};
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+JwtVerifier::Verdict rejected(const std::string& why) {
+    JwtVerifier::Verdict v;
+    v.outcome = JwtVerifier::Outcome::Rejected;
+    v.error = "Invalid access token: " + why;
+    return v;
+}
+
+} // namespace
+
+JwtVerifier& JwtVerifier::instance() {
+    static JwtVerifier verifier;
+    return verifier;
+}
+
+JwtVerifier::JwtVerifier() {
+    if (const char* secret = std::getenv("SUPABASE_JWT_SECRET")) {
+        hsSecret_ = secret;
+    }
+
+    if (const char* path = std::getenv("SUPABASE_JWKS_FILE")) {
+        const auto doc = readFile(path);
+        if (doc.empty()) {
+            LOG_WARN << "Cannot read SUPABASE_JWKS_FILE " << path;
+        } else {
+            loadJwks(doc);
+        }
+    }
+
+    if (const char* url = std::getenv("SUPABASE_JWKS_URL")) {
+        // Called once from main() before the IO loops start, so blocking is fine
+        SupabaseClient::Request req;
+        req.url = url;
+        if (const char* anon = std::getenv("SUPABASE_ANON_KEY")) {
+            req.apiKey = anon;
+            req.bearer = anon;
+        }
+        auto resp = SupabaseClient::instance().perform(req);
+        if (!resp.ok || resp.httpCode != 200) {
+            LOG_WARN << "Cannot fetch SUPABASE_JWKS_URL " << url << " (" << resp.httpCode << " " << resp.error << ")";
+        } else {
+            loadJwks(resp.body);
+        }
+    }
+
+    if (const char* flag = std::getenv("JWT_REMOTE_FALLBACK")) {
+        const std::string v(flag);
+        remoteFallback_ = !(v == "0" || v == "false" || v == "off");
+    }
+
+    if (const char* size = std::getenv("JWT_CACHE_SIZE")) {
+        try {
+            capacity_ = static_cast<std::size_t>(std::stoul(size));
+        } catch (const std::exception&) {
+            LOG_WARN << "Ignoring invalid JWT_CACHE_SIZE " << size;
+        }
+    }
+
+    LOG_INFO << "JWT verification: HS256 " << (hsSecret_.empty() ? "off" : "on")
+             << ", " << keys_.size() << " JWKS key(s), remote fallback "
+             << (remoteFallback_ ? "on" : "off");
+}
+
+void JwtVerifier::loadJwks(const std::string& document) {
+    auto doc = json::parse(document, nullptr, false);
+    if (!doc.is_object() || !doc.contains("keys") || !doc["keys"].is_array()) {
+        LOG_WARN << "Ignoring malformed JWKS document";
+        return;
+    }
+
+    for (const auto& jwk : doc["keys"]) {
+        if (!jwk.is_object()) continue;
+
+        const std::string kty = jwk.value("kty", "");
+        EVP_PKEY* raw = nullptr;
+        if (kty == "RSA") raw = rsaKeyFromJwk(jwk);
+        else if (kty == "EC") raw = ecKeyFromJwk(jwk);
+
+        if (!raw) {
+            LOG_WARN << "Skipping unsupported JWK (kty=" << kty << ")";
+            continue;
+        }
+        keys_[jwk.value("kid", "")] = PKey(raw, EVP_PKEY_free);
+    }
+}
+
+JwtVerifier::PKey JwtVerifier::keyFor(const std::string& kid, const std::string& alg) const {
+    PKey key;
+    auto it = keys_.find(kid);
+    if (it != keys_.end()) {
+        key = it->second;
+    } else if (kid.empty() && keys_.size() == 1) {
+        key = keys_.begin()->second;
+    }
+    if (!key) return nullptr;
+
+    const int wanted = (alg == "RS256") ? EVP_PKEY_RSA : EVP_PKEY_EC;
+    return EVP_PKEY_get_base_id(key.get()) == wanted ? key : nullptr;
+}
+
+JwtVerifier::Verdict JwtVerifier::verify(const std::string& token) {
+    Verdict out;
+    const std::string cacheKey = sha256(token);
+
+    if (lookup(cacheKey, out.claims)) {
+        out.outcome = Outcome::Valid;
+        return out;
+    }
+
+    JwtParts parts;
+    if (!splitJwt(token, parts)) {
+        return rejected("malformed JWT");
+    }
+
+    const std::string alg = parts.header.value("alg", "");
+    const std::string kid = parts.header.value("kid", "");
+
+    // 1) Signature
+    bool checked = false;
+    if (alg == "HS256" && !hsSecret_.empty()) {
+        if (!verifyHs256(hsSecret_, parts)) return rejected("bad signature");
+        checked = true;
+    } else if (alg == "RS256" || alg == "ES256") {
+        if (auto key = keyFor(kid, alg)) {
+            std::string signature = parts.signature;
+            if (alg == "ES256" && !es256SignatureToDer(parts.signature, signature)) {
+                return rejected("bad signature");
+            }
+            if (!verifyAsymmetric(key.get(), signature, parts)) return rejected("bad signature");
+            checked = true;
+        }
+    } else if (alg != "HS256") {
+        return rejected("unsupported alg " + alg);
+    }
+
+    if (!checked) {
+        // No key for this token (secret not configured, unknown kid...)
+        if (remoteFallback_) {
+            out.outcome = Outcome::Remote;
+            return out;
+        }
+        return rejected("no key to verify it");
+    }
+
+    // 2) Claims
+    const auto& p = parts.payload;
+    if (!p.contains("exp") || !p["exp"].is_number()) return rejected("missing exp");
+    if (!p.contains("sub") || !p["sub"].is_string()) return rejected("missing sub");
+
+    const std::int64_t now = nowSeconds();
+    out.claims.exp = p["exp"].get<std::int64_t>();
+    if (out.claims.exp <= now) return rejected("token expired");
+    if (p.contains("nbf") && p["nbf"].is_number() &&
+        p["nbf"].get<std::int64_t>() - kLeewaySeconds > now) {
+        return rejected("token not yet valid");
+    }
+
+    // Signed with the project key but meant for another audience (service
+    // roles, custom tokens): not a user session
+    const auto aud = p.find("aud");
+    const bool forUsers = aud != p.end() &&
+        ((aud->is_string() && aud->get<std::string>() == kAudience) ||
+         (aud->is_array() && std::any_of(aud->begin(), aud->end(), [](const json& a) {
+              return a.is_string() && a.get<std::string>() == kAudience;
+          })));
+    if (!forUsers) return rejected("wrong audience");
+
+    out.claims.sub = p["sub"].get<std::string>();
+    out.claims.role = p.value("role", "");
+    out.outcome = Outcome::Valid;
+
+    store(cacheKey, out.claims);
+    return out;
+}
+
+void JwtVerifier::rememberRemote(const std::string& token, const std::string& sub) {
+    JwtParts parts;
+    if (!splitJwt(token, parts)) return;
+
+    const auto& p = parts.payload;
+    if (!p.contains("exp") || !p["exp"].is_number()) return;   // no expiry => never cache
+
+    Claims claims;
+    claims.sub = sub;
+    claims.role = p.value("role", "");
+    claims.exp = p["exp"].get<std::int64_t>();
+    store(sha256(token), claims);
+}
+
+std::int64_t JwtVerifier::expiryOf(const std::string& token) {
+    JwtParts parts;
+    if (!splitJwt(token, parts)) return 0;
+
+    const auto& p = parts.payload;
+    if (!p.contains("exp") || !p["exp"].is_number()) return 0;
+    return p["exp"].get<std::int64_t>();
+}
+
+bool JwtVerifier::lookup(const std::string& key, Claims& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = index_.find(key);
+    if (it == index_.end()) return false;
+
+    if (it->second->claims.exp <= nowSeconds()) {
+        lru_.erase(it->second);
+        index_.erase(it);
+        return false;
+    }
+
+    lru_.splice(lru_.begin(), lru_, it->second);
+    out = it->second->claims;
+    return true;
+}
+
+void JwtVerifier::store(const std::string& key, const Claims& claims) {
+    if (capacity_ == 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        it->second->claims = claims;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return;
+    }
+
+    lru_.push_front(Entry{key, claims});
+    index_.emplace(key, lru_.begin());
+
+    while (lru_.size() > capacity_) {
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+    }
+}
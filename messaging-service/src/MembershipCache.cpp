@@ -0,0 +1,169 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/MembershipCache.h"
+
+#include <trantor/utils/Logger.h>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+std::uint64_t halves(const Uuid& id) {
+    std::uint64_t hi, lo;
+    std::memcpy(&hi, id.bytes.data(), 8);
+    std::memcpy(&lo, id.bytes.data() + 8, 8);
+    return hi ^ lo;
+}
+
+} // namespace
+
+MembershipCache& MembershipCache::instance() {
+    static MembershipCache cache;
+    return cache;
+}
+
+MembershipCache::MembershipCache() {
+    std::size_t total = 65536;
+    try {
+        if (const char* ttl = std::getenv("MEMBERSHIP_CACHE_TTL_SECONDS")) {
+            ttlSeconds_ = static_cast<std::uint32_t>(std::stoul(ttl));
+        }
+        if (const char* size = std::getenv("MEMBERSHIP_CACHE_SIZE")) {
+            total = static_cast<std::size_t>(std::stoul(size));
+        }
+    } catch (const std::exception& e) {
+        LOG_WARN << "Invalid MEMBERSHIP_CACHE_* setting, using defaults: " << e.what();
+    }
+
+    // Per shard: a power of two, at least one window
+    std::size_t perShard = kWindow;
+    while (perShard * kShards < total) perShard *= 2;
+    if (ttlSeconds_ == 0) perShard = 0;
+
+    for (auto& shard : shards_) shard.slots.resize(perShard);
+}
+
+std::uint64_t MembershipCache::hash(const Uuid& conversationId, const Uuid& profileId) {
+    // splitmix64 finalizer over both ids
+    std::uint64_t h = halves(conversationId) ^ (halves(profileId) * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return h;
+}
+
+std::uint32_t MembershipCache::now() const {
+    const auto elapsed = std::chrono::steady_clock::now() - start_;
+    return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(elapsed).count()) + 1;
+}
+
+std::optional<MemberRole> MembershipCache::get(const Uuid& conversationId, const Uuid& profileId) {
+    if (ttlSeconds_ == 0) return std::nullopt;
+
+    const auto h = hash(conversationId, profileId);
+    auto& shard = shards_[h >> 60];
+    const std::size_t mask = shard.slots.size() - 1;
+    const auto t = now();
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (std::size_t i = 0; i < kWindow; ++i) {
+        const auto& slot = shard.slots[(h + i) & mask];
+        if (slot.expiresAt > t && slot.conversationId == conversationId && slot.profileId == profileId) {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return slot.role;
+        }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return std::nullopt;
+}
+
+void MembershipCache::put(const Uuid& conversationId, const Uuid& profileId, MemberRole role) {
+    if (ttlSeconds_ == 0) return;
+
+    const auto h = hash(conversationId, profileId);
+    auto& shard = shards_[h >> 60];
+    const std::size_t mask = shard.slots.size() - 1;
+    const auto t = now();
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // The live entry of this key, else the lowest expiry of the window:
+    // a free slot (0), an expired one, or the live one closest to expiry
+    Slot* target = nullptr;
+    bool sameKey = false;
+    for (std::size_t i = 0; i < kWindow; ++i) {
+        auto& slot = shard.slots[(h + i) & mask];
+        if (slot.expiresAt > t && slot.conversationId == conversationId && slot.profileId == profileId) {
+            target = &slot;
+            sameKey = true;
+            break;
+        }
+        if (!target || slot.expiresAt < target->expiresAt) target = &slot;
+    }
+    if (!sameKey && target->expiresAt > t) {
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    target->conversationId = conversationId;
+    target->profileId = profileId;
+    target->role = role;
+    target->expiresAt = t + ttlSeconds_;
+}
+
+void MembershipCache::invalidate(const Uuid& conversationId, const Uuid& profileId) {
+    if (ttlSeconds_ == 0) return;
+
+    const auto h = hash(conversationId, profileId);
+    auto& shard = shards_[h >> 60];
+    const std::size_t mask = shard.slots.size() - 1;
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (std::size_t i = 0; i < kWindow; ++i) {
+        auto& slot = shard.slots[(h + i) & mask];
+        if (slot.expiresAt != 0 && slot.conversationId == conversationId && slot.profileId == profileId) {
+            slot.expiresAt = 0;
+            invalidations_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void MembershipCache::invalidateConversation(const Uuid& conversationId) {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto& slot : shard.slots) {
+            if (slot.expiresAt != 0 && slot.conversationId == conversationId) {
+                slot.expiresAt = 0;
+                invalidations_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void MembershipCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto& slot : shard.slots) slot.expiresAt = 0;
+    }
+}
+
+MembershipCache::Stats MembershipCache::stats() const {
+    Stats s{};
+    s.hits = hits_.load(std::memory_order_relaxed);
+    s.misses = misses_.load(std::memory_order_relaxed);
+    s.evictions = evictions_.load(std::memory_order_relaxed);
+    s.invalidations = invalidations_.load(std::memory_order_relaxed);
+
+    const auto t = now();
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& slot : shard.slots) {
+            if (slot.expiresAt > t) ++s.size;
+        }
+    }
+    return s;
+}
@@ -0,0 +1,639 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/MessageLog.h"
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/Logger.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+struct MessageLog::Mapping {
+    const char* data = nullptr;
+    std::size_t length = 0;
+
+    ~Mapping() {
+        if (data) munmap(const_cast<char*>(data), length);
+    }
+};
+
+namespace {
+
+constexpr std::size_t kLengthBytes = 4;
+constexpr std::size_t kHeaderBytes = 4 + 8 + 8;          // crc + seq + timestamp (after the length)
+constexpr std::uint64_t kIndexEvery = 4096;              // sparse index granularity (bytes of log)
+constexpr std::uint32_t kMaxRecordBytes = 16u * 1024 * 1024;
+
+// ---------- Helper 1 : little-endian integers ----------
+template <typename T>
+void putLe(std::string& out, T v) {
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        out.push_back(static_cast<char>((static_cast<std::uint64_t>(v) >> (8 * i)) & 0xFF));
+    }
+}
+
+template <typename T>
+T getLe(const char* p) {
+    std::uint64_t v = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        v |= static_cast<std::uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    }
+    return static_cast<T>(v);
+}
+
+// ---------- Helper 2 : CRC-32 (IEEE) ----------
+std::uint32_t crc32(const char* data, std::size_t len) {
+    static const auto table = [] {
+        std::array<std::uint32_t, 256> t{};
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    std::uint32_t c = 0xFFFFFFFFu;
+    for (std::size_t i = 0; i < len; ++i) {
+        c = table[(c ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+std::string encodeRecord(std::uint64_t seq, std::int64_t ts, const std::string& payload) {
+    std::string body;
+    body.reserve(16 + payload.size());
+    putLe<std::uint64_t>(body, seq);
+    putLe<std::int64_t>(body, ts);
+    body += payload;
+
+    std::string rec;
+    rec.reserve(kLengthBytes + 4 + body.size());
+    putLe<std::uint32_t>(rec, static_cast<std::uint32_t>(4 + body.size()));
+    putLe<std::uint32_t>(rec, crc32(body.data(), body.size()));
+    rec += body;
+    return rec;
+}
+
+// One decoded record inside a buffer
+struct RecordView {
+    std::uint64_t seq = 0;
+    std::int64_t timestampMs = 0;
+    std::string_view payload;
+    std::uint64_t totalBytes = 0;
+};
+
+// Decode the record at `offset`; false when truncated or corrupt
+bool decodeRecord(const char* base, std::uint64_t size, std::uint64_t offset, RecordView& out) {
+    if (offset + kLengthBytes > size) return false;
+    const auto length = getLe<std::uint32_t>(base + offset);
+    if (length < kHeaderBytes || length > kMaxRecordBytes) return false;
+    if (offset + kLengthBytes + length > size) return false;
+
+    const char* p = base + offset + kLengthBytes;
+    const auto crc = getLe<std::uint32_t>(p);
+    if (crc32(p + 4, length - 4) != crc) return false;
+
+    out.seq = getLe<std::uint64_t>(p + 4);
+    out.timestampMs = getLe<std::int64_t>(p + 12);
+    out.payload = std::string_view(p + kHeaderBytes, length - kHeaderBytes);
+    out.totalBytes = kLengthBytes + length;
+    return true;
+}
+
+std::string segmentName(std::uint64_t baseSeq, const char* ext) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%020llu", static_cast<unsigned long long>(baseSeq));
+    return std::string(buf) + ext;
+}
+
+bool validConversationId(const std::string& id) {
+    if (id.empty() || id.size() > 64) return false;
+    return std::all_of(id.begin(), id.end(), [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '-';
+    });
+}
+
+std::int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool writeAll(int fd, const std::string& bytes, std::uint64_t offset) {
+    std::size_t done = 0;
+    while (done < bytes.size()) {
+        const auto n = ::pwrite(fd, bytes.data() + done, bytes.size() - done, static_cast<off_t>(offset + done));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+void syncDirectory(const std::string& dir) {
+    const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return;
+    ::fsync(fd);
+    ::close(fd);
+}
+
+} // namespace
+
+MessageLog& MessageLog::instance() {
+    // Never destroyed: the writer thread keeps running until exit
+    static MessageLog* log = new MessageLog();
+    return *log;
+}
+
+MessageLog::MessageLog() {
+    const char* dir = std::getenv("MESSAGE_LOG_DIR");
+    root_ = dir && *dir ? dir : "data/messages";
+
+    if (const char* bytes = std::getenv("MESSAGE_SEGMENT_BYTES")) {
+        try {
+            segmentBytes_ = std::max<std::uint64_t>(std::stoull(bytes), 64 * 1024);
+        } catch (const std::exception&) {
+            LOG_WARN << "Ignoring invalid MESSAGE_SEGMENT_BYTES " << bytes;
+        }
+    }
+
+    std::error_code ec;
+    fs::create_directories(root_, ec);
+    if (ec) {
+        LOG_ERROR << "Cannot create message log directory " << root_ << ": " << ec.message();
+    }
+
+    writer_ = std::thread([this] { writerLoop(); });
+}
+
+MessageLog::~MessageLog() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stopping_ = true;
+    }
+    queueCv_.notify_all();
+    if (writer_.joinable()) writer_.join();
+}
+
+// ===================== Opening / recovery =====================
+
+std::shared_ptr<MessageLog::ConversationLog> MessageLog::open(const std::string& conversationId,
+                                                              bool create,
+                                                              std::string& error) {
+    if (!validConversationId(conversationId)) {
+        error = "Invalid conversation id";
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(logsMutex_);
+    auto it = logs_.find(conversationId);
+    if (it != logs_.end()) return it->second;
+
+    const std::string dir = root_ + "/" + conversationId;
+    std::error_code ec;
+    if (!fs::exists(dir, ec)) {
+        if (!create) return nullptr;
+        fs::create_directories(dir, ec);
+        if (ec) {
+            error = "Cannot create message log: " + ec.message();
+            return nullptr;
+        }
+        syncDirectory(root_);
+    }
+
+    auto log = std::make_shared<ConversationLog>();
+    log->dir = dir;
+    recover(*log);
+    logs_.emplace(conversationId, log);
+    return log;
+}
+
+void MessageLog::recover(ConversationLog& log) {
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(log.dir, ec)) {
+        if (entry.path().extension() != ".log") continue;
+        try {
+            auto seg = std::make_shared<Segment>();
+            seg->baseSeq = std::stoull(entry.path().stem().string());
+            seg->logPath = entry.path().string();
+            seg->idxPath = log.dir + "/" + segmentName(seg->baseSeq, ".idx");
+            log.segments.emplace(seg->baseSeq, seg);
+        } catch (const std::exception&) {
+            LOG_WARN << "Ignoring unexpected file " << entry.path().string();
+        }
+    }
+
+    for (auto it = log.segments.begin(); it != log.segments.end(); ++it) {
+        const bool isLast = std::next(it) == log.segments.end();
+        recoverSegment(*it->second, isLast);
+        if (!isLast) {
+            it->second->lastSeq = std::next(it)->first - 1;
+        }
+    }
+
+    if (!log.segments.empty()) {
+        const auto& last = *log.segments.rbegin()->second;
+        log.nextSeq = last.lastSeq ? last.lastSeq + 1 : last.baseSeq;
+    }
+}
+
+void MessageLog::recoverSegment(Segment& seg, bool isLast) {
+    struct stat st{};
+    if (::stat(seg.logPath.c_str(), &st) != 0) return;
+    const auto fileSize = static_cast<std::uint64_t>(st.st_size);
+
+    // 1) sparse index as written (entries past the end of the log are ignored)
+    if (const int fd = ::open(seg.idxPath.c_str(), O_RDONLY); fd >= 0) {
+        char buf[16];
+        while (::read(fd, buf, sizeof(buf)) == static_cast<ssize_t>(sizeof(buf))) {
+            IndexEntry e{getLe<std::uint64_t>(buf), getLe<std::uint64_t>(buf + 8)};
+            if (e.offset >= fileSize) break;
+            if (!seg.index.empty() && (e.seq <= seg.index.back().seq || e.offset <= seg.index.back().offset)) break;
+            seg.index.push_back(e);
+        }
+        ::close(fd);
+    }
+    if (!seg.index.empty()) seg.lastIndexedOffset = seg.index.back().offset;
+
+    if (!isLast && !seg.index.empty()) {
+        seg.size = fileSize;   // sealed and indexed: trust it
+        return;
+    }
+
+    // 2) scan the tail to find the last complete record (torn writes are cut off)
+    seg.size = 0;
+    if (fileSize == 0) return;
+
+    const int fd = ::open(seg.logPath.c_str(), O_RDWR);
+    if (fd < 0) return;
+    void* addr = ::mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        ::close(fd);
+        return;
+    }
+    const char* base = static_cast<const char*>(addr);
+
+    std::uint64_t offset = seg.index.empty() ? 0 : seg.index.back().offset;
+    std::uint64_t expected = seg.index.empty() ? seg.baseSeq : seg.index.back().seq;
+    RecordView rec;
+    while (decodeRecord(base, fileSize, offset, rec) && rec.seq == expected) {
+        if (seg.index.empty() || offset - seg.lastIndexedOffset >= kIndexEvery) {
+            if (seg.index.empty() || seg.index.back().offset != offset) seg.index.push_back({rec.seq, offset});
+            seg.lastIndexedOffset = offset;
+        }
+        seg.lastSeq = rec.seq;
+        offset += rec.totalBytes;
+        ++expected;
+    }
+    ::munmap(addr, fileSize);
+    seg.size = offset;
+
+    if (offset < fileSize) {
+        LOG_WARN << "Truncating " << seg.logPath << " from " << fileSize << " to " << offset << " bytes";
+        if (::ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+            LOG_ERROR << "Cannot truncate " << seg.logPath;
+        }
+        ::fdatasync(fd);
+    }
+    ::close(fd);
+
+    // Rewrite the index so it matches the recovered log
+    const std::string tmp = seg.idxPath + ".tmp";
+    if (const int ifd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644); ifd >= 0) {
+        std::string bytes;
+        for (const auto& e : seg.index) {
+            putLe<std::uint64_t>(bytes, e.seq);
+            putLe<std::uint64_t>(bytes, e.offset);
+        }
+        const bool ok = writeAll(ifd, bytes, 0);
+        ::close(ifd);
+        if (ok) ::rename(tmp.c_str(), seg.idxPath.c_str());
+    }
+}
+
+// ===================== Writes (group commit) =====================
+
+void MessageLog::append(const std::string& conversationId,
+                        PayloadBuilder build,
+                        trantor::EventLoop* replyLoop,
+                        AppendCallback cb) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        queue_.push_back(Pending{conversationId, std::move(build), replyLoop, std::move(cb)});
+    }
+    queueCv_.notify_one();
+}
+
+void MessageLog::writerLoop() {
+    std::vector<Pending> batch;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueCv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return;   // stopping
+
+            // Everything that queued up while the previous batch was syncing
+            while (!queue_.empty() && batch.size() < maxBatch_) {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+        }
+
+        commitBatch(batch);
+        batch.clear();
+    }
+}
+
+void MessageLog::commitBatch(std::vector<Pending>& batch) {
+    std::vector<Appended> results(batch.size());
+
+    // Bytes to add to one segment
+    struct SegmentWrite {
+        std::shared_ptr<Segment> seg;
+        bool isNew = false;
+        std::uint64_t startOffset = 0;
+        std::string bytes;
+        std::vector<IndexEntry> newIndex;
+        std::uint64_t lastIndexedOffset = 0;
+        std::uint64_t lastSeq = 0;
+        off_t idxStartSize = -1;           // .idx size before our entries, -1 if untouched
+    };
+
+    struct LogWrite {
+        std::shared_ptr<ConversationLog> log;
+        std::vector<SegmentWrite> segments;
+        std::vector<std::size_t> items;      // indexes in batch
+        std::uint64_t nextSeq = 0;
+    };
+
+    std::unordered_map<std::string, LogWrite> writes;
+
+    // 1) Assign sequence numbers and encode, segment by segment
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        auto& p = batch[i];
+        auto& w = writes[p.conversationId];
+        if (!w.log) {
+            w.log = open(p.conversationId, true, results[i].error);
+            if (!w.log) continue;
+            std::lock_guard<std::mutex> lock(w.log->mutex);
+            w.nextSeq = w.log->nextSeq;
+        }
+
+        const std::uint64_t seq = w.nextSeq;
+        const std::int64_t ts = nowMs();
+        std::string payload;
+        try {
+            payload = p.build(seq, ts);
+        } catch (const std::exception& e) {
+            results[i].error = e.what();
+            continue;
+        }
+        std::string rec = encodeRecord(seq, ts, payload);
+        if (rec.size() > kMaxRecordBytes) {
+            results[i].error = "Message too large";
+            continue;
+        }
+
+        // Current segment of this log: last one being written, else the last on disk
+        SegmentWrite* sw = w.segments.empty() ? nullptr : &w.segments.back();
+        if (!sw) {
+            std::lock_guard<std::mutex> lock(w.log->mutex);
+            if (!w.log->segments.empty()) {
+                auto seg = w.log->segments.rbegin()->second;
+                w.segments.push_back(SegmentWrite{seg, false, seg->size, {}, {}, seg->lastIndexedOffset, seg->lastSeq});
+                sw = &w.segments.back();
+            }
+        }
+
+        const bool full = sw && sw->startOffset + sw->bytes.size() > 0 &&
+                          sw->startOffset + sw->bytes.size() + rec.size() > segmentBytes_;
+        if (!sw || full) {
+            auto seg = std::make_shared<Segment>();
+            seg->baseSeq = seq;
+            seg->logPath = w.log->dir + "/" + segmentName(seq, ".log");
+            seg->idxPath = w.log->dir + "/" + segmentName(seq, ".idx");
+            w.segments.push_back(SegmentWrite{seg, true, 0, {}, {}, 0, 0});
+            sw = &w.segments.back();
+        }
+
+        const std::uint64_t offset = sw->startOffset + sw->bytes.size();
+        const bool firstInSegment = offset == 0;
+        if (firstInSegment || offset - sw->lastIndexedOffset >= kIndexEvery) {
+            sw->newIndex.push_back({seq, offset});
+            sw->lastIndexedOffset = offset;
+        }
+        sw->bytes += rec;
+        sw->lastSeq = seq;
+
+        results[i].seq = seq;
+        results[i].timestampMs = ts;
+        results[i].payload = std::move(payload);
+        w.items.push_back(i);
+        ++w.nextSeq;
+    }
+
+    // 2) Write + one fdatasync per touched segment, then publish to readers
+    for (auto& [conversationId, w] : writes) {
+        if (!w.log || w.items.empty()) continue;
+
+        bool ok = true;
+        bool newFile = false;
+        for (auto& sw : w.segments) {
+            if (sw.bytes.empty()) continue;
+
+            const int fd = ::open(sw.seg->logPath.c_str(), O_WRONLY | O_CREAT, 0644);
+            if (fd < 0) {
+                ok = false;
+                break;
+            }
+            const bool written = writeAll(fd, sw.bytes, sw.startOffset) && ::fdatasync(fd) == 0;
+            if (!written) {
+                // Undo the partial write so the log stays a clean prefix
+                if (::ftruncate(fd, static_cast<off_t>(sw.startOffset)) != 0) {
+                    LOG_ERROR << "Cannot roll back " << sw.seg->logPath;
+                }
+            }
+            ::close(fd);
+            if (!written) {
+                ok = false;
+                break;
+            }
+            newFile = newFile || sw.isNew;
+
+            // Index entries: no fsync, recovery rebuilds them if needed
+            if (!sw.newIndex.empty()) {
+                if (const int ifd = ::open(sw.seg->idxPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644); ifd >= 0) {
+                    struct stat st {};
+                    if (::fstat(ifd, &st) == 0) sw.idxStartSize = st.st_size;
+                    std::string bytes;
+                    for (const auto& e : sw.newIndex) {
+                        putLe<std::uint64_t>(bytes, e.seq);
+                        putLe<std::uint64_t>(bytes, e.offset);
+                    }
+                    if (::write(ifd, bytes.data(), bytes.size()) != static_cast<ssize_t>(bytes.size())) {
+                        LOG_WARN << "Short write on " << sw.seg->idxPath;
+                    }
+                    ::close(ifd);
+                }
+            }
+        }
+        if (newFile) syncDirectory(w.log->dir);
+
+        std::lock_guard<std::mutex> lock(w.log->mutex);
+        if (!ok) {
+            // Segments written before the failure are durable but not
+            // acknowledged; forget them and reuse their sequence numbers.
+            for (auto& sw : w.segments) {
+                if (sw.isNew) {
+                    ::unlink(sw.seg->logPath.c_str());
+                    ::unlink(sw.seg->idxPath.c_str());
+                } else if (!sw.bytes.empty()) {
+                    if (::truncate(sw.seg->logPath.c_str(), static_cast<off_t>(sw.startOffset)) != 0) {
+                        LOG_ERROR << "Cannot roll back " << sw.seg->logPath;
+                    }
+                    // Index entries pointing past the rolled back bytes
+                    if (sw.idxStartSize >= 0 && ::truncate(sw.seg->idxPath.c_str(), sw.idxStartSize) != 0) {
+                        LOG_ERROR << "Cannot roll back " << sw.seg->idxPath;
+                    }
+                }
+            }
+            for (std::size_t i : w.items) {
+                results[i] = Appended{};
+                results[i].error = "Cannot write message log";
+            }
+            continue;
+        }
+
+        for (auto& sw : w.segments) {
+            if (sw.bytes.empty()) continue;
+            auto& seg = *sw.seg;
+            seg.size = sw.startOffset + sw.bytes.size();
+            seg.lastSeq = sw.lastSeq;
+            seg.lastIndexedOffset = sw.lastIndexedOffset;
+            seg.index.insert(seg.index.end(), sw.newIndex.begin(), sw.newIndex.end());
+            if (sw.isNew) w.log->segments.emplace(seg.baseSeq, sw.seg);
+        }
+        w.log->nextSeq = w.nextSeq;
+        for (std::size_t i : w.items) results[i].ok = true;
+    }
+
+    // 3) Acknowledge on the callers' loops
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        if (!results[i].ok && results[i].error.empty()) results[i].error = "Cannot write message log";
+
+        auto cb = std::move(batch[i].cb);
+        if (batch[i].replyLoop) {
+            batch[i].replyLoop->queueInLoop([cb = std::move(cb), res = std::move(results[i])] { cb(res); });
+        } else {
+            cb(results[i]);
+        }
+    }
+}
+
+// ===================== Reads (mmap) =====================
+
+std::shared_ptr<const MessageLog::Mapping> MessageLog::mappingFor(Segment& seg) {
+    if (seg.mapping && seg.mapping->length >= seg.size) return seg.mapping;
+    if (seg.size == 0) return nullptr;
+
+    const int fd = ::open(seg.logPath.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    void* addr = ::mmap(nullptr, seg.size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) return nullptr;
+
+    auto m = std::make_shared<Mapping>();
+    m->data = static_cast<const char*>(addr);
+    m->length = seg.size;
+    // Older readers keep the previous (shorter) mapping alive through their pins
+    seg.mapping = m;
+    return m;
+}
+
+MessageLog::ReadResult MessageLog::readRangeLocked(ConversationLog& log, std::uint64_t fromSeq, std::size_t limit) {
+    ReadResult out;
+    out.ok = true;
+    out.lastSeq = log.nextSeq - 1;
+    if (fromSeq == 0) fromSeq = 1;
+    if (limit == 0 || log.segments.empty() || fromSeq > out.lastSeq) return out;
+
+    auto it = log.segments.upper_bound(fromSeq);
+    if (it != log.segments.begin()) --it;
+
+    std::uint64_t want = fromSeq;
+    for (; it != log.segments.end() && out.payloads.size() < limit; ++it) {
+        Segment& seg = *it->second;
+        auto mapping = mappingFor(seg);
+        if (!mapping) continue;
+
+        // Seek: closest indexed record at or before `want`
+        std::uint64_t offset = 0;
+        auto idx = std::upper_bound(seg.index.begin(), seg.index.end(), want,
+                                    [](std::uint64_t s, const IndexEntry& e) { return s < e.seq; });
+        if (idx != seg.index.begin()) offset = std::prev(idx)->offset;
+
+        bool pinned = false;
+        RecordView rec;
+        while (out.payloads.size() < limit && decodeRecord(mapping->data, seg.size, offset, rec)) {
+            offset += rec.totalBytes;
+            if (rec.seq < want) continue;
+
+            if (out.payloads.empty()) out.firstSeq = rec.seq;
+            out.payloads.push_back(rec.payload);
+            want = rec.seq + 1;
+            if (!pinned) {
+                out.pins.push_back(mapping);
+                pinned = true;
+            }
+        }
+    }
+    return out;
+}
+
+MessageLog::ReadResult MessageLog::readFrom(const std::string& conversationId, std::uint64_t fromSeq, std::size_t limit) {
+    std::string error;
+    auto log = open(conversationId, false, error);
+    if (!log) {
+        ReadResult empty;
+        empty.ok = error.empty();
+        empty.error = error;
+        return empty;
+    }
+
+    std::lock_guard<std::mutex> lock(log->mutex);
+    return readRangeLocked(*log, fromSeq, limit);
+}
+
+MessageLog::ReadResult MessageLog::readBefore(const std::string& conversationId, std::uint64_t beforeSeq, std::size_t limit) {
+    std::string error;
+    auto log = open(conversationId, false, error);
+    if (!log) {
+        ReadResult empty;
+        empty.ok = error.empty();
+        empty.error = error;
+        return empty;
+    }
+
+    std::lock_guard<std::mutex> lock(log->mutex);
+    const std::uint64_t end = (beforeSeq == 0 || beforeSeq > log->nextSeq) ? log->nextSeq : beforeSeq;
+    const std::uint64_t from = end > limit ? std::max<std::uint64_t>(1, end - limit) : 1;
+    return readRangeLocked(*log, from, static_cast<std::size_t>(end - from));
+}
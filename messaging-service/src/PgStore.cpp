@@ -0,0 +1,414 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/PgStore.h"
+#include "../include/FastJson.h"
+
+#include <libpq-fe.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/Logger.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// ---------- Helper 1 : statements ----------
+// Each one returns a single text column: the JSON array PostgREST would send.
+// json_build_object keeps the column order of the PostgREST select.
+struct Statement {
+    const char* name;
+    std::string sql;
+};
+
+#define CONVERSATION_ROW \
+    "json_build_object('conversation', to_json(c), 'role', m.role, " \
+    "'joined_at', m.joined_at, 'left_at', m.left_at)"
+
+const std::vector<Statement>& statements() {
+    static const std::vector<Statement> all = {
+        {"profile_id_by_auth",
+         "select coalesce(json_agg(json_build_object('id', p.id)), '[]')::text "
+         "from (select id from profiles where auth_id = $1::uuid limit 1) p"},
+
+        {"profile_names",
+         "select coalesce(json_agg(json_build_object("
+         "'id', p.id, 'first_name', p.first_name, 'last_name', p.last_name)), '[]')::text "
+         "from profiles p where p.id = any($1::uuid[])"},
+
+        // $1 profile, $2 limit, $3 since, $4 + $5 keyset (updated_at, id)
+        {"conversation_page",
+         "select coalesce(json_agg(r.j order by r.updated_at desc, r.id desc), '[]')::text "
+         "from (select " CONVERSATION_ROW " as j, c.updated_at, c.id "
+         "      from conversation_members m join conversations c on c.id = m.conversation_id "
+         "      where m.user_id = $1::uuid and m.left_at is null and c.deleted_at is null "
+         "        and ($3::timestamptz is null or c.updated_at > $3::timestamptz) "
+         "        and ($4::timestamptz is null or (c.updated_at, c.id) < ($4::timestamptz, $5::uuid)) "
+         "      order by c.updated_at desc, c.id desc "
+         "      limit $2::int) r"},
+
+        // $1 profile, $2 limit, $3 + $4 watermark ($4 null: timestamp only)
+        {"conversation_changes",
+         "select coalesce(json_agg(r.j order by r.updated_at, r.id), '[]')::text "
+         "from (select " CONVERSATION_ROW " as j, c.updated_at, c.id "
+         "      from conversation_members m join conversations c on c.id = m.conversation_id "
+         "      where m.user_id = $1::uuid "
+         "        and (m.left_at is null or m.left_at > $3::timestamptz) "
+         "        and (case when $4::uuid is null then c.updated_at > $3::timestamptz "
+         "                  else (c.updated_at, c.id) > ($3::timestamptz, $4::uuid) end) "
+         "      order by c.updated_at, c.id "
+         "      limit $2::int) r"},
+
+        {"conversation_of_member",
+         "select coalesce(json_agg(" CONVERSATION_ROW "), '[]')::text "
+         "from conversation_members m join conversations c on c.id = m.conversation_id "
+         "where m.user_id = $1::uuid and m.conversation_id = $2::uuid "
+         "  and m.left_at is null and c.deleted_at is null"},
+
+        {"conversation_ids",
+         "select coalesce(json_agg(json_build_object('conversation_id', m.conversation_id)), '[]')::text "
+         "from conversation_members m join conversations c on c.id = m.conversation_id "
+         "where m.user_id = $1::uuid and m.left_at is null and c.deleted_at is null"},
+
+        {"membership",
+         "select coalesce(json_agg(json_build_object('id', m.id, 'role', m.role)), '[]')::text "
+         "from (select id, role from conversation_members "
+         "      where conversation_id = $1::uuid and user_id = $2::uuid and left_at is null "
+         "      limit 1) m"},
+
+        {"active_members",
+         "select coalesce(json_agg(json_build_object("
+         "'id', m.id, 'conversation_id', m.conversation_id, 'user_id', m.user_id, "
+         "'role', m.role, 'joined_at', m.joined_at, 'left_at', m.left_at)), '[]')::text "
+         "from conversation_members m where m.conversation_id = $1::uuid and m.left_at is null"},
+
+        {"members_among",
+         "select coalesce(json_agg(json_build_object('user_id', m.user_id)), '[]')::text "
+         "from conversation_members m "
+         "where m.conversation_id = $1::uuid and m.user_id = any($2::uuid[]) and m.left_at is null"},
+
+        {"other_members",
+         "select coalesce(json_agg(json_build_object("
+         "'conversation_id', m.conversation_id, 'user_id', m.user_id)), '[]')::text "
+         "from conversation_members m "
+         "where m.conversation_id = any($1::uuid[]) and m.left_at is null and m.user_id <> $2::uuid"},
+    };
+    return all;
+}
+
+#undef CONVERSATION_ROW
+
+// ---------- Helper 2 : parameters ----------
+// Postgres array literal: {"a","b"}
+std::string arrayLiteral(const std::vector<std::string>& items) {
+    std::string out = "{";
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        if (i) out.push_back(',');
+        out.push_back('"');
+        for (char c : items[i]) {
+            if (c == '"' || c == '\\') out.push_back('\\');
+            out.push_back(c);
+        }
+        out.push_back('"');
+    }
+    out.push_back('}');
+    return out;
+}
+
+std::string conninfoFromEnv() {
+    if (const char* info = std::getenv("PG_CONNINFO"); info && *info) return info;
+
+    std::string out;
+    auto add = [&out](const char* key, const char* env, const char* fallback) {
+        const char* v = std::getenv(env);
+        if (!v || !*v) v = fallback;
+        if (!v) return;
+        // conninfo values are single-quoted, with \ and ' escaped
+        out += out.empty() ? "" : " ";
+        out += key;
+        out += "='";
+        for (const char* p = v; *p; ++p) {
+            if (*p == '\'' || *p == '\\') out.push_back('\\');
+            out.push_back(*p);
+        }
+        out += "'";
+    };
+    add("host", "DB_HOST", nullptr);
+    add("port", "DB_PORT", nullptr);
+    add("dbname", "DB_NAME", "securecloud");
+    add("user", "DB_USER", nullptr);
+    add("password", "DB_PASSWORD", nullptr);
+    add("application_name", "PG_APPLICATION_NAME", "messaging-service");
+    return out;
+}
+
+// ---------- Helper 3 : answers ----------
+ConversationStore::Response transportError(const std::string& message) {
+    ConversationStore::Response r;
+    r.ok = false;
+    r.error = message;
+    return r;
+}
+
+// Status as PostgREST maps the SQLSTATE classes
+long httpStatusOf(const char* sqlstate) {
+    if (!sqlstate) return 500;
+    if (std::strncmp(sqlstate, "22", 2) == 0) return 400;   // invalid input (a malformed uuid...)
+    if (std::strncmp(sqlstate, "23", 2) == 0) return 409;   // integrity constraint
+    if (std::strcmp(sqlstate, "42501") == 0) return 403;    // insufficient privilege
+    return 500;
+}
+
+ConversationStore::Response resultToResponse(PGresult* res) {
+    ConversationStore::Response r;
+    r.ok = true;
+
+    const auto status = PQresultStatus(res);
+    if (status == PGRES_TUPLES_OK && PQntuples(res) == 1 && PQnfields(res) == 1) {
+        r.httpCode = 200;
+        r.body.assign(PQgetvalue(res, 0, 0), static_cast<std::size_t>(PQgetlength(res, 0, 0)));
+        return r;
+    }
+
+    // {"code", "message", "details", "hint"}, like a PostgREST error
+    const char* sqlstate = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+    const char* message = PQresultErrorField(res, PG_DIAG_MESSAGE_PRIMARY);
+    const char* details = PQresultErrorField(res, PG_DIAG_MESSAGE_DETAIL);
+    const char* hint = PQresultErrorField(res, PG_DIAG_MESSAGE_HINT);
+    if (status == PGRES_PIPELINE_ABORTED) message = "pipeline aborted";
+
+    r.httpCode = httpStatusOf(sqlstate);
+    fastjson::Writer w(r.body);
+    w.beginObject()
+        .field("code", sqlstate ? sqlstate : "")
+        .field("message", message ? message : PQresStatus(status));
+    if (details) w.field("details", details); else w.key("details").null();
+    if (hint) w.field("hint", hint); else w.key("hint").null();
+    w.endObject();
+    return r;
+}
+
+// Connected, statements prepared, in pipeline mode; nullptr on failure
+PGconn* openConnection(const std::string& conninfo) {
+    PGconn* conn = PQconnectdb(conninfo.c_str());
+    if (PQstatus(conn) != CONNECTION_OK) {
+        LOG_ERROR << "Postgres connection failed: " << PQerrorMessage(conn);
+        PQfinish(conn);
+        return nullptr;
+    }
+
+    for (const auto& st : statements()) {
+        PGresult* res = PQprepare(conn, st.name, st.sql.c_str(), 0, nullptr);
+        const bool ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+        if (!ok) LOG_ERROR << "Cannot prepare " << st.name << ": " << PQresultErrorMessage(res);
+        PQclear(res);
+        if (!ok) {
+            PQfinish(conn);
+            return nullptr;
+        }
+    }
+
+    if (PQenterPipelineMode(conn) != 1) {
+        LOG_ERROR << "Cannot enter pipeline mode: " << PQerrorMessage(conn);
+        PQfinish(conn);
+        return nullptr;
+    }
+    return conn;
+}
+
+} // namespace
+
+PgStore::PgStore()
+    : conninfo_(conninfoFromEnv()) {
+    std::size_t poolSize = 4;
+    if (const char* size = std::getenv("PG_POOL_SIZE")) {
+        try {
+            poolSize = std::max<std::size_t>(1, std::stoul(size));
+        } catch (const std::exception&) {
+            LOG_WARN << "Ignoring invalid PG_POOL_SIZE " << size;
+        }
+    }
+
+    workers_.reserve(poolSize);
+    for (std::size_t i = 0; i < poolSize; ++i) {
+        workers_.emplace_back([this] { workerLoop(); });
+    }
+    LOG_INFO << "Conversation store: postgres, " << poolSize << " pooled connection(s)";
+}
+
+PgStore::~PgStore() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stopping_ = true;
+    }
+    queueCv_.notify_all();
+    for (auto& t : workers_) {
+        if (t.joinable()) t.join();
+    }
+}
+
+void PgStore::submit(const char* statement, std::vector<std::string> params, Callback cb) {
+    // Answer on the calling loop; inline callers (BlockingScope) wait on a
+    // future, so they take the answer on the worker thread
+    trantor::EventLoop* loop = SupabaseClient::BlockingScope::active()
+        ? nullptr : trantor::EventLoop::getEventLoopOfCurrentThread();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        queue_.push_back(Query{statement, std::move(params), loop, std::move(cb)});
+    }
+    queueCv_.notify_one();
+}
+
+void PgStore::workerLoop() {
+    PGconn* conn = nullptr;
+    std::vector<Query> batch;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueCv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) break;   // stopping, nothing left
+
+            while (!queue_.empty() && batch.size() < maxBatch_) {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+        }
+
+        runBatch(conn, batch);
+        batch.clear();
+    }
+
+    if (conn) PQfinish(conn);
+}
+
+void PgStore::runBatch(PGconn*& conn, std::vector<Query>& batch) {
+    std::vector<Response> answers(batch.size());
+
+    if (conn && PQstatus(conn) != CONNECTION_OK) {
+        PQfinish(conn);
+        conn = nullptr;
+    }
+    if (!conn) conn = openConnection(conninfo_);
+
+    if (!conn) {
+        for (auto& a : answers) a = transportError("Postgres connection failed");
+    } else {
+        // 1) Every query, each followed by its Sync, in one go
+        std::size_t sent = 0;
+        for (; sent < batch.size(); ++sent) {
+            const auto& q = batch[sent];
+            std::vector<const char*> values(q.params.size());
+            for (std::size_t i = 0; i < q.params.size(); ++i) {
+                values[i] = q.params[i].empty() ? nullptr : q.params[i].c_str();
+            }
+            if (PQsendQueryPrepared(conn, q.statement, static_cast<int>(values.size()),
+                                    values.data(), nullptr, nullptr, 0) != 1 ||
+                PQpipelineSync(conn) != 1) {
+                break;
+            }
+        }
+        const bool sendFailed = sent < batch.size();
+        if (!sendFailed && PQflush(conn) != 0) sent = 0;
+
+        // 2) Their results, in order: the query's result, NULL, then the Sync
+        bool broken = sent < batch.size();
+        for (std::size_t i = 0; i < sent; ++i) {
+            PGresult* res = PQgetResult(conn);
+            if (!res) {
+                broken = true;
+                sent = i;
+                break;
+            }
+            answers[i] = resultToResponse(res);
+            PQclear(res);
+
+            while ((res = PQgetResult(conn)) != nullptr) PQclear(res);
+
+            res = PQgetResult(conn);
+            const bool synced = res && PQresultStatus(res) == PGRES_PIPELINE_SYNC;
+            if (res) PQclear(res);
+            if (!synced) {
+                broken = true;
+                sent = i + 1;
+                break;
+            }
+        }
+
+        if (broken) {
+            const std::string error = PQerrorMessage(conn);
+            LOG_ERROR << "Postgres pipeline failed: " << error;
+            for (std::size_t i = sent; i < batch.size(); ++i) answers[i] = transportError(error);
+            PQfinish(conn);
+            conn = nullptr;
+        }
+    }
+
+    // 3) Answer on the callers' loops
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        auto cb = std::move(batch[i].cb);
+        if (batch[i].replyLoop) {
+            batch[i].replyLoop->queueInLoop([cb = std::move(cb), res = std::move(answers[i])] { cb(res); });
+        } else {
+            cb(answers[i]);
+        }
+    }
+}
+
+void PgStore::profileIdByAuthId(const Caller&, const std::string& authUserId, Callback cb) {
+    submit("profile_id_by_auth", {authUserId}, std::move(cb));
+}
+
+void PgStore::profileNames(const Caller&, const std::vector<std::string>& profileIds, Callback cb) {
+    submit("profile_names", {arrayLiteral(profileIds)}, std::move(cb));
+}
+
+void PgStore::conversationPage(const Caller&, const PageQuery& query, Callback cb) {
+    submit("conversation_page",
+           {query.profileId, std::to_string(query.limit), query.since, query.beforeUpdatedAt, query.beforeId},
+           std::move(cb));
+}
+
+void PgStore::conversationChanges(const Caller&, const ChangesQuery& query, Callback cb) {
+    submit("conversation_changes",
+           {query.profileId, std::to_string(query.limit), query.afterUpdatedAt, query.afterId},
+           std::move(cb));
+}
+
+void PgStore::conversationOfMember(const Caller&,
+                                   const std::string& profileId,
+                                   const std::string& conversationId,
+                                   Callback cb) {
+    submit("conversation_of_member", {profileId, conversationId}, std::move(cb));
+}
+
+void PgStore::conversationIds(const Caller&, const std::string& profileId, Callback cb) {
+    submit("conversation_ids", {profileId}, std::move(cb));
+}
+
+void PgStore::membership(const Caller&,
+                         const std::string& conversationId,
+                         const std::string& profileId,
+                         Callback cb) {
+    submit("membership", {conversationId, profileId}, std::move(cb));
+}
+
+void PgStore::activeMembers(const Caller&, const std::string& conversationId, Callback cb) {
+    submit("active_members", {conversationId}, std::move(cb));
+}
+
+void PgStore::membersAmong(const Caller&,
+                           const std::string& conversationId,
+                           const std::vector<std::string>& profileIds,
+                           Callback cb) {
+    submit("members_among", {conversationId, arrayLiteral(profileIds)}, std::move(cb));
+}
+
+void PgStore::otherMembers(const Caller&,
+                           const std::vector<std::string>& conversationIds,
+                           const std::string& profileId,
+                           Callback cb) {
+    submit("other_members", {arrayLiteral(conversationIds), profileId}, std::move(cb));
+}
@@ -0,0 +1,215 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/PostgrestStore.h"
+#include "../include/FastJson.h"
+
+#include <cctype>
+#include <memory>
+
+namespace {
+
+constexpr std::size_t kIdsPerRequest = 100;   // keeps URLs well under the usual 8 KB request-line limits
+
+// ---------- Helper 1 : requests ----------
+void get(const ConversationStore::Caller& caller, const std::string& pathAndQuery, ConversationStore::Callback cb) {
+    SupabaseClient::Request req;
+    req.url = caller.base + pathAndQuery;
+    req.apiKey = caller.anonKey;
+    req.bearer = caller.accessToken;
+    SupabaseClient::instance().performAsync(std::move(req), std::move(cb));
+}
+
+// Query string values: keep only unreserved characters as-is
+std::string urlEncode(const std::string& v) {
+    static const char* hex = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : v) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            out.push_back(static_cast<char>(c));
+        } else {
+            out.push_back('%');
+            out.push_back(hex[c >> 4]);
+            out.push_back(hex[c & 0x0F]);
+        }
+    }
+    return out;
+}
+
+// ---------- Helper 2 : GET "<prefix>in.(ids)<suffix>" in parallel chunks ----------
+// The rows of every chunk end up in one array; the first failed chunk is
+// the answer otherwise.
+void getWhereIn(const ConversationStore::Caller& caller,
+                const std::string& prefix,
+                const std::vector<std::string>& ids,
+                const std::string& suffix,
+                ConversationStore::Callback cb) {
+    if (ids.empty()) {
+        ConversationStore::Response empty;
+        empty.ok = true;
+        empty.httpCode = 200;
+        empty.body = "[]";
+        return cb(empty);
+    }
+
+    struct Join {
+        std::size_t pending = 0;
+        bool failed = false;
+        ConversationStore::Response merged;
+        ConversationStore::Callback cb;
+    };
+    auto join = std::make_shared<Join>();
+    join->pending = (ids.size() + kIdsPerRequest - 1) / kIdsPerRequest;
+    join->merged.ok = true;
+    join->merged.httpCode = 200;
+    join->merged.body = "[";
+    join->cb = std::move(cb);
+
+    for (std::size_t start = 0; start < ids.size(); start += kIdsPerRequest) {
+        std::string list;
+        for (std::size_t i = start; i < ids.size() && i < start + kIdsPerRequest; ++i) {
+            if (!list.empty()) list += ",";
+            list += ids[i];
+        }
+
+        get(caller, prefix + "in.(" + list + ")" + suffix, [join](const ConversationStore::Response& resp) {
+            if (join->failed) return;
+
+            fastjson::Value rows;
+            if (!resp.ok || resp.httpCode != 200 || !fastjson::parse(resp.body, rows) || !rows.isArray()) {
+                join->failed = true;
+                return join->cb(resp);
+            }
+
+            fastjson::forEachElement(rows, [&](const fastjson::Value& row) {
+                if (join->merged.body.size() > 1) join->merged.body.push_back(',');
+                join->merged.body.append(row.raw.data(), row.raw.size());
+            });
+
+            if (--join->pending == 0) {
+                join->merged.body.push_back(']');
+                join->cb(join->merged);
+            }
+        });
+    }
+}
+
+// The membership rows with their embedded conversation
+const char* kConversationRows =
+    "/rest/v1/conversation_members"
+    "?select=conversation:conversations!inner(*),role,joined_at,left_at";
+
+} // namespace
+
+void PostgrestStore::profileIdByAuthId(const Caller& caller, const std::string& authUserId, Callback cb) {
+    get(caller, "/rest/v1/profiles?select=id&auth_id=eq." + authUserId + "&limit=1", std::move(cb));
+}
+
+void PostgrestStore::profileNames(const Caller& caller, const std::vector<std::string>& profileIds, Callback cb) {
+    getWhereIn(caller, "/rest/v1/profiles?select=id,first_name,last_name&id=", profileIds, "", std::move(cb));
+}
+
+// Ordered by (conversation.updated_at, conversation.id) desc
+void PostgrestStore::conversationPage(const Caller& caller, const PageQuery& query, Callback cb) {
+    std::string url = std::string(kConversationRows) +
+        "&user_id=eq." + query.profileId +
+        "&left_at=is.null"
+        "&conversation.deleted_at=is.null"
+        "&order=conversation(updated_at).desc,conversation(id).desc"
+        "&limit=" + std::to_string(query.limit);
+
+    if (!query.since.empty()) {
+        url += "&conversation.updated_at=gt." + urlEncode(query.since);
+    }
+    if (!query.beforeUpdatedAt.empty()) {
+        // (updated_at, id) < (cursor.updated_at, cursor.id)
+        const std::string ts = "\"" + query.beforeUpdatedAt + "\"";
+        url += "&conversation.or=" + urlEncode(
+            "(updated_at.lt." + ts + ",and(updated_at.eq." + ts + ",id.lt." + query.beforeId + "))");
+    }
+
+    get(caller, url, std::move(cb));
+}
+
+void PostgrestStore::conversationChanges(const Caller& caller, const ChangesQuery& query, Callback cb) {
+    const std::string ts = "\"" + query.afterUpdatedAt + "\"";
+
+    std::string url = std::string(kConversationRows) +
+        "&user_id=eq." + query.profileId +
+        "&or=" + urlEncode("(left_at.is.null,left_at.gt." + ts + ")") +
+        "&order=conversation(updated_at).asc,conversation(id).asc"
+        "&limit=" + std::to_string(query.limit);
+
+    if (query.afterId.empty()) {
+        url += "&conversation.updated_at=gt." + urlEncode(query.afterUpdatedAt);
+    } else {
+        // (updated_at, id) > watermark
+        url += "&conversation.or=" + urlEncode(
+            "(updated_at.gt." + ts + ",and(updated_at.eq." + ts + ",id.gt." + query.afterId + "))");
+    }
+
+    get(caller, url, std::move(cb));
+}
+
+void PostgrestStore::conversationOfMember(const Caller& caller,
+                                          const std::string& profileId,
+                                          const std::string& conversationId,
+                                          Callback cb) {
+    get(caller, std::string(kConversationRows) +
+        "&user_id=eq." + profileId +
+        "&conversation_id=eq." + conversationId +
+        "&left_at=is.null"
+        "&conversation.deleted_at=is.null", std::move(cb));
+}
+
+void PostgrestStore::conversationIds(const Caller& caller, const std::string& profileId, Callback cb) {
+    get(caller,
+        "/rest/v1/conversation_members"
+        "?select=conversation_id,conversation:conversations!inner(id)"
+        "&user_id=eq." + profileId +
+        "&left_at=is.null"
+        "&conversation.deleted_at=is.null", std::move(cb));
+}
+
+void PostgrestStore::membership(const Caller& caller,
+                                const std::string& conversationId,
+                                const std::string& profileId,
+                                Callback cb) {
+    get(caller,
+        "/rest/v1/conversation_members"
+        "?select=id,role"
+        "&conversation_id=eq." + conversationId +
+        "&user_id=eq." + profileId +
+        "&left_at=is.null"
+        "&limit=1", std::move(cb));
+}
+
+void PostgrestStore::activeMembers(const Caller& caller, const std::string& conversationId, Callback cb) {
+    get(caller,
+        "/rest/v1/conversation_members"
+        "?select=id,conversation_id,user_id,role,joined_at,left_at"
+        "&conversation_id=eq." + conversationId +
+        "&left_at=is.null", std::move(cb));
+}
+
+void PostgrestStore::membersAmong(const Caller& caller,
+                                  const std::string& conversationId,
+                                  const std::vector<std::string>& profileIds,
+                                  Callback cb) {
+    getWhereIn(caller,
+        "/rest/v1/conversation_members?select=user_id&conversation_id=eq." + conversationId +
+            "&left_at=is.null&user_id=",
+        profileIds, "", std::move(cb));
+}
+
+void PostgrestStore::otherMembers(const Caller& caller,
+                                  const std::vector<std::string>& conversationIds,
+                                  const std::string& profileId,
+                                  Callback cb) {
+    getWhereIn(caller,
+        "/rest/v1/conversation_members?select=conversation_id,user_id&conversation_id=",
+        conversationIds,
+        "&left_at=is.null&user_id=neq." + profileId,
+        std::move(cb));
+}
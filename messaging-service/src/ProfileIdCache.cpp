@@ -0,0 +1,116 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/ProfileIdCache.h"
+
+#include <trantor/utils/Logger.h>
+
+#include <cstdlib>
+#include <functional>
+
+ProfileIdCache& ProfileIdCache::instance() {
+    static ProfileIdCache cache;
+    return cache;
+}
+
+ProfileIdCache::ProfileIdCache() {
+    try {
+        if (const char* ttl = std::getenv("PROFILE_CACHE_TTL_SECONDS")) {
+            ttl_ = std::chrono::seconds(std::stol(ttl));
+        }
+        if (const char* size = std::getenv("PROFILE_CACHE_SIZE")) {
+            const auto total = static_cast<std::size_t>(std::stoul(size));
+            perShardCapacity_ = (total + kShards - 1) / kShards;
+        }
+    } catch (const std::exception& e) {
+        LOG_WARN << "Invalid PROFILE_CACHE_* setting, using defaults: " << e.what();
+    }
+}
+
+ProfileIdCache::Shard& ProfileIdCache::shardFor(const std::string& authUserId) {
+    return shards_[std::hash<std::string>{}(authUserId) % kShards];
+}
+
+std::optional<std::string> ProfileIdCache::get(const std::string& authUserId) {
+    if (ttl_.count() <= 0) return std::nullopt;
+
+    auto& shard = shardFor(authUserId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(authUserId);
+    if (it == shard.index.end()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    if (it->second->expiresAt <= Clock::now()) {
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return it->second->profileId;
+}
+
+void ProfileIdCache::put(const std::string& authUserId, const std::string& profileId) {
+    if (ttl_.count() <= 0 || perShardCapacity_ == 0) return;
+
+    auto& shard = shardFor(authUserId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    const auto expiresAt = Clock::now() + ttl_;
+    auto it = shard.index.find(authUserId);
+    if (it != shard.index.end()) {
+        it->second->profileId = profileId;
+        it->second->expiresAt = expiresAt;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+
+    shard.lru.push_front(Entry{authUserId, profileId, expiresAt});
+    shard.index.emplace(authUserId, shard.lru.begin());
+
+    while (shard.lru.size() > perShardCapacity_) {
+        shard.index.erase(shard.lru.back().authUserId);
+        shard.lru.pop_back();
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ProfileIdCache::invalidate(const std::string& authUserId) {
+    auto& shard = shardFor(authUserId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(authUserId);
+    if (it == shard.index.end()) return;
+
+    shard.lru.erase(it->second);
+    shard.index.erase(it);
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ProfileIdCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        invalidations_.fetch_add(shard.lru.size(), std::memory_order_relaxed);
+        shard.lru.clear();
+        shard.index.clear();
+    }
+}
+
+ProfileIdCache::Stats ProfileIdCache::stats() const {
+    Stats s{};
+    s.hits = hits_.load(std::memory_order_relaxed);
+    s.misses = misses_.load(std::memory_order_relaxed);
+    s.evictions = evictions_.load(std::memory_order_relaxed);
+    s.invalidations = invalidations_.load(std::memory_order_relaxed);
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        s.size += shard.lru.size();
+    }
+    return s;
+}
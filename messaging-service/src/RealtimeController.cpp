@@ -0,0 +1,80 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/RealtimeController.h"
+#include "../include/ConversationService.h"
+#include "../include/JwtVerifier.h"
+#include "../include/RealtimeHub.h"
+
+#include <trantor/net/EventLoop.h>
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+namespace {
+
+std::string getAccessToken(const HttpRequestPtr& req) {
+    auto h = req->getHeader("authorization");
+    if (h.rfind("Bearer ", 0) == 0) return h.substr(7);
+    return req->getParameter("access_token");
+}
+
+} // namespace
+
+void RealtimeController::handleNewConnection(const HttpRequestPtr& req,
+                                             const WebSocketConnectionPtr& conn) {
+    const auto token = getAccessToken(req);
+    if (token.empty()) {
+        return conn->shutdown(CloseCode::kViolation, "Missing Bearer access token");
+    }
+
+    // Keeps idle sockets alive through proxies; these pings carry no probe number
+    conn->setPingMessage("", std::chrono::seconds(30));
+
+    // Resolved on this connection's loop, which is the one that owns its subscriptions
+    ConversationService service;
+    service.listMyConversationIds(token, [conn, token](ConversationService::Result result) {
+        if (!conn->connected()) return;
+
+        if (result.statusCode != 200) {
+            const auto reason = result.body.value("error", std::string("Cannot subscribe"));
+            return conn->shutdown(result.statusCode == 401 ? CloseCode::kViolation
+                                                           : CloseCode::kUnexpectedCondition,
+                                  reason);
+        }
+
+        const auto ids = result.body["conversation_ids"].get<std::vector<std::string>>();
+        RealtimeHub::instance().attach(conn, result.body["profile_id"].get<std::string>(), ids);
+
+        conn->send(R"({"type":"ready","conversations":)" + std::to_string(ids.size()) + "}");
+
+        // The token was checked once, here: the socket does not outlive it
+        // (the client reconnects with a fresh one and reads back with ?after=)
+        const std::int64_t exp = JwtVerifier::expiryOf(token);
+        if (exp <= 0) return;
+        const auto left = static_cast<double>(exp - static_cast<std::int64_t>(std::time(nullptr)));
+        std::weak_ptr<WebSocketConnection> weak = conn;
+        trantor::EventLoop::getEventLoopOfCurrentThread()->runAfter(std::max(left, 0.0), [weak] {
+            if (auto c = weak.lock(); c && c->connected()) c->shutdown(CloseCode::kViolation, "Access token expired");
+        });
+    });
+}
+
+void RealtimeController::handleNewMessage(const WebSocketConnectionPtr& conn,
+                                          std::string&& message,
+                                          const WebSocketMessageType& type) {
+    // Push only: the client's frames are ignored, except the pongs that acknowledge delivery
+    if (type == WebSocketMessageType::Pong) {
+        RealtimeHub::instance().onPong(conn, message);
+    }
+}
+
+void RealtimeController::handleConnectionClosed(const WebSocketConnectionPtr& conn) {
+    RealtimeHub::instance().detach(conn);
+}
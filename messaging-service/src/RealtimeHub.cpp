@@ -0,0 +1,281 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/RealtimeHub.h"
+
+#include <drogon/WebSocketConnection.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/Logger.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <stdexcept>
+#include <unordered_map>
+
+struct RealtimeHub::Subscriber {
+    std::weak_ptr<drogon::WebSocketConnection> conn;
+    const std::string* profileId = nullptr;             // key of LoopTable::byProfile
+    std::vector<const std::string*> conversations;      // keys of LoopTable::byConversation
+    std::size_t inFlight = 0;                           // bytes sent since the last acknowledged probe
+    std::uint64_t probe = 0;                            // ping awaiting its pong (0 = none)
+    std::unique_ptr<std::deque<Event>> backlog;         // only allocated for slow sockets
+    bool closing = false;
+};
+
+struct RealtimeHub::LoopTable {
+    std::unordered_map<const drogon::WebSocketConnection*, std::unique_ptr<Subscriber>> sockets;
+    std::unordered_map<std::string, std::vector<Subscriber*>> byConversation;
+    std::unordered_map<std::string, std::vector<Subscriber*>> byProfile;
+    std::uint64_t nextProbe = 1;
+};
+
+thread_local RealtimeHub::LoopTable* RealtimeHub::localTable_ = nullptr;
+
+namespace {
+
+// Unordered removal, the order of the subscribers does not matter
+template <typename T>
+void eraseValue(std::vector<T>& v, const T& value) {
+    auto it = std::find(v.begin(), v.end(), value);
+    if (it == v.end()) return;
+    *it = v.back();
+    v.pop_back();
+}
+
+} // namespace
+
+RealtimeHub& RealtimeHub::instance() {
+    // Never destroyed: IO loops may still publish while main() returns
+    static RealtimeHub* hub = new RealtimeHub();
+    return *hub;
+}
+
+RealtimeHub::RealtimeHub() {
+    try {
+        if (const char* window = std::getenv("WS_WINDOW_BYTES")) {
+            windowBytes_ = static_cast<std::size_t>(std::stoul(window));
+        }
+        if (const char* queue = std::getenv("WS_MAX_QUEUE")) {
+            maxQueue_ = static_cast<std::size_t>(std::stoul(queue));
+        }
+    } catch (const std::exception& e) {
+        LOG_WARN << "Invalid WS_* setting, using defaults: " << e.what();
+    }
+}
+
+void RealtimeHub::registerCurrentLoop() {
+    if (localTable_) return;
+
+    auto* loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (!loop) {
+        throw std::logic_error("RealtimeHub used outside of an event loop");
+    }
+
+    std::lock_guard<std::mutex> lock(registerMutex_);
+    const auto count = loopCount_.load(std::memory_order_relaxed);
+    if (count == kMaxLoops) {
+        throw std::length_error("RealtimeHub: too many event loops");
+    }
+    localTable_ = new LoopTable();   // lives as long as the loop thread
+    loops_[count].store(loop, std::memory_order_release);
+    loopCount_.store(count + 1, std::memory_order_release);
+}
+
+void RealtimeHub::attach(const Connection& conn,
+                         const std::string& profileId,
+                         const std::vector<std::string>& conversationIds) {
+    registerCurrentLoop();
+    auto& table = *localTable_;
+
+    auto& slot = table.sockets[conn.get()];
+    if (slot) return;   // already attached
+    slot = std::make_unique<Subscriber>();
+    auto* sub = slot.get();
+    sub->conn = conn;
+
+    auto profile = table.byProfile.try_emplace(profileId).first;
+    profile->second.push_back(sub);
+    sub->profileId = &profile->first;
+
+    sub->conversations.reserve(conversationIds.size());
+    for (const auto& id : conversationIds) {
+        auto entry = table.byConversation.try_emplace(id).first;
+        if (std::find(entry->second.begin(), entry->second.end(), sub) != entry->second.end()) continue;
+        entry->second.push_back(sub);
+        sub->conversations.push_back(&entry->first);
+    }
+
+    sockets_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RealtimeHub::detach(const Connection& conn) {
+    if (!localTable_) return;
+    auto& table = *localTable_;
+
+    auto it = table.sockets.find(conn.get());
+    if (it == table.sockets.end()) return;
+    auto* sub = it->second.get();
+
+    for (const auto* id : sub->conversations) {
+        auto entry = table.byConversation.find(*id);
+        eraseValue(entry->second, sub);
+        if (entry->second.empty()) table.byConversation.erase(entry);
+    }
+
+    auto profile = table.byProfile.find(*sub->profileId);
+    eraseValue(profile->second, sub);
+    if (profile->second.empty()) table.byProfile.erase(profile);
+
+    table.sockets.erase(it);
+    sockets_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void RealtimeHub::onPong(const Connection& conn, const std::string& payload) {
+    if (!localTable_) return;
+    auto& table = *localTable_;
+
+    auto it = table.sockets.find(conn.get());
+    if (it == table.sockets.end()) return;
+    auto& sub = *it->second;
+
+    // Only the pong of our own probe acknowledges the window (keep-alive pings carry no number)
+    if (sub.probe == 0 || payload != std::to_string(sub.probe)) return;
+
+    sub.probe = 0;
+    sub.inFlight = 0;
+
+    // deliver() may probe again (stop there) or evict (drops the backlog)
+    while (sub.backlog && !sub.backlog->empty() && sub.probe == 0) {
+        auto event = std::move(sub.backlog->front());
+        sub.backlog->pop_front();
+        deliver(table, sub, event);
+    }
+    if (sub.backlog && sub.backlog->empty()) sub.backlog.reset();
+}
+
+void RealtimeHub::sendProbe(LoopTable& table, Subscriber& sub, drogon::WebSocketConnection& conn) {
+    sub.probe = table.nextProbe++;
+    conn.send(std::to_string(sub.probe), drogon::WebSocketMessageType::Ping);
+}
+
+void RealtimeHub::deliver(LoopTable& table, Subscriber& sub, const Event& event) {
+    if (sub.closing) return;
+    auto conn = sub.conn.lock();
+    if (!conn || !conn->connected()) return;
+
+    // Window full: keep the event until the peer has caught up
+    if (sub.probe != 0) {
+        if (!sub.backlog) sub.backlog = std::make_unique<std::deque<Event>>();
+        if (sub.backlog->size() >= maxQueue_) {
+            // Slow consumer: drop it rather than buffer without bound.
+            // detach() runs from the close callback, not while a table is being walked.
+            sub.closing = true;
+            sub.backlog.reset();
+            evicted_.fetch_add(1, std::memory_order_relaxed);
+            LOG_WARN << "Closing slow WebSocket consumer " << conn->getPeerAddr().toIpPort();
+            trantor::EventLoop::getEventLoopOfCurrentThread()->queueInLoop([conn]() { conn->forceClose(); });
+            return;
+        }
+        sub.backlog->push_back(event);
+        return;
+    }
+
+    conn->send(*event);
+    delivered_.fetch_add(1, std::memory_order_relaxed);
+    sub.inFlight += event->size();
+    if (sub.inFlight >= windowBytes_) {
+        sendProbe(table, sub, *conn);
+    }
+}
+
+void RealtimeHub::deliverAll(LoopTable& table, const std::string& conversationId, const Event& event) {
+    auto entry = table.byConversation.find(conversationId);
+    if (entry == table.byConversation.end()) return;
+    for (auto* sub : entry->second) {
+        deliver(table, *sub, event);
+    }
+}
+
+void RealtimeHub::broadcast(LoopTask task,
+                            const std::string& conversationId,
+                            const std::string& profileId,
+                            std::string event) {
+    const auto count = loopCount_.load(std::memory_order_acquire);
+    if (count == 0) return;   // nobody connected yet
+
+    auto shared = std::make_shared<const std::string>(std::move(event));
+    for (std::size_t i = 0; i < count; ++i) {
+        auto* loop = loops_[i].load(std::memory_order_acquire);
+        loop->queueInLoop([this, task, conversationId, profileId, shared]() {
+            if (localTable_) task(*this, *localTable_, conversationId, profileId, shared);
+        });
+    }
+}
+
+void RealtimeHub::publish(const std::string& conversationId, std::string event) {
+    broadcast([](RealtimeHub& hub, LoopTable& table, const std::string& conversationId,
+                 const std::string&, const Event& event) {
+        hub.deliverAll(table, conversationId, event);
+    }, conversationId, {}, std::move(event));
+}
+
+void RealtimeHub::memberJoined(const std::string& conversationId,
+                               const std::string& profileId,
+                               std::string event) {
+    broadcast([](RealtimeHub& hub, LoopTable& table, const std::string& conversationId,
+                 const std::string& profileId, const Event& event) {
+        auto profile = table.byProfile.find(profileId);
+        if (profile != table.byProfile.end()) {
+            auto entry = table.byConversation.try_emplace(conversationId).first;
+            for (auto* sub : profile->second) {
+                if (std::find(entry->second.begin(), entry->second.end(), sub) != entry->second.end()) continue;
+                entry->second.push_back(sub);
+                sub->conversations.push_back(&entry->first);
+            }
+        }
+        hub.deliverAll(table, conversationId, event);
+    }, conversationId, profileId, std::move(event));
+}
+
+void RealtimeHub::memberLeft(const std::string& conversationId,
+                             const std::string& profileId,
+                             std::string event) {
+    broadcast([](RealtimeHub& hub, LoopTable& table, const std::string& conversationId,
+                 const std::string& profileId, const Event& event) {
+        hub.deliverAll(table, conversationId, event);
+
+        auto entry = table.byConversation.find(conversationId);
+        auto profile = table.byProfile.find(profileId);
+        if (entry == table.byConversation.end() || profile == table.byProfile.end()) return;
+
+        for (auto* sub : profile->second) {
+            eraseValue(entry->second, sub);
+            eraseValue(sub->conversations, &entry->first);
+        }
+        if (entry->second.empty()) table.byConversation.erase(entry);
+    }, conversationId, profileId, std::move(event));
+}
+
+void RealtimeHub::conversationClosed(const std::string& conversationId, std::string event) {
+    broadcast([](RealtimeHub& hub, LoopTable& table, const std::string& conversationId,
+                 const std::string&, const Event& event) {
+        hub.deliverAll(table, conversationId, event);
+
+        auto entry = table.byConversation.find(conversationId);
+        if (entry == table.byConversation.end()) return;
+        for (auto* sub : entry->second) {
+            eraseValue(sub->conversations, &entry->first);
+        }
+        table.byConversation.erase(entry);
+    }, conversationId, {}, std::move(event));
+}
+
+RealtimeHub::Stats RealtimeHub::stats() const {
+    Stats s;
+    s.sockets = sockets_.load(std::memory_order_relaxed);
+    s.delivered = delivered_.load(std::memory_order_relaxed);
+    s.evicted = evicted_.load(std::memory_order_relaxed);
+    return s;
+}
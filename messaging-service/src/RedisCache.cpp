@@ -0,0 +1,278 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/RedisCache.h"
+#include "../include/SupabaseClient.h"
+
+#include <drogon/HttpAppFramework.h>
+#include <drogon/nosql/RedisClient.h>
+#include <drogon/nosql/RedisSubscriber.h>
+#include <trantor/net/InetAddress.h>
+#include <trantor/utils/Logger.h>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <memory>
+
+namespace {
+
+constexpr const char* kClientName = "cache";
+
+// The Redis client takes an IP: resolve REDIS_HOST once, at startup
+std::string resolveHost(const std::string& host) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &found) != 0 || !found) return {};
+
+    char ip[INET_ADDRSTRLEN] = {};
+    const auto* addr = reinterpret_cast<const sockaddr_in*>(found->ai_addr);
+    const bool ok = inet_ntop(AF_INET, &addr->sin_addr, ip, sizeof(ip)) != nullptr;
+    freeaddrinfo(found);
+    return ok ? std::string(ip) : std::string();
+}
+
+// Writes and invalidations: nothing to do with the answer
+void ignoreResult(const drogon::nosql::RedisResult&) {}
+
+// Every key listed in the index set KEYS[1], then the set itself
+constexpr const char* kDropIndexed =
+    "local keys = redis.call('smembers', KEYS[1]) "
+    "for _, k in ipairs(keys) do redis.call('del', k) end "
+    "return redis.call('del', KEYS[1])";
+
+} // namespace
+
+RedisCache& RedisCache::instance() {
+    static RedisCache cache;
+    return cache;
+}
+
+RedisCache::RedisCache() {
+    const char* host = std::getenv("REDIS_HOST");
+    if (!host || !*host) return;
+
+    double timeoutSeconds = 0.1;
+    try {
+        if (const char* v = std::getenv("REDIS_PORT")) port_ = static_cast<unsigned short>(std::stoul(v));
+        if (const char* v = std::getenv("REDIS_DB")) db_ = static_cast<unsigned int>(std::stoul(v));
+        if (const char* v = std::getenv("REDIS_CACHE_TTL_SECONDS")) ttl_ = std::chrono::seconds(std::stol(v));
+        if (const char* v = std::getenv("REDIS_TIMEOUT_MS")) timeoutSeconds = std::stol(v) / 1000.0;
+    } catch (const std::exception& e) {
+        LOG_WARN << "Invalid REDIS_* setting, using defaults: " << e.what();
+    }
+    if (const char* v = std::getenv("REDIS_KEY_PREFIX")) prefix_ = v;
+
+    if (ttl_.count() <= 0) {
+        LOG_INFO << "Redis cache disabled (REDIS_CACHE_TTL_SECONDS)";
+        return;
+    }
+
+    ip_ = resolveHost(host);
+    if (ip_.empty()) {
+        LOG_WARN << "Cannot resolve REDIS_HOST " << host << ", Redis cache disabled";
+        return;
+    }
+    if (const char* v = std::getenv("REDIS_PASSWORD")) password_ = v;
+
+    char hostname[256] = {};
+    gethostname(hostname, sizeof(hostname) - 1);
+    replica_ = std::string(hostname) + ":" + std::to_string(getpid());
+
+    // isFast: one connection per IO loop, used only from that loop
+    drogon::app().createRedisClient(ip_, port_, kClientName, password_, 1, true, timeoutSeconds, db_);
+    enabled_ = true;
+
+    auto& metrics = Metrics::instance();
+    const char* help = "Lookups of the Redis cache tier, by result";
+    hits_ = metrics.counter("redis_cache_lookups_total", Metrics::label("result", "hit"), help);
+    misses_ = metrics.counter("redis_cache_lookups_total", Metrics::label("result", "miss"), help);
+    errors_ = metrics.counter("redis_cache_lookups_total", Metrics::label("result", "error"), help);
+
+    LOG_INFO << "Redis cache: " << host << ":" << port_ << " (ttl " << ttl_.count() << "s)";
+}
+
+RedisCache::Slot RedisCache::profileOfAuthUser(const std::string& authUserId) {
+    return {instance().prefix_ + "profile:" + authUserId, {}};
+}
+
+RedisCache::Slot RedisCache::profileNames(const std::string& profileId) {
+    return {instance().prefix_ + "names:" + profileId, {}};
+}
+
+RedisCache::Slot RedisCache::membership(const std::string& conversationId, const std::string& profileId) {
+    const auto& prefix = instance().prefix_;
+    return {prefix + "membership:" + conversationId + ":" + profileId, prefix + "memberships:" + conversationId};
+}
+
+bool RedisCache::usable() const {
+    if (!enabled_ || SupabaseClient::BlockingScope::active()) return false;
+    auto& app = drogon::app();
+    return app.getCurrentThreadIndex() < app.getThreadNum();
+}
+
+void RedisCache::get(const Slot& slot, Lookup cb) {
+    auto client = drogon::app().getFastRedisClient(kClientName);
+    if (!client) return cb(std::nullopt);
+
+    auto onResult = [this, cb](const drogon::nosql::RedisResult& r) {
+        if (r.type() != drogon::nosql::RedisResultType::kString) {
+            Metrics::instance().add(misses_);
+            return cb(std::nullopt);
+        }
+        Metrics::instance().add(hits_);
+        cb(r.asString());
+    };
+    auto onError = [this, cb](const drogon::nosql::RedisException& e) {
+        Metrics::instance().add(errors_);
+        LOG_DEBUG << "Redis cache lookup failed: " << e.what();
+        cb(std::nullopt);
+    };
+
+    client->execCommandAsync(std::move(onResult), std::move(onError), "get %s", slot.key.c_str());
+}
+
+void RedisCache::put(const Slot& slot, const std::string& value) {
+    auto client = drogon::app().getFastRedisClient(kClientName);
+    if (!client) return;
+
+    const auto ttl = std::to_string(ttl_.count());
+    auto onError = [this](const drogon::nosql::RedisException& e) {
+        Metrics::instance().add(errors_);
+        LOG_DEBUG << "Redis cache write failed: " << e.what();
+    };
+
+    // Each entry expires on its own: nothing written after it extends it
+    client->execCommandAsync(ignoreResult, onError, "set %s %b ex %s",
+                             slot.key.c_str(), value.data(), value.size(), ttl.c_str());
+    if (slot.index.empty()) return;
+
+    // Listed for invalidateMembers; the index outlives the entries it lists
+    client->execCommandAsync(ignoreResult, onError, "sadd %s %s", slot.index.c_str(), slot.key.c_str());
+    client->execCommandAsync(ignoreResult, onError, "expire %s %s", slot.index.c_str(), ttl.c_str());
+}
+
+void RedisCache::invalidateMembers(const std::string& conversationId,
+                                   const std::vector<std::string>& profileIds) {
+    if (!usable()) return;
+    auto client = drogon::app().getFastRedisClient(kClientName);
+    if (!client) return;
+
+    auto onError = [this](const drogon::nosql::RedisException& e) {
+        Metrics::instance().add(errors_);
+        LOG_WARN << "Redis cache invalidation failed: " << e.what();
+    };
+
+    std::string message = replica_ + " " + conversationId;
+
+    if (profileIds.empty()) {
+        const auto index = membership(conversationId, {}).index;
+        client->execCommandAsync(ignoreResult, onError, "eval %s 1 %s", kDropIndexed, index.c_str());
+    } else {
+        message += ' ';
+        for (size_t i = 0; i < profileIds.size(); ++i) {
+            const auto key = membership(conversationId, profileIds[i]).key;
+            client->execCommandAsync(ignoreResult, onError, "del %s", key.c_str());
+            if (i > 0) message += ',';
+            message += profileIds[i];
+        }
+    }
+
+    publish(client, message);
+}
+
+void RedisCache::invalidateProfile(const std::string& authUserId) {
+    if (!usable()) return;
+    auto client = drogon::app().getFastRedisClient(kClientName);
+    if (!client) return;
+
+    auto onError = [this](const drogon::nosql::RedisException& e) {
+        Metrics::instance().add(errors_);
+        LOG_WARN << "Redis cache invalidation failed: " << e.what();
+    };
+
+    const auto key = profileOfAuthUser(authUserId).key;
+    client->execCommandAsync(ignoreResult, onError, "del %s", key.c_str());
+    publish(client, replica_ + " profile:" + authUserId);
+}
+
+void RedisCache::publish(const std::shared_ptr<drogon::nosql::RedisClient>& client, const std::string& message) {
+    auto onError = [this](const drogon::nosql::RedisException& e) {
+        Metrics::instance().add(errors_);
+        LOG_WARN << "Redis cache invalidation failed: " << e.what();
+    };
+
+    const auto channel = prefix_ + "invalidate";
+    client->execCommandAsync(ignoreResult, onError, "publish %s %b",
+                             channel.c_str(), message.data(), message.size());
+}
+
+void RedisCache::onInvalidate(InvalidationListener listener) {
+    if (!enabled_) return;
+
+    std::lock_guard<std::mutex> lock(listenersMutex_);
+    listeners_.push_back(std::move(listener));
+    subscribe();
+}
+
+void RedisCache::onProfileInvalidate(ProfileInvalidationListener listener) {
+    if (!enabled_) return;
+
+    std::lock_guard<std::mutex> lock(listenersMutex_);
+    profileListeners_.push_back(std::move(listener));
+    subscribe();
+}
+
+void RedisCache::subscribe() {
+    if (subscriber_) return;
+
+    // SUBSCRIBE holds its connection: a plain client of its own, not the per-loop ones
+    subscriberClient_ = drogon::nosql::RedisClient::newRedisClient(trantor::InetAddress(ip_, port_), 1, password_, db_);
+    subscriber_ = subscriberClient_->newSubscriber();
+    subscriber_->subscribe(prefix_ + "invalidate", [this](const std::string&, const std::string& message) {
+        dispatch(message);
+    });
+}
+
+// "<replica> <conversationId>[ <profileId>,...]" or "<replica> profile:<authUserId>"
+void RedisCache::dispatch(const std::string& message) {
+    const auto replicaEnd = message.find(' ');
+    if (replicaEnd == std::string::npos) return;
+    if (message.compare(0, replicaEnd, replica_) == 0) return;   // one of ours
+
+    static const std::string kProfile = "profile:";
+    if (message.compare(replicaEnd + 1, kProfile.size(), kProfile) == 0) {
+        const auto authUserId = message.substr(replicaEnd + 1 + kProfile.size());
+        if (authUserId.empty()) return;
+
+        std::lock_guard<std::mutex> lock(listenersMutex_);
+        for (const auto& listener : profileListeners_) listener(authUserId);
+        return;
+    }
+
+    const auto convStart = replicaEnd + 1;
+    const auto convEnd = message.find(' ', convStart);
+    const auto conversationId = message.substr(convStart, convEnd == std::string::npos ? std::string::npos : convEnd - convStart);
+    if (conversationId.empty()) return;
+
+    std::vector<std::string> profileIds;
+    if (convEnd != std::string::npos) {
+        std::size_t start = convEnd + 1;
+        while (start <= message.size()) {
+            auto end = message.find(',', start);
+            if (end == std::string::npos) end = message.size();
+            if (end > start) profileIds.push_back(message.substr(start, end - start));
+            start = end + 1;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(listenersMutex_);
+    for (const auto& listener : listeners_) listener(conversationId, profileIds);
+}
@@ -0,0 +1,441 @@
+//
+// Created by walid on 15/10/2026.
+//
+
+#include "../include/SupabaseClient.h"
+
+#include <trantor/net/Channel.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/Logger.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+thread_local bool tlsBlocking = false;
+
+size_t writeCb(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    auto* s = static_cast<std::string*>(userdata);
+    s->append(ptr, size * nmemb);
+    return size * nmemb;
+}
+
+curl_slist* buildHeaders(const SupabaseClient::Request& req) {
+    struct curl_slist* h = nullptr;
+    h = curl_slist_append(h, ("apikey: " + req.apiKey).c_str());
+    h = curl_slist_append(h, ("Authorization: Bearer " + req.bearer).c_str());
+    h = curl_slist_append(h, "Content-Type: application/json");
+    if (req.returnRepresentation) {
+        h = curl_slist_append(h, "Prefer: return=representation");
+    }
+    return h;
+}
+
+// Owns the easy handle of one thread; the handle keeps its connection cache
+// between calls as long as we only curl_easy_reset() it.
+struct ThreadHandle {
+    CURL* curl = nullptr;
+    ~ThreadHandle() {
+        if (curl) curl_easy_cleanup(curl);
+    }
+};
+
+// One asynchronous transfer; request and response live here until the callback ran
+struct Transfer {
+    CURL* easy = nullptr;
+    curl_slist* headers = nullptr;
+    SupabaseClient::Request req;
+    SupabaseClient::Response resp;
+    SupabaseClient::Callback cb;
+};
+
+// curl_multi handle of one IO loop, driven by trantor channels and timers.
+// The multi handle owns the connection cache, so keep-alive connections and
+// HTTP/2 streams are shared by every transfer started from this loop.
+class LoopMulti {
+public:
+    explicit LoopMulti(trantor::EventLoop* loop) : loop_(loop), multi_(curl_multi_init()) {
+        curl_multi_setopt(multi_, CURLMOPT_SOCKETFUNCTION, &LoopMulti::socketCb);
+        curl_multi_setopt(multi_, CURLMOPT_SOCKETDATA, this);
+        curl_multi_setopt(multi_, CURLMOPT_TIMERFUNCTION, &LoopMulti::timerCb);
+        curl_multi_setopt(multi_, CURLMOPT_TIMERDATA, this);
+        curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    }
+
+    CURL* acquireEasy() {
+        if (idle_.empty()) return curl_easy_init();
+        CURL* c = idle_.back();
+        idle_.pop_back();
+        curl_easy_reset(c);
+        return c;
+    }
+
+    void start(std::unique_ptr<Transfer> t) {
+        curl_easy_setopt(t->easy, CURLOPT_PRIVATE, t.get());
+        if (curl_multi_add_handle(multi_, t->easy) != CURLM_OK) {
+            finish(std::move(t), CURLE_FAILED_INIT);
+            return;
+        }
+        t.release();   // owned by the multi handle until CURLMSG_DONE
+    }
+
+private:
+    static int socketCb(CURL*, curl_socket_t s, int what, void* userp, void*) {
+        static_cast<LoopMulti*>(userp)->watch(s, what);
+        return 0;
+    }
+
+    static int timerCb(CURLM*, long timeoutMs, void* userp) {
+        auto* self = static_cast<LoopMulti*>(userp);
+        if (self->timerArmed_) {
+            self->loop_->invalidateTimer(self->timer_);
+            self->timerArmed_ = false;
+        }
+        if (timeoutMs >= 0) {
+            // Never call curl_multi_socket_action from inside the timer callback itself
+            self->timer_ = self->loop_->runAfter(timeoutMs / 1000.0, [self] {
+                self->timerArmed_ = false;
+                self->action(CURL_SOCKET_TIMEOUT, 0);
+            });
+            self->timerArmed_ = true;
+        }
+        return 0;
+    }
+
+    void watch(curl_socket_t s, int what) {
+        auto it = channels_.find(s);
+
+        if (what == CURL_POLL_REMOVE) {
+            if (it == channels_.end()) return;
+            it->second->disableAll();
+            it->second->remove();
+            // We may be inside this channel's own event handler: destroy it later
+            std::shared_ptr<trantor::Channel> dead(std::move(it->second));
+            channels_.erase(it);
+            loop_->queueInLoop([dead] {});
+            return;
+        }
+
+        if (it == channels_.end()) {
+            auto ch = std::make_unique<trantor::Channel>(loop_, s);
+            ch->setReadCallback([this, s] { action(s, CURL_CSELECT_IN); });
+            ch->setWriteCallback([this, s] { action(s, CURL_CSELECT_OUT); });
+            ch->setErrorCallback([this, s] { action(s, CURL_CSELECT_ERR); });
+            ch->setCloseCallback([this, s] { action(s, CURL_CSELECT_ERR); });
+            it = channels_.emplace(s, std::move(ch)).first;
+        }
+
+        auto& ch = *it->second;
+        const bool wantRead  = (what == CURL_POLL_IN  || what == CURL_POLL_INOUT);
+        const bool wantWrite = (what == CURL_POLL_OUT || what == CURL_POLL_INOUT);
+        if (wantRead && !ch.isReading()) ch.enableReading();
+        if (!wantRead && ch.isReading()) ch.disableReading();
+        if (wantWrite && !ch.isWriting()) ch.enableWriting();
+        if (!wantWrite && ch.isWriting()) ch.disableWriting();
+    }
+
+    void action(curl_socket_t s, int events) {
+        int running = 0;
+        curl_multi_socket_action(multi_, s, events, &running);
+        drainCompleted();
+    }
+
+    void drainCompleted() {
+        int left = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi_, &left)) {
+            if (msg->msg != CURLMSG_DONE) continue;
+
+            CURL* easy = msg->easy_handle;
+            const CURLcode res = msg->data.result;
+            char* priv = nullptr;
+            curl_easy_getinfo(easy, CURLINFO_PRIVATE, &priv);
+            curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &reinterpret_cast<Transfer*>(priv)->resp.httpCode);
+            curl_multi_remove_handle(multi_, easy);
+
+            finish(std::unique_ptr<Transfer>(reinterpret_cast<Transfer*>(priv)), res);
+        }
+    }
+
+    void finish(std::unique_ptr<Transfer> t, CURLcode res) {
+        curl_slist_free_all(t->headers);
+        t->headers = nullptr;
+        idle_.push_back(t->easy);
+
+        if (res == CURLE_OK) {
+            t->resp.ok = true;
+        } else {
+            t->resp.error = curl_easy_strerror(res);
+        }
+
+        try {
+            t->cb(t->resp);
+        } catch (const std::exception& e) {
+            LOG_ERROR << "Supabase callback threw: " << e.what();
+        }
+    }
+
+    trantor::EventLoop* loop_;
+    CURLM* multi_;
+    std::unordered_map<curl_socket_t, std::unique_ptr<trantor::Channel>> channels_;
+    std::vector<CURL*> idle_;
+    trantor::TimerId timer_{0};
+    bool timerArmed_ = false;
+};
+
+LoopMulti& loopMulti(trantor::EventLoop* loop) {
+    // One IO loop per thread; lives as long as the thread (never torn down
+    // while transfers could still be in flight)
+    thread_local LoopMulti* multi = nullptr;
+    if (!multi) multi = new LoopMulti(loop);
+    return *multi;
+}
+
+// ---------- Single-flight: identical GETs in flight share one transfer ----------
+struct Waiter {
+    trantor::EventLoop* loop;
+    SupabaseClient::Callback cb;
+};
+
+class InFlightTable {
+public:
+    // Registers cb under key; true when the caller is the first one and must go upstream
+    bool join(const std::string& key, trantor::EventLoop* loop, SupabaseClient::Callback cb) {
+        auto& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto [it, first] = shard.flights.try_emplace(key);
+        it->second.push_back({loop, std::move(cb)});
+        return first;
+    }
+
+    // Removes the flight; later identical GETs start a new transfer
+    std::vector<Waiter> land(const std::string& key) {
+        auto& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.flights.find(key);
+        if (it == shard.flights.end()) return {};
+        auto waiters = std::move(it->second);
+        shard.flights.erase(it);
+        return waiters;
+    }
+
+private:
+    static constexpr std::size_t kShards = 16;
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::vector<Waiter>> flights;
+    };
+
+    Shard& shardFor(const std::string& key) {
+        return shards_[std::hash<std::string>{}(key) % kShards];
+    }
+
+    std::array<Shard, kShards> shards_;
+};
+
+InFlightTable& inFlight() {
+    static auto* table = new InFlightTable();
+    return *table;
+}
+
+std::string flightKey(const SupabaseClient::Request& req) {
+    std::string key;
+    key.reserve(req.url.size() + req.apiKey.size() + req.bearer.size() + 2);
+    key.append(req.url).append(1, '\n').append(req.apiKey).append(1, '\n').append(req.bearer);
+    return key;
+}
+
+void invokeWaiter(const SupabaseClient::Callback& cb, const SupabaseClient::Response& resp) {
+    try {
+        cb(resp);
+    } catch (const std::exception& e) {
+        LOG_ERROR << "Supabase callback threw: " << e.what();
+    }
+}
+
+std::atomic<std::uint64_t> upstreamCount{0};
+std::atomic<std::uint64_t> coalescedCount{0};
+
+} // namespace
+
+SupabaseClient::BlockingScope::BlockingScope() : previous_(tlsBlocking) {
+    tlsBlocking = true;
+}
+
+SupabaseClient::BlockingScope::~BlockingScope() {
+    tlsBlocking = previous_;
+}
+
+bool SupabaseClient::BlockingScope::active() {
+    return tlsBlocking;
+}
+
+SupabaseClient& SupabaseClient::instance() {
+    // Never destroyed: thread-local handles may outlive static destruction
+    static SupabaseClient* client = new SupabaseClient();
+    return *client;
+}
+
+SupabaseClient::SupabaseClient() {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    const auto readTimeout = [](const char* name, long& value) {
+        if (const char* ms = std::getenv(name)) {
+            try {
+                value = std::max(std::stol(ms), 1L);
+            } catch (const std::exception&) {
+                LOG_WARN << "Ignoring invalid " << name << " " << ms;
+            }
+        }
+    };
+    readTimeout("SUPABASE_CONNECT_TIMEOUT_MS", connectTimeoutMs_);
+    readTimeout("SUPABASE_TIMEOUT_MS", timeoutMs_);
+
+    share_ = curl_share_init();
+    if (share_) {
+        curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, &SupabaseClient::lockShare);
+        curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, &SupabaseClient::unlockShare);
+        curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+}
+
+void SupabaseClient::lockShare(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+    static_cast<SupabaseClient*>(userptr)->shareLocks_[data].lock();
+}
+
+void SupabaseClient::unlockShare(CURL*, curl_lock_data data, void* userptr) {
+    static_cast<SupabaseClient*>(userptr)->shareLocks_[data].unlock();
+}
+
+CURL* SupabaseClient::threadHandle() {
+    thread_local ThreadHandle handle;
+    if (!handle.curl) {
+        handle.curl = curl_easy_init();
+    } else {
+        // Drops the previous options but keeps the live connections
+        curl_easy_reset(handle.curl);
+    }
+    return handle.curl;
+}
+
+void SupabaseClient::applyOptions(CURL* c, const Request& req, curl_slist* headers, std::string* out) {
+    curl_easy_setopt(c, CURLOPT_URL, req.url.c_str());
+    curl_easy_setopt(c, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, writeCb);
+    curl_easy_setopt(c, CURLOPT_WRITEDATA, out);
+    curl_easy_setopt(c, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(c, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(c, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(c, CURLOPT_CONNECTTIMEOUT_MS, connectTimeoutMs_);
+    curl_easy_setopt(c, CURLOPT_TIMEOUT_MS, timeoutMs_);
+    if (share_) {
+        curl_easy_setopt(c, CURLOPT_SHARE, share_);
+    }
+
+    if (req.method == "GET") {
+        curl_easy_setopt(c, CURLOPT_HTTPGET, 1L);
+    } else if (req.method == "POST") {
+        curl_easy_setopt(c, CURLOPT_POST, 1L);
+        curl_easy_setopt(c, CURLOPT_POSTFIELDS, req.body.c_str());
+        curl_easy_setopt(c, CURLOPT_POSTFIELDSIZE, static_cast<long>(req.body.size()));
+    } else {
+        curl_easy_setopt(c, CURLOPT_CUSTOMREQUEST, req.method.c_str());
+        if (!req.body.empty()) {
+            curl_easy_setopt(c, CURLOPT_POSTFIELDS, req.body.c_str());
+            curl_easy_setopt(c, CURLOPT_POSTFIELDSIZE, static_cast<long>(req.body.size()));
+        }
+    }
+}
+
+SupabaseClient::Response SupabaseClient::perform(const Request& req) {
+    Response out;
+
+    CURL* c = threadHandle();
+    if (!c) {
+        out.error = "curl init failed";
+        return out;
+    }
+
+    curl_slist* h = buildHeaders(req);
+    applyOptions(c, req, h, &out.body);
+
+    auto res = curl_easy_perform(c);
+    curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &out.httpCode);
+    curl_slist_free_all(h);
+
+    if (res != CURLE_OK) {
+        out.error = curl_easy_strerror(res);
+        return out;
+    }
+
+    out.ok = true;
+    return out;
+}
+
+void SupabaseClient::performAsync(Request req, Callback cb) {
+    auto* loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (tlsBlocking || !loop) {
+        cb(perform(req));
+        return;
+    }
+
+    // Only reads are coalesced: a write must always reach the upstream
+    if (req.method != "GET" || !req.body.empty()) {
+        return startTransfer(loop, std::move(req), std::move(cb));
+    }
+
+    auto key = flightKey(req);
+    if (!inFlight().join(key, loop, std::move(cb))) {
+        coalescedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    startTransfer(loop, std::move(req), [key = std::move(key)](const Response& resp) {
+        auto waiters = inFlight().land(key);
+        std::shared_ptr<const Response> shared;   // one copy for the waiters of other loops
+
+        for (auto& w : waiters) {
+            if (w.loop->isInLoopThread()) {
+                invokeWaiter(w.cb, resp);
+                continue;
+            }
+            if (!shared) shared = std::make_shared<const Response>(resp);
+            w.loop->queueInLoop([shared, cb = std::move(w.cb)]() { invokeWaiter(cb, *shared); });
+        }
+    });
+}
+
+void SupabaseClient::startTransfer(trantor::EventLoop* loop, Request req, Callback cb) {
+    upstreamCount.fetch_add(1, std::memory_order_relaxed);
+    auto& multi = loopMulti(loop);
+
+    auto t = std::make_unique<Transfer>();
+    t->req = std::move(req);
+    t->cb = std::move(cb);
+    t->easy = multi.acquireEasy();
+    if (!t->easy) {
+        t->resp.error = "curl init failed";
+        t->cb(t->resp);
+        return;
+    }
+
+    t->headers = buildHeaders(t->req);
+    applyOptions(t->easy, t->req, t->headers, &t->resp.body);
+    multi.start(std::move(t));
+}
+
+SupabaseClient::Stats SupabaseClient::stats() const {
+    Stats s;
+    s.upstream = upstreamCount.load(std::memory_order_relaxed);
+    s.coalesced = coalescedCount.load(std::memory_order_relaxed);
+    return s;
+}
@@ -3,10 +3,20 @@
 //
 
 #include "../include/ConversationController.h"
+#include "../include/ConversationStore.h"
+#include "../include/JwtVerifier.h"
+#include "../include/MembershipCache.h"
+#include "Metrics.h"
+#include "../include/ProfileIdCache.h"
+#include "../include/RealtimeHub.h"
+#include "../include/RedisCache.h"
+#include "ServerConfig.h"
+#include "../include/SupabaseClient.h"
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <algorithm>
+#include <vector>
 
 void loadEnvFile(const std::string& path = ".env") {
     std::ifstream file(path);
@@ -38,6 +48,58 @@ void loadEnvFile(const std::string& path = ".env") {
     std::cout << "[INFO] Variables .env chargées depuis " << path << std::endl;
 }
 
+// Stats kept by the components themselves, exported at scrape time
+void registerMetricCollectors() {
+    Metrics::instance().addCollector([](std::string& out) {
+        auto sample = [&out](const char* type, const std::string& name, unsigned long long value) {
+            out += "# TYPE " + name + " " + type + "\n" + name + " " + std::to_string(value) + "\n";
+        };
+
+        const auto supabase = SupabaseClient::instance().stats();
+        sample("counter", "supabase_transfers_total", supabase.upstream);
+        sample("counter", "supabase_coalesced_total", supabase.coalesced);
+
+        const auto profiles = ProfileIdCache::instance().stats();
+        sample("counter", "profile_cache_hits_total", profiles.hits);
+        sample("counter", "profile_cache_misses_total", profiles.misses);
+        sample("counter", "profile_cache_evictions_total", profiles.evictions);
+        sample("gauge", "profile_cache_entries", profiles.size);
+
+        const auto memberships = MembershipCache::instance().stats();
+        sample("counter", "membership_cache_hits_total", memberships.hits);
+        sample("counter", "membership_cache_misses_total", memberships.misses);
+        sample("counter", "membership_cache_evictions_total", memberships.evictions);
+        sample("counter", "membership_cache_invalidations_total", memberships.invalidations);
+        sample("gauge", "membership_cache_entries", memberships.size);
+
+        const auto realtime = RealtimeHub::instance().stats();
+        sample("gauge", "websocket_connections", realtime.sockets);
+        sample("counter", "websocket_events_delivered_total", realtime.delivered);
+        sample("counter", "websocket_slow_consumers_evicted_total", realtime.evicted);
+    });
+}
+
+// Member changes made by the other replicas (Redis pub/sub)
+void subscribeCacheInvalidations() {
+    RedisCache::instance().onInvalidate([](const std::string& conversationId,
+                                           const std::vector<std::string>& profileIds) {
+        Uuid conversation;
+        if (!Uuid::parse(conversationId, conversation)) return;
+
+        auto& cache = MembershipCache::instance();
+        if (profileIds.empty()) return cache.invalidateConversation(conversation);
+        for (const auto& id : profileIds) {
+            Uuid profile;
+            if (Uuid::parse(id, profile)) cache.invalidate(conversation, profile);
+        }
+    });
+
+    // Accounts deleted through another replica (/internal/cache/profiles/invalidate)
+    RedisCache::instance().onProfileInvalidate([](const std::string& authUserId) {
+        ProfileIdCache::instance().invalidate(authUserId);
+    });
+}
+
 int main() {
     loadEnvFile(".env");
 
@@ -45,6 +107,22 @@ int main() {
               << (std::getenv("SUPABASE_URL") ? std::getenv("SUPABASE_URL") : "non défini")
               << std::endl;
 
+    // curl_global_init + shared DNS/TLS cache before the IO threads start
+    SupabaseClient::instance();
+    // JWT secret / JWKS keys (may fetch SUPABASE_JWKS_URL, so before run())
+    JwtVerifier::instance();
+    // CONVERSATION_STORE: PostgREST, or libpq workers started here
+    ConversationStore::instance();
+    // Shared cache tier (REDIS_HOST): its per-loop clients must exist before run()
+    RedisCache::instance();
+    subscribeCacheInvalidations();
+
+    // IO threads / listeners / limits (SERVER_* env or SERVER_CONFIG_FILE)
+    ServerConfig::load(8081).apply(drogon::app());
+    // GET /metrics + per-route latency histograms
+    Metrics::instrument(drogon::app());
+    registerMetricCollectors();
+
     drogon::app()
         .registerHandler(
             "/health",
@@ -57,7 +135,6 @@ int main() {
             },
             {drogon::Get}
         )
-        .addListener("0.0.0.0", 8081)   // on force 8081
         .setLogLevel(trantor::Logger::kInfo)
         .run();
 }
\ No newline at end of file